@@ -259,6 +259,7 @@ extern std::string llvmFlags;
 extern bool fPrintAdditionalErrors;
 
 extern bool fCompilerLibraryParser;
+extern char fCompilerLibraryCacheDir[FILENAME_MAX+1];
 
 namespace chpl {
   class Context;
@@ -292,6 +292,7 @@ static
 bool fPrintChplSettings = false;
 
 bool fCompilerLibraryParser = false;
+char fCompilerLibraryCacheDir[FILENAME_MAX+1] = "";
 
 chpl::Context* gContext = nullptr;
 
@@ -1164,6 +1165,7 @@ static ArgumentDescription arg_desc[] = {
  {"warn-special", ' ', NULL, "Enable [disable] special warnings", "n", &fNoWarnSpecial, "CHPL_WARN_SPECIAL", setWarnSpecial},
 
  {"compiler-library-parser", ' ', NULL, "Enable [disable] using compiler library parser", "N", &fCompilerLibraryParser, "CHPL_COMPILER_LIBRARY_PARSER", NULL},
+ {"compiler-library-cache", ' ', "<directory>", "Reuse compiler library parse results stored in directory", "P", fCompilerLibraryCacheDir, "CHPL_COMPILER_LIBRARY_CACHE", NULL},
 
  DRIVER_ARG_PRINT_CHPL_HOME,
  DRIVER_ARG_LAST
@@ -1509,6 +1511,16 @@ static void checkIncrementalAndOptimized() {
               " using -O optimizations directly.");
 }
 
+static void setCompilerLibraryCache() {
+  if (fCompilerLibraryCacheDir[0] != '\0') {
+    // cached results are only used by a compiler with the same version
+    char version[128];
+    get_version(version);
+    gContext->setPersistentCacheDirectory(fCompilerLibraryCacheDir,
+                                          version);
+  }
+}
+
 static void checkUnsupportedConfigs(void) {
   // Check for cce classic
   if (!strcmp(CHPL_TARGET_COMPILER, "cray-prgenv-cray")) {
@@ -1599,6 +1611,8 @@ static void postprocess_args() {
 
   setPrintCppLineno();
 
+  setCompilerLibraryCache();
+
   checkLLVMCodeGen();
 
   checkTargetCpu();
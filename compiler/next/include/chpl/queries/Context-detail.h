@@ -25,8 +25,14 @@
 #include "chpl/util/memory.h"
 #include "chpl/util/hash.h"
 
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <utility>
@@ -40,17 +46,99 @@ class ID;
 
 namespace detail {
 
-struct UniqueStrEqual final {
-  bool operator()(const char* lhs, const char* rhs) const {
-    // pass the 2 metadata bytes
-    return strcmp(lhs, rhs) == 0;
+/**
+  The table of unique strings used by the Context. It is an open
+  addressing hash table split into shards, where each slot records
+  the string's hash along with a pointer to the string data.
+
+  Looking up a string that is already in the table does not take any
+  locks, so it can be done concurrently from many threads. Adding a new
+  string locks only the shard that the string belongs to. When a shard
+  needs to grow, its slots are copied to a new, larger array; the old
+  array stays valid for any concurrent readers until collectGarbage
+  is called.
+
+  Each string is preceded by 2 bytes of metadata: the GC mark and 0x02.
+  The string data is always aligned to 2 bytes.
+ */
+class UniqueStringsTable final {
+ private:
+  struct Slot {
+    std::atomic<size_t> hash;
+    // the length is compared before the string data so that
+    // a lookup never reads past the end of a shorter string
+    std::atomic<size_t> len;
+    std::atomic<const char*> str;
+  };
+  struct SlotArray {
+    size_t mask; // number of slots - 1
+    Slot* slots;
+  };
+  struct alignas(64) Shard {
+    // readers use this without locking
+    std::atomic<SlotArray*> current;
+    // the rest is protected by 'lock'
+    std::mutex lock;
+    size_t count = 0;
+    std::vector<SlotArray*> retired;
+  };
+
+  enum {
+    NUM_SHARDS = 32,
+    MIN_SHARD_SLOTS = 64,
+  };
+  Shard shards[NUM_SHARDS];
+
+  static const char* find(const SlotArray* a,
+                          const char* s, size_t len, size_t hash);
+  static void insert(SlotArray* a, const char* str, size_t len,
+                     size_t hash);
+  static SlotArray* allocateSlots(size_t nSlots);
+  static void freeSlots(SlotArray* a);
+  const char* insertLocked(Shard& shard, const char* s, size_t len,
+                           size_t hash, char gcMark);
+
+ public:
+  UniqueStringsTable();
+  ~UniqueStringsTable();
+  UniqueStringsTable(const UniqueStringsTable&) = delete;
+  UniqueStringsTable& operator=(const UniqueStringsTable&) = delete;
+
+  static size_t hash(const char* s, size_t len) {
+    uint64_t seed = FNV_offset_basis;
+    for (size_t i = 0; i < len; i++)
+      seed = (seed ^ static_cast<unsigned char>(s[i])) * FNV_prime;
+    return (size_t) seed;
   }
-};
 
-struct UniqueStrHash final {
-  size_t operator()(const char* s) const {
-    return chpl::hash(s);
+  /**
+    Return the unique copy of the string 's', which has length 'len'
+    and hash 'hash' (as computed by the above hash function).
+    If it needs to be added, its GC mark is set to 'gcMark'.
+    This can be called concurrently from multiple threads.
+   */
+  const char* getOrCreate(const char* s, size_t len, size_t hash,
+                          char gcMark) {
+    Shard& shard = shards[(hash >> 24) % NUM_SHARDS];
+    const SlotArray* a = shard.current.load(std::memory_order_acquire);
+    if (const char* found = find(a, s, len, hash)) {
+      return found;
+    }
+    return insertLocked(shard, s, len, hash, gcMark);
   }
+
+  /**
+    Free the strings with a GC mark other than 'gcMark' and any slot
+    arrays retired when the table grew. Returns the number of strings
+    freed. This must not be called concurrently with anything else.
+   */
+  size_t collectGarbage(char gcMark, bool trace);
+
+  /**
+    Returns the number of strings in the table. This must not be
+    called concurrently with getOrCreate.
+   */
+  size_t size() const;
 };
 
 }
@@ -151,6 +239,143 @@ void queryArgsPrint(const std::tuple<Ts...>& tuple) {
 using QueryDependencyVec = std::vector<const QueryMapResultBase*>;
 using QueryErrorVec = std::vector<ErrorMessage>;
 
+// ContextLock is a recursive lock used to serialize the bookkeeping
+// done by the Context when queries are running on multiple threads.
+// Unlike std::recursive_mutex, it can be completely released
+// while waiting for another thread to finish a query.
+class ContextLock {
+ private:
+  std::mutex mutex;
+  // signaled whenever the lock becomes available
+  std::condition_variable released;
+  std::thread::id owner;
+  int depth = 0;
+  // counts the number of times the lock was released by 'waitUntil'
+  // so that callers can detect that the state might have changed
+  uint64_t nWaits = 0;
+
+ public:
+  void lock() {
+    std::thread::id me = std::this_thread::get_id();
+    std::unique_lock<std::mutex> guard(mutex);
+    if (owner == me) {
+      depth++;
+      return;
+    }
+    released.wait(guard, [this] { return depth == 0; });
+    owner = me;
+    depth = 1;
+  }
+
+  void unlock() {
+    std::unique_lock<std::mutex> guard(mutex);
+    assert(owner == std::this_thread::get_id() && depth > 0);
+    depth--;
+    if (depth == 0) {
+      owner = std::thread::id();
+      guard.unlock();
+      released.notify_all();
+    }
+  }
+
+  // Fully releases the lock (which must be held by the calling thread)
+  // until 'pred' returns true. 'pred' is only evaluated while no
+  // thread holds the lock, so it can inspect state protected by it.
+  template<typename Pred>
+  void waitUntil(Pred pred) {
+    std::thread::id me = std::this_thread::get_id();
+    std::unique_lock<std::mutex> guard(mutex);
+    assert(owner == me && depth > 0);
+    int savedDepth = depth;
+    owner = std::thread::id();
+    depth = 0;
+    nWaits++;
+    released.notify_all();
+    released.wait(guard, [this, &pred] { return depth == 0 && pred(); });
+    owner = me;
+    depth = savedDepth;
+  }
+
+  // Returns a counter that changes whenever 'waitUntil' released the lock.
+  // Should only be called while holding the lock.
+  uint64_t waitCount() const {
+    return nWaits;
+  }
+};
+
+// Locks a ContextLock for a scope, but only if 'enable' is set.
+// That way, the locking overhead is only paid when running
+// queries on multiple threads.
+class ContextLockGuard {
+ private:
+  ContextLock* lock_;
+ public:
+  ContextLockGuard(ContextLock& lock, bool enable)
+    : lock_(enable ? &lock : nullptr) {
+    if (lock_ != nullptr) lock_->lock();
+  }
+  ~ContextLockGuard() {
+    if (lock_ != nullptr) lock_->unlock();
+  }
+  ContextLockGuard(const ContextLockGuard&) = delete;
+  ContextLockGuard& operator=(const ContextLockGuard&) = delete;
+};
+
+// Timing and count information for a query.
+// This is only collected when query timing is enabled
+// (see Context::enableQueryTiming).
+struct QueryTimingStats {
+  // the number of times the saved result was reused
+  int64_t nReused = 0;
+  // the number of times the query was computed for the first time
+  int64_t nComputed = 0;
+  // the number of times the query was computed again
+  // because a dependency changed (or because it is an input query)
+  int64_t nRecomputed = 0;
+  // total time spent in the query, including the time in other queries
+  // (in nanoseconds)
+  int64_t totalNs = 0;
+  // time spent in Context functions on behalf of the query,
+  // i.e. looking up results and checking and recording dependencies
+  int64_t contextNs = 0;
+  // time spent in other queries called by this query
+  int64_t childNs = 0;
+
+  int64_t nCalls() const {
+    return nReused + nComputed + nRecomputed;
+  }
+  // time spent running the query function itself
+  int64_t selfNs() const {
+    return totalNs - contextNs - childNs;
+  }
+};
+
+// A query in progress, for the purpose of collecting timing information
+struct QueryTimingFrame {
+  const char* queryName = nullptr;
+  const QueryMapBase* queryMap = nullptr;
+  // index of the QueryTimingStackNode for the stack ending in this frame
+  int stackNode = -1;
+  int64_t startNs = 0;
+  int64_t contextNs = 0;
+  int64_t childNs = 0;
+};
+
+// A stack of running queries, for the purpose of generating
+// the folded stacks timing report. The stacks form a tree
+// where each node refers to the stack without its last query.
+struct QueryTimingStackNode {
+  const char* queryName = nullptr;
+  int parent = -1;
+  int64_t selfNs = 0;
+  int64_t contextNs = 0;
+};
+
+static inline int64_t queryTimingNowNs() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
 class QueryMapResultBase {
  public:
 
@@ -168,6 +393,10 @@ class QueryMapResultBase {
   mutable QueryDependencyVec dependencies;
   mutable QueryErrorVec errors;
 
+  // When running queries on multiple threads, this indicates
+  // which thread is currently computing the query (if any).
+  mutable std::thread::id runningThread;
+
   QueryMapBase* parentQueryMap;
 
   QueryMapResultBase(RevisionNumber lastChecked,
@@ -177,6 +406,7 @@ class QueryMapResultBase {
       lastChanged(lastChanged),
       dependencies(),
       errors(),
+      runningThread(),
       parentQueryMap(parentQueryMap) {
   }
   virtual ~QueryMapResultBase() = 0; // this is an abstract base class
@@ -216,9 +446,10 @@ class QueryMapBase {
  public:
    const char* queryName;
    bool isInputQuery;
+   QueryTimingStats timing;
 
    QueryMapBase(const char* queryName, bool isInputQuery)
-     : queryName(queryName), isInputQuery(isInputQuery) {
+     : queryName(queryName), isInputQuery(isInputQuery), timing() {
    }
    virtual ~QueryMapBase() = 0; // this is an abstract base class
    virtual void clearOldResults(RevisionNumber currentRevisionNumber) = 0;
@@ -26,7 +26,13 @@
 #include "chpl/util/memory.h"
 #include "chpl/util/hash.h"
 
+#include <cstdio>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -180,10 +186,8 @@ because the ``parse`` query will update the pointer if the contents change.
  */
 class Context {
  private:
-  // map that supports uniqueCString / UniqueString
-  // TODO this could be an unordered_set
-  using UniqueStringsTableType = std::unordered_map<const char*, char*, chpl::detail::UniqueStrHash, chpl::detail::UniqueStrEqual>;
-  UniqueStringsTableType uniqueStringsTable;
+  // table that supports uniqueCString / UniqueString
+  detail::UniqueStringsTable uniqueStringsTable;
 
   // Map from a query function pointer to appropriate QueryMap object.
   // Maps to an 'owned' heap-allocated thing to manage having subclasses
@@ -197,7 +201,26 @@ class Context {
   //  start including file path in IDs).
   std::unordered_map<UniqueString, UniqueString> modNameToFilepath;
 
-  std::vector<const querydetail::QueryMapResultBase*> queryStack;
+  using QueryStackType = std::vector<const querydetail::QueryMapResultBase*>;
+  QueryStackType queryStack;
+
+  // When running queries on multiple threads (see runInParallel),
+  // each worker thread has its own stack of running queries.
+  static thread_local const Context* workerContext;
+  static thread_local QueryStackType* workerQueryStack;
+
+  // The number of threads to use in runInParallel.
+  // 0 means to use the number of hardware threads.
+  int numThreads = 1;
+  // Set while runInParallel is running tasks on multiple threads.
+  // In that event, the query bookkeeping is protected by bookkeepingLock.
+  // (The unique strings table handles concurrent use on its own.)
+  bool runningInParallel = false;
+  querydetail::ContextLock bookkeepingLock;
+  // Which query each thread is waiting for, used to detect
+  // recursion through queries running on different threads.
+  std::unordered_map<std::thread::id,
+                     const querydetail::QueryMapResultBase*> waitingFor;
 
 
   querydetail::RevisionNumber currentRevisionNumber = 1;
@@ -206,11 +229,50 @@ class Context {
   static void defaultReportError(const ErrorMessage& err);
   void (*reportError)(const ErrorMessage& err) = defaultReportError;
 
+  // The following are used when query timing is enabled.
+  // They are protected by bookkeepingLock when running in parallel.
+  // Each thread using this Context has its own stack of timing frames.
+  using QueryTimingStackType = std::vector<querydetail::QueryTimingFrame>;
+  std::unordered_map<std::thread::id, QueryTimingStackType> timingStacks;
+  bool queryTimingEnabled = false;
+  std::string queryTimingReportPath;
+  int queryTimingReportFormat = 0;
+  // self time for each stack of query names, for flamegraphs,
+  // stored as a tree so that the stack strings are only built
+  // when writing the report
+  std::vector<querydetail::QueryTimingStackNode> queryTimingNodes;
+  std::map<std::pair<int, const char*>, int> queryTimingNodeIds;
+
+  QueryTimingStackType& currentTimingStack() {
+    return timingStacks[std::this_thread::get_id()];
+  }
+  void queryTimingBegin(const char* traceQueryName);
+  void queryTimingBeginDone(const querydetail::QueryMapResultBase* r,
+                            bool useSaved);
+  void queryTimingEnd(const querydetail::QueryMapResultBase* r,
+                      int64_t queryEndStartNs);
+
+  // Where to store query results that persist across compiler runs
+  // (see setPersistentCacheDirectory).
+  std::string cacheDirectory;
+  std::string cacheVersion;
+
   // The following are only used for UniqueString garbage collection
   querydetail::RevisionNumber lastPrepareToGCRevisionNumber = 0;
   querydetail::RevisionNumber gcCounter = 1;
 
-  const char* getOrCreateUniqueString(const char* s);
+  const char* getOrCreateUniqueString(const char* s, size_t len);
+
+  // returns the stack of running queries for the current thread
+  QueryStackType& currentQueryStack() {
+    if (workerContext == this) return *workerQueryStack;
+    return queryStack;
+  }
+
+  // Called when a query result is found that is currently being computed.
+  // Halts if the query is running on the current thread (recursion)
+  // and otherwise waits for the thread computing it to finish.
+  void waitForRunningQuery(const querydetail::QueryMapResultBase* r);
 
   // saves the dependency in the parent query, which is assumed
   // to be at queryStack.back().
@@ -278,24 +340,16 @@ class Context {
             const void* queryFunction,
             const querydetail::QueryMapResultBase* resultEntry);
 
-  // Future Work: make the context thread-safe
+  // Future Work: allow the query bookkeeping to proceed concurrently
+  //              (currently only the bodies of queries run concurrently)
 
   // Future Work: allow moving some AST to a different context
   //              (or, at least, that can handle the unique strings)
 
-  // Performance: Add fine-grained timing to measure
-  //  * the total time spent in each query
-  //  * the time spent in each query in Context functions
-  //    (i.e. hashtable manipulations)
-  //  * the time spent in each query in other queries
-  //  * the time spent in each query in other query code
-
-  // Performance: How can we arrange for better locality of reference/
-  // cache reuse for the maps from IDs? The IDs within a function could
-  // be just stored in a vector, but that would add an indirection to
-  // the hashtable. Is there a way to adjust the hashing function and
-  // tune the hashtable bucket size, or something? Do we need a custom
-  // hashtable?
+  // Performance: The maps from IDs in the parse results store the IDs
+  // within a symbol in a vector (see IdTable) for better locality of
+  // reference. The query results for queries keyed by ID (such as
+  // locateId) are still stored in the hashtable for that query.
 
  public:
   /**
@@ -312,6 +366,109 @@ class Context {
     this->reportError = reportError;
   }
 
+  /**
+    Set the number of threads that runInParallel will use.
+    0 indicates that it should use the number of hardware threads.
+    The default is 1, which runs everything on the calling thread.
+   */
+  void setNumThreads(int numThreads) {
+    this->numThreads = numThreads;
+  }
+
+  /**
+    Calls ``body(i)`` for each ``i`` in ``0..<nTasks``, distributing
+    these calls among up to ``numThreads`` threads (see setNumThreads).
+    The calls can run queries, which allows independent queries (for
+    example, parsing different files) to be computed concurrently.
+
+    While the query bodies run concurrently, the bookkeeping the Context
+    does (looking up saved results, checking dependencies, and recording
+    results) is serialized. If one thread needs the result of a query
+    that another thread is currently computing, it waits for that result.
+
+    If this function is called from within a query, the queries
+    run by ``body`` are recorded as dependencies of that query.
+
+    The ``body`` function must not return until all queries it started
+    are complete, must be safe to run concurrently, and must not call
+    advanceToNextRevision or collectGarbage.
+   */
+  void runInParallel(size_t nTasks, const std::function<void(size_t)>& body);
+
+  typedef enum {
+    QUERY_TIMING_JSON = 0,
+    QUERY_TIMING_FOLDED = 1
+  } QueryTimingFormat;
+
+  /**
+    Start collecting timing information for each query. For each query
+    function, this measures:
+
+      * the total time spent in the query
+      * the time spent in Context functions on behalf of the query
+        (i.e. hashtable lookups and dependency checking)
+      * the time spent in other queries called by the query
+      * the time spent in the query's own code
+      * the number of times the result was reused, computed,
+        or recomputed
+
+    Time spent in queries run by other threads (see runInParallel) is not
+    counted as time in other queries for the calling query.
+
+    If ``reportPath`` is not empty, a report in the requested format
+    is written to that path when the Context is destroyed.
+    ``QUERY_TIMING_FOLDED`` produces the folded stacks format used by
+    flamegraph tools, where the time spent in Context functions is
+    shown as a ``[Context]`` frame.
+   */
+  void enableQueryTiming(std::string reportPath = "",
+                         QueryTimingFormat format = QUERY_TIMING_JSON);
+
+  /**
+    Write the query timing information collected so far to ``fp``
+    in the requested format.
+   */
+  void writeQueryTimingReport(FILE* fp, QueryTimingFormat format);
+
+  /**
+    Call ``f(queryName, stats)`` for each query that has
+    collected timing information.
+   */
+  void forEachQueryTimingStats(
+      const std::function<void(const char*,
+                               const querydetail::QueryTimingStats&)>& f);
+
+  /**
+    Store the results of some queries (currently, ``parsing::parseFile``)
+    in the directory ``path`` so that later compiler runs can load them
+    instead of recomputing them. An empty ``path`` disables this cache.
+
+    Stored results are keyed by the contents of the input file and by
+    ``version``, which should identify the build of the compiler (for
+    example, its version and commit), so that results computed by a
+    different compiler are not used. The stored results are also keyed
+    by a hash of the uAST classes that the compiler was built with.
+   */
+  void setPersistentCacheDirectory(std::string path, std::string version) {
+    cacheDirectory = std::move(path);
+    cacheVersion = std::move(version);
+  }
+
+  /**
+    Returns the directory set by setPersistentCacheDirectory, or an
+    empty string if the persistent cache is not enabled.
+   */
+  const std::string& persistentCacheDirectory() const {
+    return cacheDirectory;
+  }
+
+  /**
+    Returns the version set by setPersistentCacheDirectory.
+   */
+  const std::string& persistentCacheVersion() const {
+    return cacheVersion;
+  }
+
   /**
     Get or create a unique string for a NULL-terminated C string
     and return it as a C string. If the passed string is NULL,
@@ -325,6 +482,13 @@ class Context {
    */
   const char* uniqueCString(const char* s);
 
+  /**
+    Get or create a unique string for the 'len' bytes at 's', which
+    should not contain a zero byte, and return it as a C string.
+    The bytes need not be followed by a null terminator.
+   */
+  const char* uniqueCString(const char* s, size_t len);
+
   /**
    When the context is configured to run with garbage collection
    enabled, unique strings that are reused need to be marked.
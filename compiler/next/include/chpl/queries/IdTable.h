@@ -0,0 +1,173 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CHPL_QUERIES_IDTABLE_H
+#define CHPL_QUERIES_IDTABLE_H
+
+#include "chpl/queries/ID.h"
+#include "chpl/queries/UniqueString.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chpl {
+
+
+/**
+  This class stores a value for each of a set of IDs.
+
+  The postOrderIds within a symbol are dense, so rather than storing an
+  entry per ID in a hashtable, it stores a vector for each symbol path that
+  is indexed by the postOrderId (with the symbol itself, which has
+  postOrderId -1, stored first). Looking up an ID only needs to find the
+  vector for its symbol path (which is hashed by pointer), and the values
+  for the nodes in a symbol are next to each other in memory.
+
+  A value equal to a default-constructed T is treated as absent,
+  so T should be something like a pointer, ID, or Location.
+ */
+template<typename T>
+class IdTable final {
+ private:
+  using MapType = std::unordered_map<UniqueString, std::vector<T>>;
+  MapType symbols_;
+  size_t size_ = 0;
+
+  static size_t indexFor(const ID& id) {
+    return (size_t) (id.postOrderId() + 1);
+  }
+
+ public:
+  IdTable() = default;
+
+  /**
+    Returns a pointer to the value stored for 'id',
+    or nullptr if there is none.
+   */
+  const T* find(const ID& id) const {
+    auto search = symbols_.find(id.symbolPath());
+    if (search == symbols_.end()) {
+      return nullptr;
+    }
+    const std::vector<T>& v = search->second;
+    size_t i = indexFor(id);
+    if (i >= v.size() || v[i] == T()) {
+      return nullptr;
+    }
+    return &v[i];
+  }
+
+  /**
+    Returns the value stored for 'id', or a default-constructed T
+    if there is none.
+   */
+  T get(const ID& id) const {
+    const T* ptr = find(id);
+    return ptr ? *ptr : T();
+  }
+
+  /**
+    Store 'value' for 'id', replacing any value already stored.
+   */
+  void set(const ID& id, T value) {
+    assert(!id.isEmpty() && id.postOrderId() >= -1);
+    std::vector<T>& v = symbols_[id.symbolPath()];
+    size_t i = indexFor(id);
+    if (i >= v.size()) {
+      // the IDs in a symbol are usually added in postorder,
+      // so grow the vector geometrically
+      v.resize(std::max(i + 1, 2 * v.size()));
+    }
+    bool wasEmpty = (v[i] == T());
+    bool isEmpty = (value == T());
+    v[i] = std::move(value);
+    if (wasEmpty && !isEmpty) size_++;
+    if (!wasEmpty && isEmpty) size_--;
+  }
+
+  /**
+    Release any extra space reserved while adding IDs.
+   */
+  void shrinkToFit() {
+    for (auto& pair : symbols_) {
+      std::vector<T>& v = pair.second;
+      while (!v.empty() && v.back() == T()) v.pop_back();
+      v.shrink_to_fit();
+    }
+  }
+
+  /**
+    Returns the number of IDs with a value.
+   */
+  size_t size() const {
+    return size_;
+  }
+
+  void clear() {
+    symbols_.clear();
+    size_ = 0;
+  }
+
+  /**
+    Calls fn(symbolPath, postOrderId, value) for each ID with a value.
+    The symbols are visited in an unspecified order.
+   */
+  template<typename F>
+  void forEach(F fn) const {
+    for (const auto& pair : symbols_) {
+      const std::vector<T>& v = pair.second;
+      for (size_t i = 0; i < v.size(); i++) {
+        if (!(v[i] == T())) {
+          fn(pair.first, (int) i - 1, v[i]);
+        }
+      }
+    }
+  }
+
+  bool operator==(const IdTable& other) const {
+    if (size_ != other.size_) {
+      return false;
+    }
+    // compare without regard to trailing absent entries
+    bool ret = true;
+    forEach([&](UniqueString path, int postOrderId, const T& value) {
+      if (ret) {
+        const T* otherValue = other.find(ID(path, postOrderId, 0));
+        ret = (otherValue != nullptr && *otherValue == value);
+      }
+    });
+    return ret;
+  }
+  bool operator!=(const IdTable& other) const {
+    return !(*this == other);
+  }
+
+  void swap(IdTable& other) {
+    symbols_.swap(other.symbols_);
+    std::swap(size_, other.size_);
+  }
+};
+
+
+} // end namespace chpl
+
+#endif
@@ -118,6 +118,9 @@ QueryMapResult<ResultType,ArgTs...>::markUniqueStringsInResult(Context* context)
 template<typename... ArgTs>
 void Context::queryBeginTrace(const char* traceQueryName,
                               const std::tuple<ArgTs...>& tupleOfArg) {
+  if (queryTimingEnabled) {
+    queryTimingBegin(traceQueryName);
+  }
   if (enableDebugTracing) {
     printf("QUERY BEGIN     %s (", traceQueryName);
     queryArgsPrint(tupleOfArg);
@@ -133,6 +136,8 @@ Context::getMap(const ResultType& (*queryFunc)(Context* context, ArgTs...),
                 const char* traceQueryName,
                 bool isInputQuery) {
 
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+
   const void* queryFuncV = (const void*) queryFunc;
 
   // Look up the map entry for this query
@@ -177,6 +182,8 @@ const QueryMapResult<ResultType, ArgTs...>*
 Context::getResult(QueryMap<ResultType, ArgTs...>* queryMap,
                    const std::tuple<ArgTs...>& tupleOfArgs) {
 
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+
   // Run the constructor QueryMapResult(queryMap, tupleOfArgs)
   // and insert the result into the map if it is not already present.
   auto pair = queryMap->map.emplace(queryMap, tupleOfArgs);
@@ -191,7 +198,12 @@ Context::getResult(QueryMap<ResultType, ArgTs...>* queryMap,
   }
 
   if (newElementWasAdded == false && savedElement->lastChecked == -1) {
-    haltForRecursiveQuery(savedElement);
+    if (runningInParallel) {
+      // it might be running on another thread
+      waitForRunningQuery(savedElement);
+    } else {
+      haltForRecursiveQuery(savedElement);
+    }
   }
 
   return savedElement;
@@ -215,6 +227,10 @@ Context::queryUseSaved(
   const void* queryFuncV = (const void*) queryFunction;
   bool useSaved = queryCanUseSavedResultAndPushIfNot(queryFuncV, r);
 
+  if (queryTimingEnabled) {
+    queryTimingBeginDone(r, useSaved);
+  }
+
   if (enableDebugTracing) {
     if (useSaved) {
       printf("QUERY END       %s (...) REUSING BASED ON DEPS %p\n",
@@ -231,7 +247,14 @@ Context::queryUseSaved(
 template<typename ResultType, typename... ArgTs>
 const ResultType&
 Context::queryGetSaved(const QueryMapResult<ResultType, ArgTs...>* r) {
+  int64_t queryEndStartNs = 0;
+  if (queryTimingEnabled) {
+    queryEndStartNs = queryTimingNowNs();
+  }
   this->saveDependencyInParent(r);
+  if (queryTimingEnabled) {
+    queryTimingEnd(r, queryEndStartNs);
+  }
   return r->result;
 }
 
@@ -241,6 +264,7 @@ const ResultType* Context::queryGetRunningQueryPartialResult(
              const ResultType& (*queryFunction)(Context* context, ArgTs...),
              const std::tuple<ArgTs...>& tupleOfArgs,
              const char* traceQueryName) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
   // Look up the map entry for this query name
   const void* queryFuncV = (const void*) queryFunction;
   // Look up the map entry for this query
@@ -272,6 +296,7 @@ template<typename ResultType,
 Context::QueryStatus Context::queryStatus(
              const ResultType& (*queryFunction)(Context* context, ArgTs...),
              const std::tuple<ArgTs...>& tupleOfArgs) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
   // Look up the map entry for this query name
   const void* queryFuncV = (const void*) queryFunction;
   // Look up the map entry for this query
@@ -309,8 +334,15 @@ Context::queryEnd(
               ResultType result,
               const char* traceQueryName) {
 
+  int64_t queryEndStartNs = 0;
+  if (queryTimingEnabled) {
+    queryEndStartNs = queryTimingNowNs();
+  }
+
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+
   // must be in a query to be running one!
-  assert(queryStack.size() > 0);
+  assert(currentQueryStack().size() > 0);
 
   const QueryMapResult<ResultType, ArgTs...>* ret =
     this->updateResultForQueryMapR(queryMap, r, tupleOfArgs, std::move(result));
@@ -328,6 +360,10 @@ Context::queryEnd(
 
   endQueryHandleDependency(ret);
 
+  if (queryTimingEnabled) {
+    queryTimingEnd(ret, queryEndStartNs);
+  }
+
   return ret->result;
 }
 
@@ -390,6 +426,8 @@ Context::updateResultForQuery(
                 ResultType result,
                 const char* traceQueryName,
                 bool isInputQuery) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+
   // Look up the map entry for this query name
   QueryMap<ResultType, ArgTs...>* queryMap =
     getMap(queryFunction, tupleOfArgs, traceQueryName, isInputQuery);
@@ -406,6 +444,8 @@ Context::hasResultForQuery(
      const std::tuple<ArgTs...>& tupleOfArgs,
      const char* traceQueryName) {
 
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+
   // Look up the map entry for this query name
   const void* queryFuncV = (const void*) queryFunction;
   // Look up the map entry for this query
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CHPL_UAST_ASTALLOCATOR_H
+#define CHPL_UAST_ASTALLOCATOR_H
+
+#include <cstddef>
+
+namespace chpl {
+namespace uast {
+namespace detail {
+
+
+/**
+  uAST nodes and the lists of their children are allocated from large
+  chunks of memory with a bump pointer. Each thread allocates from its own
+  chunk, so the nodes built while parsing a file end up next to each other
+  in memory, in the order the parser created them (which is close to a
+  postorder traversal). That makes traversals of the uAST mostly scan
+  memory linearly rather than chasing pointers around the heap.
+
+  Memory is not reused when a node is freed. Instead, each chunk counts
+  the allocations in it that are still live and the chunk is released
+  once they have all been freed. Since the uAST for a file is generally
+  freed all at once, this does not waste much memory.
+
+  Allocations larger than a fraction of the chunk size use the regular
+  heap, so the size passed to deallocateAST must match the size passed
+  to allocateAST.
+
+  Both functions can be called from any thread, and memory can be freed
+  on a different thread from the one that allocated it.
+ */
+void* allocateAST(size_t size);
+
+/**
+  Free memory allocated by allocateAST.
+ */
+void deallocateAST(void* ptr, size_t size);
+
+/**
+  Return the number of chunks currently in use by allocateAST.
+  This is intended for testing and measurement.
+ */
+size_t numASTChunksInUse();
+
+/**
+  A C++ allocator that uses allocateAST. It is used for ASTList so
+  that the list of a node's children is near the nodes themselves.
+ */
+template<typename T>
+struct ASTListAllocator {
+  using value_type = T;
+
+  ASTListAllocator() = default;
+  template<typename U>
+  ASTListAllocator(const ASTListAllocator<U>& other) { }
+
+  T* allocate(size_t n) {
+    return (T*) allocateAST(n * sizeof(T));
+  }
+  void deallocate(T* ptr, size_t n) {
+    deallocateAST(ptr, n * sizeof(T));
+  }
+
+  template<typename U>
+  bool operator==(const ASTListAllocator<U>& other) const {
+    return true;
+  }
+  template<typename U>
+  bool operator!=(const ASTListAllocator<U>& other) const {
+    return false;
+  }
+};
+
+
+} // end namespace detail
+} // end namespace uast
+} // end namespace chpl
+
+#endif
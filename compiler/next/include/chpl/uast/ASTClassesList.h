@@ -55,6 +55,7 @@ AST_BEGIN_SUBCLASSES(Expression)       // old AST: Expr
     AST_NODE(Local)                    //
     AST_NODE(On)                       //
     AST_NODE(Serial)                   //
+    AST_NODE(Sync)                     //
   AST_END_SUBCLASSES(SimpleBlockLike)
 
   AST_NODE(As)                         //
@@ -74,7 +75,6 @@ AST_BEGIN_SUBCLASSES(Expression)       // old AST: Expr
   //AST_NODE(Require)                    //
   AST_NODE(Return)                   //
   //AST_NODE(Select)                   //
-  AST_NODE(Sync)                     //
   //AST_NODE(TryCatch)                 // old AST: TryStmt/CatchStmt
   AST_NODE(Use)                        // old AST: UseStmt
   AST_NODE(UseClause)                  //
@@ -20,6 +20,7 @@
 #ifndef CHPL_UAST_ASTLIST_H
 #define CHPL_UAST_ASTLIST_H
 
+#include "chpl/uast/ASTAllocator.h"
 #include "chpl/uast/ASTTypes.h"
 #include "chpl/util/memory.h"
 
@@ -34,8 +35,10 @@ namespace uast {
 
 /**
   ASTList is just a list that owns some AST nodes.
+  Its storage is allocated near the AST nodes (see allocateAST).
  */
-using ASTList = std::vector<owned<ASTNode>>;
+using ASTList = std::vector<owned<ASTNode>,
+                            detail::ASTListAllocator<owned<ASTNode>>>;
 
 /**
   Create an ASTList containing a single ast element, transferring
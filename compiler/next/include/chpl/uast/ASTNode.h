@@ -91,6 +91,16 @@ class ASTNode {
  public:
   virtual ~ASTNode() = 0; // this is an abstract base class
 
+  /// \cond DO_NOT_DOCUMENT
+  // AST nodes are allocated with allocateAST for better locality
+  static void* operator new(size_t size) {
+    return detail::allocateAST(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    detail::deallocateAST(ptr, size);
+  }
+  /// \endcond
+
   /**
     Returns the tag indicating which ASTNode subclass this is.
    */
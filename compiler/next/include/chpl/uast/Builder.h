@@ -21,11 +21,13 @@
 #define CHPL_UAST_BUILDER_H
 
 #include "chpl/queries/ErrorMessage.h"
+#include "chpl/queries/IdTable.h"
 #include "chpl/queries/UniqueString.h"
 #include "chpl/queries/mark-functions.h"
 #include "chpl/queries/update-functions.h"
 #include "chpl/uast/ASTNode.h"
 
+#include <string>
 #include <vector>
 #include <unordered_map>
 #include <utility>
@@ -55,13 +57,14 @@ class Builder final {
 
   // note: notedLocations_ might have keys pointing to deleted uAST
   // nodes in the event one is created temporarily during parsing.
-  // These are removed in the astToLocation_ map.
+  // These are removed in the idToLocation_ and commentToLocation_ maps.
   std::unordered_map<const ASTNode*, Location> notedLocations_;
 
   // the following maps are computed during assignIDs
-  std::unordered_map<const ASTNode*, Location> astToLocation_;
-  std::unordered_map<ID, const ASTNode*> idToAst_;
-  std::unordered_map<ID, ID> idToParent_;
+  IdTable<Location> idToLocation_;
+  std::unordered_map<const ASTNode*, Location> commentToLocation_;
+  IdTable<const ASTNode*> idToAst_;
+  IdTable<ID> idToParent_;
 
   Builder(Context* context, UniqueString filepath)
     : context_(context), filepath_(filepath)
@@ -103,13 +106,16 @@ class Builder final {
     std::vector<ErrorMessage> errors;
 
     // Given an ID, what is the ASTNode?
-    std::unordered_map<ID, const ASTNode*> idToAst;
+    IdTable<const ASTNode*> idToAst;
 
     // Given an ID, what is the parent ID?
-    std::unordered_map<ID, ID> idToParentId;
+    IdTable<ID> idToParentId;
 
-    // Goes from ASTNode* to Location because Comments don't have AST IDs
-    std::unordered_map<const ASTNode*, Location> astToLocation;
+    // Given an ID, what is the Location?
+    IdTable<Location> idToLocation;
+
+    // Comments don't have AST IDs, so their Locations are stored here
+    std::unordered_map<const ASTNode*, Location> commentToLocation;
 
     Result();
     Result(Result&&) = default; // move-constructable
@@ -121,6 +127,26 @@ class Builder final {
     static bool update(Result& keep, Result& addin);
     static void mark(Context* context, const Result& keep);
     static void updateFilePaths(Context* context, const Result& keep);
+
+    /**
+      Append a compact binary encoding of the uAST and Locations
+      in this Result to 'out'. The errors are not included, so
+      this should only be used for a Result without errors.
+
+      The encoding depends on the uAST classes, so it should only be
+      read back by the same version of the compiler library.
+     */
+    void serialize(std::string& out) const;
+
+    /**
+      Rebuild a Result from 'len' bytes at 'data' that were produced
+      by serialize. IDs are assigned in the same way as when the
+      original Result was built. Returns false if the data could not
+      be decoded, in which case 'out' is not modified.
+     */
+    static bool deserialize(Context* context, UniqueString filePath,
+                            const char* data, size_t len,
+                            Result& out);
   };
 
   /**
@@ -0,0 +1,45 @@
+# Copyright 2021 Hewlett Packard Enterprise Development LP
+# Other additional copyright holders may be indicated within.
+#
+# The entirety of this work is licensed under the Apache License,
+# Version 2.0 (the "License"); you may not use this file except
+# in compliance with the License.
+#
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Computes a hash of the files that determine the format of the
+# serialized uAST stored in the persistent parse cache and writes it
+# to OUTPUT as a C header. This way, a compiler built from changed
+# uAST classes or serialization code does not load cache entries
+# written by a different build.
+#
+# Invoked with cmake -P with SCHEMA_FILES (a list) and OUTPUT set.
+
+set(combined "")
+foreach(f IN LISTS SCHEMA_FILES)
+  file(SHA256 ${f} fileHash)
+  get_filename_component(name ${f} NAME)
+  string(APPEND combined "${name} ${fileHash}\n")
+endforeach()
+string(SHA256 schemaHash "${combined}")
+string(SUBSTRING ${schemaHash} 0 16 schemaHash)
+
+set(contents "// generated by parse-cache-schema.cmake -- do not edit\n")
+string(APPEND contents "#define CHPL_PARSE_CACHE_SCHEMA_HASH \"${schemaHash}\"\n")
+
+# Only write the file if it changed, to avoid needless rebuilds
+set(old "")
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} old)
+endif()
+if(NOT old STREQUAL contents)
+  file(WRITE ${OUTPUT} "${contents}")
+endif()
@@ -25,10 +25,13 @@
 #include "chpl/uast/ASTNode.h"
 #include "chpl/uast/Identifier.h"
 #include "chpl/uast/Module.h"
+#include "chpl/util/hash.h"
 
 #include "../util/filesystem.h"
+#include "parse-cache-schema.h"
 
 #include <cstdio>
+#include <cstring>
 #include <set>
 #include <string>
 #include <tuple>
@@ -36,6 +39,9 @@
 #include <utility>
 #include <vector>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace chpl {
 
 template<> struct update<parsing::FileContents> {
@@ -78,6 +84,143 @@ void setFileText(Context* context, UniqueString path, std::string text) {
   setFileText(context, path, FileContents(std::move(text)));
 }
 
+// The persistent parse cache (see Context::setPersistentCacheDirectory)
+// stores the serialized uAST for a file in the cache directory.
+// Each cache file starts with a header and then records the key
+// (the file path, the compiler version, and a hash of the uAST
+// serialization schema) and the serialized uAST.
+// Everything the stored uAST depends on is checked when loading it,
+// so a stale or corrupted cache file is ignored.
+//
+// CHPL_PARSE_CACHE_SCHEMA_HASH is computed at build time from the uAST
+// headers and sources (see parse-cache-schema.cmake), so a rebuilt
+// compiler with different uAST classes does not load old entries
+// even if the compiler version is the same.
+
+// Update this when the format of the cache file header changes.
+static const uint64_t PARSE_CACHE_FORMAT_VERSION = 1;
+
+struct ParseCacheHeader {
+  char magic[8];
+  uint64_t formatVersion;
+  uint64_t textHash;
+  uint64_t textLength;
+  uint64_t keyLength;
+  uint64_t payloadHash;
+  uint64_t payloadLength;
+};
+
+static const char PARSE_CACHE_MAGIC[8] = {'C','H','P','L','U','A','S','T'};
+
+static uint64_t hashBytes(const char* data, size_t len) {
+  // FNV-1a, as in chpl::hash for strings
+  uint64_t seed = FNV_offset_basis;
+  for (size_t i = 0; i < len; i++) {
+    seed = (seed ^ (unsigned char) data[i]) * FNV_prime;
+  }
+  return seed;
+}
+
+static std::string parseCacheKey(Context* context, UniqueString path) {
+  std::string key = path.c_str();
+  key.push_back('\0');
+  key += context->persistentCacheVersion();
+  key.push_back('\0');
+  key += CHPL_PARSE_CACHE_SCHEMA_HASH;
+  return key;
+}
+
+static std::string parseCacheFilePath(Context* context,
+                                      const std::string& key,
+                                      uint64_t textHash) {
+  char buf[64];
+  uint64_t keyHash = hashBytes(key.data(), key.size());
+  snprintf(buf, sizeof(buf), "/%016llx%016llx.uast",
+           (unsigned long long) keyHash, (unsigned long long) textHash);
+  return context->persistentCacheDirectory() + buf;
+}
+
+// Returns true and sets 'result' if the cache had a usable entry
+static bool loadCachedParse(Context* context, UniqueString path,
+                            const std::string& text,
+                            uast::Builder::Result& result) {
+  uint64_t textHash = hashBytes(text.data(), text.size());
+  std::string key = parseCacheKey(context, path);
+  std::string cachePath = parseCacheFilePath(context, key, textHash);
+
+  const char* data = nullptr;
+  size_t len = 0;
+  ErrorMessage ignored;
+  if (!mapfile(cachePath.c_str(), data, len, ignored)) {
+    return false;
+  }
+
+  bool ok = false;
+  ParseCacheHeader header;
+  if (len >= sizeof(header)) {
+    memcpy(&header, data, sizeof(header));
+    const char* keyData = data + sizeof(header);
+    const char* payload = keyData + header.keyLength;
+    size_t avail = len - sizeof(header);
+    ok = memcmp(header.magic, PARSE_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+         header.formatVersion == PARSE_CACHE_FORMAT_VERSION &&
+         header.textHash == textHash &&
+         header.textLength == text.size() &&
+         header.keyLength == key.size() &&
+         header.keyLength <= avail &&
+         header.payloadLength == avail - header.keyLength &&
+         memcmp(keyData, key.data(), key.size()) == 0 &&
+         header.payloadHash == hashBytes(payload, header.payloadLength);
+    if (ok) {
+      ok = uast::Builder::Result::deserialize(context, path, payload,
+                                              header.payloadLength,
+                                              result);
+    }
+  }
+
+  unmapfile(data, len);
+  return ok;
+}
+
+static void storeCachedParse(Context* context, UniqueString path,
+                             const std::string& text,
+                             const uast::Builder::Result& result) {
+  const std::string& dir = context->persistentCacheDirectory();
+  // create the cache directory if it does not exist yet
+  mkdir(dir.c_str(), 0755);
+
+  std::string key = parseCacheKey(context, path);
+  std::string payload;
+  result.serialize(payload);
+
+  ParseCacheHeader header;
+  memcpy(header.magic, PARSE_CACHE_MAGIC, sizeof(header.magic));
+  header.formatVersion = PARSE_CACHE_FORMAT_VERSION;
+  header.textHash = hashBytes(text.data(), text.size());
+  header.textLength = text.size();
+  header.keyLength = key.size();
+  header.payloadHash = hashBytes(payload.data(), payload.size());
+  header.payloadLength = payload.size();
+
+  // Write to a temporary file and then rename it so that other
+  // compiler processes never see a partially written cache file.
+  std::string cachePath = parseCacheFilePath(context, key, header.textHash);
+  std::string tmpPath = cachePath + ".tmp" + std::to_string(getpid());
+
+  ErrorMessage ignored;
+  FILE* fp = openfile(tmpPath.c_str(), "wb", ignored);
+  if (fp == nullptr) {
+    return;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            fwrite(key.data(), 1, key.size(), fp) == key.size() &&
+            fwrite(payload.data(), 1, payload.size(), fp) == payload.size();
+  ok = closefile(fp, tmpPath.c_str(), ignored) && ok;
+  if (!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+    remove(tmpPath.c_str());
+  }
+}
+
 const uast::Builder::Result& parseFile(Context* context, UniqueString path) {
   QUERY_BEGIN(parseFile, context, path);
 
@@ -89,12 +232,22 @@ const uast::Builder::Result& parseFile(Context* context, UniqueString path) {
   result.filePath = path;
 
   if (error.isEmpty()) {
-    // if there was no error reading the file, proceed to parse
-    auto parser = Parser::build(context);
-    const char* pathc = path.c_str();
-    const char* textc = text.c_str();
-    uast::Builder::Result tmpResult = parser->parseString(pathc, textc);
-    result.swap(tmpResult);
+    bool useCache = !context->persistentCacheDirectory().empty();
+    if (useCache && loadCachedParse(context, path, text, result)) {
+      // the result was loaded from the persistent cache
+    } else {
+      // if there was no error reading the file, proceed to parse
+      auto parser = Parser::build(context);
+      const char* pathc = path.c_str();
+      const char* textc = text.c_str();
+      uast::Builder::Result tmpResult = parser->parseString(pathc, textc);
+      result.swap(tmpResult);
+      // only results without errors are cached so that the
+      // errors are reported again when the file is compiled again
+      if (useCache && result.errors.empty()) {
+        storeCachedParse(context, path, text, result);
+      }
+    }
     // raise any errors encountered
     for (const ErrorMessage& e : result.errors) {
       context->error(e);
@@ -120,22 +273,9 @@ const Location& locateId(Context* context, ID id) {
 
   Location result(path);
 
-  const uast::ASTNode* ast = nullptr;
-
-  // Look in idToAST
-  {
-    auto search = p.idToAst.find(id);
-    if (search != p.idToAst.end()) {
-      ast = search->second;
-    }
-  }
-
-  if (ast != nullptr) {
-    // Look in astToLocation
-    auto search = p.astToLocation.find(ast);
-    if (search != p.astToLocation.end()) {
-      result = search->second;
-    }
+  // Look in idToLocation
+  if (const Location* loc = p.idToLocation.find(id)) {
+    result = *loc;
   }
 
   return QUERY_END(result);
@@ -186,7 +326,7 @@ static const Module* const& getToplevelModuleQuery(Context* context,
     }
   } else {
     // TODO: if we don't have a module read yet, read one.
-    assert(false && "TODO");
+    // For now, only modules in files that were already parsed are found.
   }
 
   return QUERY_END(result);
@@ -205,13 +345,8 @@ static const ASTNode* const& astForIDQuery(Context* context, ID id) {
   // Get the result of parsing
   const uast::Builder::Result& p = parseFile(context, path);
 
-  const uast::ASTNode* result = nullptr;
-
   // Look in idToAST
-  auto search = p.idToAst.find(id);
-  if (search != p.idToAst.end()) {
-    result = search->second;
-  }
+  const uast::ASTNode* result = p.idToAst.get(id);
 
   return QUERY_END(result);
 }
@@ -234,13 +369,8 @@ const ID& idToParentId(Context* context, ID id) {
   // Get the result of parsing
   const uast::Builder::Result& p = parseFile(context, path);
 
-  ID result;
-
-  // Look in idToAST
-  auto search = p.idToParentId.find(id);
-  if (search != p.idToParentId.end()) {
-    result = search->second;
-  }
+  // Look in idToParentId
+  ID result = p.idToParentId.get(id);
 
   return QUERY_END(result);
 }
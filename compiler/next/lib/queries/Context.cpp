@@ -22,17 +22,23 @@
 #include "chpl/queries/query-impl.h"
 #include "chpl/parsing/parsing-queries.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdlib>
+#include <map>
 
-#include "../util/my_aligned_alloc.h" // assumes size_t defined
+#include "../util/filesystem.h"
 
 namespace chpl {
 
 using namespace chpl::querydetail;
 
+thread_local const Context* Context::workerContext = nullptr;
+thread_local Context::QueryStackType* Context::workerQueryStack = nullptr;
+
 static void defaultReportErrorPrintDetail(const ErrorMessage& err,
                                           const char* prefix,
                                           const char* kind) {
@@ -61,71 +67,53 @@ void Context::defaultReportError(const ErrorMessage& err) {
 }
 
 Context::~Context() {
-  // free all of the unique'd strings
-  for (auto& item: uniqueStringsTable)
-    free(item.second);
-}
-
-#define ALIGN_DN(i, size)  ((i) & ~((size) - 1))
-#define ALIGN_UP(i, size)  ALIGN_DN((i) + (size) - 1, size)
-
-static char* allocateEvenAligned(size_t amt) {
-  char* buf = (char*) malloc(amt);
-  // Normally, malloc returns something that is aligned to 16 bytes,
-  // but it's technically possible that a platform library
-  // could not do so. So, here we check.
-  // We only need even alignment here.
-  if ((((uintptr_t)buf) & 1) != 0) {
-    free(buf);
-    // try again with an aligned allocation
-    size_t alignment = sizeof(void *);
-    size_t align_up_len = ALIGN_UP(amt, sizeof(void*));
-    buf = (char*) my_aligned_alloc(alignment, align_up_len);
-  }
-  assert(buf);
-  assert((((uintptr_t)buf) & 1) == 0);
-  return buf;
-}
-
-const char* Context::getOrCreateUniqueString(const char* str) {
-  auto search = this->uniqueStringsTable.find(str);
-  if (search != this->uniqueStringsTable.end()) {
-    char* buf = search->second;
-    const char* key = buf+2; // pass the 2 bytes of metadata
-    // update the GC mark
-    this->markUniqueCString(key);
-    return key;
+  // write the query timing report, if requested
+  if (queryTimingEnabled && !queryTimingReportPath.empty()) {
+    const char* path = queryTimingReportPath.c_str();
+    ErrorMessage error;
+    FILE* fp = openfile(path, "w", error);
+    if (fp != nullptr) {
+      writeQueryTimingReport(fp, (QueryTimingFormat) queryTimingReportFormat);
+      closefile(fp, path, error);
+    }
+    if (!error.isEmpty()) {
+      reportError(error);
+    }
   }
+}
+
+const char* Context::getOrCreateUniqueString(const char* str, size_t len) {
+  size_t hash = detail::UniqueStringsTable::hash(str, len);
   char gcMark = this->gcCounter & 0xff;
-  size_t strLen = strlen(str);
-  size_t allocLen = strLen+3; // 2 bytes of metadata, str data, '\0'
-  char* buf = allocateEvenAligned(allocLen);
-  // set the GC mark
-  buf[0] = gcMark;
-  // set the unused metadata (need to still have even alignment)
-  buf[1] = 0x02;
-  // copy the string data, including the null terminator
-  memcpy(buf+2, str, strLen+1);
-  const char* key = buf+2; // pass the 2 bytes of metadata
-  // Add it to the table
-  this->uniqueStringsTable.insert(search, {key, buf});
+  const char* key = uniqueStringsTable.getOrCreate(str, len, hash, gcMark);
+  // update the GC mark
+  this->markUniqueCString(key);
   return key;
 }
 
 const char* Context::uniqueCString(const char* s) {
   if (s == nullptr) s = "";
-  return this->getOrCreateUniqueString(s);
+  return this->getOrCreateUniqueString(s, strlen(s));
+}
+
+const char* Context::uniqueCString(const char* s, size_t len) {
+  if (s == nullptr) return this->uniqueCString(s);
+  return this->getOrCreateUniqueString(s, len);
 }
 
 void Context::markUniqueCString(const char* s) {
-  // Performance: Would it be better to do this store unconditionally?
   if (this->currentRevisionNumber == this->lastPrepareToGCRevisionNumber &&
       s != nullptr) {
     char gcMark = this->gcCounter & 0xff;
     char* buf = (char*) s;
     buf -= 2; // the string is preceeded by gcMark and 0x02
     assert(buf[1] == 0x02);
-    buf[0] = gcMark;
+    // Strings can be marked by multiple threads at once, so use atomic
+    // accesses, and only store if needed to avoid writing to shared
+    // cache lines.
+    if (__atomic_load_n(buf, __ATOMIC_RELAXED) != gcMark) {
+      __atomic_store_n(buf, gcMark, __ATOMIC_RELAXED);
+    }
   }
 }
 
@@ -239,42 +227,295 @@ void Context::collectGarbage() {
   if (this->lastPrepareToGCRevisionNumber == this->currentRevisionNumber) {
     // remove UniqueStrings that have not been marked
 
-    size_t nUniqueStringsBefore = uniqueStringsTable.size();
-
-    // Performance: Would it be better to modify the table in-place
-    // rather than creating a new table as is done here?
     char gcMark = this->gcCounter & 0xff;
-    UniqueStringsTableType newTable;
-    std::vector<char*> toFree;
-    // warning: this loop proceeds in a nondeterministic order
-    for (auto& e: uniqueStringsTable) {
-      const char* key = e.first;
-      char* buf = e.second;
-      if (buf[0] == gcMark) {
-        newTable.insert(std::make_pair(key, buf));
-        if (enableDebugTracing) {
-          printf("COPYING OVER UNIQUESTRING %s\n", key);
-        }
+    size_t nCollected = uniqueStringsTable.collectGarbage(gcMark,
+                                                          enableDebugTracing);
+
+    if (enableDebugTracing) {
+      printf("COLLECTED %i UniqueStrings\n", (int)nCollected);
+    }
+  }
+}
+
+void Context::runInParallel(size_t nTasks,
+                            const std::function<void(size_t)>& body) {
+  size_t nThreads = numThreads;
+  if (numThreads <= 0) {
+    nThreads = std::thread::hardware_concurrency();
+  }
+  nThreads = std::min(nThreads, nTasks);
+
+  // Run serially if only one thread is requested or if this
+  // is a nested call to runInParallel.
+  if (nThreads <= 1 || runningInParallel) {
+    for (size_t i = 0; i < nTasks; i++) {
+      body(i);
+    }
+    return;
+  }
+
+  if (enableDebugTracing) {
+    printf("RUNNING %i TASKS ON %i THREADS\n", (int) nTasks, (int) nThreads);
+  }
+
+  // Each worker starts with a copy of the current query stack
+  // so that queries it runs are recorded as dependencies of the
+  // current query (if any) and so that recursion is detected.
+  const QueryStackType parentStack = currentQueryStack();
+  std::atomic<size_t> nextTask(0);
+
+  auto worker = [this, nTasks, &body, &parentStack, &nextTask]() {
+    QueryStackType stack = parentStack;
+    const Context* savedContext = workerContext;
+    QueryStackType* savedStack = workerQueryStack;
+    workerContext = this;
+    workerQueryStack = &stack;
+    // time in queries run by the workers is not counted
+    // as child time for the calling query
+    QueryTimingStackType savedTimingStack;
+    {
+      ContextLockGuard guard(bookkeepingLock, true);
+      savedTimingStack.swap(currentTimingStack());
+    }
+
+    while (true) {
+      size_t i = nextTask.fetch_add(1);
+      if (i >= nTasks) break;
+      body(i);
+      assert(stack.size() == parentStack.size());
+    }
+
+    workerContext = savedContext;
+    workerQueryStack = savedStack;
+    {
+      ContextLockGuard guard(bookkeepingLock, true);
+      if (savedTimingStack.empty()) {
+        timingStacks.erase(std::this_thread::get_id());
       } else {
-        toFree.push_back(buf);
-        if (enableDebugTracing) {
-          printf("WILL FREE UNIQUESTRING %s\n", key);
-        }
+        currentTimingStack().swap(savedTimingStack);
       }
     }
-    for (char* buf: toFree) {
-      free(buf);
+  };
+
+  runningInParallel = true;
+
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < nThreads; t++) {
+    threads.emplace_back(worker);
+  }
+  // the calling thread also runs tasks
+  worker();
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  runningInParallel = false;
+  assert(waitingFor.empty());
+}
+
+void Context::enableQueryTiming(std::string reportPath,
+                                QueryTimingFormat format) {
+  queryTimingEnabled = true;
+  queryTimingReportPath = std::move(reportPath);
+  queryTimingReportFormat = format;
+}
+
+// Escape a string for use within a JSON string literal
+static std::string escapeStringForJson(const char* s) {
+  std::string ret;
+  for (const char* p = s; *p != '\0'; p++) {
+    unsigned char c = *p;
+    if (c == '"' || c == '\\') {
+      ret.push_back('\\');
+      ret.push_back(c);
+    } else if (c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned) c);
+      ret += buf;
+    } else {
+      ret.push_back(c);
     }
-    uniqueStringsTable.swap(newTable);
+  }
+  return ret;
+}
 
-    if (enableDebugTracing) {
-      size_t nUniqueStringsAfter = uniqueStringsTable.size();
-      printf("COLLECTED %i UniqueStrings\n",
-             (int)(nUniqueStringsBefore-nUniqueStringsAfter));
+void Context::writeQueryTimingReport(FILE* fp, QueryTimingFormat format) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+
+  if (format == QUERY_TIMING_FOLDED) {
+    // Build the string for each stack from the tree of stacks.
+    // Since the parent of a node is always created before it,
+    // the strings can be built in order.
+    std::vector<std::string> names(queryTimingNodes.size());
+    std::map<std::string, int64_t> stacks;
+    for (size_t i = 0; i < queryTimingNodes.size(); i++) {
+      const QueryTimingStackNode& node = queryTimingNodes[i];
+      if (node.parent >= 0) {
+        names[i] = names[node.parent] + ";";
+      }
+      names[i] += node.queryName;
+      if (node.selfNs > 0) {
+        stacks[names[i]] += node.selfNs;
+      }
+      if (node.contextNs > 0) {
+        stacks[names[i] + ";[Context]"] += node.contextNs;
+      }
+    }
+    // the map is sorted so that the output is deterministic
+    for (const auto& elt : stacks) {
+      // folded stacks use integer sample counts; use microseconds
+      fprintf(fp, "%s %lld\n", elt.first.c_str(),
+              (long long) (elt.second / 1000));
+    }
+    return;
+  }
+
+  // Otherwise, write JSON, with the most expensive queries first
+  std::vector<std::pair<const char*, const QueryTimingStats*>> stats;
+  forEachQueryTimingStats([&stats](const char* name,
+                                   const QueryTimingStats& t) {
+    stats.push_back(std::make_pair(name, &t));
+  });
+  std::sort(stats.begin(), stats.end(),
+            [](const std::pair<const char*, const QueryTimingStats*>& a,
+               const std::pair<const char*, const QueryTimingStats*>& b) {
+              if (a.second->totalNs != b.second->totalNs)
+                return a.second->totalNs > b.second->totalNs;
+              return strcmp(a.first, b.first) < 0;
+            });
+
+  fprintf(fp, "{\n  \"queries\": [");
+  bool first = true;
+  for (const auto& elt : stats) {
+    const QueryTimingStats& t = *elt.second;
+    fprintf(fp, "%s\n    {\"name\": \"%s\", \"calls\": %lld, "
+                "\"reused\": %lld, \"computed\": %lld, "
+                "\"recomputed\": %lld, \"totalNs\": %lld, "
+                "\"contextNs\": %lld, \"childNs\": %lld, "
+                "\"selfNs\": %lld}",
+            first?"":",",
+            escapeStringForJson(elt.first).c_str(),
+            (long long) t.nCalls(),
+            (long long) t.nReused,
+            (long long) t.nComputed,
+            (long long) t.nRecomputed,
+            (long long) t.totalNs,
+            (long long) t.contextNs,
+            (long long) t.childNs,
+            (long long) t.selfNs());
+    first = false;
+  }
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+void Context::forEachQueryTimingStats(
+    const std::function<void(const char*, const QueryTimingStats&)>& f) {
+  for (const auto& dbEntry : queryDB) {
+    const QueryMapBase* queryMap = dbEntry.second.get();
+    if (queryMap->timing.nCalls() > 0) {
+      f(queryMap->queryName, queryMap->timing);
     }
   }
 }
 
+void Context::queryTimingBegin(const char* traceQueryName) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+  QueryTimingStackType& timingStack = currentTimingStack();
+
+  QueryTimingFrame frame;
+  frame.queryName = traceQueryName;
+
+  // find or create the node for the stack ending in this query
+  int parent = timingStack.empty() ? -1 : timingStack.back().stackNode;
+  auto key = std::make_pair(parent, traceQueryName);
+  auto search = queryTimingNodeIds.find(key);
+  if (search != queryTimingNodeIds.end()) {
+    frame.stackNode = search->second;
+  } else {
+    QueryTimingStackNode node;
+    node.queryName = traceQueryName;
+    node.parent = parent;
+    frame.stackNode = (int) queryTimingNodes.size();
+    queryTimingNodes.push_back(node);
+    queryTimingNodeIds.emplace(key, frame.stackNode);
+  }
+
+  frame.startNs = queryTimingNowNs();
+  timingStack.push_back(frame);
+}
+
+void Context::queryTimingBeginDone(const QueryMapResultBase* r,
+                                   bool useSaved) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+  QueryTimingStackType& timingStack = currentTimingStack();
+  // If timing was enabled while this query was running,
+  // there is no frame for it. Any frames for queries it called
+  // have been popped, so the stack is empty in that case.
+  if (timingStack.empty()) return;
+  QueryTimingFrame& frame = timingStack.back();
+
+  // The time so far, other than checking dependencies by running
+  // other queries, is spent in the Context.
+  int64_t now = queryTimingNowNs();
+  frame.contextNs += (now - frame.startNs) - frame.childNs;
+  frame.queryMap = r->parentQueryMap;
+
+  QueryTimingStats& t = r->parentQueryMap->timing;
+  if (useSaved) {
+    t.nReused++;
+  } else if (r->lastChanged == -1) {
+    t.nComputed++;
+  } else {
+    t.nRecomputed++;
+  }
+}
+
+void Context::queryTimingEnd(const QueryMapResultBase* r,
+                             int64_t queryEndStartNs) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+  QueryTimingStackType& timingStack = currentTimingStack();
+  // as above, there is no frame if timing was enabled during the query
+  if (timingStack.empty()) return;
+  QueryTimingFrame frame = timingStack.back();
+  timingStack.pop_back();
+  assert(frame.queryMap == r->parentQueryMap);
+
+  int64_t now = queryTimingNowNs();
+  frame.contextNs += now - queryEndStartNs;
+  int64_t totalNs = now - frame.startNs;
+  int64_t selfNs = totalNs - frame.contextNs - frame.childNs;
+
+  // Only count the time for the outermost instance of a query, so that
+  // the time for queries that (indirectly) call themselves is not counted
+  // twice. The time for the inner instances is included in the
+  // childNs of the outermost one.
+  bool outermost = true;
+  for (const QueryTimingFrame& f : timingStack) {
+    if (f.queryMap == frame.queryMap) {
+      outermost = false;
+      break;
+    }
+  }
+
+  if (outermost) {
+    QueryTimingStats& t = r->parentQueryMap->timing;
+    t.totalNs += totalNs;
+    t.contextNs += frame.contextNs;
+    t.childNs += frame.childNs;
+  }
+
+  if (timingStack.size() > 0) {
+    timingStack.back().childNs += totalNs;
+  }
+
+  // record the self time and Context time for the stack of queries
+  QueryTimingStackNode& node = queryTimingNodes[frame.stackNode];
+  if (selfNs > 0) {
+    node.selfNs += selfNs;
+  }
+  node.contextNs += frame.contextNs;
+}
+
 void Context::setFilePathForModuleID(ID moduleID, UniqueString path) {
   UniqueString moduleIdSymbolPath = moduleID.symbolPath();
   auto tupleOfArgs = std::make_tuple(moduleIdSymbolPath);
@@ -292,12 +533,14 @@ void Context::setFilePathForModuleID(ID moduleID, UniqueString path) {
 }
 
 void Context::error(ErrorMessage error) {
-  if (queryStack.size() == 0) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+  QueryStackType& stack = currentQueryStack();
+  if (stack.size() == 0) {
     assert(false && "Context::error called with no running query");
     return;
   }
-  queryStack.back()->errors.push_back(std::move(error));
-  reportError(queryStack.back()->errors.back());
+  stack.back()->errors.push_back(std::move(error));
+  reportError(stack.back()->errors.back());
 }
 
 void Context::error(Location loc, const char* fmt, ...) {
@@ -330,63 +573,84 @@ void Context::error(const uast::ASTNode* ast, const char* fmt, ...) {
 }
 
 void Context::recomputeIfNeeded(const QueryMapResultBase* resultEntry) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
 
   if (enableDebugTracing) {
     printf("RECOMPUTING IF NEEDED FOR %p %s\n", resultEntry,
            resultEntry->parentQueryMap->queryName);
   }
 
-  if (this->currentRevisionNumber == resultEntry->lastChecked) {
-    // No need to check the dependencies again.
-    // We already know that we can reuse the result.
-    return;
-  }
+  // When running on multiple threads, the lock might be released
+  // while checking the dependencies (to wait for a query running
+  // on another thread). In that event, check again, since another
+  // thread might have updated this result in the meantime.
+  while (true) {
+    if (runningInParallel &&
+        resultEntry->runningThread != std::thread::id()) {
+      waitForRunningQuery(resultEntry);
+    }
 
-  if (resultEntry->parentQueryMap->isInputQuery) {
-    // For an input query, compute it once per revision, ignoring
-    // dependencies (e.g. if it is reading a file, we need to check that the
-    // file has not changed.)
-    resultEntry->recompute(this);
-    assert(resultEntry->lastChecked == this->currentRevisionNumber);
-    return;
-  }
+    if (this->currentRevisionNumber == resultEntry->lastChecked) {
+      // No need to check the dependencies again.
+      // We already know that we can reuse the result.
+      return;
+    }
 
-  // Otherwise, check the dependencies. Have any of them
-  // changed since the last revision in which we computed this?
-  // If so, compute it again.
-  bool useSaved = true;
-  for (const QueryMapResultBase* dependency : resultEntry->dependencies) {
-    if (dependency->lastChanged > resultEntry->lastChanged) {
-      useSaved = false;
-      break;
-    } else if (this->currentRevisionNumber == dependency->lastChecked) {
-      // No need to check the dependency again; already did and it was OK
-    } else {
-      recomputeIfNeeded(dependency);
-      // we might have recomputed the dependency, so check its lastChanged
+    if (resultEntry->parentQueryMap->isInputQuery) {
+      // For an input query, compute it once per revision, ignoring
+      // dependencies (e.g. if it is reading a file, we need to check that the
+      // file has not changed.)
+      resultEntry->recompute(this);
+      assert(resultEntry->lastChecked == this->currentRevisionNumber);
+      return;
+    }
+
+    uint64_t nWaits = bookkeepingLock.waitCount();
+
+    // Otherwise, check the dependencies. Have any of them
+    // changed since the last revision in which we computed this?
+    // If so, compute it again.
+    // Note: this loop uses an index since the dependencies could be
+    // recomputed by another thread while waiting.
+    bool useSaved = true;
+    for (size_t i = 0; i < resultEntry->dependencies.size(); i++) {
+      const QueryMapResultBase* dependency = resultEntry->dependencies[i];
       if (dependency->lastChanged > resultEntry->lastChanged) {
         useSaved = false;
         break;
+      } else if (this->currentRevisionNumber == dependency->lastChecked) {
+        // No need to check the dependency again; already did and it was OK
+      } else {
+        recomputeIfNeeded(dependency);
+        // we might have recomputed the dependency, so check its lastChanged
+        if (dependency->lastChanged > resultEntry->lastChanged) {
+          useSaved = false;
+          break;
+        }
       }
     }
-  }
 
-  if (useSaved == false) {
-    resultEntry->recompute(this);
-    assert(resultEntry->lastChecked == this->currentRevisionNumber);
-    if (enableDebugTracing) {
-      printf("DONE RECOMPUTING IF NEEDED -- RECOMPUTED FOR %s\n",
-             resultEntry->parentQueryMap->queryName);
+    if (runningInParallel && bookkeepingLock.waitCount() != nWaits) {
+      // Another thread might have handled this result; check it again.
+      continue;
     }
-    return;
-  } else {
-    updateForReuse(resultEntry);
-    if (enableDebugTracing) {
-      printf("DONE RECOMPUTING IF NEEDED -- REUSED FOR %s\n",
-             resultEntry->parentQueryMap->queryName);
+
+    if (useSaved == false) {
+      resultEntry->recompute(this);
+      assert(resultEntry->lastChecked == this->currentRevisionNumber);
+      if (enableDebugTracing) {
+        printf("DONE RECOMPUTING IF NEEDED -- RECOMPUTED FOR %s\n",
+               resultEntry->parentQueryMap->queryName);
+      }
+    } else {
+      updateForReuse(resultEntry);
+      if (enableDebugTracing) {
+        printf("DONE RECOMPUTING IF NEEDED -- REUSED FOR %s\n",
+               resultEntry->parentQueryMap->queryName);
+      }
     }
+    return;
   }
-
 }
 
 // this should be called once each revision the first time
@@ -412,42 +676,67 @@ void Context::updateForReuse(const QueryMapResultBase* resultEntry) {
 bool Context::queryCanUseSavedResultAndPushIfNot(
                    const void* queryFunction,
                    const QueryMapResultBase* resultEntry) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
 
   bool useSaved = false;
 
   assert(resultEntry != nullptr);
 
-  if (resultEntry->lastChanged == -1) {
-    // If it is a new entry, we can't reuse it
-    useSaved = false;
-  } else if (this->currentRevisionNumber == resultEntry->lastChecked) {
-    // the query was already checked/run in this revision
-    useSaved = true;
-  } else if (resultEntry->parentQueryMap->isInputQuery) {
-    // be sure to re-run input queries
-    useSaved = false;
-  } else {
-    useSaved = true;
-    for (const QueryMapResultBase* dependency : resultEntry->dependencies) {
-      recomputeIfNeeded(dependency);
-      assert(dependency->lastChecked == this->currentRevisionNumber);
-      if (dependency->lastChanged > resultEntry->lastChanged) {
-        useSaved = false;
-        break;
+  // As with recomputeIfNeeded, check again if the lock was released
+  // while checking the dependencies.
+  while (true) {
+    if (runningInParallel &&
+        resultEntry->runningThread != std::thread::id()) {
+      waitForRunningQuery(resultEntry);
+    }
+
+    uint64_t nWaits = bookkeepingLock.waitCount();
+    bool checkedDependencies = false;
+
+    if (resultEntry->lastChanged == -1) {
+      // If it is a new entry, we can't reuse it
+      useSaved = false;
+    } else if (this->currentRevisionNumber == resultEntry->lastChecked) {
+      // the query was already checked/run in this revision
+      useSaved = true;
+    } else if (resultEntry->parentQueryMap->isInputQuery) {
+      // be sure to re-run input queries
+      useSaved = false;
+    } else {
+      useSaved = true;
+      checkedDependencies = true;
+      for (size_t i = 0; i < resultEntry->dependencies.size(); i++) {
+        const QueryMapResultBase* dependency = resultEntry->dependencies[i];
+        recomputeIfNeeded(dependency);
+        assert(dependency->lastChecked == this->currentRevisionNumber);
+        if (dependency->lastChanged > resultEntry->lastChanged) {
+          useSaved = false;
+          break;
+        }
       }
     }
-    if (useSaved == true) {
+
+    if (runningInParallel && bookkeepingLock.waitCount() != nWaits) {
+      // Another thread might have handled this result; check it again.
+      continue;
+    }
+
+    if (checkedDependencies && useSaved == true) {
       updateForReuse(resultEntry);
     }
+    break;
   }
 
   if (useSaved == false) {
     // Since the result cannot be reused, the query will be evaluated.
     // So, push something to queryDeps
-    queryStack.push_back(resultEntry);
+    currentQueryStack().push_back(resultEntry);
     // Record that this query is being recomputed
     // (to enable detecting recursion)
     resultEntry->lastChecked = -1;
+    if (runningInParallel) {
+      resultEntry->runningThread = std::this_thread::get_id();
+    }
     // Clear out the dependencies and errors since these will be recomputed
     // by evaluating the query.
     resultEntry->dependencies.clear();
@@ -458,19 +747,28 @@ bool Context::queryCanUseSavedResultAndPushIfNot(
 }
 
 void Context::saveDependencyInParent(const QueryMapResultBase* resultEntry) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+  QueryStackType& stack = currentQueryStack();
+
   // Record that the parent query depends upon this one.
   //
   // We haven't pushed the query beginning yet; on already popped it.
   // So, the parent query is at queryDeps.back().
-  if (queryStack.size() > 0) {
-    assert(queryStack.back() != resultEntry); // should be parent query
-    queryStack.back()->dependencies.push_back(resultEntry);
+  if (stack.size() > 0) {
+    assert(stack.back() != resultEntry); // should be parent query
+    stack.back()->dependencies.push_back(resultEntry);
   }
 }
 void Context::endQueryHandleDependency(const QueryMapResultBase* resultEntry) {
+  ContextLockGuard guard(bookkeepingLock, runningInParallel);
+  QueryStackType& stack = currentQueryStack();
+
   // Remove the current query from the stack
-  assert(queryStack.back() == resultEntry);
-  queryStack.pop_back();
+  assert(stack.back() == resultEntry);
+  stack.pop_back();
+  // Any threads waiting for this query will be able to proceed
+  // once the lock is released.
+  resultEntry->runningThread = std::thread::id();
 
   // We've just the query represented by 'resultEntry'. If that query
   // was called from another query, we need to record that the calling
@@ -478,6 +776,49 @@ void Context::endQueryHandleDependency(const QueryMapResultBase* resultEntry) {
   saveDependencyInParent(resultEntry);
 }
 
+void Context::waitForRunningQuery(const QueryMapResultBase* r) {
+  QueryStackType& stack = currentQueryStack();
+
+  // Is the query running on this thread? Note that the stack might
+  // also include queries inherited from the caller of runInParallel.
+  if (std::find(stack.begin(), stack.end(), r) != stack.end()) {
+    haltForRecursiveQuery(r);
+  }
+
+  if (!runningInParallel || r->runningThread == std::thread::id()) {
+    // Not running on another thread, so it is OK to proceed.
+    return;
+  }
+
+  std::thread::id me = std::this_thread::get_id();
+
+  // Detect recursion through queries running on different threads:
+  // follow the chain of threads waiting for each other.
+  const QueryMapResultBase* cur = r;
+  for (size_t i = 0; i <= waitingFor.size(); i++) {
+    std::thread::id owner = cur->runningThread;
+    if (owner == me) {
+      haltForRecursiveQuery(r);
+    }
+    auto search = waitingFor.find(owner);
+    if (owner == std::thread::id() || search == waitingFor.end()) {
+      break;
+    }
+    cur = search->second;
+  }
+
+  if (enableDebugTracing) {
+    printf("WAITING FOR %p %s TO COMPLETE ON ANOTHER THREAD\n",
+           r, r->parentQueryMap->queryName);
+  }
+
+  waitingFor[me] = r;
+  bookkeepingLock.waitUntil([r] {
+    return r->runningThread == std::thread::id();
+  });
+  waitingFor.erase(me);
+}
+
 void Context::haltForRecursiveQuery(const querydetail::QueryMapResultBase* r) {
   // If an old element present has lastChecked == -1, that means that
   // we trying to compute it when a recursive call was made. In that event
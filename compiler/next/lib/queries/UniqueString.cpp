@@ -21,7 +21,11 @@
 
 #include "chpl/queries/Context.h"
 
+#include "../util/my_aligned_alloc.h" // assumes size_t defined
+
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 namespace chpl {
@@ -30,12 +34,204 @@ namespace detail {
 
 InlinedString InlinedString::buildUsingContextTable(Context* context,
                                                     const char* s, size_t len) {
-  const char* u = context->uniqueCString(s);
+  const char* u = context->uniqueCString(s, len);
   // assert that the address returned is even
   assert( (((uintptr_t)u)&1)==0 );
   return InlinedString::buildFromAligned(u, len);
 }
 
+#define ALIGN_DN(i, size)  ((i) & ~((size) - 1))
+#define ALIGN_UP(i, size)  ALIGN_DN((i) + (size) - 1, size)
+
+static char* allocateEvenAligned(size_t amt) {
+  char* buf = (char*) malloc(amt);
+  // Normally, malloc returns something that is aligned to 16 bytes,
+  // but it's technically possible that a platform library
+  // could not do so. So, here we check.
+  // We only need even alignment here.
+  if ((((uintptr_t)buf) & 1) != 0) {
+    free(buf);
+    // try again with an aligned allocation
+    size_t alignment = sizeof(void *);
+    size_t align_up_len = ALIGN_UP(amt, sizeof(void*));
+    buf = (char*) my_aligned_alloc(alignment, align_up_len);
+  }
+  assert(buf);
+  assert((((uintptr_t)buf) & 1) == 0);
+  return buf;
+}
+
+UniqueStringsTable::UniqueStringsTable() {
+  for (auto& shard : shards) {
+    shard.current.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+UniqueStringsTable::~UniqueStringsTable() {
+  for (auto& shard : shards) {
+    SlotArray* a = shard.current.load(std::memory_order_relaxed);
+    if (a != nullptr) {
+      for (size_t i = 0; i <= a->mask; i++) {
+        const char* str = a->slots[i].str.load(std::memory_order_relaxed);
+        if (str != nullptr) free((char*) str - 2);
+      }
+      freeSlots(a);
+    }
+    for (SlotArray* old : shard.retired) {
+      freeSlots(old);
+    }
+  }
+}
+
+UniqueStringsTable::SlotArray*
+UniqueStringsTable::allocateSlots(size_t nSlots) {
+  assert((nSlots & (nSlots - 1)) == 0);
+  SlotArray* a = new SlotArray;
+  a->mask = nSlots - 1;
+  a->slots = new Slot[nSlots];
+  for (size_t i = 0; i < nSlots; i++) {
+    a->slots[i].hash.store(0, std::memory_order_relaxed);
+    a->slots[i].len.store(0, std::memory_order_relaxed);
+    a->slots[i].str.store(nullptr, std::memory_order_relaxed);
+  }
+  return a;
+}
+
+void UniqueStringsTable::freeSlots(SlotArray* a) {
+  delete [] a->slots;
+  delete a;
+}
+
+const char* UniqueStringsTable::find(const SlotArray* a,
+                                     const char* s, size_t len, size_t hash) {
+  if (a == nullptr) return nullptr;
+
+  // The table is never full, so this will reach an empty slot.
+  for (size_t i = hash & a->mask; ; i = (i + 1) & a->mask) {
+    const char* str = a->slots[i].str.load(std::memory_order_acquire);
+    if (str == nullptr) {
+      return nullptr;
+    }
+    if (a->slots[i].hash.load(std::memory_order_relaxed) == hash &&
+        a->slots[i].len.load(std::memory_order_relaxed) == len &&
+        memcmp(str, s, len) == 0) {
+      return str;
+    }
+  }
+}
+
+void UniqueStringsTable::insert(SlotArray* a, const char* str, size_t len,
+                                size_t hash) {
+  size_t i = hash & a->mask;
+  while (a->slots[i].str.load(std::memory_order_relaxed) != nullptr) {
+    i = (i + 1) & a->mask;
+  }
+  a->slots[i].hash.store(hash, std::memory_order_relaxed);
+  a->slots[i].len.store(len, std::memory_order_relaxed);
+  // publish the string after its hash and length are visible
+  a->slots[i].str.store(str, std::memory_order_release);
+}
+
+const char* UniqueStringsTable::insertLocked(Shard& shard,
+                                             const char* s, size_t len,
+                                             size_t hash, char gcMark) {
+  std::lock_guard<std::mutex> guard(shard.lock);
+
+  // check again since another thread might have added it
+  SlotArray* a = shard.current.load(std::memory_order_relaxed);
+  if (const char* found = find(a, s, len, hash)) {
+    return found;
+  }
+
+  // grow the shard to keep it at most 3/4 full
+  size_t nSlots = (a == nullptr) ? 0 : a->mask + 1;
+  if (4*(shard.count + 1) > 3*nSlots) {
+    size_t newSlots = nSlots == 0 ? (size_t) MIN_SHARD_SLOTS : 2*nSlots;
+    SlotArray* grown = allocateSlots(newSlots);
+    for (size_t i = 0; i < nSlots; i++) {
+      const char* str = a->slots[i].str.load(std::memory_order_relaxed);
+      if (str != nullptr) {
+        insert(grown, str,
+               a->slots[i].len.load(std::memory_order_relaxed),
+               a->slots[i].hash.load(std::memory_order_relaxed));
+      }
+    }
+    shard.current.store(grown, std::memory_order_release);
+    // concurrent readers might still be using the old array
+    if (a != nullptr) shard.retired.push_back(a);
+    a = grown;
+  }
+
+  size_t allocLen = len+3; // 2 bytes of metadata, str data, '\0'
+  char* buf = allocateEvenAligned(allocLen);
+  // set the GC mark
+  buf[0] = gcMark;
+  // set the unused metadata (need to still have even alignment)
+  buf[1] = 0x02;
+  // copy the string data and add the null terminator
+  memcpy(buf+2, s, len);
+  buf[len+2] = '\0';
+  const char* key = buf+2; // pass the 2 bytes of metadata
+
+  insert(a, key, len, hash);
+  shard.count++;
+  return key;
+}
+
+size_t UniqueStringsTable::collectGarbage(char gcMark, bool trace) {
+  size_t nFreed = 0;
+  for (auto& shard : shards) {
+    for (SlotArray* old : shard.retired) {
+      freeSlots(old);
+    }
+    shard.retired.clear();
+
+    SlotArray* a = shard.current.load(std::memory_order_relaxed);
+    if (a == nullptr) continue;
+
+    // free the strings that have not been marked
+    std::vector<const Slot*> keep;
+    for (size_t i = 0; i <= a->mask; i++) {
+      const char* str = a->slots[i].str.load(std::memory_order_relaxed);
+      if (str == nullptr) continue;
+      if (str[-2] == gcMark) {
+        keep.push_back(&a->slots[i]);
+        if (trace) {
+          printf("COPYING OVER UNIQUESTRING %s\n", str);
+        }
+      } else {
+        if (trace) {
+          printf("WILL FREE UNIQUESTRING %s\n", str);
+        }
+        free((char*) str - 2);
+        nFreed++;
+      }
+    }
+
+    // rebuild the slots, shrinking the array if most strings were freed
+    size_t nSlots = MIN_SHARD_SLOTS;
+    while (4*keep.size() > 3*nSlots) nSlots *= 2;
+    SlotArray* rebuilt = allocateSlots(nSlots);
+    for (const Slot* slot : keep) {
+      insert(rebuilt, slot->str.load(std::memory_order_relaxed),
+             slot->len.load(std::memory_order_relaxed),
+             slot->hash.load(std::memory_order_relaxed));
+    }
+    freeSlots(a);
+    shard.current.store(rebuilt, std::memory_order_relaxed);
+    shard.count = keep.size();
+  }
+  return nFreed;
+}
+
+size_t UniqueStringsTable::size() const {
+  size_t ret = 0;
+  for (const auto& shard : shards) {
+    ret += shard.count;
+  }
+  return ret;
+}
+
 
 } // end namespace detail
 
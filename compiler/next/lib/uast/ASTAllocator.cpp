@@ -0,0 +1,128 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/uast/ASTAllocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace chpl {
+namespace uast {
+namespace detail {
+
+
+// Chunks are aligned to their size so that the chunk containing
+// an allocation can be computed from its address.
+static const size_t CHUNK_SIZE = 64*1024;
+static const size_t MAX_CHUNK_ALLOC_SIZE = CHUNK_SIZE / 16;
+static const size_t ALLOC_ALIGN = 16;
+
+struct ASTChunk {
+  // The number of live allocations in this chunk, plus one while
+  // a thread is still allocating from it.
+  std::atomic<size_t> refs;
+};
+
+static const size_t CHUNK_HEADER_SIZE =
+  (sizeof(ASTChunk) + ALLOC_ALIGN - 1) & ~(ALLOC_ALIGN - 1);
+
+static std::atomic<size_t> nChunksInUse(0);
+
+static void releaseChunk(ASTChunk* chunk) {
+  if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    chunk->~ASTChunk();
+    free(chunk);
+    nChunksInUse.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+namespace {
+  // the chunk the current thread is allocating from
+  struct ThreadChunk {
+    ASTChunk* chunk = nullptr;
+    char* next = nullptr;
+    char* end = nullptr;
+
+    ~ThreadChunk() {
+      if (chunk != nullptr) releaseChunk(chunk);
+    }
+  };
+}
+
+static thread_local ThreadChunk threadChunk;
+
+static void startNewChunk(ThreadChunk& t) {
+  if (t.chunk != nullptr) {
+    releaseChunk(t.chunk);
+    t.chunk = nullptr;
+  }
+
+  void* mem = nullptr;
+  if (posix_memalign(&mem, CHUNK_SIZE, CHUNK_SIZE) != 0) {
+    throw std::bad_alloc();
+  }
+  nChunksInUse.fetch_add(1, std::memory_order_relaxed);
+
+  t.chunk = new (mem) ASTChunk();
+  t.chunk->refs.store(1, std::memory_order_relaxed);
+  t.next = (char*) mem + CHUNK_HEADER_SIZE;
+  t.end = (char*) mem + CHUNK_SIZE;
+}
+
+void* allocateAST(size_t size) {
+  if (size > MAX_CHUNK_ALLOC_SIZE) {
+    return ::operator new(size);
+  }
+
+  size = (size + ALLOC_ALIGN - 1) & ~(ALLOC_ALIGN - 1);
+  if (size == 0) size = ALLOC_ALIGN;
+
+  ThreadChunk& t = threadChunk;
+  if (t.chunk == nullptr || (size_t) (t.end - t.next) < size) {
+    startNewChunk(t);
+  }
+
+  void* ret = t.next;
+  t.next += size;
+  t.chunk->refs.fetch_add(1, std::memory_order_relaxed);
+  return ret;
+}
+
+void deallocateAST(void* ptr, size_t size) {
+  if (ptr == nullptr) return;
+
+  if (size > MAX_CHUNK_ALLOC_SIZE) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  auto chunk = (ASTChunk*) (((uintptr_t) ptr) & ~(uintptr_t) (CHUNK_SIZE-1));
+  releaseChunk(chunk);
+}
+
+size_t numASTChunksInUse() {
+  return nChunksInUse.load(std::memory_order_relaxed);
+}
+
+
+} // end namespace detail
+} // end namespace uast
+} // end namespace chpl
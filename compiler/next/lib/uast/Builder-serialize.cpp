@@ -0,0 +1,1108 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/uast/Builder.h"
+
+#include "chpl/queries/Context.h"
+#include "chpl/uast/all-uast.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+  The serialized form of a Builder::Result is a sequence of variable-length
+  integers (LEB128, with zig-zag encoding for signed values). Each uAST node
+  is written as its tag (plus one, so that 0 can represent a missing
+  optional child), its Location, and then whatever fields and children
+  are needed to call the corresponding build() function again.
+
+  Nodes are rebuilt with the same build() functions the parser uses and
+  then Builder::result() assigns IDs, so the IDs of a deserialized result
+  match those computed when the file was originally parsed.
+
+  UniqueStrings are interned in a table as they are written: the first
+  occurrence is written as 0 followed by the string and later occurrences
+  are written as the table index plus one.
+ */
+
+namespace chpl {
+namespace uast {
+
+
+namespace {
+
+class Serializer {
+ private:
+  const Builder::Result& result_;
+  std::string& out_;
+  std::unordered_map<UniqueString, uint64_t> strings_;
+  int64_t prevLine_ = 0;
+
+  void writeUInt(uint64_t v) {
+    while (v >= 0x80) {
+      out_.push_back((char) ((v & 0x7f) | 0x80));
+      v >>= 7;
+    }
+    out_.push_back((char) v);
+  }
+  void writeInt(int64_t v) {
+    writeUInt((((uint64_t) v) << 1) ^ (uint64_t) (v >> 63));
+  }
+  void writeBool(bool v) {
+    writeUInt(v ? 1 : 0);
+  }
+  void writeDouble(double v) {
+    uint64_t bits = 0;
+    static_assert(sizeof(bits) == sizeof(v), "unexpected double size");
+    memcpy(&bits, &v, sizeof(v));
+    writeUInt(bits);
+  }
+  void writeString(const std::string& s) {
+    writeUInt(s.size());
+    out_.append(s);
+  }
+  void writeUniqueString(UniqueString s) {
+    auto search = strings_.find(s);
+    if (search != strings_.end()) {
+      writeUInt(search->second + 1);
+    } else {
+      uint64_t idx = strings_.size();
+      strings_[s] = idx;
+      writeUInt(0);
+      writeString(s.c_str());
+    }
+  }
+  void writeLocation(const ASTNode* ast) {
+    Location loc;
+    if (ast->isComment()) {
+      auto search = result_.commentToLocation.find(ast);
+      if (search != result_.commentToLocation.end()) {
+        loc = search->second;
+      }
+    } else {
+      loc = result_.idToLocation.get(ast->id());
+    }
+    // lines are written relative to the previous Location
+    // since nearby uAST nodes tend to be on nearby lines
+    writeUniqueString(loc.path());
+    writeInt(loc.firstLine() - prevLine_);
+    writeInt(loc.firstColumn());
+    writeInt(loc.lastLine() - loc.firstLine());
+    writeInt(loc.lastColumn());
+    prevLine_ = loc.firstLine();
+  }
+  template<typename Iterable>
+  void writeList(int n, Iterable lst) {
+    writeUInt(n);
+    for (const ASTNode* ast : lst) {
+      writeNode(ast);
+    }
+  }
+  void writeStmts(const SimpleBlockLike* block) {
+    writeUInt((uint64_t) block->blockStyle());
+    writeList(block->numStmts(), block->stmts());
+  }
+  void writeIndexableLoop(const IndexableLoop* loop) {
+    writeNode(loop->index());
+    writeNode(loop->iterand());
+    writeNode(loop->withClause());
+    writeUInt((uint64_t) loop->blockStyle());
+    writeNode(loop->body());
+    writeBool(loop->isExpressionLevel());
+  }
+  void writeVarLikeDecl(const VarLikeDecl* decl) {
+    writeUniqueString(decl->name());
+    writeNode(decl->typeExpression());
+    writeNode(decl->initExpression());
+  }
+  void writeNode(const ASTNode* ast);
+
+ public:
+  Serializer(const Builder::Result& result, std::string& out)
+    : result_(result), out_(out) {
+  }
+
+  void writeResult() {
+    writeUInt(result_.topLevelExpressions.size());
+    for (const auto& ast : result_.topLevelExpressions) {
+      writeNode(ast.get());
+    }
+  }
+};
+
+void Serializer::writeNode(const ASTNode* ast) {
+  if (ast == nullptr) {
+    writeUInt(0);
+    return;
+  }
+
+  writeUInt(((uint64_t) ast->tag()) + 1);
+  writeLocation(ast);
+
+  switch (ast->tag()) {
+    case asttags::Array: {
+      auto x = ast->toArray();
+      writeList(x->numExprs(), x->exprs());
+      break;
+    }
+    case asttags::As: {
+      auto x = ast->toAs();
+      writeNode(x->symbol());
+      writeNode(x->rename());
+      break;
+    }
+    case asttags::Begin: {
+      auto x = ast->toBegin();
+      writeNode(x->withClause());
+      writeStmts(x);
+      break;
+    }
+    case asttags::Block: {
+      auto x = ast->toBlock();
+      writeList(x->numStmts(), x->stmts());
+      break;
+    }
+    case asttags::BoolLiteral:
+      writeBool(ast->toBoolLiteral()->value());
+      break;
+    case asttags::BracketLoop:
+      writeIndexableLoop(ast->toBracketLoop());
+      break;
+    case asttags::Break:
+      writeNode(ast->toBreak()->target());
+      break;
+    case asttags::BytesLiteral: {
+      auto x = ast->toBytesLiteral();
+      writeString(x->str());
+      writeUInt((uint64_t) x->quoteStyle());
+      break;
+    }
+    case asttags::CStringLiteral: {
+      auto x = ast->toCStringLiteral();
+      writeString(x->str());
+      writeUInt((uint64_t) x->quoteStyle());
+      break;
+    }
+    case asttags::Class: {
+      auto x = ast->toClass();
+      writeUInt((uint64_t) x->visibility());
+      writeUniqueString(x->name());
+      writeNode(x->parentClass());
+      writeList(x->numDeclOrComments(), x->declOrComments());
+      break;
+    }
+    case asttags::Cobegin: {
+      auto x = ast->toCobegin();
+      writeNode(x->withClause());
+      writeList(x->numTaskBodies(), x->taskBodies());
+      break;
+    }
+    case asttags::Coforall:
+      writeIndexableLoop(ast->toCoforall());
+      break;
+    case asttags::Comment:
+      writeString(ast->toComment()->str());
+      break;
+    case asttags::Conditional: {
+      auto x = ast->toConditional();
+      writeNode(x->condition());
+      writeUInt((uint64_t) x->thenBlockStyle());
+      writeNode(x->thenBlock());
+      writeUInt((uint64_t) x->elseBlockStyle());
+      writeNode(x->elseBlock());
+      writeBool(x->isExpressionLevel());
+      break;
+    }
+    case asttags::Continue:
+      writeNode(ast->toContinue()->target());
+      break;
+    case asttags::Defer:
+      writeStmts(ast->toDefer());
+      break;
+    case asttags::Delete: {
+      auto x = ast->toDelete();
+      writeList(x->numExprs(), x->exprs());
+      break;
+    }
+    case asttags::DoWhile: {
+      auto x = ast->toDoWhile();
+      writeUInt((uint64_t) x->blockStyle());
+      writeNode(x->body());
+      writeNode(x->condition());
+      break;
+    }
+    case asttags::Domain: {
+      auto x = ast->toDomain();
+      writeList(x->numExprs(), x->exprs());
+      break;
+    }
+    case asttags::Dot: {
+      auto x = ast->toDot();
+      writeNode(x->receiver());
+      writeUniqueString(x->field());
+      break;
+    }
+    case asttags::Enum: {
+      auto x = ast->toEnum();
+      writeUniqueString(x->name());
+      writeUInt((uint64_t) x->visibility());
+      writeList(x->numDeclOrComments(), x->declOrComments());
+      break;
+    }
+    case asttags::EnumElement: {
+      auto x = ast->toEnumElement();
+      writeUniqueString(x->name());
+      writeNode(x->initExpression());
+      break;
+    }
+    case asttags::ErroneousExpression:
+      break;
+    case asttags::FnCall: {
+      auto x = ast->toFnCall();
+      writeNode(x->calledExpression());
+      writeList(x->numActuals(), x->actuals());
+      for (int i = 0; i < x->numActuals(); i++) {
+        writeUniqueString(x->actualName(i));
+      }
+      writeBool(x->callUsedSquareBrackets());
+      break;
+    }
+    case asttags::For: {
+      auto x = ast->toFor();
+      writeIndexableLoop(x);
+      writeBool(x->isParam());
+      break;
+    }
+    case asttags::Forall:
+      writeIndexableLoop(ast->toForall());
+      break;
+    case asttags::Foreach:
+      writeIndexableLoop(ast->toForeach());
+      break;
+    case asttags::Formal: {
+      auto x = ast->toFormal();
+      writeUInt((uint64_t) x->intent());
+      writeVarLikeDecl(x);
+      break;
+    }
+    case asttags::Function: {
+      auto x = ast->toFunction();
+      const Formal* thisFormal = x->thisFormal();
+      writeUniqueString(x->name());
+      writeUInt((uint64_t) x->visibility());
+      writeUInt((uint64_t) x->linkage());
+      writeNode(x->linkageNameExpression());
+      writeBool(x->isInline());
+      writeBool(x->isOverride());
+      writeUInt((uint64_t) x->kind());
+      writeNode(thisFormal);
+      writeUInt((uint64_t) x->returnIntent());
+      writeBool(x->throws());
+      writeBool(x->isPrimaryMethod());
+      writeUInt(x->numFormals() - (thisFormal != nullptr ? 1 : 0));
+      for (const Formal* formal : x->formals()) {
+        if (formal != thisFormal) writeNode(formal);
+      }
+      writeNode(x->returnType());
+      writeNode(x->whereClause());
+      writeList(x->numLifetimeClauses(), x->lifetimeClauses());
+      writeNode(x->body());
+      break;
+    }
+    case asttags::Identifier:
+      writeUniqueString(ast->toIdentifier()->name());
+      break;
+    case asttags::ImagLiteral: {
+      auto x = ast->toImagLiteral();
+      writeDouble(x->value());
+      writeUniqueString(x->text());
+      break;
+    }
+    case asttags::IntLiteral: {
+      auto x = ast->toIntLiteral();
+      writeInt(x->value());
+      writeUniqueString(x->text());
+      break;
+    }
+    case asttags::Label: {
+      auto x = ast->toLabel();
+      writeUniqueString(x->name());
+      writeNode(x->loop());
+      break;
+    }
+    case asttags::Local: {
+      auto x = ast->toLocal();
+      writeNode(x->condition());
+      writeStmts(x);
+      break;
+    }
+    case asttags::Module: {
+      auto x = ast->toModule();
+      writeUniqueString(x->name());
+      writeUInt((uint64_t) x->visibility());
+      writeUInt((uint64_t) x->kind());
+      writeList(x->numStmts(), x->stmts());
+      break;
+    }
+    case asttags::MultiDecl: {
+      auto x = ast->toMultiDecl();
+      writeUInt((uint64_t) x->visibility());
+      writeList(x->numDeclOrComments(), x->declOrComments());
+      break;
+    }
+    case asttags::New: {
+      auto x = ast->toNew();
+      writeNode(x->typeExpression());
+      writeUInt((uint64_t) x->management());
+      break;
+    }
+    case asttags::On: {
+      auto x = ast->toOn();
+      writeNode(x->destination());
+      writeStmts(x);
+      break;
+    }
+    case asttags::OpCall: {
+      auto x = ast->toOpCall();
+      writeUniqueString(x->op());
+      writeList(x->numActuals(), x->actuals());
+      break;
+    }
+    case asttags::Range: {
+      auto x = ast->toRange();
+      writeUInt((uint64_t) x->opKind());
+      writeNode(x->lowerBound());
+      writeNode(x->upperBound());
+      break;
+    }
+    case asttags::RealLiteral: {
+      auto x = ast->toRealLiteral();
+      writeDouble(x->value());
+      writeUniqueString(x->text());
+      break;
+    }
+    case asttags::Record: {
+      auto x = ast->toRecord();
+      writeUInt((uint64_t) x->visibility());
+      writeUniqueString(x->name());
+      writeList(x->numDeclOrComments(), x->declOrComments());
+      break;
+    }
+    case asttags::Return:
+      writeNode(ast->toReturn()->value());
+      break;
+    case asttags::Serial: {
+      auto x = ast->toSerial();
+      writeNode(x->condition());
+      writeStmts(x);
+      break;
+    }
+    case asttags::StringLiteral: {
+      auto x = ast->toStringLiteral();
+      writeString(x->str());
+      writeUInt((uint64_t) x->quoteStyle());
+      break;
+    }
+    case asttags::Sync:
+      writeStmts(ast->toSync());
+      break;
+    case asttags::TaskVar: {
+      auto x = ast->toTaskVar();
+      writeUInt((uint64_t) x->intent());
+      writeVarLikeDecl(x);
+      break;
+    }
+    case asttags::TupleDecl: {
+      auto x = ast->toTupleDecl();
+      writeUInt((uint64_t) x->visibility());
+      writeUInt((uint64_t) x->kind());
+      writeList(x->numDecls(), x->decls());
+      writeNode(x->typeExpression());
+      writeNode(x->initExpression());
+      break;
+    }
+    case asttags::UintLiteral: {
+      auto x = ast->toUintLiteral();
+      writeUInt(x->value());
+      writeUniqueString(x->text());
+      break;
+    }
+    case asttags::Union: {
+      auto x = ast->toUnion();
+      writeUInt((uint64_t) x->visibility());
+      writeUniqueString(x->name());
+      writeList(x->numDeclOrComments(), x->declOrComments());
+      break;
+    }
+    case asttags::Use: {
+      auto x = ast->toUse();
+      writeUInt((uint64_t) x->visibility());
+      writeList(x->numUseClauses(), x->useClauses());
+      break;
+    }
+    case asttags::UseClause: {
+      auto x = ast->toUseClause();
+      writeNode(x->symbol());
+      writeUInt((uint64_t) x->limitationClauseKind());
+      writeList(x->numLimitations(), x->limitations());
+      break;
+    }
+    case asttags::Variable: {
+      auto x = ast->toVariable();
+      writeUInt((uint64_t) x->visibility());
+      writeUInt((uint64_t) x->kind());
+      writeBool(x->isConfig());
+      writeBool(x->isField());
+      writeVarLikeDecl(x);
+      break;
+    }
+    case asttags::While: {
+      auto x = ast->toWhile();
+      writeNode(x->condition());
+      writeUInt((uint64_t) x->blockStyle());
+      writeNode(x->body());
+      break;
+    }
+    case asttags::WithClause: {
+      auto x = ast->toWithClause();
+      writeList(x->numExprs(), x->exprs());
+      break;
+    }
+    case asttags::Yield:
+      writeNode(ast->toYield()->value());
+      break;
+    case asttags::Zip: {
+      auto x = ast->toZip();
+      writeList(x->numActuals(), x->actuals());
+      break;
+    }
+    default:
+      assert(false && "case not handled in uAST serialization");
+      break;
+  }
+}
+
+// All uAST nodes are Expressions, but ASTList stores them as ASTNodes
+static owned<Expression> toOwnedExpression(owned<ASTNode> ast) {
+  return toOwned((Expression*) ast.release());
+}
+
+class Deserializer {
+ private:
+  Context* context_;
+  Builder* builder_;
+  const unsigned char* cur_;
+  const unsigned char* end_;
+  std::vector<UniqueString> strings_;
+  int64_t prevLine_ = 0;
+  bool failed_ = false;
+
+  uint64_t readUInt() {
+    uint64_t ret = 0;
+    int shift = 0;
+    while (true) {
+      if (cur_ == end_ || shift > 63) {
+        failed_ = true;
+        return 0;
+      }
+      unsigned char c = *cur_++;
+      ret |= ((uint64_t) (c & 0x7f)) << shift;
+      if ((c & 0x80) == 0) return ret;
+      shift += 7;
+    }
+  }
+  int64_t readInt() {
+    uint64_t v = readUInt();
+    return (int64_t) ((v >> 1) ^ (~(v & 1) + 1));
+  }
+  bool readBool() {
+    return readUInt() != 0;
+  }
+  double readDouble() {
+    uint64_t bits = readUInt();
+    double ret = 0.0;
+    memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+  }
+  std::string readString() {
+    uint64_t len = readUInt();
+    if (failed_ || len > (uint64_t) (end_ - cur_)) {
+      failed_ = true;
+      return std::string();
+    }
+    std::string ret((const char*) cur_, len);
+    cur_ += len;
+    return ret;
+  }
+  UniqueString readUniqueString() {
+    uint64_t idx = readUInt();
+    if (idx == 0) {
+      uint64_t len = readUInt();
+      if (failed_ || len > (uint64_t) (end_ - cur_)) {
+        failed_ = true;
+        return UniqueString();
+      }
+      auto ret = UniqueString::build(context_, (const char*) cur_, len);
+      cur_ += len;
+      strings_.push_back(ret);
+      return ret;
+    }
+    if (idx > strings_.size()) {
+      failed_ = true;
+      return UniqueString();
+    }
+    return strings_[idx - 1];
+  }
+  Location readLocation() {
+    UniqueString path = readUniqueString();
+    int64_t firstLine = prevLine_ + readInt();
+    int64_t firstColumn = readInt();
+    int64_t lastLine = firstLine + readInt();
+    int64_t lastColumn = readInt();
+    prevLine_ = firstLine;
+    return Location(path, firstLine, firstColumn, lastLine, lastColumn);
+  }
+  BlockStyle readBlockStyle() {
+    return (BlockStyle) readUInt();
+  }
+  owned<Expression> readRequiredNode() {
+    auto ret = readNode();
+    if (ret.get() == nullptr) failed_ = true;
+    return ret;
+  }
+  template<typename T>
+  owned<T> readNodeAs(bool (ASTNode::*isT)() const) {
+    auto ret = readNode();
+    if (ret.get() == nullptr) return nullptr;
+    if (!((ret.get())->*isT)()) {
+      failed_ = true;
+      return nullptr;
+    }
+    return toOwned((T*) ret.release());
+  }
+  ASTList readList() {
+    ASTList ret;
+    uint64_t n = readUInt();
+    for (uint64_t i = 0; i < n && !failed_; i++) {
+      ret.push_back(readRequiredNode());
+    }
+    return ret;
+  }
+  owned<Expression> readNode();
+
+ public:
+  Deserializer(Context* context, Builder* builder,
+               const char* data, size_t len)
+    : context_(context), builder_(builder),
+      cur_((const unsigned char*) data),
+      end_((const unsigned char*) data + len) {
+  }
+
+  bool readResult() {
+    ASTList topLevelExpressions = readList();
+    if (failed_ || cur_ != end_ || topLevelExpressions.size() == 0) {
+      return false;
+    }
+    for (auto& ast : topLevelExpressions) {
+      if (!ast->isModule() && !ast->isComment()) return false;
+    }
+    for (auto& ast : topLevelExpressions) {
+      builder_->addToplevelExpression(toOwnedExpression(std::move(ast)));
+    }
+    return true;
+  }
+};
+
+owned<Expression> Deserializer::readNode() {
+  uint64_t tagPlusOne = readUInt();
+  if (failed_ || tagPlusOne == 0 ||
+      tagPlusOne > (uint64_t) asttags::NUM_AST_TAGS) {
+    if (tagPlusOne != 0) failed_ = true;
+    return nullptr;
+  }
+
+  // Note: the fields are read into local variables before calling
+  // build() because the order of evaluation of arguments is unspecified.
+  auto tag = (asttags::ASTTag) (tagPlusOne - 1);
+  Location loc = readLocation();
+  Builder* b = builder_;
+
+  switch (tag) {
+    case asttags::Array: {
+      auto exprs = readList();
+      if (failed_) return nullptr;
+      return Array::build(b, loc, std::move(exprs));
+    }
+    case asttags::As: {
+      auto symbol = readRequiredNode();
+      auto rename = readNodeAs<Identifier>(&ASTNode::isIdentifier);
+      if (failed_ || rename.get() == nullptr) break;
+      return As::build(b, loc, std::move(symbol), std::move(rename));
+    }
+    case asttags::Begin: {
+      auto withClause = readNodeAs<WithClause>(&ASTNode::isWithClause);
+      auto blockStyle = readBlockStyle();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return Begin::build(b, loc, std::move(withClause), blockStyle,
+                          std::move(stmts));
+    }
+    case asttags::Block: {
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return Block::build(b, loc, std::move(stmts));
+    }
+    case asttags::BoolLiteral: {
+      bool value = readBool();
+      if (failed_) return nullptr;
+      return BoolLiteral::build(b, loc, value);
+    }
+    case asttags::BracketLoop:
+    case asttags::Coforall:
+    case asttags::For:
+    case asttags::Forall:
+    case asttags::Foreach: {
+      auto index = readNodeAs<Decl>(&ASTNode::isDecl);
+      auto iterand = readRequiredNode();
+      auto withClause = readNodeAs<WithClause>(&ASTNode::isWithClause);
+      auto blockStyle = readBlockStyle();
+      auto body = readNodeAs<Block>(&ASTNode::isBlock);
+      bool isExpressionLevel = readBool();
+      bool isParam = tag == asttags::For ? readBool() : false;
+      if (failed_) return nullptr;
+      if (tag == asttags::BracketLoop) {
+        return BracketLoop::build(b, loc, std::move(index),
+                                  std::move(iterand), std::move(withClause),
+                                  blockStyle, std::move(body),
+                                  isExpressionLevel);
+      } else if (tag == asttags::Coforall) {
+        return Coforall::build(b, loc, std::move(index),
+                               std::move(iterand), std::move(withClause),
+                               blockStyle, std::move(body));
+      } else if (tag == asttags::For) {
+        return For::build(b, loc, std::move(index), std::move(iterand),
+                          blockStyle, std::move(body),
+                          isExpressionLevel, isParam);
+      } else if (tag == asttags::Forall) {
+        return Forall::build(b, loc, std::move(index),
+                             std::move(iterand), std::move(withClause),
+                             blockStyle, std::move(body),
+                             isExpressionLevel);
+      } else {
+        return Foreach::build(b, loc, std::move(index),
+                              std::move(iterand), std::move(withClause),
+                              blockStyle, std::move(body));
+      }
+    }
+    case asttags::Break: {
+      auto target = readNodeAs<Identifier>(&ASTNode::isIdentifier);
+      if (failed_) return nullptr;
+      return Break::build(b, loc, std::move(target));
+    }
+    case asttags::BytesLiteral:
+    case asttags::CStringLiteral:
+    case asttags::StringLiteral: {
+      std::string value = readString();
+      auto quotes = (StringLikeLiteral::QuoteStyle) readUInt();
+      if (failed_) return nullptr;
+      if (tag == asttags::BytesLiteral) {
+        return BytesLiteral::build(b, loc, std::move(value), quotes);
+      } else if (tag == asttags::CStringLiteral) {
+        return CStringLiteral::build(b, loc, std::move(value), quotes);
+      } else {
+        return StringLiteral::build(b, loc, std::move(value), quotes);
+      }
+    }
+    case asttags::Class: {
+      auto vis = (Decl::Visibility) readUInt();
+      auto name = readUniqueString();
+      auto parentClass = readNode();
+      auto contents = readList();
+      if (failed_) return nullptr;
+      return Class::build(b, loc, vis, name, std::move(parentClass),
+                          std::move(contents));
+    }
+    case asttags::Cobegin: {
+      auto withClause = readNodeAs<WithClause>(&ASTNode::isWithClause);
+      auto taskBodies = readList();
+      if (failed_) return nullptr;
+      return Cobegin::build(b, loc, std::move(withClause),
+                            std::move(taskBodies));
+    }
+    case asttags::Comment: {
+      std::string c = readString();
+      if (failed_) return nullptr;
+      return Comment::build(b, loc, std::move(c));
+    }
+    case asttags::Conditional: {
+      auto condition = readRequiredNode();
+      auto thenBlockStyle = readBlockStyle();
+      auto thenBlock = readNodeAs<Block>(&ASTNode::isBlock);
+      auto elseBlockStyle = readBlockStyle();
+      auto elseBlock = readNodeAs<Block>(&ASTNode::isBlock);
+      bool isExpressionLevel = readBool();
+      if (failed_ || thenBlock.get() == nullptr) break;
+      return Conditional::build(b, loc, std::move(condition),
+                                thenBlockStyle, std::move(thenBlock),
+                                elseBlockStyle, std::move(elseBlock),
+                                isExpressionLevel);
+    }
+    case asttags::Continue: {
+      auto target = readNodeAs<Identifier>(&ASTNode::isIdentifier);
+      if (failed_) return nullptr;
+      return Continue::build(b, loc, std::move(target));
+    }
+    case asttags::Defer: {
+      auto blockStyle = readBlockStyle();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return Defer::build(b, loc, blockStyle, std::move(stmts));
+    }
+    case asttags::Delete: {
+      auto exprs = readList();
+      if (failed_) return nullptr;
+      return Delete::build(b, loc, std::move(exprs));
+    }
+    case asttags::DoWhile: {
+      auto blockStyle = readBlockStyle();
+      auto body = readNodeAs<Block>(&ASTNode::isBlock);
+      auto condition = readRequiredNode();
+      if (failed_ || body.get() == nullptr) break;
+      return DoWhile::build(b, loc, blockStyle, std::move(body),
+                            std::move(condition));
+    }
+    case asttags::Domain: {
+      auto exprs = readList();
+      if (failed_) return nullptr;
+      return Domain::build(b, loc, std::move(exprs));
+    }
+    case asttags::Dot: {
+      auto receiver = readRequiredNode();
+      auto field = readUniqueString();
+      if (failed_) return nullptr;
+      return Dot::build(b, loc, std::move(receiver), field);
+    }
+    case asttags::Enum: {
+      auto name = readUniqueString();
+      auto vis = (Decl::Visibility) readUInt();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return Enum::build(b, loc, name, vis, std::move(stmts));
+    }
+    case asttags::EnumElement: {
+      auto name = readUniqueString();
+      auto initExpression = readNode();
+      if (failed_) return nullptr;
+      return EnumElement::build(b, loc, name, std::move(initExpression));
+    }
+    case asttags::ErroneousExpression:
+      return ErroneousExpression::build(b, loc);
+    case asttags::FnCall: {
+      auto calledExpression = readRequiredNode();
+      auto actuals = readList();
+      std::vector<UniqueString> actualNames;
+      bool anyNamed = false;
+      for (size_t i = 0; i < actuals.size() && !failed_; i++) {
+        actualNames.push_back(readUniqueString());
+        anyNamed |= !actualNames.back().isEmpty();
+      }
+      // the parser leaves actualNames empty when no actual is named
+      if (!anyNamed) actualNames.clear();
+      bool callUsedSquareBrackets = readBool();
+      if (failed_) return nullptr;
+      return FnCall::build(b, loc, std::move(calledExpression),
+                           std::move(actuals), std::move(actualNames),
+                           callUsedSquareBrackets);
+    }
+    case asttags::Formal: {
+      auto intent = (Formal::Intent) readUInt();
+      auto name = readUniqueString();
+      auto typeExpression = readNode();
+      auto initExpression = readNode();
+      if (failed_) return nullptr;
+      return Formal::build(b, loc, name, intent, std::move(typeExpression),
+                           std::move(initExpression));
+    }
+    case asttags::Function: {
+      auto name = readUniqueString();
+      auto vis = (Decl::Visibility) readUInt();
+      auto linkage = (Function::Linkage) readUInt();
+      auto linkageNameExpr = readNode();
+      bool inline_ = readBool();
+      bool override_ = readBool();
+      auto kind = (Function::Kind) readUInt();
+      auto receiver = readNodeAs<Formal>(&ASTNode::isFormal);
+      auto returnIntent = (Function::ReturnIntent) readUInt();
+      bool throws = readBool();
+      bool primaryMethod = readBool();
+      ASTList formals;
+      uint64_t nFormals = readUInt();
+      for (uint64_t i = 0; i < nFormals && !failed_; i++) {
+        auto formal = readNodeAs<Formal>(&ASTNode::isFormal);
+        if (formal.get() == nullptr) failed_ = true;
+        formals.push_back(std::move(formal));
+      }
+      auto returnType = readNode();
+      auto where = readNode();
+      auto lifetime = readList();
+      auto body = readNodeAs<Block>(&ASTNode::isBlock);
+      if (failed_) return nullptr;
+      return Function::build(b, loc, name, vis, linkage,
+                             std::move(linkageNameExpr),
+                             inline_, override_, kind,
+                             std::move(receiver), returnIntent,
+                             throws, primaryMethod,
+                             std::move(formals),
+                             std::move(returnType),
+                             std::move(where),
+                             std::move(lifetime),
+                             std::move(body));
+    }
+    case asttags::Identifier: {
+      auto name = readUniqueString();
+      if (failed_) return nullptr;
+      return Identifier::build(b, loc, name);
+    }
+    case asttags::ImagLiteral: {
+      double value = readDouble();
+      auto text = readUniqueString();
+      if (failed_) return nullptr;
+      return ImagLiteral::build(b, loc, value, text);
+    }
+    case asttags::IntLiteral: {
+      int64_t value = readInt();
+      auto text = readUniqueString();
+      if (failed_) return nullptr;
+      return IntLiteral::build(b, loc, value, text);
+    }
+    case asttags::Label: {
+      auto name = readUniqueString();
+      auto loop = readNodeAs<Loop>(&ASTNode::isLoop);
+      if (failed_ || loop.get() == nullptr) break;
+      return Label::build(b, loc, name, std::move(loop));
+    }
+    case asttags::Local:
+    case asttags::Serial: {
+      auto condition = readNode();
+      auto blockStyle = readBlockStyle();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      if (tag == asttags::Local) {
+        if (condition.get() == nullptr) {
+          return Local::build(b, loc, blockStyle, std::move(stmts));
+        }
+        return Local::build(b, loc, std::move(condition), blockStyle,
+                            std::move(stmts));
+      } else {
+        if (condition.get() == nullptr) {
+          return Serial::build(b, loc, blockStyle, std::move(stmts));
+        }
+        return Serial::build(b, loc, std::move(condition), blockStyle,
+                             std::move(stmts));
+      }
+    }
+    case asttags::Module: {
+      auto name = readUniqueString();
+      auto vis = (Decl::Visibility) readUInt();
+      auto kind = (Module::Kind) readUInt();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return Module::build(b, loc, name, vis, kind, std::move(stmts));
+    }
+    case asttags::MultiDecl: {
+      auto vis = (Decl::Visibility) readUInt();
+      auto varDecls = readList();
+      if (failed_) return nullptr;
+      return MultiDecl::build(b, loc, vis, std::move(varDecls));
+    }
+    case asttags::New: {
+      auto typeExpression = readRequiredNode();
+      auto management = (New::Management) readUInt();
+      if (failed_) return nullptr;
+      return New::build(b, loc, std::move(typeExpression), management);
+    }
+    case asttags::On: {
+      auto destination = readRequiredNode();
+      auto blockStyle = readBlockStyle();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return On::build(b, loc, std::move(destination), blockStyle,
+                       std::move(stmts));
+    }
+    case asttags::OpCall: {
+      auto op = readUniqueString();
+      auto actuals = readList();
+      if (failed_) return nullptr;
+      if (actuals.size() == 1) {
+        return OpCall::build(b, loc, op,
+                             toOwnedExpression(std::move(actuals[0])));
+      } else if (actuals.size() == 2) {
+        return OpCall::build(b, loc, op,
+                             toOwnedExpression(std::move(actuals[0])),
+                             toOwnedExpression(std::move(actuals[1])));
+      }
+      break;
+    }
+    case asttags::Range: {
+      auto opKind = (Range::OpKind) readUInt();
+      auto lowerBound = readNode();
+      auto upperBound = readNode();
+      if (failed_) return nullptr;
+      return Range::build(b, loc, opKind, std::move(lowerBound),
+                          std::move(upperBound));
+    }
+    case asttags::RealLiteral: {
+      double value = readDouble();
+      auto text = readUniqueString();
+      if (failed_) return nullptr;
+      return RealLiteral::build(b, loc, value, text);
+    }
+    case asttags::Record:
+    case asttags::Union: {
+      auto vis = (Decl::Visibility) readUInt();
+      auto name = readUniqueString();
+      auto contents = readList();
+      if (failed_) return nullptr;
+      if (tag == asttags::Record) {
+        return Record::build(b, loc, vis, name, std::move(contents));
+      } else {
+        return Union::build(b, loc, vis, name, std::move(contents));
+      }
+    }
+    case asttags::Return: {
+      auto value = readNode();
+      if (failed_) return nullptr;
+      return Return::build(b, loc, std::move(value));
+    }
+    case asttags::Sync: {
+      auto blockStyle = readBlockStyle();
+      auto stmts = readList();
+      if (failed_) return nullptr;
+      return Sync::build(b, loc, blockStyle, std::move(stmts));
+    }
+    case asttags::TaskVar: {
+      auto intent = (TaskVar::Intent) readUInt();
+      auto name = readUniqueString();
+      auto typeExpression = readNode();
+      auto initExpression = readNode();
+      if (failed_) return nullptr;
+      return TaskVar::build(b, loc, name, intent, std::move(typeExpression),
+                            std::move(initExpression));
+    }
+    case asttags::TupleDecl: {
+      auto vis = (Decl::Visibility) readUInt();
+      auto kind = (Variable::Kind) readUInt();
+      auto elements = readList();
+      auto typeExpression = readNode();
+      auto initExpression = readNode();
+      if (failed_) return nullptr;
+      return TupleDecl::build(b, loc, vis, kind, std::move(elements),
+                              std::move(typeExpression),
+                              std::move(initExpression));
+    }
+    case asttags::UintLiteral: {
+      uint64_t value = readUInt();
+      auto text = readUniqueString();
+      if (failed_) return nullptr;
+      return UintLiteral::build(b, loc, value, text);
+    }
+    case asttags::Use: {
+      auto vis = (Decl::Visibility) readUInt();
+      auto useClauses = readList();
+      if (failed_) return nullptr;
+      return Use::build(b, loc, vis, std::move(useClauses));
+    }
+    case asttags::UseClause: {
+      auto symbol = readRequiredNode();
+      auto kind = (UseClause::LimitationClauseKind) readUInt();
+      auto limitations = readList();
+      if (failed_) return nullptr;
+      return UseClause::build(b, loc, std::move(symbol), kind,
+                              std::move(limitations));
+    }
+    case asttags::Variable: {
+      auto vis = (Decl::Visibility) readUInt();
+      auto kind = (Variable::Kind) readUInt();
+      bool isConfig = readBool();
+      bool isField = readBool();
+      auto name = readUniqueString();
+      auto typeExpression = readNode();
+      auto initExpression = readNode();
+      if (failed_) return nullptr;
+      return Variable::build(b, loc, name, vis, kind, isConfig, isField,
+                             std::move(typeExpression),
+                             std::move(initExpression));
+    }
+    case asttags::While: {
+      auto condition = readRequiredNode();
+      auto blockStyle = readBlockStyle();
+      auto body = readNodeAs<Block>(&ASTNode::isBlock);
+      if (failed_ || body.get() == nullptr) break;
+      return While::build(b, loc, std::move(condition), blockStyle,
+                          std::move(body));
+    }
+    case asttags::WithClause: {
+      auto exprs = readList();
+      if (failed_) return nullptr;
+      return WithClause::build(b, loc, std::move(exprs));
+    }
+    case asttags::Yield: {
+      auto value = readRequiredNode();
+      if (failed_) return nullptr;
+      return Yield::build(b, loc, std::move(value));
+    }
+    case asttags::Zip: {
+      auto actuals = readList();
+      if (failed_) return nullptr;
+      return Zip::build(b, loc, std::move(actuals));
+    }
+    default:
+      break;
+  }
+
+  failed_ = true;
+  return nullptr;
+}
+
+
+} // end anonymous namespace
+
+void Builder::Result::serialize(std::string& out) const {
+  Serializer serializer(*this, out);
+  serializer.writeResult();
+}
+
+bool Builder::Result::deserialize(Context* context, UniqueString filePath,
+                                  const char* data, size_t len,
+                                  Result& out) {
+  auto builder = Builder::build(context, filePath.c_str());
+  Deserializer deserializer(context, builder.get(), data, len);
+  if (!deserializer.readResult()) {
+    return false;
+  }
+  Result tmp = builder->result();
+  out.swap(tmp);
+  return true;
+}
+
+
+} // namespace uast
+} // namespace chpl
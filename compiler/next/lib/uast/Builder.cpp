@@ -69,18 +69,22 @@ Builder::Result Builder::result() {
   this->createImplicitModuleIfNeeded();
   this->assignIDs();
 
-  // Performance: We could consider copying all of these AST
-  // nodes to a newly allocated buffer big enough to hold them
-  // all contiguously. The reason to do so would be to ensure
-  // that a postorder traversal of the AST has good data locality
-  // (i.e. good cache behavior).
+  // Performance: The AST nodes and their child lists are already
+  // allocated contiguously in the order the parser created them
+  // (see allocateAST), which gives a postorder traversal good data
+  // locality without copying them here.
 
   Builder::Result ret;
   ret.filePath.swap(filepath_);
   ret.topLevelExpressions.swap(topLevelExpressions_);
   ret.errors.swap(errors_);
+  idToAst_.shrinkToFit();
+  idToParent_.shrinkToFit();
+  idToLocation_.shrinkToFit();
   ret.idToAst.swap(idToAst_);
-  ret.astToLocation.swap(astToLocation_);
+  ret.idToParentId.swap(idToParent_);
+  ret.idToLocation.swap(idToLocation_);
+  ret.commentToLocation.swap(commentToLocation_);
 
   return ret;
 }
@@ -177,17 +181,19 @@ void Builder::assignIDs() {
 void Builder::doAssignIDs(ASTNode* ast, UniqueString symbolPath, int& i,
                           pathVecT& pathVec, declaredHereT& duplicates) {
 
-  // update locations_ for the visited ast
+  // find the location noted for the visited ast
+  Location loc;
   auto search = notedLocations_.find(ast);
   if (search != notedLocations_.end()) {
     assert(!search->second.isEmpty());
-    astToLocation_[search->first] = search->second;
+    loc = search->second;
   } else {
     assert(false && "Location for all ast should be set by noteLocation");
   }
 
   if (ast->isComment()) {
     // comments don't have IDs
+    commentToLocation_[ast] = loc;
     return;
   }
 
@@ -266,53 +272,68 @@ void Builder::doAssignIDs(ASTNode* ast, UniqueString symbolPath, int& i,
     ast->setID(ID(symbolPath, myID, numContainedIDs));
   }
 
-  // update idToAst_ for the visited AST node
-  idToAst_[ast->id()] = ast;
+  // update the ID maps for the visited AST node
+  idToAst_.set(ast->id(), ast);
+  idToLocation_.set(ast->id(), loc);
+  for (const ASTNode* child : ast->children()) {
+    if (!child->isComment()) {
+      idToParent_.set(child->id(), ast->id());
+    }
+  }
 }
 
 Builder::Result::Result()
 {
 }
 
-// Recomputes idToAst / astToLocation maps by visiting all uAST nodes
+// Recomputes the ID and Location maps by visiting all uAST nodes
 // and combining information from the provided maps.
+// The Locations are taken from 'resultB' if possible since it is newer.
 static
 void recomputeIdAndLocMaps(
     const ASTNode* ast,
     const ASTNode* parentAst,
-    std::unordered_map<ID, const ASTNode*>& dstIdToAst,
-    std::unordered_map<ID, ID>& dstIdToParent,
-    std::unordered_map<const ASTNode*, Location>& dstAstToLoc,
-    const std::unordered_map<const ASTNode*, Location>& astToLocA,
-    const std::unordered_map<const ASTNode*, Location>& astToLocB) {
+    Builder::Result& dst,
+    const Builder::Result& resultA,
+    const Builder::Result& resultB) {
 
   for (const ASTNode* child : ast->children()) {
-    recomputeIdAndLocMaps(child, ast, dstIdToAst, dstIdToParent,
-                          dstAstToLoc, astToLocA, astToLocB);
+    recomputeIdAndLocMaps(child, ast, dst, resultA, resultB);
+  }
+
+  if (ast->isComment()) {
+    auto searchA = resultA.commentToLocation.find(ast);
+    if (searchA != resultA.commentToLocation.end()) {
+      // found a location in mapA so use it
+      dst.commentToLocation[ast] = searchA->second;
+    } else {
+      // check in mapB
+      auto searchB = resultB.commentToLocation.find(ast);
+      if (searchB != resultB.commentToLocation.end()) {
+        // found a location in mapB so use it
+        dst.commentToLocation[ast] = searchB->second;
+      } else {
+        assert(false && "Could not find location");
+      }
+    }
+    return;
   }
 
   if (!ast->id().isEmpty()) {
-    dstIdToAst[ast->id()] = ast;
+    dst.idToAst.set(ast->id(), ast);
 
     if (parentAst != nullptr) {
       if (!parentAst->id().isEmpty()) {
-        dstIdToParent[ast->id()] = parentAst->id();
+        dst.idToParentId.set(ast->id(), parentAst->id());
       } else {
         assert(false && "parentAst does not have valid ID");
       }
     }
-  }
 
-  auto searchA = astToLocA.find(ast);
-  if (searchA != astToLocA.end()) {
-    // found a location in mapA so use it
-    dstAstToLoc[ast] = searchA->second;
-  } else {
-    // check in mapB
-    auto searchB = astToLocB.find(ast);
-    if (searchB != astToLocB.end()) {
-      // found a location in mapB so use it
-      dstAstToLoc[ast] = searchB->second;
+    const Location* loc = resultB.idToLocation.find(ast->id());
+    if (loc == nullptr) loc = resultA.idToLocation.find(ast->id());
+    if (loc != nullptr) {
+      dst.idToLocation.set(ast->id(), *loc);
     } else {
       assert(false && "Could not find location");
     }
@@ -324,7 +345,9 @@ void Builder::Result::swap(Result& other) {
   topLevelExpressions.swap(other.topLevelExpressions);
   errors.swap(other.errors);
   idToAst.swap(other.idToAst);
-  astToLocation.swap(other.astToLocation);
+  idToParentId.swap(other.idToParentId);
+  idToLocation.swap(other.idToLocation);
+  commentToLocation.swap(other.commentToLocation);
 }
 
 bool Builder::Result::update(Result& keep, Result& addin) {
@@ -339,21 +362,22 @@ bool Builder::Result::update(Result& keep, Result& addin) {
   // update the ASTs
   changed |= updateASTList(keep.topLevelExpressions, addin.topLevelExpressions);
 
-  std::unordered_map<ID, const ASTNode*> newIdToAst;
-  std::unordered_map<ID, ID> newIdToParent;
-  std::unordered_map<const ASTNode*, Location> newAstToLoc;
+  Result recomputed;
 
-  // recompute locationsVec by traversing the AST and using the maps
+  // recompute the maps by traversing the AST and using the maps
   for (const auto& ast : keep.topLevelExpressions) {
-    recomputeIdAndLocMaps(ast.get(), nullptr,
-                          newIdToAst, newIdToParent,
-                          newAstToLoc, keep.astToLocation, addin.astToLocation);
+    recomputeIdAndLocMaps(ast.get(), nullptr, recomputed, keep, addin);
   }
+  recomputed.idToAst.shrinkToFit();
+  recomputed.idToParentId.shrinkToFit();
+  recomputed.idToLocation.shrinkToFit();
 
   // now update the ID and Locations maps in keep
-  changed |= defaultUpdate(keep.idToAst, newIdToAst);
-  changed |= defaultUpdate(keep.idToParentId, newIdToParent);
-  changed |= defaultUpdate(keep.astToLocation, newAstToLoc);
+  changed |= defaultUpdate(keep.idToAst, recomputed.idToAst);
+  changed |= defaultUpdate(keep.idToParentId, recomputed.idToParentId);
+  changed |= defaultUpdate(keep.idToLocation, recomputed.idToLocation);
+  changed |= defaultUpdate(keep.commentToLocation,
+                           recomputed.commentToLocation);
 
   return changed;
 }
@@ -366,7 +390,12 @@ void Builder::Result::mark(Context* context, const Result& keep) {
   // UniqueStrings in the AST IDs will be marked in markASTList below
 
   // mark UniqueStrings in the Locations
-  for (const auto& pair : keep.astToLocation) {
+  keep.idToLocation.forEach([context](UniqueString symbolPath,
+                                      int postOrderId,
+                                      const Location& loc) {
+    loc.markUniqueStrings(context);
+  });
+  for (const auto& pair : keep.commentToLocation) {
     pair.second.markUniqueStrings(context);
   }
 
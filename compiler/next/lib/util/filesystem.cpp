@@ -26,6 +26,11 @@
 
 #include <cerrno>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace chpl {
 
 static std::string my_strerror(int errno_) {
@@ -104,4 +109,52 @@ bool readfile(const char* path,
   return true;
 }
 
+bool mapfile(const char* path,
+             const char*& dataOut, size_t& lenOut,
+             ErrorMessage& errorOut) {
+  dataOut = nullptr;
+  lenOut = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    std::string strerr = my_strerror(errno);
+    errorOut = ErrorMessage::build(Location(), "opening %s: %s",
+                                   path, strerr.c_str());
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    std::string strerr = my_strerror(errno);
+    errorOut = ErrorMessage::build(Location(), "reading %s: %s",
+                                   path, strerr.c_str());
+    close(fd);
+    return false;
+  }
+
+  // mmap does not support mapping 0 bytes
+  if (st.st_size > 0) {
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      std::string strerr = my_strerror(errno);
+      errorOut = ErrorMessage::build(Location(), "mapping %s: %s",
+                                     path, strerr.c_str());
+      close(fd);
+      return false;
+    }
+    dataOut = (const char*) p;
+    lenOut = st.st_size;
+  }
+
+  // the mapping remains valid after the file is closed
+  close(fd);
+  return true;
+}
+
+void unmapfile(const char* data, size_t len) {
+  if (data != nullptr && len > 0) {
+    munmap((void*) data, len);
+  }
+}
+
 }
@@ -43,6 +43,20 @@ bool closefile(FILE* fp, const char* path, ErrorMessage& errorOut);
  */
 bool readfile(const char* path, std::string& strOut, ErrorMessage& errorOut);
 
+/**
+  Map the contents of a file into memory for reading.
+  If something failed, returns false and sets errorOut.
+  The memory should be released with unmapfile.
+ */
+bool mapfile(const char* path,
+             const char*& dataOut, size_t& lenOut,
+             ErrorMessage& errorOut);
+
+/**
+  Release memory returned by mapfile.
+ */
+void unmapfile(const char* data, size_t len);
+
 } // end namespace chpl
 
 #endif
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/parsing/Parser.h"
+#include "chpl/parsing/parsing-queries.h"
+#include "chpl/queries/Context.h"
+#include "chpl/uast/Module.h"
+
+// always check assertions in this test
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <cassert>
+#include <cstdlib>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace chpl;
+using namespace uast;
+using namespace parsing;
+
+// uses many of the different uAST nodes
+static const char* program =
+  "/* a comment */\n"
+  "module M {\n"
+  "  use A, B;\n  public use D except x;\n"
+  "  private use C only y as z;\n"
+  "  config const n = 10, m: int = 0b101;\n"
+  "  var (a, b) = f(1, 2.5e3);\n"
+  "  const i = 3i, s = \"str\", bs = b'bytes', cs = c\"cstr\";\n"
+  "  enum color { red, green = 2, blue }\n"
+  "  class C : Parent { var x: int; proc method() { } }\n"
+  "  record R { var y = 0xffffffffffffffff; }\n"
+  "  union U { var a: int; var b: real; }\n"
+  "  proc R.secondary(ref arg: int, param p = 1): int where p > 0 {\n"
+  "    return arg + p;\n"
+  "  }\n"
+  "  iter it(n) throws { for i in 1..n do yield i; }\n"
+  "  override proc f(x) const ref : int where x > 1 lifetime x=y { }\n"
+  "  inline proc h() { }\n"
+  "  proc main() {\n"
+  "    var A = makeArray(1..n);\n"
+  "    var D = {1..n by 2, ..m};\n"
+  "    forall i in zip(A.domain, 0..) with (ref A) do A[i] = i;\n"
+  "    foreach a in A { a += 1; }\n"
+  "    coforall loc in Locales do on loc { writeln(here); }\n"
+  "    [x in A] x = -x;\n"
+  "    for param k in 1..3 { continue; }\n"
+  "    label outer while true { break outer; }\n"
+  "    do { n -= 1; } while n > 0;\n"
+  "    begin with (in n) { writeln(n); }\n"
+  "    cobegin { f(1); g(2); }\n"
+  "    sync { begin f(3); }\n"
+  "    serial n > 1 { f(4); }\n"
+  "    local { f(5); }\n"
+  "    defer { delete c, d; }\n"
+  "    var c = new owned C(x=1);\n"
+    "    if a then f(a); else { g(b); }\n"
+  "    var e = [1, 2, 3];\n"
+  "    if x then y; else if z then { w; } else { u; }\n"
+  "    writeln(f[1], a.b.c, !true, false);\n"
+  "  }\n"
+  "}\n";
+
+static void checkRoundTrip(Context* ctx, const char* path,
+                           const std::string& text) {
+  auto parser = Parser::build(ctx);
+  Builder::Result parsed = parser->parseString(path, text.c_str());
+  assert(parsed.errors.size() == 0);
+
+  std::string data;
+  parsed.serialize(data);
+
+  Builder::Result loaded;
+  bool ok = Builder::Result::deserialize(ctx, UniqueString::build(ctx, path),
+                                         data.data(), data.size(), loaded);
+  assert(ok);
+  assert(loaded.filePath == parsed.filePath);
+  assert(loaded.topLevelExpressions.size() ==
+         parsed.topLevelExpressions.size());
+  for (size_t i = 0; i < parsed.topLevelExpressions.size(); i++) {
+    const ASTNode* p = parsed.topLevelExpressions[i].get();
+    const ASTNode* l = loaded.topLevelExpressions[i].get();
+    assert(p->completeMatch(l));
+  }
+
+  // check that the IDs and Locations match
+  assert(loaded.idToAst.size() == parsed.idToAst.size());
+  assert(loaded.idToLocation.size() == parsed.idToLocation.size());
+  assert(loaded.commentToLocation.size() == parsed.commentToLocation.size());
+  parsed.idToAst.forEach([&](UniqueString symbolPath, int postOrderId,
+                             const ASTNode* ast) {
+    const ASTNode* got = loaded.idToAst.get(ast->id());
+    assert(got != nullptr);
+    assert(got->tag() == ast->tag());
+    assert(got->id() == ast->id());
+    assert(loaded.idToLocation.get(got->id()) ==
+           parsed.idToLocation.get(ast->id()));
+  });
+
+  // truncated data should be rejected
+  for (size_t len = 0; len < data.size(); len += 1 + len / 4) {
+    Builder::Result bad;
+    ok = Builder::Result::deserialize(ctx, UniqueString::build(ctx, path),
+                                      data.data(), len, bad);
+    assert(!ok);
+  }
+}
+
+// check that deserializing the serialized uAST gives the same result
+static void test0() {
+  printf("test0\n");
+  Context context;
+  Context* ctx = &context;
+
+  checkRoundTrip(ctx, "M.chpl", program);
+  checkRoundTrip(ctx, "implicit.chpl", "/* c */ var x = 1;\nproc f() { }\n");
+  checkRoundTrip(ctx, "comment.chpl", "// only a comment\n");
+}
+
+static int countCacheFiles(const std::string& dir) {
+  int ret = 0;
+  DIR* d = opendir(dir.c_str());
+  assert(d != nullptr);
+  while (struct dirent* ent = readdir(d)) {
+    if (ent->d_name[0] != '.') ret++;
+  }
+  closedir(d);
+  return ret;
+}
+
+static void removeCacheDir(const std::string& dir) {
+  DIR* d = opendir(dir.c_str());
+  assert(d != nullptr);
+  while (struct dirent* ent = readdir(d)) {
+    if (ent->d_name[0] != '.') {
+      std::string path = dir + "/" + ent->d_name;
+      unlink(path.c_str());
+    }
+  }
+  closedir(d);
+  rmdir(dir.c_str());
+}
+
+// check that parseFile stores and then uses the persistent cache
+static void test1() {
+  printf("test1\n");
+
+  char tmpl[] = "/tmp/testParseCacheXXXXXX";
+  std::string dir = mkdtemp(tmpl);
+
+  std::string firstPath;
+  int firstPostOrderId = 0;
+  int firstLine = 0;
+  {
+    Context context;
+    Context* ctx = &context;
+    ctx->setPersistentCacheDirectory(dir, "test1");
+    auto path = UniqueString::build(ctx, "M.chpl");
+    setFileText(ctx, path, program);
+    const ModuleVec& v = parse(ctx, path);
+    assert(v.size() == 1);
+    firstPath = v[0]->stmt(0)->id().symbolPath().c_str();
+    firstPostOrderId = v[0]->stmt(0)->id().postOrderId();
+    firstLine = locateAst(ctx, v[0]->stmt(0)).firstLine();
+    assert(countCacheFiles(dir) == 1);
+  }
+
+  {
+    Context context;
+    Context* ctx = &context;
+    ctx->setPersistentCacheDirectory(dir, "test1");
+    auto path = UniqueString::build(ctx, "M.chpl");
+    setFileText(ctx, path, program);
+    const ModuleVec& v = parse(ctx, path);
+    assert(v.size() == 1);
+    assert(firstPath == v[0]->stmt(0)->id().symbolPath().c_str());
+    assert(firstPostOrderId == v[0]->stmt(0)->id().postOrderId());
+    assert(locateAst(ctx, v[0]->stmt(0)).firstLine() == firstLine);
+    // the cached result was used, so no new file was written
+    assert(countCacheFiles(dir) == 1);
+
+    // a different compiler version does not use the same entry
+    ctx->setPersistentCacheDirectory(dir, "test1-other");
+    auto otherPath = UniqueString::build(ctx, "N.chpl");
+    setFileText(ctx, otherPath, program);
+    parse(ctx, otherPath);
+    assert(countCacheFiles(dir) == 2);
+  }
+
+  {
+    // changing the file contents does not use the cached result
+    Context context;
+    Context* ctx = &context;
+    ctx->setPersistentCacheDirectory(dir, "test1");
+    auto path = UniqueString::build(ctx, "M.chpl");
+    setFileText(ctx, path, std::string("\n") + program);
+    const ModuleVec& v = parse(ctx, path);
+    assert(v.size() == 1);
+    assert(locateAst(ctx, v[0]->stmt(0)).firstLine() == firstLine + 1);
+    assert(countCacheFiles(dir) == 3);
+  }
+
+  {
+    // files with syntax errors are not cached
+    Context context;
+    Context* ctx = &context;
+    ctx->setErrorHandler([](const ErrorMessage& err) { });
+    ctx->setPersistentCacheDirectory(dir, "test1");
+    auto path = UniqueString::build(ctx, "Bad.chpl");
+    setFileText(ctx, path, "var x = ;");
+    const Builder::Result& r = parseFile(ctx, path);
+    assert(r.errors.size() > 0);
+    assert(countCacheFiles(dir) == 3);
+  }
+
+  removeCacheDir(dir);
+}
+
+int main(int argc, char** argv) {
+  test0();
+  test1();
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/queries/Context.h"
+#include "chpl/queries/IdTable.h"
+#include "chpl/queries/Location.h"
+
+// always check assertions in this test
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <cassert>
+
+using namespace chpl;
+
+// check setting and finding values
+static void test0() {
+  printf("test0\n");
+  Context context;
+  Context* ctx = &context;
+
+  auto m = UniqueString::build(ctx, "M");
+  auto f = UniqueString::build(ctx, "M.f");
+  auto path = UniqueString::build(ctx, "M.chpl");
+
+  IdTable<Location> table;
+  assert(table.size() == 0);
+  assert(table.find(ID(m, 0, 0)) == nullptr);
+
+  // add in postorder, with the symbol itself last
+  for (int i = 0; i < 100; i++) {
+    table.set(ID(f, i, 0), Location(path, i+2));
+  }
+  table.set(ID(f, -1, 100), Location(path, 1));
+  table.set(ID(m, -1, 0), Location(path, 1));
+  assert(table.size() == 102);
+
+  for (int i = 0; i < 100; i++) {
+    // numContainedChildren does not matter for lookups
+    const Location* loc = table.find(ID(f, i, 7));
+    assert(loc != nullptr);
+    assert(loc->firstLine() == i+2);
+  }
+  assert(table.get(ID(f, -1, 0)).firstLine() == 1);
+  assert(table.get(ID(m, -1, 0)).firstLine() == 1);
+
+  // not present
+  assert(table.find(ID(f, 100, 0)) == nullptr);
+  assert(table.find(ID(m, 0, 0)) == nullptr);
+  assert(table.get(ID(m, 5, 0)) == Location());
+
+  // replacing a value does not change the size
+  table.set(ID(f, 3, 0), Location(path, 50));
+  assert(table.size() == 102);
+  assert(table.get(ID(f, 3, 0)).firstLine() == 50);
+
+  // setting the default value removes the entry
+  table.set(ID(f, 3, 0), Location());
+  assert(table.size() == 101);
+  assert(table.find(ID(f, 3, 0)) == nullptr);
+
+  int count = 0;
+  table.forEach([&](UniqueString symbolPath, int postOrderId,
+                    const Location& loc) {
+    assert(table.get(ID(symbolPath, postOrderId, 0)) == loc);
+    count++;
+  });
+  assert(count == 101);
+}
+
+// check comparison, swap, and shrinkToFit
+static void test1() {
+  printf("test1\n");
+  Context context;
+  Context* ctx = &context;
+
+  auto f = UniqueString::build(ctx, "M.f");
+  auto g = UniqueString::build(ctx, "M.g");
+
+  IdTable<ID> a;
+  IdTable<ID> b;
+  assert(a == b);
+
+  for (int i = 0; i < 10; i++) {
+    a.set(ID(f, i, 0), ID(f, -1, 0));
+    b.set(ID(f, i, 0), ID(f, -1, 0));
+  }
+  assert(a == b);
+
+  // a trailing absent entry does not matter
+  b.set(ID(f, 20, 0), ID(f, -1, 0));
+  assert(a != b);
+  b.set(ID(f, 20, 0), ID());
+  assert(a == b);
+  b.shrinkToFit();
+  assert(a == b);
+
+  b.set(ID(g, 0, 0), ID(g, -1, 0));
+  assert(a != b);
+  a.swap(b);
+  assert(a.size() == 11);
+  assert(b.size() == 10);
+  assert(a.get(ID(g, 0, 0)) == ID(g, -1, 0));
+  assert(b.find(ID(g, 0, 0)) == nullptr);
+
+  a.clear();
+  assert(a.size() == 0);
+  assert(a.find(ID(f, 0, 0)) == nullptr);
+}
+
+int main(int argc, char** argv) {
+  test0();
+  test1();
+
+  return 0;
+}
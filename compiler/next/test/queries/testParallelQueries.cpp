@@ -0,0 +1,195 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/parsing/parsing-queries.h"
+#include "chpl/queries/Context.h"
+#include "chpl/queries/query-impl.h"
+#include "chpl/uast/Module.h"
+
+// always check assertions in this test
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace chpl;
+using namespace parsing;
+using namespace uast;
+
+// This test uses global counters so that the queries
+// have side effects. That's not allowed in the framework
+// and if this test becomes problematic then it should be updated.
+std::atomic<int> nSharedQueryRuns(0);
+std::atomic<int> nLeafQueryRuns(0);
+std::atomic<int> nSumQueryRuns(0);
+int sharedInput = 1;
+
+static const int& sharedQuery(Context* context, int unused) {
+  QUERY_BEGIN(sharedQuery, context, unused);
+
+  nSharedQueryRuns++;
+  int result = sharedInput;
+  // give other threads a chance to ask for this query while it is running
+  std::this_thread::yield();
+
+  return QUERY_END(result);
+}
+
+static const int& leafQuery(Context* context, int i) {
+  QUERY_BEGIN(leafQuery, context, i);
+
+  nLeafQueryRuns++;
+  int result = i + sharedQuery(context, 0);
+
+  return QUERY_END(result);
+}
+
+static const int& sumQuery(Context* context, int n) {
+  QUERY_BEGIN(sumQuery, context, n);
+
+  nSumQueryRuns++;
+  std::vector<int> got(n);
+  context->runInParallel(n, [context, &got](size_t i) {
+    got[i] = leafQuery(context, (int) i);
+  });
+
+  int result = 0;
+  for (int x : got) {
+    result += x;
+  }
+
+  return QUERY_END(result);
+}
+
+static void test0() {
+  printf("test0\n");
+  Context ctx;
+  Context* context = &ctx;
+  context->setNumThreads(4);
+
+  // Run independent queries in parallel. The query they share
+  // should only be computed once.
+  context->advanceToNextRevision(false);
+  nSharedQueryRuns = 0;
+  nLeafQueryRuns = 0;
+  std::vector<int> got(100);
+  context->runInParallel(100, [context, &got](size_t i) {
+    got[i] = leafQuery(context, (int) i);
+  });
+  assert(nSharedQueryRuns == 1);
+  assert(nLeafQueryRuns == 100);
+  for (int i = 0; i < 100; i++) {
+    assert(got[i] == i + 1);
+  }
+
+  // Running them again in the same revision should reuse the results.
+  context->runInParallel(100, [context, &got](size_t i) {
+    got[i] = leafQuery(context, (int) i);
+  });
+  assert(nSharedQueryRuns == 1);
+  assert(nLeafQueryRuns == 100);
+}
+
+static void test1() {
+  printf("test1\n");
+  Context ctx;
+  Context* context = &ctx;
+  context->setNumThreads(4);
+
+  // Dependencies of queries run in parallel should be recorded
+  // in the calling query.
+  context->advanceToNextRevision(false);
+  sharedInput = 1;
+  nSharedQueryRuns = 0;
+  nLeafQueryRuns = 0;
+  nSumQueryRuns = 0;
+  int sum = sumQuery(context, 10);
+  assert(sum == 45 + 10);
+  assert(nSumQueryRuns == 1);
+  assert(nSharedQueryRuns == 1);
+  assert(nLeafQueryRuns == 10);
+
+  // Nothing changed, so the next revision can reuse everything
+  // (but still needs to check the dependencies, which is done
+  //  with nested parallel calls).
+  context->advanceToNextRevision(false);
+  sum = sumQuery(context, 10);
+  assert(sum == 45 + 10);
+  assert(nSumQueryRuns == 1);
+  assert(nSharedQueryRuns == 1);
+  assert(nLeafQueryRuns == 10);
+  assert(context->queryStatus(sumQuery, std::make_tuple(10)) ==
+         Context::REUSED);
+}
+
+static void test2() {
+  printf("test2\n");
+  Context ctx;
+  Context* context = &ctx;
+  context->setNumThreads(4);
+
+  // Parse many files in parallel and check that the results
+  // match parsing them on one thread.
+  int nFiles = 50;
+  std::vector<UniqueString> paths;
+  for (int i = 0; i < nFiles; i++) {
+    std::string name = "M" + std::to_string(i);
+    std::string contents = "module " + name + " {\n"
+                           "  var x = " + std::to_string(i) + ";\n"
+                           "  proc f(a: int) { return a + x; }\n"
+                           "}\n";
+    auto path = UniqueString::build(context, name + ".chpl");
+    setFileText(context, path, contents);
+    paths.push_back(path);
+  }
+
+  std::vector<const Module*> mods(nFiles);
+  context->runInParallel(nFiles, [context, &paths, &mods](size_t i) {
+    const ModuleVec& v = parse(context, paths[i]);
+    assert(v.size() == 1);
+    mods[i] = v[0];
+  });
+
+  Context serialCtx;
+  Context* serialContext = &serialCtx;
+  for (int i = 0; i < nFiles; i++) {
+    auto path = UniqueString::build(serialContext, paths[i].c_str());
+    setFileText(serialContext, path, fileText(context, paths[i]).text);
+    const ModuleVec& v = parse(serialContext, path);
+    assert(v.size() == 1);
+    assert(mods[i]->name() == v[0]->name());
+    assert(mods[i]->numStmts() == v[0]->numStmts());
+    assert(mods[i]->id().symbolPath() == v[0]->id().symbolPath());
+    // the file path for the module should be set
+    assert(context->filePathForId(mods[i]->id()) == paths[i]);
+  }
+}
+
+int main() {
+  test0();
+  test1();
+  test2();
+
+  return 0;
+}
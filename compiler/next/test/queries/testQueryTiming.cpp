@@ -0,0 +1,196 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/queries/Context.h"
+#include "chpl/queries/query-impl.h"
+
+// always check assertions in this test
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace chpl;
+
+// This test uses a global variable for the input
+// so that it can be changed between revisions.
+int inputValue = 0;
+
+static const int& inputQuery(Context* context, int unused) {
+  QUERY_BEGIN_INPUT(inputQuery, context, unused);
+  int result = inputValue;
+  return QUERY_END(result);
+}
+
+static const int& innerQuery(Context* context, int i) {
+  QUERY_BEGIN(innerQuery, context, i);
+  int result = i + inputQuery(context, 0);
+  return QUERY_END(result);
+}
+
+static const int& outerQuery(Context* context, int n) {
+  QUERY_BEGIN(outerQuery, context, n);
+  int result = 0;
+  for (int i = 0; i < n; i++) {
+    result += innerQuery(context, i);
+    // call it again to get a reused result
+    result -= innerQuery(context, i);
+  }
+  return QUERY_END(result);
+}
+
+static std::string readReport(Context* context,
+                              Context::QueryTimingFormat format) {
+  FILE* fp = tmpfile();
+  assert(fp);
+  context->writeQueryTimingReport(fp, format);
+  std::string ret;
+  rewind(fp);
+  int ch;
+  while ((ch = fgetc(fp)) != EOF) {
+    ret.push_back((char) ch);
+  }
+  fclose(fp);
+  printf("%s\n", ret.c_str());
+  return ret;
+}
+
+static const querydetail::QueryTimingStats& getStats(Context* context,
+                                        const char* queryName) {
+  static querydetail::QueryTimingStats empty;
+  const querydetail::QueryTimingStats* ret = &empty;
+  auto f = [&](const char* name, const querydetail::QueryTimingStats& stats) {
+    if (0 == strcmp(name, queryName)) ret = &stats;
+  };
+  context->forEachQueryTimingStats(f);
+  return *ret;
+}
+
+static void test0() {
+  printf("test0\n");
+  Context ctx;
+  Context* context = &ctx;
+  context->enableQueryTiming();
+
+  context->advanceToNextRevision(false);
+  inputValue = 1;
+  outerQuery(context, 10);
+
+  const auto& outer = getStats(context, "outerQuery");
+  const auto& inner = getStats(context, "innerQuery");
+  const auto& input = getStats(context, "inputQuery");
+  assert(outer.nComputed == 1 && outer.nReused == 0);
+  assert(inner.nComputed == 10 && inner.nReused == 10);
+  assert(input.nComputed == 1 && input.nReused == 9);
+  assert(outer.totalNs >= outer.childNs + outer.contextNs);
+  assert(outer.childNs >= inner.totalNs);
+
+  // change the input so that everything is recomputed
+  context->advanceToNextRevision(false);
+  inputValue = 2;
+  outerQuery(context, 10);
+  assert(outer.nRecomputed == 1);
+  assert(inner.nRecomputed == 10);
+  assert(input.nRecomputed == 1);
+
+  std::string json = readReport(context, Context::QUERY_TIMING_JSON);
+  assert(json.find("\"name\": \"outerQuery\"") != std::string::npos);
+  assert(json.find("\"name\": \"innerQuery\"") != std::string::npos);
+  // the outer query should be listed first since it takes the longest
+  assert(json.find("outerQuery") < json.find("innerQuery"));
+
+  std::string folded = readReport(context, Context::QUERY_TIMING_FOLDED);
+  assert(folded.find("outerQuery;innerQuery;inputQuery") != std::string::npos);
+  assert(folded.find("outerQuery;[Context]") != std::string::npos);
+}
+
+// Runs outerQuery in another Context while computing a query
+static Context* otherContext = nullptr;
+static const int& otherContextQuery(Context* context, int n) {
+  QUERY_BEGIN(otherContextQuery, context, n);
+  int result = outerQuery(otherContext, n);
+  return QUERY_END(result);
+}
+
+static void test1() {
+  printf("test1\n");
+  // query timing for nested Contexts on the same thread
+  // should be collected separately
+  Context ctx1;
+  Context ctx2;
+  ctx1.enableQueryTiming();
+  ctx2.enableQueryTiming();
+
+  ctx1.advanceToNextRevision(false);
+  ctx2.advanceToNextRevision(false);
+  inputValue = 1;
+  otherContext = &ctx2;
+  otherContextQuery(&ctx1, 3);
+
+  assert(getStats(&ctx1, "otherContextQuery").nComputed == 1);
+  assert(getStats(&ctx1, "outerQuery").nCalls() == 0);
+  assert(getStats(&ctx2, "outerQuery").nComputed == 1);
+  assert(getStats(&ctx2, "otherContextQuery").nCalls() == 0);
+
+  std::string folded1 = readReport(&ctx1, Context::QUERY_TIMING_FOLDED);
+  std::string folded2 = readReport(&ctx2, Context::QUERY_TIMING_FOLDED);
+  assert(folded1.find("outerQuery") == std::string::npos);
+  assert(folded2.find("otherContextQuery") == std::string::npos);
+  assert(folded2.find("outerQuery;innerQuery") != std::string::npos);
+}
+
+// Enables query timing while it is running
+static const int& enablingQuery(Context* context, int n) {
+  QUERY_BEGIN(enablingQuery, context, n);
+  context->enableQueryTiming();
+  int result = outerQuery(context, n);
+  return QUERY_END(result);
+}
+
+static void test2() {
+  printf("test2\n");
+  // enabling timing while a query is running should only
+  // collect timing for the queries started after that
+  Context ctx;
+  Context* context = &ctx;
+
+  context->advanceToNextRevision(false);
+  inputValue = 1;
+  enablingQuery(context, 4);
+
+  assert(getStats(context, "enablingQuery").nCalls() == 0);
+  assert(getStats(context, "outerQuery").nComputed == 1);
+  assert(getStats(context, "innerQuery").nComputed == 4);
+
+  // and it should work as usual after that
+  context->advanceToNextRevision(false);
+  enablingQuery(context, 4);
+  assert(getStats(context, "enablingQuery").nReused == 1);
+}
+
+int main() {
+  test0();
+  test1();
+  test2();
+  return 0;
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+  This test replays a sequence of edits to one of the standard modules
+  and checks how many queries are recomputed versus reused in each
+  revision, so that regressions in incremental reuse are noticed.
+
+  With --timing it also reports the latency of each revision. Other
+  arguments choose the module directory and the file to edit:
+
+    testIncrementalReuse [--timing] [--by-query]
+                         [--modules dir] [--edit File.chpl]
+
+  --by-query breaks the counts down by query.
+ */
+
+#include "chpl/parsing/parsing-queries.h"
+#include "chpl/queries/Context.h"
+#include "chpl/resolution/scope-queries.h"
+#include "chpl/uast/all-uast.h"
+
+// always check assertions in this test
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+using namespace chpl;
+using namespace parsing;
+using namespace resolution;
+using namespace uast;
+
+// These use qualified imports, which scope resolution does not handle yet.
+static const char* skipFiles[] = { "Random.chpl" };
+
+struct QueryCounts {
+  int64_t computed = 0;
+  int64_t recomputed = 0;
+  int64_t reused = 0;
+};
+
+using CountsByQuery = std::map<std::string, QueryCounts>;
+
+static CountsByQuery gatherCounts(Context* context) {
+  CountsByQuery ret;
+  context->forEachQueryTimingStats(
+    [&ret](const char* name, const querydetail::QueryTimingStats& t) {
+      QueryCounts& c = ret[name];
+      c.computed = t.nComputed;
+      c.recomputed = t.nRecomputed;
+      c.reused = t.nReused;
+    });
+  return ret;
+}
+
+// returns the counts in 'after' that are not in 'before'
+static CountsByQuery diffCounts(const CountsByQuery& before,
+                                const CountsByQuery& after) {
+  CountsByQuery ret;
+  for (const auto& pair : after) {
+    QueryCounts c = pair.second;
+    auto search = before.find(pair.first);
+    if (search != before.end()) {
+      c.computed -= search->second.computed;
+      c.recomputed -= search->second.recomputed;
+      c.reused -= search->second.reused;
+    }
+    ret[pair.first] = c;
+  }
+  return ret;
+}
+
+static QueryCounts countsFor(const CountsByQuery& counts, const char* name) {
+  auto search = counts.find(name);
+  if (search != counts.end()) return search->second;
+  return QueryCounts();
+}
+
+static QueryCounts totalCounts(const CountsByQuery& counts) {
+  QueryCounts ret;
+  for (const auto& pair : counts) {
+    // the file text is set for every file in every revision
+    if (pair.first == "fileText") continue;
+    ret.computed += pair.second.computed;
+    ret.recomputed += pair.second.recomputed;
+    ret.reused += pair.second.reused;
+  }
+  return ret;
+}
+
+static void resolveIdentifiers(Context* context, const ASTNode* ast) {
+  if (auto ident = ast->toIdentifier()) {
+    const Scope* scope = scopeForId(context, ast->id());
+    assert(scope != nullptr);
+    findInnermostDecl(context, scope, ident->name());
+  }
+  for (const ASTNode* child : ast->children()) {
+    resolveIdentifiers(context, child);
+  }
+}
+
+struct SourceFile {
+  std::string path;
+  std::string text;
+};
+
+static std::vector<SourceFile> readModules(const std::string& dir) {
+  std::vector<std::string> names;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    fprintf(stderr, "could not open directory %s\n", dir.c_str());
+    exit(-1);
+  }
+  while (struct dirent* ent = readdir(d)) {
+    std::string name = ent->d_name;
+    size_t len = name.size();
+    if (len > 5 && name.compare(len - 5, 5, ".chpl") == 0) {
+      bool skip = false;
+      for (const char* s : skipFiles) {
+        if (name == s) skip = true;
+      }
+      if (!skip) names.push_back(name);
+    }
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+
+  std::vector<SourceFile> ret;
+  for (const auto& name : names) {
+    SourceFile f;
+    f.path = dir + "/" + name;
+    std::ifstream file(f.path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    f.text = ss.str();
+    ret.push_back(std::move(f));
+  }
+  return ret;
+}
+
+// Set the text of each file and then parse and scope-resolve all of them
+// in a new revision. Returns the query counts for that revision.
+static CountsByQuery runRevision(Context* context,
+                                 const std::vector<SourceFile>& files,
+                                 double& elapsedMs) {
+  CountsByQuery before = gatherCounts(context);
+  auto start = std::chrono::steady_clock::now();
+
+  context->advanceToNextRevision(false);
+  for (const auto& f : files) {
+    auto path = UniqueString::build(context, f.path);
+    setFileText(context, path, f.text);
+  }
+  for (const auto& f : files) {
+    auto path = UniqueString::build(context, f.path);
+    const ModuleVec& mods = parse(context, path);
+    for (const Module* mod : mods) {
+      resolveIdentifiers(context, mod);
+    }
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  elapsedMs = std::chrono::duration<double, std::milli>(end - start).count();
+  return diffCounts(before, gatherCounts(context));
+}
+
+// The edits return false if they could not be applied to the text.
+
+static bool editNone(std::string& text) {
+  return true;
+}
+
+// e.g. adding a license header or reformatting
+static bool editInsertLineAtTop(std::string& text) {
+  text = "\n" + text;
+  return true;
+}
+
+// add a statement at the start of the first proc body
+static bool editProcBody(std::string& text) {
+  size_t proc = text.find("\n  proc ");
+  if (proc == std::string::npos) return false;
+  size_t brace = text.find('{', proc);
+  if (brace == std::string::npos) return false;
+  text.insert(brace + 1, "\n    var addedByEdit = 1;");
+  return true;
+}
+
+// add a new proc at the end of the module
+static bool editAddProc(std::string& text) {
+  size_t close = text.rfind('}');
+  if (close == std::string::npos) return false;
+  text.insert(close, "  proc addedByEdit() { return 1; }\n");
+  return true;
+}
+
+struct Edit {
+  const char* name;
+  bool (*apply)(std::string& text);
+};
+
+static const Edit edits[] = {
+  { "no change",              editNone },
+  { "insert line at top",     editInsertLineAtTop },
+  { "edit proc body",         editProcBody },
+  { "add proc",               editAddProc },
+  { "revert",                 editNone },
+};
+
+static void printCounts(const char* name, double elapsedMs,
+                        const CountsByQuery& counts) {
+  QueryCounts total = totalCounts(counts);
+  QueryCounts lookups = countsFor(counts, "findInnermostDecl");
+  printf("%-20s %9.2f ms  computed %7lld  recomputed %7lld  reused %8lld"
+         "  findInnermostDecl run %lld/%lld\n",
+         name, elapsedMs,
+         (long long) total.computed,
+         (long long) total.recomputed,
+         (long long) total.reused,
+         (long long) (lookups.computed + lookups.recomputed),
+         (long long) (lookups.computed + lookups.recomputed + lookups.reused));
+  fflush(stdout);
+}
+
+static void printCountsByQuery(const CountsByQuery& counts) {
+  for (const auto& pair : counts) {
+    const QueryCounts& c = pair.second;
+    if (c.computed == 0 && c.recomputed == 0 && c.reused == 0) continue;
+    printf("    %-36s computed %7lld  recomputed %7lld  reused %8lld\n",
+           pair.first.c_str(),
+           (long long) c.computed,
+           (long long) c.recomputed,
+           (long long) c.reused);
+  }
+  fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+  std::string modulesDir = CHPL_MODULES_DIR;
+  std::string editFile = "List.chpl";
+  bool printTiming = false;
+  bool printByQuery = false;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "--timing"))
+      printTiming = true;
+    else if (0 == strcmp(argv[i], "--by-query"))
+      printTiming = printByQuery = true;
+    else if (0 == strcmp(argv[i], "--modules") && i+1 < argc)
+      modulesDir = argv[++i];
+    else if (0 == strcmp(argv[i], "--edit") && i+1 < argc)
+      editFile = argv[++i];
+  }
+
+  std::vector<SourceFile> files = readModules(modulesDir + "/standard");
+  assert(files.size() > 0);
+  size_t editIdx = files.size();
+  for (size_t i = 0; i < files.size(); i++) {
+    const std::string& p = files[i].path;
+    if (p.size() >= editFile.size() &&
+        p.compare(p.size() - editFile.size(), editFile.size(), editFile) == 0) {
+      editIdx = i;
+    }
+  }
+  assert(editIdx < files.size());
+  const std::string original = files[editIdx].text;
+
+  Context context;
+  Context* ctx = &context;
+  // the standard modules refer to things that are not resolved yet
+  ctx->setErrorHandler([](const ErrorMessage& err) { });
+  ctx->enableQueryTiming();
+
+  double elapsedMs = 0.0;
+  CountsByQuery initial = runRevision(ctx, files, elapsedMs);
+  QueryCounts initialTotal = totalCounts(initial);
+  assert(initialTotal.computed > 0);
+  if (printTiming) {
+    printf("%zu files, editing %s\n", files.size(), editFile.c_str());
+    printCounts("initial", elapsedMs, initial);
+    if (printByQuery) printCountsByQuery(initial);
+  }
+
+  for (const Edit& edit : edits) {
+    std::string text = original;
+    bool applied = edit.apply(text);
+    assert(applied);
+    files[editIdx].text = text;
+
+    CountsByQuery counts = runRevision(ctx, files, elapsedMs);
+    if (printTiming) {
+      printCounts(edit.name, elapsedMs, counts);
+      if (printByQuery) printCountsByQuery(counts);
+    }
+
+    QueryCounts total = totalCounts(counts);
+    QueryCounts lookups = countsFor(counts, "findInnermostDecl");
+    QueryCounts parses = countsFor(counts, "parseFile");
+
+    // Nothing is computed again unless it depends on the edited file,
+    // so only that file is parsed again.
+    assert(parses.computed + parses.recomputed <= 1);
+    // The lookups depend on more than one file (through use statements),
+    // but most of them should be reused.
+    assert(5*(lookups.computed + lookups.recomputed) <=
+           lookups.computed + lookups.recomputed + lookups.reused);
+
+    if (0 == strcmp(edit.name, "no change")) {
+      // the text is the same as in the previous revision
+      assert(total.computed == 0);
+      assert(total.recomputed == 0);
+    }
+    if (edit.apply == editInsertLineAtTop) {
+      // Only Locations change, so no new lookups are needed. Some
+      // lookups in the edited file are still run again because the
+      // queries they depend on are recomputed with the new parse result.
+      assert(lookups.computed == 0);
+    }
+  }
+
+  return 0;
+}
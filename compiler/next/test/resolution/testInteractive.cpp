@@ -29,6 +29,16 @@
 #endif
 
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
 
 using namespace chpl;
 using namespace parsing;
@@ -76,21 +86,162 @@ static void findInnermostDecls(Context* context, const ASTNode* ast) {
   }
 }
 
+static void resolveIdentifiers(Context* context, const ASTNode* ast) {
+  if (auto ident = ast->toIdentifier()) {
+    const Scope* scope = scopeForId(context, ast->id());
+    assert(scope != nullptr);
+    findInnermostDecl(context, scope, ident->name());
+  }
+  for (const ASTNode* child : ast->children()) {
+    resolveIdentifiers(context, child);
+  }
+}
+
+struct WatchedFile {
+  UniqueString path;
+  std::string text;
+  struct timespec mtime = {0, 0};
+  off_t size = -1;
+};
+
+// Returns true if the file changed on disk since it was last read,
+// in which case its text is updated.
+static bool refreshWatchedFile(WatchedFile& f) {
+  struct stat st;
+  if (stat(f.path.c_str(), &st) != 0) {
+    // leave the text alone if the file is being replaced
+    return false;
+  }
+  if (st.st_size == f.size &&
+      st.st_mtim.tv_sec == f.mtime.tv_sec &&
+      st.st_mtim.tv_nsec == f.mtime.tv_nsec) {
+    return false;
+  }
+  std::ifstream file(f.path.c_str());
+  std::stringstream ss;
+  ss << file.rdbuf();
+  f.text = ss.str();
+  f.mtime = st.st_mtim;
+  f.size = st.st_size;
+  return true;
+}
+
+struct RevisionCounts {
+  int64_t computed = 0;
+  int64_t recomputed = 0;
+  int64_t reused = 0;
+};
+
+static RevisionCounts gatherCounts(Context* context) {
+  RevisionCounts ret;
+  context->forEachQueryTimingStats(
+    [&ret](const char* name, const querydetail::QueryTimingStats& t) {
+      ret.computed += t.nComputed;
+      ret.recomputed += t.nRecomputed;
+      ret.reused += t.nReused;
+    });
+  return ret;
+}
+
+// Keeps the Context alive and re-resolves the files whenever one of them
+// changes on disk, reporting the latency and query reuse of each revision.
+static int watchFiles(Context* ctx, const std::vector<const char*>& paths,
+                      int intervalMs, int gcEvery) {
+  std::vector<WatchedFile> files;
+  for (const char* p : paths) {
+    WatchedFile f;
+    f.path = UniqueString::build(ctx, p);
+    files.push_back(f);
+  }
+
+  ctx->setErrorHandler([](const ErrorMessage& err) { });
+  ctx->enableQueryTiming();
+
+  int revision = 0;
+  while (true) {
+    int nChanged = 0;
+    for (auto& f : files) {
+      if (refreshWatchedFile(f)) nChanged++;
+    }
+    if (nChanged == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+      continue;
+    }
+
+    revision++;
+    bool gc = gcEvery > 0 && revision % gcEvery == 0;
+    RevisionCounts before = gatherCounts(ctx);
+    auto start = std::chrono::steady_clock::now();
+
+    ctx->advanceToNextRevision(gc);
+    // set the text of every file so that the unchanged ones
+    // are not read from disk again
+    for (const auto& f : files) {
+      setFileText(ctx, f.path, f.text);
+    }
+    for (const auto& f : files) {
+      const ModuleVec& mods = parse(ctx, f.path);
+      for (const auto mod : mods) {
+        resolveIdentifiers(ctx, mod);
+      }
+    }
+    if (gc) {
+      ctx->collectGarbage();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    RevisionCounts after = gatherCounts(ctx);
+    printf("revision %d: %d file(s) changed, %.2f ms, "
+           "computed %lld recomputed %lld reused %lld%s\n",
+           revision, nChanged, ms,
+           (long long) (after.computed - before.computed),
+           (long long) (after.recomputed - before.recomputed),
+           (long long) (after.reused - before.reused),
+           gc ? " (collected garbage)" : "");
+    fflush(stdout);
+  }
+
+  return 0;
+}
+
 int main(int argc, char** argv) {
 
   if (argc == 1) {
     printf("Usage: %s file.chpl otherFile.chpl ...\n", argv[0]);
+    printf("       %s --watch [--interval ms] [--gc-every n] "
+           "file.chpl otherFile.chpl ...\n", argv[0]);
     return 0; // need this to return 0 for testing to be happy
   }
 
+  bool watch = false;
+  int intervalMs = 200;
+  int gcEvery = 10;
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "--watch")) {
+      watch = true;
+    } else if (0 == strcmp(argv[i], "--interval") && i+1 < argc) {
+      intervalMs = atoi(argv[++i]);
+    } else if (0 == strcmp(argv[i], "--gc-every") && i+1 < argc) {
+      gcEvery = atoi(argv[++i]);
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+
   bool gc = false;
   Context context;
   Context* ctx = &context;
 
+  if (watch) {
+    return watchFiles(ctx, paths, intervalMs, gcEvery);
+  }
+
   while (true) {
     ctx->advanceToNextRevision(gc);
-    for (int i = 1; i < argc; i++) {
-      auto filepath = UniqueString::build(ctx, argv[i]);
+    for (const char* path : paths) {
+      auto filepath = UniqueString::build(ctx, path);
 
       const ModuleVec& mods = parse(ctx, filepath);
       for (const auto mod : mods) {
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chpl/queries/Context.h"
+#include "chpl/queries/Location.h"
+#include "chpl/queries/UniqueString.h"
+#include "chpl/uast/ASTAllocator.h"
+#include "chpl/uast/Block.h"
+#include "chpl/uast/Builder.h"
+#include "chpl/uast/Identifier.h"
+
+// always check assertions in this test
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+using namespace chpl;
+using namespace uast;
+
+static owned<Block> buildBlock(Builder* b, Location loc, int n) {
+  auto name = UniqueString::build(b->context(), "x");
+  ASTList stmts;
+  for (int i = 0; i < n; i++) {
+    stmts.push_back(Identifier::build(b, loc, name));
+  }
+  return Block::build(b, loc, std::move(stmts));
+}
+
+// nodes built one after another are next to each other in memory
+static void test0() {
+  printf("test0\n");
+  Context context;
+  Context* ctx = &context;
+  auto builder = Builder::build(ctx, "test0.chpl");
+  Builder* b = builder.get();
+  Location loc(UniqueString::build(ctx, "test0.chpl"));
+
+  auto name = UniqueString::build(ctx, "x");
+  std::vector<owned<Identifier>> ids;
+  for (int i = 0; i < 100; i++) {
+    ids.push_back(Identifier::build(b, loc, name));
+  }
+
+  int adjacent = 0;
+  for (int i = 1; i < 100; i++) {
+    const char* prev = (const char*) ids[i-1].get();
+    const char* cur = (const char*) ids[i].get();
+    assert(prev != cur);
+    if (cur > prev && cur - prev < 2*(ptrdiff_t)sizeof(Identifier))
+      adjacent++;
+  }
+  // only a new chunk should separate consecutive nodes
+  assert(adjacent >= 98);
+}
+
+// chunks are released once the nodes in them are freed
+static void test1() {
+  printf("test1\n");
+  size_t before = uast::detail::numASTChunksInUse();
+  {
+    Context context;
+    Context* ctx = &context;
+    auto builder = Builder::build(ctx, "test1.chpl");
+    Builder* b = builder.get();
+    Location loc(UniqueString::build(ctx, "test1.chpl"));
+
+    std::vector<owned<Block>> blocks;
+    for (int i = 0; i < 100; i++) {
+      blocks.push_back(buildBlock(b, loc, 100));
+    }
+    assert(blocks[50]->numStmts() == 100);
+    assert(uast::detail::numASTChunksInUse() > before + 1);
+  }
+  // the current thread may still be allocating from one chunk
+  assert(uast::detail::numASTChunksInUse() <= before + 1);
+}
+
+// nodes allocated on other threads can be freed on this thread
+static void test2() {
+  printf("test2\n");
+  size_t before = uast::detail::numASTChunksInUse();
+  {
+    Context context;
+    Context* ctx = &context;
+    Location loc(UniqueString::build(ctx, "test2.chpl"));
+    // build the UniqueString before the threads to avoid racing on it
+    UniqueString::build(ctx, "x");
+
+    // Each thread uses its own Builder, since a Builder is not
+    // thread-safe; only the allocator is shared.
+    const int nThreads = 4;
+    std::vector<owned<Builder>> builders;
+    for (int t = 0; t < nThreads; t++) {
+      builders.push_back(Builder::build(ctx, "test2.chpl"));
+    }
+    std::vector<owned<Block>> blocks(nThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++) {
+      Builder* b = builders[t].get();
+      threads.push_back(std::thread([&blocks, b, loc, t]() {
+        blocks[t] = buildBlock(b, loc, 1000);
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (int t = 0; t < nThreads; t++) {
+      assert(blocks[t]->numStmts() == 1000);
+    }
+    // the threads have exited but their nodes are still live
+    assert(uast::detail::numASTChunksInUse() > before);
+  }
+  assert(uast::detail::numASTChunksInUse() <= before);
+}
+
+int main(int argc, char** argv) {
+  test0();
+  test1();
+  test2();
+
+  return 0;
+}
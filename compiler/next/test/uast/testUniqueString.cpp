@@ -25,12 +25,17 @@
 #undef NDEBUG
 #endif
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
 
 using namespace chpl;
 
@@ -81,7 +86,7 @@ static void testPerformance(Context* ctx,
   std::chrono::duration<double> elapsed = end - start;
 
   if (printTiming) {
-    std::cout << "unordered map elapsed time: " << elapsed.count() << " s\n";
+    std::cout << "moby.txt elapsed time: " << elapsed.count() << " s\n";
 
     if (dohisto) {
       std::cout << "Queried " << nqueries << " strings\n";
@@ -96,6 +101,112 @@ static void testPerformance(Context* ctx,
   }
 }
 
+// Append the identifiers and string literals in the Chapel source 'text'
+// to 'tokens'. This approximates the strings the parser will intern.
+static void gatherTokens(const std::string& text,
+                         std::vector<std::string>& tokens) {
+  size_t n = text.size();
+  size_t i = 0;
+  while (i < n) {
+    char c = text[i];
+    if (c == '/' && i+1 < n && text[i+1] == '/') {
+      while (i < n && text[i] != '\n') i++;
+    } else if (c == '/' && i+1 < n && text[i+1] == '*') {
+      size_t end = text.find("*/", i+2);
+      i = (end == std::string::npos) ? n : end + 2;
+    } else if (c == '"' || c == '\'') {
+      size_t start = ++i;
+      while (i < n && text[i] != c && text[i] != '\n') {
+        if (text[i] == '\\') i++;
+        i++;
+      }
+      std::string str = text.substr(start, std::min(i, n) - start);
+      if (str.find('\0') == std::string::npos) tokens.push_back(str);
+      i++;
+    } else if (isalpha((unsigned char) c) || c == '_') {
+      size_t start = i;
+      while (i < n && (isalnum((unsigned char) text[i]) ||
+                       text[i] == '_' || text[i] == '$')) {
+        i++;
+      }
+      tokens.push_back(text.substr(start, i - start));
+    } else {
+      i++;
+    }
+  }
+}
+
+static void gatherTokensInDir(const std::string& dir,
+                              std::vector<std::string>& tokens) {
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    std::cerr << "could not open directory " << dir << "\n";
+    exit(-1);
+  }
+  std::vector<std::string> names;
+  while (struct dirent* ent = readdir(d)) {
+    if (ent->d_name[0] != '.') names.push_back(ent->d_name);
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+
+  for (const auto& name : names) {
+    std::string path = dir + "/" + name;
+    size_t len = name.size();
+    if (len > 5 && name.compare(len - 5, 5, ".chpl") == 0) {
+      std::ifstream file(path);
+      std::stringstream ss;
+      ss << file.rdbuf();
+      gatherTokens(ss.str(), tokens);
+    } else if (DIR* sub = opendir(path.c_str())) {
+      closedir(sub);
+      gatherTokensInDir(path, tokens);
+    }
+  }
+}
+
+// Measure how quickly the identifiers and string literals
+// in the module code can be interned, with 1 and with nThreads threads.
+static void testModulesPerformance(const char* modulesDir,
+                                   bool printTiming,
+                                   int nThreads) {
+  std::vector<std::string> tokens;
+  gatherTokensInDir(modulesDir, tokens);
+  assert(tokens.size() > 0);
+
+  int repeat = 5;
+  for (int threads = 1; threads <= nThreads; threads *= 2) {
+    Context context;
+    Context* ctx = &context;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+      workers.push_back(std::thread([&tokens, ctx, repeat]() {
+        for (int i = 0; i < repeat; i++) {
+          for (const auto& tok : tokens) {
+            UniqueString::build(ctx, tok.c_str(), tok.size());
+          }
+        }
+      }));
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    if (printTiming) {
+      double nBuilt = (double) tokens.size() * repeat * threads;
+      std::cout << "modules tokens: " << tokens.size()
+                << " threads: " << threads
+                << " elapsed time: " << elapsed.count() << " s"
+                << " (" << (nBuilt / elapsed.count() / 1e6)
+                << " M strings/s)\n";
+    }
+  }
+}
+
 static void test0() {
   Context context;
   Context* ctx = &context;
@@ -187,25 +298,86 @@ static void test1() {
   assert(t1.hash() != h1.hash());
 }
 
+// check that strings built concurrently are unique
+// and that unmarked strings are garbage collected
+static void test2() {
+  Context context;
+  Context* ctx = &context;
+
+  const int nThreads = 4;
+  const int nStrings = 10000;
+  std::vector<std::vector<const char*>> results(nThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nThreads; t++) {
+    threads.push_back(std::thread([&results, ctx, t]() {
+      for (int i = 0; i < nStrings; i++) {
+        // visit the strings in a different order on each thread
+        int j = (t % 2 == 0) ? i : nStrings - 1 - i;
+        std::string str = "aLongerString" + std::to_string(j);
+        results[t].push_back(ctx->uniqueCString(str.c_str()));
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < nThreads; t++) {
+    for (int i = 0; i < nStrings; i++) {
+      int j = (t % 2 == 0) ? i : nStrings - 1 - i;
+      const char* s = results[t][i];
+      assert(s == results[0][j]);
+      assert(std::string(s) == "aLongerString" + std::to_string(j));
+    }
+  }
+
+  // a truncated string is the same as the null-terminated one
+  assert(ctx->uniqueCString("aLongerString12345", 17) == results[0][1234]);
+  // as are strings that are prefixes of other strings in the table
+  assert(ctx->uniqueCString("aLongerString12345", 14) == results[0][1]);
+  assert(ctx->uniqueCString("aLongerString12345", 15) == results[0][12]);
+
+  // mark only the even strings, and check that the others are collected
+  ctx->advanceToNextRevision(true);
+  for (int i = 0; i < nStrings; i += 2) {
+    ctx->markUniqueCString(results[0][i]);
+  }
+  ctx->collectGarbage();
+  for (int i = 0; i < nStrings; i += 2) {
+    std::string str = "aLongerString" + std::to_string(i);
+    assert(ctx->uniqueCString(str.c_str()) == results[0][i]);
+  }
+}
+
 
 int main(int argc, char** argv) {
   const char* inputFile = "moby.txt";
+  const char* modulesDir = CHPL_MODULES_DIR;
+  int nThreads = 4;
   std::string timingArg = "--timing";
+  std::string modulesArg = "--modules";
+  std::string threadsArg = "--threads";
   bool printTiming = false;
   for (int i = 1; i < argc; i++) {
     if (argv[i] == timingArg)
       printTiming = true;
+    else if (argv[i] == modulesArg && i+1 < argc)
+      modulesDir = argv[++i];
+    else if (argv[i] == threadsArg && i+1 < argc)
+      nThreads = atoi(argv[++i]);
     else
       inputFile = argv[i];
   }
 
   test0();
   test1();
+  test2();
 
   Context context;
   Context* ctx = &context;
 
   // Next, measure performance
   testPerformance(ctx, inputFile, printTiming);
+  testModulesPerformance(modulesDir, printTiming, nThreads);
   return 0;
 }
@@ -25,13 +25,24 @@
 //
 // chpl_TableEntry is the type for each hashtable slot
 // chpl__hashtable is the record implementing a hashtable
+// chpl__hashtableLocks lets several tasks add to a chpl__hashtable at once
 // chpl__defaultHash is the default hash function for most types
+//
+// A chpl__hashtable uses one of two layouts. By default the table size
+// is a prime and each lookup probes the entries quadratically. With
+// swiss=true, the table size is a power of two and a separate array of
+// control bytes holds a 7-bit fingerprint of the hash of each full slot.
+// Lookups scan the control bytes a group of 8 slots at a time and only
+// compare keys whose fingerprint matches.
 pragma "unsafe"
 module ChapelHashtable {
 
-  use ChapelBase, DSIUtil;
+  use ChapelBase, DSIUtil, ChapelLocks;
+
+  private use CPtr, Atomics, BitOps;
 
-  private use CPtr;
+  // Number of key and slot lock stripes in a chpl__hashtableLocks.
+  config param parSafeHashtableLockStripes = 256;
 
   // empty needs to be 0 so memset 0 sets it
   enum chpl__hash_status { empty=0, full, deleted };
@@ -57,6 +68,52 @@ module ChapelHashtable {
      27021597764222939, 54043195528445869, 108086391056891903, 216172782113783773,
      432345564227567561, 864691128455135207);
 
+  // ### swiss layout helpers ###
+
+  // slots per group of control bytes, which are read as one uint(64)
+  private param swissGroupWidth = 8;
+
+  // control byte values; full slots store the low 7 bits of the hash
+  private param swissCtrlEmpty = 0x80:uint(8);
+  private param swissCtrlDeleted = 0xFE:uint(8);
+
+  private param swissLsbs = 0x0101010101010101:uint;
+  private param swissMsbs = 0x8080808080808080:uint;
+
+  // Returns a mask with the high bit of byte i set if byte i of
+  // 'group' equals 'b'. This is exact: no neighboring byte can produce
+  // a false match.
+  private inline proc _swissMatch(group: uint, b: uint(8)): uint {
+    const x = group ^ (swissLsbs * b:uint);
+    // the high bit of a byte of t is set if that byte of x is nonzero
+    const t = ((x & ~swissMsbs) + ~swissMsbs) | x;
+    return ~t & swissMsbs;
+  }
+
+  // Returns a mask with the high bit set for each empty or deleted slot.
+  private inline proc _swissMatchOpen(group: uint): uint {
+    return group & swissMsbs;
+  }
+
+  // Returns the offset in its group of the lowest slot set in 'mask'.
+  // (The control bytes are read as a little-endian word.)
+  private inline proc _swissFirst(mask: uint): int {
+    return (ctz(mask) / 8):int;
+  }
+
+  private proc _allocateCtrl(size: int) {
+    var ret: _ddata(uint(8));
+    if size > 0 {
+      var callPostAlloc: bool;
+      ret = _ddata_allocate_noinit(uint(8), size, callPostAlloc);
+      c_memset(c_ptrTo(ret[0]), swissCtrlEmpty, size);
+      if callPostAlloc {
+        _ddata_allocate_postalloc(ret, size);
+      }
+    }
+    return ret;
+  }
+
   // ### allocation helpers ###
 
   // returns the value referred to by arg
@@ -256,9 +313,56 @@ module ChapelHashtable {
     proc finishRehash(oldSize: int) { }
   }
 
+  // Locks used by parSafe associative domains so that adds and lookups
+  // from many tasks can proceed at the same time.
+  //
+  // Adds and lookups hold 'resizeLock' for reading. Anything that moves
+  // entries or removes them (rehash, remove, clear) holds it for writing.
+  // Under the read lock, adds of the same key are serialized by a key
+  // stripe, and adds racing for the same empty slot by a slot stripe.
+  // Slot statuses and control bytes are read under the slot stripe too,
+  // since another task may be filling the slot. A task holds at most
+  // one of each stripe and takes the key stripe first.
+  record chpl__hashtableLocks {
+    var resizeLock: chpl_LocalRWSpinlock;
+    var keyLocks: _ddata(chpl_LocalSpinlock);
+    var slotLocks: _ddata(chpl_LocalSpinlock);
+
+    // Slots filled, and deleted slots reused, by adds holding the read
+    // lock. These are moved into the table counts by
+    // chpl__hashtable.foldConcurrentCounts.
+    var numFilled: chpl__processorAtomicType(int);
+    var numReused: chpl__processorAtomicType(int);
+
+    proc init() {
+      this.complete();
+      keyLocks = _ddata_allocate(chpl_LocalSpinlock,
+                                 parSafeHashtableLockStripes);
+      slotLocks = _ddata_allocate(chpl_LocalSpinlock,
+                                  parSafeHashtableLockStripes);
+    }
+    proc deinit() {
+      _ddata_free(keyLocks, parSafeHashtableLockStripes);
+      _ddata_free(slotLocks, parSafeHashtableLockStripes);
+    }
+
+    inline proc keyLock(key) ref {
+      const h = chpl__defaultHashWrapper(key):uint;
+      return keyLocks[(h % parSafeHashtableLockStripes:uint):int];
+    }
+    // The slots of a swiss group share a stripe, so that their control
+    // bytes can be read together.
+    inline proc slotLock(slotNum: int) ref {
+      return slotLocks[(slotNum / swissGroupWidth) %
+                       parSafeHashtableLockStripes];
+    }
+  }
+
   record chpl__hashtable {
     type keyType;
     type valType;
+    // use the power-of-two sized layout with control bytes
+    param swiss: bool = false;
 
     var tableNumFullSlots: int;
     var tableNumDeletedSlots: int;
@@ -267,27 +371,43 @@ module ChapelHashtable {
     var tableSize: int;
     var table: _ddata(chpl_TableEntry(keyType, valType)); // 0..<tableSize
 
+    // control byte for each slot when swiss, 0..<tableSize
+    var ctrl: if swiss then _ddata(uint(8)) else nothing;
+
     var rehashHelpers: owned chpl__rehashHelpers?;
 
     var postponeResize: bool;
 
-    proc init(type keyType, type valType,
+    // The slot findAvailableSlot last returned in the swiss layout, and
+    // the control byte for its key, so fillSlot need not hash the key
+    // again
+    var swissFillSlot: if swiss then int else nothing;
+    var swissFillH2: if swiss then uint(8) else nothing;
+
+    proc init(type keyType, type valType, param swiss: bool = false,
               in rehashHelpers: owned chpl__rehashHelpers? = nil) {
       this.keyType = keyType;
       this.valType = valType;
+      this.swiss = swiss;
       this.tableNumFullSlots = 0;
       this.tableNumDeletedSlots = 0;
       this.tableSizeNum = 0;
-      this.tableSize = chpl__primes(tableSizeNum);
+      this.tableSize = 0;
       this.rehashHelpers = rehashHelpers;
       this.postponeResize = false;
+      if swiss then
+        this.swissFillSlot = -1;
       this.complete();
 
+      this.tableSize = _sizeForSizeNum(tableSizeNum);
+
       // allocates a _ddata(chpl_TableEntry(keyType,valType)) storing the table
       // All elements are memset to 0 (no initializer is run for the idxType)
       // This allows them to be empty, but the key and val
       // are considered uninitialized.
       this.table = allocateTable(this.tableSize);
+      if swiss then
+        this.ctrl = _allocateCtrl(this.tableSize);
     }
     proc deinit() {
       // Go through the full slots in the current table and run
@@ -313,6 +433,8 @@ module ChapelHashtable {
 
       // Free the buffer
       _freeData(table, tableSize);
+      if swiss then
+        _freeData(ctrl, tableSize);
     }
 
     // #### iteration helpers ####
@@ -364,10 +486,20 @@ module ChapelHashtable {
     // empty slot that may be re-used for faster addition to the domain
     //
     // This function never returns deleted slots.
-    proc _findSlot(key: keyType) : (bool, int) {
+    //
+    // 'locks' should be passed when other tasks may be filling slots.
+    // The status of each slot is then read under its slot stripe, which
+    // publishSlotConcurrent also holds, so the key of a full slot has
+    // been written by the time it is compared.
+    proc _findSlot(key: keyType, locks: ?locksType = none) : (bool, int) {
+      if swiss {
+        const (foundSlot, slotNum, _) = _findSlotSwiss(key, locks);
+        return (foundSlot, slotNum);
+      }
+
       var firstOpen = -1;
       for slotNum in _lookForSlots(key) {
-        const slotStatus = table[slotNum].status;
+        const slotStatus = _readStatus(slotNum, locks);
         // if we encounter a slot that's empty, our element could not
         // be found past this point.
         if (slotStatus == chpl__hash_status.empty) {
@@ -384,6 +516,103 @@ module ChapelHashtable {
       return (false, -1);
     }
 
+    // Like _findSlot, but also returns the control byte for 'key', which
+    // the swiss layout needs to fill the slot. It is 0 in the prime
+    // layout.
+    proc _findSlotForAdd(key: keyType,
+                         locks: ?locksType = none) : (bool, int, uint(8)) {
+      if swiss then
+        return _findSlotSwiss(key, locks);
+      const (foundSlot, slotNum) = _findSlot(key, locks);
+      return (foundSlot, slotNum, 0:uint(8));
+    }
+
+    // _findSlot for the swiss layout. Groups are probed in triangular
+    // order, which visits every group once since the number of groups
+    // is a power of two. Also returns the control byte for 'key'.
+    proc _findSlotSwiss(key: keyType, locks) : (bool, int, uint(8)) {
+      const hash = chpl__defaultHashWrapper(key):uint;
+      const h2 = _swissH2(hash);
+      if tableSize == 0 then
+        return (false, -1, h2);
+
+      const groupMask = (tableSize / swissGroupWidth - 1):uint;
+      var group = (hash >> 7) & groupMask;
+      var firstOpen = -1;
+      for probe in 1:uint..groupMask+1 {
+        const base = group:int * swissGroupWidth;
+        const ctrlGroup = _readGroup(base, locks);
+
+        var matches = _swissMatch(ctrlGroup, h2);
+        while matches != 0 {
+          const slotNum = base + _swissFirst(matches);
+          if table[slotNum].key == key {
+            return (true, slotNum, h2);
+          }
+          matches &= matches - 1;
+        }
+
+        const open = _swissMatchOpen(ctrlGroup);
+        if firstOpen == -1 && open != 0 then
+          firstOpen = base + _swissFirst(open);
+
+        // if a group has an empty slot, our element could not
+        // be found past this point.
+        if _swissMatch(ctrlGroup, swissCtrlEmpty) != 0 then
+          return (false, firstOpen, h2);
+
+        group = (group + probe) & groupMask;
+      }
+      return (false, firstOpen, h2);
+    }
+
+    inline proc _swissH2(hash: uint): uint(8) {
+      return (hash & 0x7f):uint(8);
+    }
+
+    // reads the control bytes for the group starting at slot 'base'
+    inline proc _swissGroup(base: int): uint {
+      // memcpy rather than a pointer cast to stay clear of aliasing
+      // rules; the backend turns it into a single load
+      var ret: uint;
+      c_memcpy(c_ptrTo(ret), c_ptrTo(ctrl[base]), swissGroupWidth);
+      return ret;
+    }
+
+    // Reads the status of a slot, under its slot stripe if 'locks' is
+    // a chpl__hashtableLocks
+    inline proc _readStatus(slotNum: int, locks) {
+      if locks.type == nothing {
+        return table[slotNum].status;
+      } else {
+        ref slotLock = locks.slotLock(slotNum);
+        slotLock.lock();
+        const ret = table[slotNum].status;
+        slotLock.unlock();
+        return ret;
+      }
+    }
+
+    // Reads the control bytes for a group, under its slot stripe if
+    // 'locks' is a chpl__hashtableLocks. A group shares one stripe.
+    inline proc _readGroup(base: int, locks) {
+      if locks.type == nothing {
+        return _swissGroup(base);
+      } else {
+        ref slotLock = locks.slotLock(base);
+        slotLock.lock();
+        const ret = _swissGroup(base);
+        slotLock.unlock();
+        return ret;
+      }
+    }
+
+    // Sets the control byte for a slot that was just filled with a key
+    // whose control byte is h2, as returned by _findSlotForAdd.
+    inline proc _swissSetFull(slotNum: int, h2: uint(8)) {
+      ctrl[slotNum] = h2;
+    }
+
     iter _lookForSlots(key: keyType, numSlots = tableSize) {
       const baseSlot = chpl__defaultHashWrapper(key):uint;
       if numSlots == 0 then return;
@@ -398,6 +627,19 @@ module ChapelHashtable {
     //  findAvailableSlot
     //  fillSlot
 
+    // Returns true if the table should grow before adding another key.
+    // The prime layout keeps at most half of the slots in use; the swiss
+    // layout can go to 7/8 since its probes do not lengthen as quickly.
+    inline proc _needsGrow(numFull: int, numDeleted: int): bool {
+      return _needsGrowAtSize(numFull+numDeleted, tableSize);
+    }
+    inline proc _needsGrowAtSize(numUsed: int, size: int): bool {
+      if swiss then
+        return (numUsed+1)*8 > size*7;
+      else
+        return (numUsed+1)*2 > size;
+    }
+
     // Finds a slot available for adding a key
     // or a slot that was already present with that key.
     // It can rehash the table.
@@ -406,26 +648,23 @@ module ChapelHashtable {
       var slotNum = -1;
       var foundSlot = false;
 
-      if (tableNumFullSlots+tableNumDeletedSlots+1)*2 > tableSize {
+      if _needsGrow(tableNumFullSlots, tableNumDeletedSlots) {
         resize(grow=true);
       }
 
       // Note that when adding elements, if a deleted slot is encountered,
       // later slots need to be checked for the value.
       // That is why this uses the same function that looks for filled slots.
-      (foundSlot, slotNum) = _findSlot(key);
+      var h2: uint(8);
+      (foundSlot, slotNum, h2) = _findSlotForAdd(key);
 
-      if slotNum >= 0 {
-        return (foundSlot, slotNum);
-      } else {
-        // slotNum < 0
-        //
+      if slotNum < 0 {
         // This can happen if there are too many deleted elements in the
         // table. In that event, we can garbage collect the table by rehashing
         // everything now.
         rehash(tableSizeNum, tableSize);
 
-        (foundSlot, slotNum) = _findSlot(key);
+        (foundSlot, slotNum, h2) = _findSlotForAdd(key);
 
         if slotNum < 0 {
           // This shouldn't be possible since we just garbage collected
@@ -434,13 +673,41 @@ module ChapelHashtable {
           halt("couldn't add key -- ", tableNumFullSlots, " / ", tableSize, " taken");
           return (false, -1);
         }
-        return (foundSlot, slotNum);
       }
+
+      if swiss {
+        swissFillSlot = slotNum;
+        swissFillH2 = h2;
+      }
+      return (foundSlot, slotNum);
     }
 
     proc fillSlot(ref tableEntry: chpl_TableEntry(keyType, valType),
                   in key: keyType,
                   in val: valType) {
+      if swiss then
+        compilerError("swiss hashtables need the slot number to fill a slot");
+      _fillEntry(tableEntry, key, val);
+    }
+    proc fillSlot(slotNum: int,
+                  in key: keyType,
+                  in val: valType) {
+      ref tableEntry = table[slotNum];
+      if swiss {
+        // findAvailableSlot already hashed the key if it found this slot
+        const h2 = if slotNum == swissFillSlot
+                   then swissFillH2
+                   else _swissH2(chpl__defaultHashWrapper(key):uint);
+        swissFillSlot = -1;
+        _fillEntry(tableEntry, key, val);
+        _swissSetFull(slotNum, h2);
+      } else {
+        _fillEntry(tableEntry, key, val);
+      }
+    }
+    proc _fillEntry(ref tableEntry: chpl_TableEntry(keyType, valType),
+                    in key: keyType,
+                    in val: valType) {
       if tableEntry.status == chpl__hash_status.full {
         _deinitSlot(tableEntry);
       } else {
@@ -455,11 +722,132 @@ module ChapelHashtable {
       _moveInit(tableEntry.key, key);
       _moveInit(tableEntry.val, val);
     }
-    proc fillSlot(slotNum: int,
-                  in key: keyType,
-                  in val: valType) {
+
+    // concurrent add pattern, with 'locks.resizeLock' held for reading
+    // and the key stripe for the key held:
+    //  _findSlotForAdd(key, locks)
+    //  claimSlotConcurrent (retry the search if it returns false)
+    //  publishSlotConcurrent, with the control byte _findSlotForAdd gave
+
+    // Returns true if the table should grow before another key is added.
+    // With the read lock held, this only accounts for the adds so far.
+    proc needsGrowConcurrent(const ref locks: chpl__hashtableLocks): bool {
+      const numFull = tableNumFullSlots + locks.numFilled.read();
+      const numDeleted = tableNumDeletedSlots - locks.numReused.read();
+      return _needsGrow(numFull, numDeleted);
+    }
+
+    // Moves the counts accumulated by concurrent adds into
+    // tableNumFullSlots and tableNumDeletedSlots.
+    // Assumes 'locks.resizeLock' is held for writing.
+    proc foldConcurrentCounts(ref locks: chpl__hashtableLocks) {
+      tableNumFullSlots += locks.numFilled.exchange(0);
+      tableNumDeletedSlots -= locks.numReused.exchange(0);
+    }
+
+    // Moves key and val into an empty or deleted slot found by _findSlot.
+    // Returns false if another task filled the slot first. On success
+    // the slot stripe stays locked and the slot is not yet visible as
+    // full; publishSlotConcurrent finishes the add.
+    proc claimSlotConcurrent(slotNum: int,
+                             in key: keyType,
+                             in val: valType,
+                             ref locks: chpl__hashtableLocks): bool {
       ref tableEntry = table[slotNum];
-      fillSlot(tableEntry, key, val);
+      locks.slotLock(slotNum).lock();
+      const slotStatus = tableEntry.status;
+      if slotStatus == chpl__hash_status.full {
+        locks.slotLock(slotNum).unlock();
+        return false;
+      }
+
+      if slotStatus == chpl__hash_status.deleted then
+        locks.numReused.add(1);
+      locks.numFilled.add(1);
+
+      _moveInit(tableEntry.key, key);
+      _moveInit(tableEntry.val, val);
+      return true;
+    }
+
+    // Marks a slot claimed by claimSlotConcurrent as full and unlocks
+    // its slot stripe. Readers take the stripe to see the status, so the
+    // unlock is what publishes the key and value.
+    proc publishSlotConcurrent(slotNum: int, h2: uint(8),
+                               ref locks: chpl__hashtableLocks) {
+      if swiss then
+        _swissSetFull(slotNum, h2);
+      table[slotNum].status = chpl__hash_status.full;
+      locks.slotLock(slotNum).unlock();
+    }
+
+    // #### bulk add ####
+
+    // Adds each key in 'keys', paired with the element in the same
+    // position of 'vals' (which is none when valType is nothing), with
+    // one task per chunk of 'keys'. Keys that are already in the table
+    // are left alone, as are repeats of a key within 'keys' after the
+    // first one added. Returns the number of keys added.
+    //
+    // The table is sized once for every key up front, so the tasks never
+    // rehash; they coordinate the same way as concurrent adds, through a
+    // chpl__hashtableLocks. Assumes no other task is using the table.
+    // If 'keys' had enough repeats or keys already present that the
+    // table grew more than it needed to, it is shrunk again afterwards.
+    proc bulkAdd(keys, vals: ?valsType = none): int {
+      const numKeys = keys.size;
+      if numKeys == 0 then
+        return 0;
+
+      var locks: chpl__hashtableLocks;
+      const oldSizeNum = tableSizeNum;
+
+      // make room for every key, dropping any deleted slots on the way
+      if _needsGrowAtSize(tableNumFullSlots + tableNumDeletedSlots +
+                          numKeys - 1, tableSize) {
+        const sizeNum = _findSizeNum(tableNumFullSlots + numKeys);
+        rehash(sizeNum, _sizeForSizeNum(sizeNum), locks);
+      }
+
+      if valType == nothing {
+        forall key in keys with (ref locks) {
+          _bulkAddOne(key, none, locks);
+        }
+      } else {
+        forall (key, val) in zip(keys, vals) with (ref locks) {
+          _bulkAddOne(key, val, locks);
+        }
+      }
+
+      const numAdded = locks.numFilled.read();
+      foldConcurrentCounts(locks);
+
+      // size for the keys that were actually added
+      if tableSizeNum > oldSizeNum {
+        const sizeNum = max(oldSizeNum, _findSizeNum(tableNumFullSlots));
+        if sizeNum < tableSizeNum then
+          rehash(sizeNum, _sizeForSizeNum(sizeNum), locks);
+      }
+
+      return numAdded;
+    }
+
+    proc _bulkAddOne(key: keyType, val: valType,
+                     ref locks: chpl__hashtableLocks) {
+      ref keyLock = locks.keyLock(key);
+      keyLock.lock();
+      while true {
+        const (foundFullSlot, slotNum, h2) = _findSlotForAdd(key, locks);
+        if foundFullSlot then
+          break;
+        if slotNum < 0 then
+          halt("couldn't add key -- table full during bulk add");
+        if claimSlotConcurrent(slotNum, key, val, locks) {
+          publishSlotConcurrent(slotNum, h2, locks);
+          break;
+        }
+      }
+      keyLock.unlock();
     }
 
     // remove pattern:
@@ -484,6 +872,31 @@ module ChapelHashtable {
     // Returns the key and value that were removed in the out arguments
     proc clearSlot(ref tableEntry: chpl_TableEntry(keyType, valType),
                    out key: keyType, out val: valType) {
+      if swiss then
+        compilerError("swiss hashtables need the slot number to clear a slot");
+      _clearEntry(tableEntry, key, val);
+    }
+    proc clearSlot(slotNum: int, out key: keyType, out val: valType) {
+      // move the table entry into the key/val variables to be returned
+      ref tableEntry = table[slotNum];
+      _clearEntry(tableEntry, key, val);
+
+      if swiss {
+        // A probe stops at the first group with an empty slot, so if
+        // this group still has one, no probe continues past it and the
+        // slot can go straight back to empty.
+        const base = slotNum - slotNum % swissGroupWidth;
+        if _swissMatch(_swissGroup(base), swissCtrlEmpty) != 0 {
+          ctrl[slotNum] = swissCtrlEmpty;
+          tableEntry.status = chpl__hash_status.empty;
+          tableNumDeletedSlots -= 1;
+        } else {
+          ctrl[slotNum] = swissCtrlDeleted;
+        }
+      }
+    }
+    proc _clearEntry(ref tableEntry: chpl_TableEntry(keyType, valType),
+                     out key: keyType, out val: valType) {
       // move the table entry into the key/val variables to be returned
       key = _moveToReturn(tableEntry.key);
       val = _moveToReturn(tableEntry.val);
@@ -495,10 +908,17 @@ module ChapelHashtable {
       tableNumFullSlots -= 1;
       tableNumDeletedSlots += 1;
     }
-    proc clearSlot(slotNum: int, out key: keyType, out val: valType) {
-      // move the table entry into the key/val variables to be returned
+
+    // Marks an empty or deleted slot as empty. This is only correct
+    // when no remaining key was placed by probing past this slot, for
+    // example when every slot in the table is being cleared.
+    proc resetSlot(slotNum: int) {
       ref tableEntry = table[slotNum];
-      clearSlot(tableEntry, key, val);
+      if tableEntry.status == chpl__hash_status.deleted then
+        tableNumDeletedSlots -= 1;
+      tableEntry.status = chpl__hash_status.empty;
+      if swiss then
+        ctrl[slotNum] = swissCtrlEmpty;
     }
 
     proc maybeShrinkAfterRemove() {
@@ -509,6 +929,35 @@ module ChapelHashtable {
 
     // #### rehash / resize helpers ####
 
+    // Returns the table size for a given tableSizeNum.
+    proc _sizeForSizeNum(sizeNum: int): int {
+      if swiss then
+        return if sizeNum == 0 then 0 else swissGroupWidth << sizeNum;
+      else
+        return chpl__primes(sizeNum);
+    }
+
+    proc _maxSizeNum(): int {
+      if swiss then
+        return 55; // swissGroupWidth << 55 == 2**58
+      else
+        return chpl__primes.size - 1;
+    }
+
+    // Returns the tableSizeNum of the smallest table that holds numKeys
+    // keys without growing.
+    proc _findSizeNum(numKeys: int): int {
+      if !swiss then
+        return _findPrimeSizeIndex(numKeys);
+
+      for sizeNum in 1.._maxSizeNum() {
+        if !_needsGrowAtSize(numKeys, _sizeForSizeNum(sizeNum)) then
+          return sizeNum;
+      }
+      halt("Requested capacity (", numKeys, ") exceeds maximum size");
+      return 0;
+    }
+
     proc _findPrimeSizeIndex(numKeys:int) {
       //Find the first suitable prime
       var threshold = (numKeys + 1) * 2;
@@ -545,12 +994,22 @@ module ChapelHashtable {
     }
 
     // newSize is the new table size
-    // newSizeNum is an index into chpl__primes == newSize
+    // newSizeNum is the matching tableSizeNum, which for the prime
+    // layout is an index into chpl__primes == newSize
     // assumes the array is already locked
-    proc rehash(newSizeNum:int, newSize:int) {
+    //
+    // If 'locks' is a chpl__hashtableLocks, the entries are moved into
+    // the new table by several tasks, using the slot stripes to settle
+    // which entry gets a contended slot. Its resizeLock should be held
+    // for writing.
+    proc rehash(newSizeNum:int, newSize:int, locks: ?locksType = none) {
       // save the old table
       var oldSize = tableSize;
       var oldTable = table;
+      var oldCtrl = ctrl;
+
+      if swiss then
+        swissFillSlot = -1;
 
       tableSizeNum = newSizeNum;
       tableSize = newSize;
@@ -564,6 +1023,8 @@ module ChapelHashtable {
         }
 
         table = allocateTable(tableSize);
+        if swiss then
+          ctrl = _allocateCtrl(tableSize);
 
         if rehashHelpers != nil then
           rehashHelpers!.startRehash(tableSize);
@@ -574,32 +1035,15 @@ module ChapelHashtable {
 
         // Move old data into newly resized table
         //
-        // It would be nice if this could be done in parallel
-        // but it's possible that multiple old keys will go to the
-        // same position in the new array which would lead to data
-        // races. So it's not as simple as using forall here.
-        for oldslot in _allSlots(oldSize) {
-          if oldTable[oldslot].status == chpl__hash_status.full {
-            ref oldEntry = oldTable[oldslot];
-            // find a destination slot
-            var (foundSlot, newslot) = _findSlot(oldEntry.key);
-            if foundSlot {
-              halt("duplicate element found while resizing for key");
-            }
-            if newslot < 0 {
-              halt("couldn't add element during resize - got slot ", newslot,
-                   " for key");
-            }
-
-            // move the key and value from the old entry into the new one
-            ref dstSlot = table[newslot];
-            dstSlot.status = chpl__hash_status.full;
-            _moveInit(dstSlot.key, _moveToReturn(oldEntry.key));
-            _moveInit(dstSlot.val, _moveToReturn(oldEntry.val));
-
-            // move array elements to the new location
-            if rehashHelpers != nil then
-              rehashHelpers!.moveElementDuringRehash(oldslot, newslot);
+        // Multiple old keys can go to the same position in the new
+        // table, so without slot locks this has to be done serially.
+        if locks.type == nothing {
+          for oldslot in _allSlots(oldSize) {
+            _moveEntryDuringRehash(oldTable, oldCtrl, oldslot, locks);
+          }
+        } else {
+          forall oldslot in _allSlots(oldSize) {
+            _moveEntryDuringRehash(oldTable, oldCtrl, oldslot, locks);
           }
         }
 
@@ -608,6 +1052,8 @@ module ChapelHashtable {
 
         // delete the old allocation
         _freeData(oldTable, oldSize);
+        if swiss then
+          _freeData(oldCtrl, oldSize);
 
       } else {
         // There were no entries, so just make a new allocation
@@ -620,31 +1066,87 @@ module ChapelHashtable {
 
         // delete the old allocation
         _freeData(oldTable, oldSize);
+        if swiss then
+          _freeData(oldCtrl, oldSize);
 
         table = allocateTable(tableSize);
+        if swiss then
+          ctrl = _allocateCtrl(tableSize);
         tableNumDeletedSlots = 0;
       }
     }
 
-    proc requestCapacity(numKeys:int) {
+    // moves the entry in oldTable[oldslot], if it is full, into the
+    // current table
+    //
+    // In the swiss layout, oldCtrl holds the old control bytes. A key's
+    // control byte does not depend on the table size, so it is copied
+    // rather than computed again.
+    proc _moveEntryDuringRehash(oldTable, oldCtrl, oldslot: int, locks) {
+      param concurrent = locks.type != nothing;
+
+      if oldTable[oldslot].status != chpl__hash_status.full then
+        return;
+
+      ref oldEntry = oldTable[oldslot];
+      while true {
+        // find a destination slot
+        var (foundSlot, newslot) = _findSlot(oldEntry.key, locks);
+        if foundSlot {
+          halt("duplicate element found while resizing for key");
+        }
+        if newslot < 0 {
+          halt("couldn't add element during resize - got slot ", newslot,
+               " for key");
+        }
+
+        ref dstSlot = table[newslot];
+        if concurrent {
+          locks.slotLock(newslot).lock();
+          if dstSlot.status == chpl__hash_status.full {
+            // another task took this slot, so search again
+            locks.slotLock(newslot).unlock();
+            continue;
+          }
+        }
+
+        // move the key and value from the old entry into the new one
+        _moveInit(dstSlot.key, _moveToReturn(oldEntry.key));
+        _moveInit(dstSlot.val, _moveToReturn(oldEntry.val));
+        if swiss then
+          _swissSetFull(newslot, oldCtrl[oldslot]);
+        dstSlot.status = chpl__hash_status.full;
+
+        if concurrent then
+          locks.slotLock(newslot).unlock();
+
+        // move array elements to the new location
+        if rehashHelpers != nil then
+          rehashHelpers!.moveElementDuringRehash(oldslot, newslot);
+
+        break;
+      }
+    }
+
+    proc requestCapacity(numKeys:int, locks: ?locksType = none) {
       if tableNumFullSlots < numKeys {
 
-        var primeLoc = _findPrimeSizeIndex(numKeys);
-        var prime = chpl__primes(primeLoc);
+        var sizeNum = _findSizeNum(numKeys);
+        var size = _sizeForSizeNum(sizeNum);
 
-        rehash(primeLoc, prime);
+        rehash(sizeNum, size, locks);
       }
     }
 
-    proc resize(grow:bool) {
+    proc resize(grow:bool, locks: ?locksType = none) {
       if postponeResize then return;
 
       var newSizeNum = tableSizeNum;
       newSizeNum += if grow then 1 else -1;
-      if newSizeNum > chpl__primes.size then
+      if newSizeNum > _maxSizeNum() then
         halt("associative array exceeds maximum size");
 
-      var newSize = chpl__primes(newSizeNum);
+      var newSize = _sizeForSizeNum(newSizeNum);
 
       if grow==false && 2*tableNumFullSlots > newSize {
         // don't shrink if the number of elements would not
@@ -652,7 +1154,7 @@ module ChapelHashtable {
         return;
       }
 
-      rehash(newSizeNum, newSize);
+      rehash(newSizeNum, newSize, locks);
     }
   }
 }
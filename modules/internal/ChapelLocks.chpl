@@ -49,4 +49,57 @@ module ChapelLocks {
       l.clear(memoryOrder.release);
     }
   }
+
+  /*
+   * Local processor atomic readers-writer spinlock. Any number of tasks
+   * can hold it for reading at once; a task holding it for writing
+   * excludes everyone else. A waiting writer stops new readers from
+   * entering so that it is not starved by a steady stream of them.
+   */
+  pragma "default intent is ref"
+  record chpl_LocalRWSpinlock {
+    // the number of readers, plus writerBit while a writer holds or
+    // is waiting for the lock
+    var l: chpl__processorAtomicType(int);
+
+    proc init() {
+    }
+
+    proc writerBit param return 1 << 62;
+
+    inline proc readLock() {
+      on this {
+        while true {
+          const cur = l.read();
+          if (cur & writerBit) == 0 &&
+             l.compareAndSwap(cur, cur + 1, memoryOrder.acquire) then
+            break;
+          chpl_task_yield();
+        }
+      }
+    }
+
+    inline proc readUnlock() {
+      l.sub(1, memoryOrder.release);
+    }
+
+    inline proc writeLock() {
+      on this {
+        // claim the writer bit, then wait for the readers to drain
+        while true {
+          const cur = l.read();
+          if (cur & writerBit) == 0 &&
+             l.compareAndSwap(cur, cur | writerBit, memoryOrder.acquire) then
+            break;
+          chpl_task_yield();
+        }
+        while l.read(memoryOrder.acquire) != writerBit do
+          chpl_task_yield();
+      }
+    }
+
+    inline proc writeUnlock() {
+      l.write(0, memoryOrder.release);
+    }
+  }
 }
@@ -34,10 +34,18 @@ module DefaultAssociative {
 
   config param defaultAssociativeSupportsAutoLocalAccess = true;
 
+  // Store associative domains in the swiss layout of chpl__hashtable
+  config param defaultAssociativeUseSwissTable = false;
+
   // helps to move around array elements when rehashing the domain
+  //
+  // The domain's _arrsLock is held from startRehash to finishRehash, so
+  // that the list of arrays stays the same while the tasks of a parallel
+  // rehash walk it for every element they move.
   class DefaultAssociativeDomRehashHelper : chpl__rehashHelpers {
     var dom: unmanaged DefaultAssociativeDom;
     override proc startRehash(newSize: int) {
+      dom._arrsLock.lock();
       for arr in dom._arrs {
         arr._startRehash(newSize);
       }
@@ -51,6 +59,7 @@ module DefaultAssociative {
       for arr in dom._arrs {
         arr._finishRehash(oldSize);
       }
+      dom._arrsLock.unlock();
     }
   }
 
@@ -63,15 +72,21 @@ module DefaultAssociative {
     // We explicitly use processor atomics here since this is not
     // by design a distributed data structure
     var numEntries: chpl__processorAtomicType(int);
-    var tableLock: if parSafe then chpl_LocalSpinlock else nothing;
-    var table: chpl__hashtable(idxType, nothing);
+    var tableLocks: if parSafe then chpl__hashtableLocks else nothing;
+    var table: chpl__hashtable(idxType, nothing,
+                               defaultAssociativeUseSwissTable);
 
+    // Takes the table for exclusive use. Adds and membership tests in
+    // parSafe domains only hold it shared (see _addConcurrent).
     inline proc lockTable() {
-      if parSafe then tableLock.lock();
+      if parSafe {
+        tableLocks.resizeLock.writeLock();
+        table.foldConcurrentCounts(tableLocks);
+      }
     }
 
     inline proc unlockTable() {
-      if parSafe then tableLock.unlock();
+      if parSafe then tableLocks.resizeLock.writeUnlock();
     }
 
     override proc linksDistribution() param return false;
@@ -87,7 +102,8 @@ module DefaultAssociative {
       this.idxType = idxType;
       this.parSafe = parSafe;
       this.dist = dist;
-      this.table = new chpl__hashtable(idxType, nothing);
+      this.table = new chpl__hashtable(idxType, nothing,
+                                       defaultAssociativeUseSwissTable);
       this.complete();
 
       // set the rehash helpers
@@ -280,13 +296,13 @@ module DefaultAssociative {
           if aSlot.isFull() {
             var tmpKey: idxType;
             var tmpVal: nothing;
-            table.clearSlot(aSlot, tmpKey, tmpVal);
+            table.clearSlot(slot, tmpKey, tmpVal);
             // deinit any array entries
             for arr in _arrs {
               arr._deinitSlot(slot);
             }
           }
-          table.table[slot].status = chpl__hash_status.empty;
+          table.resetSlot(slot);
         }
         numEntries.write(0);
         table.maybeShrinkAfterRemove();
@@ -295,9 +311,15 @@ module DefaultAssociative {
     }
 
     proc dsiMember(idx: idxType): bool {
-      lockTable(); defer { unlockTable(); }
-      var (foundFullSlot, slotNum) = table.findFullSlot(idx);
-      return foundFullSlot;
+      if parSafe {
+        tableLocks.resizeLock.readLock();
+        defer { tableLocks.resizeLock.readUnlock(); }
+        var (foundFullSlot, slotNum) = table._findSlot(idx, tableLocks);
+        return foundFullSlot;
+      } else {
+        var (foundFullSlot, slotNum) = table.findFullSlot(idx);
+        return foundFullSlot;
+      }
     }
 
     // returns the number of indices added
@@ -324,17 +346,82 @@ module DefaultAssociative {
       var retVal = 0;
 
       on this {
-        lockTable();
-        defer {
-          unlockTable();
+        if parSafe {
+          (slotNum, retVal) = _addConcurrent(idx);
+        } else {
+          (slotNum, retVal) = _add(idx);
         }
-
-        (slotNum, retVal) = _add(idx);
       }
 
       return (slotNum, retVal);
     }
 
+    // Adds idx while other tasks may also be adding or looking up
+    // indices. Only when the table has to grow does this take the
+    // table exclusively, and then it rehashes in parallel.
+    proc _addConcurrent(in idx: idxType) {
+      tableLocks.resizeLock.readLock();
+
+      if !table.needsGrowConcurrent(tableLocks) {
+        ref keyLock = tableLocks.keyLock(idx);
+        keyLock.lock();
+
+        while true {
+          const (foundFullSlot, slotNum, h2) =
+            table._findSlotForAdd(idx, tableLocks);
+          if foundFullSlot {
+            keyLock.unlock();
+            tableLocks.resizeLock.readUnlock();
+            return (slotNum, 0);
+          }
+
+          // no room without garbage collecting deleted slots
+          if slotNum < 0 then break;
+
+          if table.claimSlotConcurrent(slotNum, idx, none, tableLocks) {
+            // default initialize newly added array elements before
+            // other tasks can find the index
+            _defaultInitSlotInArrs(slotNum);
+            table.publishSlotConcurrent(slotNum, h2, tableLocks);
+            numEntries.add(1);
+
+            keyLock.unlock();
+            tableLocks.resizeLock.readUnlock();
+            return (slotNum, 1);
+          }
+        }
+
+        keyLock.unlock();
+      }
+
+      tableLocks.resizeLock.readUnlock();
+
+      lockTable();
+      defer {
+        unlockTable();
+      }
+
+      if table.needsGrowConcurrent(tableLocks) then
+        table.resize(grow=true, tableLocks);
+
+      return _add(idx);
+    }
+
+    // Default initializes the elements for a newly filled slot in each
+    // array over this domain. The list of arrays is walked under
+    // _arrsLock, since in a parSafe domain another task can be adding
+    // or removing an array meanwhile. Declaring an array over a domain
+    // while other tasks add indices to it is still not supported: the
+    // new array is sized and initialized from the table as it was when
+    // the array was created.
+    proc _defaultInitSlotInArrs(slotNum: int) {
+      if parSafe then _arrsLock.lock();
+      for arr in _arrs {
+        arr._defaultInitSlot(slotNum);
+      }
+      if parSafe then _arrsLock.unlock();
+    }
+
     proc _add(in idx: idxType) {
       var foundFullSlot = false;
       var slotNum = -1;
@@ -347,9 +434,7 @@ module DefaultAssociative {
         numEntries.add(1);
 
         // default initialize newly added array elements
-        for arr in _arrs {
-          arr._defaultInitSlot(slotNum);
-        }
+        _defaultInitSlotInArrs(slotNum);
 
         return (slotNum, 1);
       }
@@ -395,7 +480,10 @@ module DefaultAssociative {
           defer {
             unlockTable();
           }
-          table.requestCapacity(numKeys);
+          if parSafe then
+            table.requestCapacity(numKeys, tableLocks);
+          else
+            table.requestCapacity(numKeys);
 
         } else {
           warning("Requested capacity (", numKeys, ") ",
@@ -26,6 +26,10 @@ module DefaultRectangular {
   config const dataParTasksPerLocale = 0;
   config const dataParIgnoreRunningTasks = false;
   config const dataParMinGranularity: int = 1;
+  // Under locale models without sublocales, spread large arrays across
+  // the NUMA domains.  Running each forall chunk on the domain holding
+  // its part of the array takes sublocales, as in the numa locale model.
+  config const dataParNumaAffinity = false;
 
   if dataParTasksPerLocale<0 then halt("dataParTasksPerLocale must be >= 0");
   if dataParMinGranularity<=0 then halt("dataParMinGranularity must be > 0");
@@ -286,6 +290,29 @@ module DefaultRectangular {
       }
     }
 
+    // Divide 'block' along dimension 'dim' into 'numChunks' parts and
+    // return part number 'chunk', for the standalone iterator.
+    //
+    // TODO: This is somewhat of an abuse of what _computeBlock() was
+    // designed for (dense ranges only; I multiplied by the stride as a
+    // white lie to make it work reasonably.  We should switch to using
+    // the RangeChunk library...
+    proc _standaloneBlock(in block, dim: int, numChunks: int, chunk: int) {
+      const r = block(dim);
+      const len = if (!r.stridable) then r.sizeAs(r.intIdxType)
+          else r.sizeAs(uint) * abs(r.stride):uint;
+      const (lo,hi) = _computeBlock(len,
+                                    numChunks, chunk,
+                                    r._high,
+                                    r._low,
+                                    r._low);
+      if r.stridable then
+        block(dim) = lo..hi by r.stride align chpl__idxToInt(r.alignment);
+      else
+        block(dim) = lo..hi;
+      return block;
+    }
+
     iter these(param tag: iterKind,
                tasksPerLocale = dataParTasksPerLocale,
                ignoreRunning = dataParIgnoreRunningTasks,
@@ -297,6 +324,74 @@ module DefaultRectangular {
       if debugDefaultDist then
         chpl_debug_writeln("*** In domain standalone code:");
 
+      const numSublocs = here.getChildCount();
+
+      // As in the leader below, run each chunk on the sublocale that
+      // holds its part of the array, then divide it among tasks there.
+      if localeModelHasSublocales && numSublocs != 0 {
+        var dptpl = if tasksPerLocale==0 then here.maxTaskPar
+                    else tasksPerLocale;
+        if !ignoreRunning {
+          const otherTasks = here.runningTasks() - 1; // don't include self
+          dptpl = if otherTasks < dptpl then (dptpl-otherTasks):int else 1;
+        }
+        const numSublocTasks = min(numSublocs, dptpl);
+        const (numChunks, parDim) = if __primitive("task_get_serial") then
+                                    (1, 0) else
+                                    _computeChunkStuff(numSublocTasks,
+                                                       ignoreRunning=true,
+                                                       minIndicesPerTask,
+                                                       ranges);
+        if debugDataParNuma {
+          chpl_debug_writeln("### numSublocs = ", numSublocs, "\n",
+                 "### numTasksPerSubloc = ", numSublocTasks, "\n",
+                  "### ignoreRunning = ", ignoreRunning, "\n",
+                  "### minIndicesPerTask = ", minIndicesPerTask, "\n",
+                  "### numChunks = ", numChunks, " (parDim = ", parDim, ")\n",
+                  "### nranges = ", ranges);
+        }
+
+        coforall chunk in 0..#numChunks { // make sure coforall on can trigger
+          local do on here.getChild(chunk) {
+            if debugDataParNuma {
+              if chunk!=chpl_getSubloc() then
+                chpl_debug_writeln("*** ERROR: ON WRONG SUBLOC (should be ", chunk,
+                                   ", on ", chpl_getSubloc(), ") ***");
+            }
+            const numSublocTasks = (if chunk < dptpl % numChunks
+                                    then dptpl / numChunks + 1
+                                    else dptpl / numChunks);
+            const block = _standaloneBlock(ranges, parDim, numChunks, chunk);
+            const (numChunks2, parDim2) = _computeChunkStuff(numSublocTasks,
+                                                             ignoreRunning=true,
+                                                             minIndicesPerTask,
+                                                             block);
+            // coforall tasks may start on any sublocale, so put these
+            // back on this one
+            const subloc = here;
+            coforall chunk2 in 0..#numChunks2 {
+              local do on subloc {
+                if debugDataParNuma {
+                  if chunk!=chpl_getSubloc() then
+                    chpl_debug_writeln("*** ERROR: ON WRONG SUBLOC (should be ", chunk,
+                                       ", on ", chpl_getSubloc(), ") ***");
+                }
+                const block2 = _standaloneBlock(block, parDim2,
+                                                numChunks2, chunk2);
+                if debugDataParNuma {
+                  chpl_debug_writeln("### chunk = ", chunk, "  chunk2 = ", chunk2,
+                                     "  block = ", block2);
+                }
+                for i in these_help(0, block2) {
+                  yield i;
+                }
+              }
+            }
+          }
+        }
+        return;
+      }
+
       const numTasks = if tasksPerLocale == 0 then here.maxTaskPar
                        else tasksPerLocale;
       if debugDefaultDist {
@@ -323,24 +418,8 @@ module DefaultRectangular {
       if debugDefaultDist {
         chpl_debug_writeln("*** DI: ranges = ", ranges);
       }
-      // TODO: The following is somewhat of an abuse of what
-      // _computeBlock() was designed for (dense ranges only; I
-      // multiplied by the stride as a white lie to make it work
-      // reasonably.  We should switch to using the RangeChunk
-      // library...
       coforall chunk in 0..#numChunks {
-        var block = ranges;
-        const len = if (!ranges(parDim).stridable) then ranges(parDim).sizeAs(ranges(parDim).intIdxType)
-            else ranges(parDim).sizeAs(uint) * abs(ranges(parDim).stride):uint;
-        const (lo,hi) = _computeBlock(len,
-                                      numChunks, chunk,
-                                      ranges(parDim)._high,
-                                      ranges(parDim)._low,
-                                      ranges(parDim)._low);
-        if block(parDim).stridable then
-          block(parDim) = lo..hi by block(parDim).stride align chpl__idxToInt(block(parDim).alignment);
-        else
-          block(parDim) = lo..hi;
+        const block = _standaloneBlock(ranges, parDim, numChunks, chunk);
         if debugDefaultDist {
           chpl_debug_writeln("*** DI[", chunk, "]: block = ", block);
         }
@@ -411,22 +490,32 @@ module DefaultRectangular {
                                                              ignoreRunning=true,
                                                              minIndicesPerTask,
                                                              followMe);
+            // coforall tasks may start on any sublocale, so put these
+            // back on this one
+            const subloc = here;
             coforall chunk2 in 0..#numChunks2 {
-              var locBlock2: rank*range(intIdxType);
-              for param i in 0..rank-1 do
-                locBlock2(i) = followMe(i).low..followMe(i).high;
-              var followMe2: rank*range(intIdxType) = locBlock2;
-              const low  = locBlock2(parDim2)._low,
-                high = locBlock2(parDim2)._high;
-              const (lo,hi) = _computeBlock(locBlock2(parDim2).sizeAs(intIdxType),
-                                            numChunks2, chunk2,
-                                            high, low, low);
-              followMe2(parDim2) = lo..hi;
-              if debugDataParNuma {
-                chpl_debug_writeln("### chunk = ", chunk, "  chunk2 = ", chunk2, "  ",
-                        "followMe = ", followMe, "  followMe2 = ", followMe2);
+              local do on subloc {
+                if debugDataParNuma {
+                  if chunk!=chpl_getSubloc() then
+                    chpl_debug_writeln("*** ERROR: ON WRONG SUBLOC (should be ", chunk,
+                                       ", on ", chpl_getSubloc(), ") ***");
+                }
+                var locBlock2: rank*range(intIdxType);
+                for param i in 0..rank-1 do
+                  locBlock2(i) = followMe(i).low..followMe(i).high;
+                var followMe2: rank*range(intIdxType) = locBlock2;
+                const low  = locBlock2(parDim2)._low,
+                  high = locBlock2(parDim2)._high;
+                const (lo,hi) = _computeBlock(locBlock2(parDim2).sizeAs(intIdxType),
+                                              numChunks2, chunk2,
+                                              high, low, low);
+                followMe2(parDim2) = lo..hi;
+                if debugDataParNuma {
+                  chpl_debug_writeln("### chunk = ", chunk, "  chunk2 = ", chunk2, "  ",
+                          "followMe = ", followMe, "  followMe2 = ", followMe2);
+                }
+                yield followMe2;
               }
-              yield followMe2;
             }
           }
         }
@@ -1245,7 +1334,11 @@ module DefaultRectangular {
         }
 
         if !localeModelHasSublocales {
-          data = _ddata_allocate_noinit(eltType, size, callPostAlloc);
+          data = _ddata_allocate_noinit(eltType, size,
+                                        callPostAlloc,
+                                        subloc = (if dataParNumaAffinity
+                                                  then c_sublocid_all
+                                                  else c_sublocid_none));
         } else {
           data = _ddata_allocate_noinit(eltType, size,
                                         callPostAlloc,
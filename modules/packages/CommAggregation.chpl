@@ -0,0 +1,168 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+   .. warning::
+     This module represents work in progress. The API is unstable and likely to
+     change over time.
+
+   This module provides aggregators for batches of small remote copies of
+   trivially copyable types, built on the communication layer's aggregated
+   GET and PUT operations.  A :record:`DstAggregator` aggregates copies to
+   remote destinations from local values, and a :record:`SrcAggregator`
+   aggregates copies from remote sources to local destinations:
+
+   .. code-block:: chapel
+
+     use BlockDist, CommAggregation;
+
+     const size = 10000;
+     const space = {0..size};
+     const D = space dmapped Block(space);
+     var A, reversedA: [D] int = D;
+
+     forall i in D with (var agg = new DstAggregator(int)) do
+       agg.copy(reversedA[size-i], A[i]);
+
+     // no flush required, aggregators flush when they are deinitialized
+
+     forall (rA, i) in zip(reversedA, D) do
+       assert(rA == size-i);
+
+   Copies done through an aggregator are not ordered with respect to regular
+   operations or to each other.  The destination of a copy is not guaranteed
+   to have been updated until the aggregator is flushed, either explicitly
+   with :proc:`DstAggregator.flush()` or :proc:`SrcAggregator.flush()`, or
+   implicitly when it is deinitialized or the task that used it ends.  For
+   a :record:`DstAggregator` the source value has been captured when
+   ``copy()`` returns.
+
+   Aggregators are not parallel safe and are expected to be created on a
+   per-task basis, as with the task-private ``with`` clause variables above.
+
+   .. note::
+     Currently, this is only optimized for ``CHPL_COMM=ofi``, ``ugni``, and
+     ``gasnet``.  Under ofi and ugni small copies are internally buffered
+     per task and sent together when the buffers fill or are flushed.  Under
+     gasnet copies are started as nonblocking transfers and completed at the
+     flush.  Copies to or from memory the network cannot reach directly fall
+     back to regular operations.
+ */
+module CommAggregation {
+  private use CPtr;
+  private use SysCTypes;
+
+  pragma "insert line file info"
+  private extern proc chpl_gen_comm_get_aggregated(addr: c_void_ptr,
+                                                   node: int(32),
+                                                   raddr: c_void_ptr,
+                                                   size: c_size_t,
+                                                   commID: int(32)): void;
+
+  pragma "insert line file info"
+  private extern proc chpl_gen_comm_put_aggregated(addr: c_void_ptr,
+                                                   node: int(32),
+                                                   raddr: c_void_ptr,
+                                                   size: c_size_t,
+                                                   commID: int(32)): void;
+
+  private extern proc chpl_gen_comm_aggregated_flush(): void;
+
+  private param unknownCommID = -1: int(32);
+
+  private inline proc getAddr(const ref p): c_ptr(p.type) {
+    return __primitive("_wide_get_addr", p): c_ptr(p.type);
+  }
+
+  private proc checkElemType(type elemType) {
+    if !isPODType(elemType) then
+      compilerError("aggregated copies are only supported for trivially copyable types");
+  }
+
+  /*
+     Aggregates ``copy(ref dst, src)``.  Optimized for when ``src`` is local.
+   */
+  record DstAggregator {
+    /* The type of the elements being copied. */
+    type elemType;
+
+    pragma "no doc"
+    proc postinit() {
+      checkElemType(elemType);
+    }
+
+    pragma "no doc"
+    proc deinit() {
+      flush();
+    }
+
+    /*
+       Complete all the copies done so far by the current task.
+     */
+    proc flush() {
+      chpl_gen_comm_aggregated_flush();
+    }
+
+    /*
+       Copy ``srcVal`` to ``dst``, which may be remote.
+     */
+    inline proc copy(ref dst: elemType, const in srcVal: elemType) {
+      var val = srcVal;
+      chpl_gen_comm_put_aggregated(c_ptrTo(val), dst.locale.id: int(32),
+                                   getAddr(dst), c_sizeof(elemType),
+                                   unknownCommID);
+    }
+  }
+
+  /*
+     Aggregates ``copy(ref dst, const ref src)``.  Only works when ``dst`` is
+     local.
+   */
+  record SrcAggregator {
+    /* The type of the elements being copied. */
+    type elemType;
+
+    pragma "no doc"
+    proc postinit() {
+      checkElemType(elemType);
+    }
+
+    pragma "no doc"
+    proc deinit() {
+      flush();
+    }
+
+    /*
+       Complete all the copies done so far by the current task.
+     */
+    proc flush() {
+      chpl_gen_comm_aggregated_flush();
+    }
+
+    /*
+       Copy ``src``, which may be remote, to the local ``dst``.
+     */
+    inline proc copy(ref dst: elemType, const ref src: elemType) {
+      assert(dst.locale.id == here.id);
+      chpl_gen_comm_get_aggregated(getAddr(dst), src.locale.id: int(32),
+                                   getAddr(src), c_sizeof(elemType),
+                                   unknownCommID);
+    }
+  }
+}
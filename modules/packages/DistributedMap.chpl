@@ -0,0 +1,728 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+  A parallel-safe distributed map from keys to values.
+
+  .. note::
+
+    This module is a work in progress and may change in future releases.
+
+  Each key is owned by one of the map's target locales, chosen by the hash
+  of the key, and each target locale keeps the keys it owns in its own
+  hashtable. Every locale works through its privatized instance of the map,
+  so looking up which locale owns a key does not communicate.
+
+  Usage
+  _____
+
+  The initializer must be invoked explicitly:
+
+  .. code-block:: chapel
+
+    var m = new DistributedMap(int, real);
+
+  Single-key operations such as :proc:`DistributedMapImpl.add` run on the
+  locale that owns the key, so each one costs a round trip when that locale
+  is remote. For many keys at once, the batched operations
+  :proc:`DistributedMapImpl.addAll`, :proc:`DistributedMapImpl.setAll` and
+  :proc:`DistributedMapImpl.lookupAll` are much faster. Each locale that
+  holds part of the key array groups its keys by owning locale and ships
+  every owner its whole group in one bulk transfer. The owner then applies
+  the group to its hashtable in parallel:
+
+  .. code-block:: chapel
+
+    use BlockDist;
+
+    const D = {0..#n} dmapped Block({0..#n});
+    var keys: [D] int = D;
+    var vals: [D] real = keys:real;
+
+    m.addAll(keys, vals);
+
+    var got: [D] real;
+    var found: [D] bool;
+    m.lookupAll(keys, got, found);
+
+  Iterating over a map with a ``forall`` runs on every target locale in
+  parallel. The map should not be modified while it is being iterated over.
+
+  Methods
+  _______
+*/
+module DistributedMap {
+
+  private use ChapelHashtable;
+  private use RangeChunk;
+
+  /*
+    Reference counter for DistributedMap
+  */
+  pragma "no doc"
+  class DistributedMapRC {
+    type keyType;
+    type valType;
+    var _pid : int;
+
+    proc deinit() {
+      coforall loc in Locales do on loc {
+        delete chpl_getPrivatizedCopy(
+                 unmanaged DistributedMapImpl(keyType, valType), _pid);
+      }
+    }
+  }
+
+  /*
+    A parallel-safe distributed map. Each key lives in the hashtable of the
+    target locale that owns it, and batched operations move keys and values
+    between locales in bulk.
+  */
+  pragma "always RVF"
+  record DistributedMap {
+    /* Type of map keys. */
+    type keyType;
+    /* Type of map values. */
+    type valType;
+
+    // This is unused, and merely for documentation purposes. See '_value'.
+    /*
+      The implementation of the map is forwarded. See
+      :class:`DistributedMapImpl` for documentation.
+    */
+    var _impl : unmanaged DistributedMapImpl(keyType, valType)?;
+
+    // Privatized id...
+    pragma "no doc"
+    var _pid : int = -1;
+
+    // Reference Counting...
+    pragma "no doc"
+    var _rc : shared DistributedMapRC(keyType, valType);
+
+    /*
+      Initializes an empty map.
+
+      :arg keyType: The type of the keys of this map.
+      :arg valType: The type of the values of this map.
+      :arg targetLocales: The locales to spread the keys of this map over.
+    */
+    proc init(type keyType, type valType, targetLocales = Locales) {
+      this.keyType = keyType;
+      this.valType = valType;
+      this._pid = (new unmanaged DistributedMapImpl(keyType, valType,
+                                                     targetLocales)).pid;
+      this._rc = new shared DistributedMapRC(keyType, valType, _pid = _pid);
+    }
+
+    pragma "no doc"
+    inline proc _value {
+      if _pid == -1 {
+        halt("DistributedMap is uninitialized...");
+      }
+      return chpl_getPrivatizedCopy(
+               unmanaged DistributedMapImpl(keyType, valType), _pid);
+    }
+
+    forwarding _value;
+  }
+
+  class DistributedMapImpl {
+    /* Type of map keys. */
+    type keyType;
+    /* Type of map values. */
+    type valType;
+
+    pragma "no doc"
+    var targetLocDom : domain(1);
+    /*
+      The locales that own the keys of this map.
+    */
+    var targetLocales : [targetLocDom] locale;
+    pragma "no doc"
+    var pid : int = -1;
+
+    // Node-local fields below. These fields are specific to the privatized
+    // instance. To access them from another node, make sure you use
+    // 'getPrivatizedThis'
+    pragma "no doc"
+    var table : chpl__hashtable(keyType, valType);
+    // Protects 'table'. This is a sync rather than a spinlock because
+    // the batched operations hold it while they work on the table in
+    // parallel, and tasks waiting for it should not spin.
+    pragma "no doc"
+    var lock$ : sync bool;
+
+    proc init(type keyType, type valType,
+              targetLocales : [] locale = Locales) {
+      this.keyType = keyType;
+      this.valType = valType;
+
+      // index the target locales from 0, in the order given
+      this.targetLocDom  = {0..#targetLocales.size};
+      this.targetLocales = targetLocales;
+
+      complete();
+
+      this.pid = _newPrivatizedClass(this);
+    }
+
+    pragma "no doc"
+    proc init(other, pid, type keyType = other.keyType,
+              type valType = other.valType) {
+      this.keyType = keyType;
+      this.valType = valType;
+
+      this.targetLocDom  = other.targetLocDom;
+      this.targetLocales = other.targetLocales;
+      this.pid           = pid;
+    }
+
+    pragma "no doc"
+    proc dsiPrivatize(pid) {
+      return new unmanaged DistributedMapImpl(this, pid);
+    }
+
+    pragma "no doc"
+    proc dsiGetPrivatizeData() {
+      return pid;
+    }
+
+    pragma "no doc"
+    inline proc getPrivatizedThis {
+      return chpl_getPrivatizedCopy(this.type, pid);
+    }
+
+    // Returns the index into targetLocales of the locale owning 'k'. The
+    // hash is mixed first so that the keys one locale owns do not all
+    // share the low bits its own table probes with.
+    pragma "no doc"
+    inline proc _ownerIdx(const ref k: keyType): int {
+      const h = chpl__defaultHashWrapper(k):uint * 0x9E3779B97F4A7C15;
+      return ((h >> 32) % targetLocDom.size:uint):int;
+    }
+
+    pragma "no doc"
+    inline proc _owner(const ref k: keyType) {
+      return targetLocales[_ownerIdx(k)];
+    }
+
+    /*
+      Adds a key-value pair to the map. Returns `false` if the key already
+      exists in the map.
+
+      :arg k: The key to add to the map
+      :arg v: The value that maps to ``k``
+
+      :returns: `true` if `k` was not in the map and added with value `v`.
+                `false` otherwise.
+      :rtype: bool
+    */
+    proc add(in k: keyType, in v: valType): bool {
+      var added = false;
+      on _owner(k) {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        var (found, slot) = inst.table.findAvailableSlot(k);
+        if !found {
+          inst.table.fillSlot(slot, k, v);
+          added = true;
+        }
+        inst.lock$.readFE();
+      }
+      return added;
+    }
+
+    /*
+      Sets the value associated with a key. Returns `false` if the key does
+      not exist in the map.
+
+      :arg k: The key whose value needs to change
+      :arg v: The desired value to the key ``k``
+
+      :returns: `true` if `k` was in the map and its value is updated with
+                `v`. `false` otherwise.
+      :rtype: bool
+    */
+    proc set(k: keyType, in v: valType): bool {
+      var updated = false;
+      on _owner(k) {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        var (found, slot) = inst.table.findFullSlot(k);
+        if found {
+          inst.table.fillSlot(slot, k, v);
+          updated = true;
+        }
+        inst.lock$.readFE();
+      }
+      return updated;
+    }
+
+    /*
+      If the map doesn't contain a value for `k`, add one and set it to `v`.
+      If it does, update it to `v`.
+    */
+    proc addOrSet(in k: keyType, in v: valType) {
+      on _owner(k) {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        var (_, slot) = inst.table.findAvailableSlot(k);
+        inst.table.fillSlot(slot, k, v);
+        inst.lock$.readFE();
+      }
+    }
+
+    /*
+      Returns `true` if the given key is a member of this map.
+
+      :arg k: The key to test for membership
+      :rtype: bool
+    */
+    proc contains(const k: keyType): bool {
+      var result = false;
+      on _owner(k) {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        (result, _) = inst.table.findFullSlot(k);
+        inst.lock$.readFE();
+      }
+      return result;
+    }
+
+    /*
+      Returns a copy of the value mapped to `k`. Halts if `k` is not in
+      the map.
+
+      :arg k: The key to look up
+      :rtype: valType
+    */
+    proc getValue(const k: keyType): valType {
+      var result: valType;
+      on _owner(k) {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        var (found, slot) = inst.table.findFullSlot(k);
+        if found then
+          result = inst.table.table[slot].val;
+        inst.lock$.readFE();
+        if !found then
+          halt("DistributedMap index ", k, " out of bounds");
+      }
+      return result;
+    }
+
+    /*
+      Removes a key-value pair from the map.
+
+      :arg k: The key to remove from the map
+
+      :returns: `false` if `k` was not in the map. `true` if it was and
+                was removed.
+      :rtype: bool
+    */
+    proc remove(const k: keyType): bool {
+      var removed = false;
+      on _owner(k) {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        var (found, slot) = inst.table.findFullSlot(k);
+        if found {
+          var outKey: keyType, outVal: valType;
+          inst.table.clearSlot(slot, outKey, outVal);
+          inst.table.maybeShrinkAfterRemove();
+          removed = true;
+        }
+        inst.lock$.readFE();
+      }
+      return removed;
+    }
+
+    /*
+      The current number of keys contained in this map, summed over all of
+      its target locales.
+    */
+    proc size: int {
+      var total = 0;
+      coforall loc in targetLocales with (+ reduce total) do on loc {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        total += inst.table.tableNumFullSlots;
+        inst.lock$.readFE();
+      }
+      return total;
+    }
+
+    /*
+      Returns `true` if this map contains zero keys.
+    */
+    proc isEmpty(): bool {
+      return size == 0;
+    }
+
+    /*
+      Removes every key from this map.
+    */
+    proc clear() {
+      coforall loc in targetLocales do on loc {
+        const inst = getPrivatizedThis;
+        inst.lock$.writeEF(true);
+        for slot in inst.table.allSlots() {
+          if inst.table.isSlotFull(slot) {
+            var outKey: keyType, outVal: valType;
+            inst.table.clearSlot(slot, outKey, outVal);
+          }
+        }
+        inst.table.maybeShrinkAfterRemove();
+        inst.lock$.readFE();
+      }
+    }
+
+    // #### batched operations ####
+    //
+    // Each locale holding part of 'keys' sorts its indices by the locale
+    // owning each key, gathers its keys (and values) into a buffer in that
+    // order, and ships each owner its contiguous part of the buffer with
+    // one bulk transfer.
+
+    // Returns (counts, offsets, perm) for the indices 'inds' of 'keys':
+    // perm lists the indices grouped by owner, and owner i's group is
+    // perm[offsets[i]..#counts[i]].
+    //
+    // Each task counts the owners in its chunk of the indices, and then
+    // places its chunk's indices in each group after those of the chunks
+    // before it, so the result is the same as a serial stable sort.
+    pragma "no doc"
+    proc _sortByOwner(const ref keys, inds) {
+      const n = inds.size;
+      const indsRange = inds.dim(0);
+
+      var owner: [0..#n] int;
+      forall (o, i) in zip(owner, inds) do
+        o = _ownerIdx(keys[i]);
+
+      const numChunks = max(1, min(here.maxTaskPar, n));
+      var chunkCounts: [0..#numChunks] [targetLocDom] int;
+      coforall c in 0..#numChunks {
+        for j in chunk(0..#n, numChunks, c) do
+          chunkCounts[c][owner[j]] += 1;
+      }
+
+      // the start of each chunk's part of each owner's group
+      var counts: [targetLocDom] int;
+      var offsets: [targetLocDom] int;
+      var chunkNext: [0..#numChunks] [targetLocDom] int;
+      var start = 0;
+      for o in targetLocDom {
+        offsets[o] = start;
+        for c in 0..#numChunks {
+          chunkNext[c][o] = start;
+          start += chunkCounts[c][o];
+        }
+        counts[o] = start - offsets[o];
+      }
+
+      var perm: [0..#n] inds.idxType;
+      coforall c in 0..#numChunks {
+        ref next = chunkNext[c];
+        for j in chunk(0..#n, numChunks, c) {
+          const o = owner[j];
+          perm[next[o]] = indsRange.orderToIndex(j);
+          next[o] += 1;
+        }
+      }
+
+      return (counts, offsets, perm);
+    }
+
+    pragma "no doc"
+    proc _checkBatchArgs(param op: string, keys, vals) {
+      if keys.domain.dim(0) != vals.domain.dim(0) then
+        halt("DistributedMap.", op, " needs vals to be declared over ",
+             "the same indices as keys");
+    }
+
+    /*
+      Adds each key in `keys` to the map, mapped to the value at the same
+      index in `vals`. Keys that are already in the map keep their current
+      values. If a key appears more than once in `keys`, it is added with
+      the value from one of its indices.
+
+      :arg keys: The keys to add to the map
+      :arg vals: The values that map to ``keys``, declared over the same
+                 indices as ``keys``
+
+      :returns: The number of keys that were added to the map.
+      :rtype: int
+    */
+    proc addAll(const ref keys: [?kD] keyType,
+                const ref vals: [?vD] valType): int
+    where kD.rank == 1 && vD.rank == 1 {
+      _checkBatchArgs("addAll", keys, vals);
+
+      const pid = this.pid;
+      var numAdded = 0;
+      coforall loc in keys.targetLocales() with (+ reduce numAdded) do on loc {
+        const inst = chpl_getPrivatizedCopy(this.type, pid);
+        for inds in keys.localSubdomains() {
+          const (counts, offsets, perm) = inst._sortByOwner(keys, inds);
+          const sendKeys: [perm.domain] keyType = [i in perm] keys[i];
+          const sendVals: [perm.domain] valType = [i in perm] vals[i];
+
+          coforall dst in inst.targetLocDom with (+ reduce numAdded) {
+            const cnt = counts[dst];
+            if cnt > 0 then on inst.targetLocales[dst] {
+              const lo = offsets[dst];
+              const myKeys: [0..#cnt] keyType = sendKeys[lo..#cnt];
+              const myVals: [0..#cnt] valType = sendVals[lo..#cnt];
+
+              const owner = chpl_getPrivatizedCopy(this.type, pid);
+              owner.lock$.writeEF(true);
+              numAdded += owner.table.bulkAdd(myKeys, myVals);
+              owner.lock$.readFE();
+            }
+          }
+        }
+      }
+      return numAdded;
+    }
+
+    /*
+      Sets the value of each key in `keys` that is in the map to the value
+      at the same index in `vals`. Keys that are not in the map are
+      skipped. If a key appears more than once in `keys`, it is set to the
+      value from one of its indices.
+
+      :arg keys: The keys whose values need to change
+      :arg vals: The new values for ``keys``, declared over the same
+                 indices as ``keys``
+
+      :returns: The number of values that were set.
+      :rtype: int
+    */
+    proc setAll(const ref keys: [?kD] keyType,
+                const ref vals: [?vD] valType): int
+    where kD.rank == 1 && vD.rank == 1 {
+      _checkBatchArgs("setAll", keys, vals);
+
+      const pid = this.pid;
+      var numSet = 0;
+      coforall loc in keys.targetLocales() with (+ reduce numSet) do on loc {
+        const inst = chpl_getPrivatizedCopy(this.type, pid);
+        for inds in keys.localSubdomains() {
+          const (counts, offsets, perm) = inst._sortByOwner(keys, inds);
+          const sendKeys: [perm.domain] keyType = [i in perm] keys[i];
+          const sendVals: [perm.domain] valType = [i in perm] vals[i];
+
+          coforall dst in inst.targetLocDom with (+ reduce numSet) {
+            const cnt = counts[dst];
+            if cnt > 0 then on inst.targetLocales[dst] {
+              const lo = offsets[dst];
+              const myKeys: [0..#cnt] keyType = sendKeys[lo..#cnt];
+              const myVals: [0..#cnt] valType = sendVals[lo..#cnt];
+
+              const owner = chpl_getPrivatizedCopy(this.type, pid);
+              owner.lock$.writeEF(true);
+              // serial, since repeated keys would update the same slot
+              for (k, v) in zip(myKeys, myVals) {
+                var (found, slot) = owner.table.findFullSlot(k);
+                if found {
+                  owner.table.fillSlot(slot, k, v);
+                  numSet += 1;
+                }
+              }
+              owner.lock$.readFE();
+            }
+          }
+        }
+      }
+      return numSet;
+    }
+
+    /*
+      Looks up each key in `keys`. For each index ``i``, sets ``found[i]`` to
+      whether ``keys[i]`` is in the map and, if it is, sets ``vals[i]`` to a
+      copy of its value. Elements of ``vals`` for missing keys are left
+      unchanged.
+
+      :arg keys: The keys to look up
+      :arg vals: Receives the values of ``keys``, declared over the same
+                 indices as ``keys``
+      :arg found: Receives whether each key was found, declared over the
+                  same indices as ``keys``
+
+      :returns: The number of keys that were found.
+      :rtype: int
+    */
+    proc lookupAll(const ref keys: [?kD] keyType,
+                   ref vals: [?vD] valType,
+                   ref found: [?fD] bool): int
+    where kD.rank == 1 && vD.rank == 1 && fD.rank == 1 {
+      if !isDefaultInitializable(valType) then
+        compilerError("DistributedMap.lookupAll needs a default ",
+                      "initializable value type");
+      _checkBatchArgs("lookupAll", keys, vals);
+      _checkBatchArgs("lookupAll", keys, found);
+
+      const pid = this.pid;
+      var numFound = 0;
+      coforall loc in keys.targetLocales() with (+ reduce numFound) do on loc {
+        const inst = chpl_getPrivatizedCopy(this.type, pid);
+        for inds in keys.localSubdomains() {
+          const (counts, offsets, perm) = inst._sortByOwner(keys, inds);
+          const sendKeys: [perm.domain] keyType = [i in perm] keys[i];
+          var recvVals: [perm.domain] valType;
+          var recvFound: [perm.domain] bool;
+
+          coforall dst in inst.targetLocDom with (+ reduce numFound) {
+            const cnt = counts[dst];
+            if cnt > 0 then on inst.targetLocales[dst] {
+              const lo = offsets[dst];
+              const myKeys: [0..#cnt] keyType = sendKeys[lo..#cnt];
+              var myVals: [0..#cnt] valType;
+              var myFound: [0..#cnt] bool;
+
+              const owner = chpl_getPrivatizedCopy(this.type, pid);
+              owner.lock$.writeEF(true);
+              forall (k, v, f) in zip(myKeys, myVals, myFound)
+                with (+ reduce numFound) {
+                const (isFound, slot) = owner.table.findFullSlot(k);
+                if isFound {
+                  v = owner.table.table[slot].val;
+                  f = true;
+                  numFound += 1;
+                }
+              }
+              owner.lock$.readFE();
+
+              recvVals[lo..#cnt] = myVals;
+              recvFound[lo..#cnt] = myFound;
+            }
+          }
+
+          forall (j, i) in zip(perm.domain, perm) {
+            found[i] = recvFound[j];
+            if recvFound[j] then
+              vals[i] = recvVals[j];
+          }
+        }
+      }
+      return numFound;
+    }
+
+    // #### iteration ####
+
+    // Returns a copy of the keys this locale owns.
+    pragma "no doc"
+    proc _localKeys() {
+      lock$.writeEF(true);
+      var ret: [0..#table.tableNumFullSlots] keyType;
+      var i = 0;
+      for slot in table.allSlots() {
+        if table.isSlotFull(slot) {
+          ret[i] = table.table[slot].key;
+          i += 1;
+        }
+      }
+      lock$.readFE();
+      return ret;
+    }
+
+    // Returns a copy of the key-value pairs this locale owns.
+    pragma "no doc"
+    proc _localItems() {
+      lock$.writeEF(true);
+      var ret: [0..#table.tableNumFullSlots] (keyType, valType);
+      var i = 0;
+      for slot in table.allSlots() {
+        if table.isSlotFull(slot) {
+          ref tabEntry = table.table[slot];
+          ret[i] = (tabEntry.key, tabEntry.val);
+          i += 1;
+        }
+      }
+      lock$.readFE();
+      return ret;
+    }
+
+    /*
+      Iterates over the keys of this map. The serial iterator visits one
+      target locale at a time, copying its keys to the current locale.
+    */
+    iter these() : keyType {
+      for loc in targetLocales {
+        var dom : domain(1);
+        var buffer : [dom] keyType;
+        on loc {
+          const snapshot = getPrivatizedThis._localKeys();
+          dom = snapshot.domain;
+          buffer = snapshot;
+        }
+        foreach k in buffer do
+          yield k;
+      }
+    }
+
+    pragma "no doc"
+    iter these(param tag : iterKind) : keyType
+    where tag == iterKind.standalone {
+      coforall loc in targetLocales do on loc {
+        const inst = getPrivatizedThis;
+        forall slot in inst.table.allSlots() {
+          if inst.table.isSlotFull(slot) then
+            yield inst.table.table[slot].key;
+        }
+      }
+    }
+
+    /*
+      Iterates over the key-value pairs of this map, yielding each as a
+      tuple. The serial iterator visits one target locale at a time,
+      copying its pairs to the current locale.
+    */
+    iter items() : (keyType, valType) {
+      for loc in targetLocales {
+        var dom : domain(1);
+        var buffer : [dom] (keyType, valType);
+        on loc {
+          const snapshot = getPrivatizedThis._localItems();
+          dom = snapshot.domain;
+          buffer = snapshot;
+        }
+        foreach item in buffer do
+          yield item;
+      }
+    }
+
+    pragma "no doc"
+    iter items(param tag : iterKind) : (keyType, valType)
+    where tag == iterKind.standalone {
+      coforall loc in targetLocales do on loc {
+        const inst = getPrivatizedThis;
+        forall slot in inst.table.allSlots() {
+          if inst.table.isSlotFull(slot) {
+            ref tabEntry = inst.table.table[slot];
+            yield (tabEntry.key, tabEntry.val);
+          }
+        }
+      }
+    }
+  }
+}
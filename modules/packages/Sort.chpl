@@ -3232,13 +3232,236 @@ module TwoArraySampleSort {
 
 pragma "no doc"
 module InPlacePartitioning {
-  // TODO -- based on ips4o
+  // A parallel in-place partitioning step based on ips4o
+  // (Axtmann et al., "In-place Parallel Super Scalar Samplesort").
+  //
+  // The data is divided into one stripe per task. Each task first gathers
+  // its stripe into blocks of blockSize elements that all belong to the
+  // same bucket, writing the full blocks back to the front of the stripe
+  // (local classification). The tasks then move the full blocks into
+  // their buckets, swapping out whatever block is in the way (block
+  // permutation). Last, the elements left in partly-filled blocks are
+  // written into the gaps at the start and end of each bucket (cleanup).
+  //
+  // Besides A, this uses blockSize elements per task per bucket. Elements
+  // are moved by assignment, so the element type should be POD.
+
+  // The state of each block during the block permutation
+  private param blockEmpty = 0; // nothing in it needs to be kept
+  private param blockFull  = 1; // holds a block that has not been placed
+  private param blockTaken = 2; // a task is reading the block out
+  private param blockDone  = 3; // holds a block in its final place
+
+  // The number of tasks bucketize uses for n elements
+  private proc numTasks(n: int, blockSize: int) {
+    const maxTasks = if dataParTasksPerLocale > 0
+                     then dataParTasksPerLocale
+                     else here.maxTaskPar;
+    return max(1, min(maxTasks, divceil(n, blockSize)));
+  }
+
+  // Returns the number of elements bucketize buffers, besides A, when
+  // it reorders n elements into nBuckets buckets
+  proc bufferSize(n: int, nBuckets: int, blockSize:int = 256) {
+    return (numTasks(n, blockSize)+1)*nBuckets*blockSize + blockSize;
+  }
+
+  // Returns the count for each bucket
+  // Reorders A[start_n..end_n] into buckets according to the bucketizer,
+  // in bucket order, using all of the tasks on this locale.
+  // A should be a local array.
+  proc bucketize(start_n: int, end_n: int, A:[],
+                 bucketizer,
+                 criterion, startbit:int,
+                 blockSize:int = 256) {
+
+    const nBuckets = bucketizer.getNumBuckets();
+    const n = end_n - start_n + 1;
+    const nBlocks = divceil(n, blockSize);
+    const nTasks = numTasks(n, blockSize);
+    const blocksPerTask = divceil(nBlocks, nTasks);
+
+    // The elements of each task's partly-filled block for each bucket.
+    // Row nTasks is used in cleanup for elements that spill out of the
+    // end of a bucket.
+    var buffers: [0..#(nTasks+1)*nBuckets*blockSize] A.eltType;
+    var bufferCounts: [0..nTasks, 0..#nBuckets] int;
+    // The number of full blocks each task wrote for each bucket
+    var fullCounts: [0..#nTasks, 0..#nBuckets] int;
+
+    var blockState: [0..#nBlocks] atomic int;
+
+    // The last block can extend past end_n. If a block is placed there,
+    // it is kept in 'overflow' until cleanup.
+    const lastBlockPartial = n % blockSize != 0;
+    var overflow: [0..#blockSize] A.eltType;
+
+    inline proc blockStart(blk: int) {
+      return start_n + blk*blockSize;
+    }
+    inline proc bufferStart(tid: int, bin: int) {
+      return (tid*nBuckets + bin)*blockSize;
+    }
+    proc readBlock(blk: int, ref buf) {
+      const start = blockStart(blk);
+      for j in 0..#blockSize do
+        buf[j] = A[start+j];
+    }
+    proc writeBlock(blk: int, const ref buf) {
+      if lastBlockPartial && blk == nBlocks-1 {
+        for j in 0..#blockSize do
+          overflow[j] = buf[j];
+      } else {
+        const start = blockStart(blk);
+        for j in 0..#blockSize do
+          A[start+j] = buf[j];
+      }
+    }
+
+    // Step 1: local classification
+    coforall tid in 0..#nTasks {
+      const firstBlock = tid*blocksPerTask;
+      const start = blockStart(firstBlock);
+      const end = min(blockStart(firstBlock + blocksPerTask) - 1, end_n);
+      var w = start;
+      for i in start..end {
+        const bin = bucketizer.bucketForRecord(A[i], criterion, startbit);
+        const bufStart = bufferStart(tid, bin);
+        ref cnt = bufferCounts[tid, bin];
+        buffers[bufStart + cnt] = A[i];
+        cnt += 1;
+        if cnt == blockSize {
+          // A[w..i] has already been read, so the block fits there
+          for j in 0..#blockSize do
+            A[w+j] = buffers[bufStart + j];
+          blockState[(w - start_n) / blockSize].write(blockFull);
+          w += blockSize;
+          cnt = 0;
+          fullCounts[tid, bin] += 1;
+        }
+      }
+    }
+
+    // Step 2: find the bucket boundaries, and the first block
+    // boundary in each bucket
+    var counts: [0..#nBuckets] int;
+    var blockCounts: [0..#nBuckets] int;
+    forall bin in 0..#nBuckets {
+      for tid in 0..#nTasks {
+        counts[bin] += fullCounts[tid, bin]*blockSize + bufferCounts[tid, bin];
+        blockCounts[bin] += fullCounts[tid, bin];
+      }
+    }
+    const bucketEnds = (+ scan counts) + start_n;
+    const bucketStarts = bucketEnds - counts;
+    const firstBlocks = [s in bucketStarts] divceil(s - start_n, blockSize);
+
+    // The next block to place a block of each bucket into
+    var nextBlock: [0..#nBuckets] atomic int;
+    forall (next, first) in zip(nextBlock, firstBlocks) do
+      next.write(first);
+
+    // Step 3: block permutation
+    coforall tid in 0..#nTasks {
+      var cur, other: [0..#blockSize] A.eltType;
+      var nFull = 0;
+      for bin in 0..#nBuckets do
+        nFull += fullCounts[tid, bin];
+
+      for blk in tid*blocksPerTask..#nFull {
+        // another task may have already moved this block
+        if !blockState[blk].compareAndSwap(blockFull, blockTaken) then
+          continue;
+        readBlock(blk, cur);
+        blockState[blk].write(blockEmpty);
+
+        // Place cur, then the block it displaces, and so on
+        // until a block lands in an empty spot.
+        var placing = true;
+        while placing {
+          const bin = bucketizer.bucketForRecord(cur[0], criterion, startbit);
+          var dst = nextBlock[bin].fetchAdd(1);
+          while true {
+            const state = blockState[dst].read();
+            if state == blockEmpty {
+              writeBlock(dst, cur);
+              blockState[dst].write(blockDone);
+              placing = false;
+              break;
+            } else if state == blockFull &&
+                      blockState[dst].compareAndSwap(blockFull, blockTaken) {
+              const dstBin = bucketizer.bucketForRecord(A[blockStart(dst)],
+                                                        criterion, startbit);
+              if dstBin == bin {
+                // It is already in its bucket, so try the next spot.
+                blockState[dst].write(blockDone);
+                dst = nextBlock[bin].fetchAdd(1);
+                continue;
+              }
+              readBlock(dst, other);
+              writeBlock(dst, cur);
+              blockState[dst].write(blockDone);
+              cur <=> other;
+              break;
+            } else if state == blockTaken {
+              // wait for the task reading it out
+              chpl_task_yield();
+            }
+          }
+        }
+      }
+    }
+
+    // Step 4: cleanup
+    // Copy the part of a last block placed in 'overflow' that fits into A.
+    if lastBlockPartial && blockState[nBlocks-1].read() == blockDone {
+      const start = blockStart(nBlocks-1);
+      for j in 0..end_n-start do
+        A[start+j] = overflow[j];
+    }
+
+    // The last block of a bucket can spill over into the next bucket, or
+    // past end_n. Save the spilled elements before the gaps are filled.
+    forall bin in 0..#nBuckets {
+      const blocksEnd = blockStart(firstBlocks[bin] + blockCounts[bin]);
+      if blockCounts[bin] > 0 && blocksEnd > bucketEnds[bin] {
+        const bufStart = bufferStart(nTasks, bin);
+        ref cnt = bufferCounts[nTasks, bin];
+        for i in bucketEnds[bin]..blocksEnd-1 {
+          buffers[bufStart + cnt] =
+            if i <= end_n then A[i] else overflow[i - blockStart(nBlocks-1)];
+          cnt += 1;
+        }
+      }
+    }
+
+    // Fill the gaps before and after each bucket's blocks with the
+    // elements from the partly-filled and spilled blocks.
+    forall bin in 0..#nBuckets {
+      const bucketEnd = bucketEnds[bin];
+      const blocksLo = min(blockStart(firstBlocks[bin]), bucketEnd);
+      const blocksHi = min(blockStart(firstBlocks[bin] + blockCounts[bin]),
+                           bucketEnd);
+      var pos = bucketStarts[bin];
+      for tid in 0..nTasks {
+        const bufStart = bufferStart(tid, bin);
+        for j in 0..#bufferCounts[tid, bin] {
+          if pos == blocksLo then
+            pos = blocksHi;
+          A[pos] = buffers[bufStart + j];
+          pos += 1;
+        }
+      }
+    }
+
+    return counts;
+  }
 }
 
 
 pragma "no doc"
 module MSBRadixSort {
-  import Sort.{defaultComparator, ShellSort};
+  import Sort.{defaultComparator, ShellSort, InPlacePartitioning};
   private use super.RadixSortHelp;
 
   // This structure tracks configuration for the radix sorter.
@@ -3250,6 +3473,10 @@ module MSBRadixSort {
     param progress = false; // print progress
     const alwaysSerial = false; // never create tasks
     const maxTasks = here.maxTaskPar;//;here.numPUs(logical=true); // maximum number of tasks to make
+    // shuffle with all tasks when sorting >= minForParallelShuffle elements
+    // and >= parallelShuffleRatio times the elements that shuffle buffers
+    const minForParallelShuffle = 0;
+    const parallelShuffleRatio = 8;
   }
 
   proc msbRadixSort(Data:[], comparator:?rec=defaultComparator) {
@@ -3358,6 +3585,11 @@ module MSBRadixSort {
     if settings.progress then writeln("shuffle");
 
     // Step 3: shuffle
+    // Large local arrays are shuffled by all of the tasks at once,
+    // which leaves every bin in place for the loop below.
+    if parallelShuffle(A, start_n, end_n, criterion, startbit, settings) then
+      curbin = radix + 1;
+
     while true {
       // Find the next bin that isn't totally in place.
       while curbin <= radix && offsets[curbin] == end_offsets[curbin] {
@@ -3372,9 +3604,6 @@ module MSBRadixSort {
       // buf would need to be populated with the first M elements that aren't
       // already in the correct bin.
 
-      // TODO: I think it's possible to make this shuffle parallel
-      // by imagining each task has a max_buf and have them update
-      // atomic offsets.
       param max_buf = settings.DISTRIBUTE_BUFFER;
       var buf: max_buf*A.eltType;
       var used_buf = 0;
@@ -3484,6 +3713,33 @@ module MSBRadixSort {
 
     if settings.CHECK_SORTS then checkSorted(start_n, end_n, A, criterion);
   }
+
+  // Shuffles A[start_n..end_n] into bins with InPlacePartitioning, if A
+  // is a local array of POD elements with fixed-width keys and there is
+  // enough data to be worth using all of the tasks. The buffers it needs
+  // grow with the number of tasks, so enough data means enough that
+  // they stay small next to it.
+  // Returns whether it did.
+  proc parallelShuffle(A:[], start_n, end_n, criterion,
+                       startbit:int, settings): bool {
+    if A._instance.isDefaultRectangular() && !A.domain.stridable &&
+       A.idxType == int && isPODType(A.eltType) &&
+       msbRadixSortParamLastStartBit(A, criterion) >= 0 {
+      const n = end_n - start_n + 1;
+      const bucketizer = new RadixBucketizer();
+      const buffered =
+        InPlacePartitioning.bufferSize(n, bucketizer.getNumBuckets());
+      if !settings.alwaysSerial &&
+         n >= settings.minForParallelShuffle &&
+         n >= settings.parallelShuffleRatio * buffered &&
+         here.runningTasks() < settings.maxTasks {
+        InPlacePartitioning.bucketize(start_n, end_n, A, bucketizer,
+                                      criterion, startbit);
+        return true;
+      }
+    }
+    return false;
+  }
 }
 
 /* Comparators */
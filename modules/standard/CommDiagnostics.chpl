@@ -282,6 +282,16 @@ module CommDiagnostics
       PUTs that required the cache to create a new page to store them.
      */
     var cache_put_misses: uint(64);
+    /*
+      Cache pages prefetched by the strided stream detector that were
+      later read by a GET.
+     */
+    var cache_stream_useful: uint(64);
+    /*
+      Cache pages prefetched by the strided stream detector that were
+      evicted or invalidated before any GET read them.
+     */
+    var cache_stream_wasted: uint(64);
 
     proc writeThis(c) throws {
       use Reflection;
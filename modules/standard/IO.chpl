@@ -697,6 +697,8 @@ extern const QIO_METHOD_FREADFWRITE:c_int;
 pragma "no doc"
 extern const QIO_METHOD_MMAP:c_int;
 pragma "no doc"
+extern const QIO_METHOD_URING:c_int;
+pragma "no doc"
 extern const QIO_METHODMASK:c_int;
 pragma "no doc"
 extern const QIO_HINT_RANDOM:c_int;
@@ -744,6 +746,13 @@ const IOHINT_CACHED = QIO_HINT_CACHED;
  */
 const IOHINT_PARALLEL = QIO_HINT_PARALLEL;
 
+/*  IOHINT_URING requests that buffered channels read and write the file
+    with batches of asynchronous requests through Linux io_uring, keeping
+    several in flight at a time.  Where io_uring is not available, the
+    file is read and written with pread and pwrite instead.
+ */
+const IOHINT_URING = QIO_METHOD_URING;
+
 pragma "no doc"
 extern type qio_file_ptr_t;
 private extern const QIO_FILE_PTR_NULL:qio_file_ptr_t;
@@ -1185,6 +1194,8 @@ private extern proc qio_channel_scan_int(threadsafe:c_int, ch:qio_channel_ptr_t,
 private extern proc qio_channel_print_int(threadsafe:c_int, ch:qio_channel_ptr_t, const ref ptr, len:size_t, issigned:c_int):syserr;
 
 private extern proc qio_channel_scan_float(threadsafe:c_int, ch:qio_channel_ptr_t, ref ptr, len:size_t):syserr;
+private extern proc qio_channel_scan_ints(threadsafe:c_int, ch:qio_channel_ptr_t, ptr:c_void_ptr, len:size_t, issigned:c_int, n:ssize_t, ref num_read:ssize_t):syserr;
+private extern proc qio_channel_scan_floats(threadsafe:c_int, ch:qio_channel_ptr_t, ptr:c_void_ptr, len:size_t, n:ssize_t, ref num_read:ssize_t):syserr;
 private extern proc qio_channel_print_float(threadsafe:c_int, ch:qio_channel_ptr_t, const ref ptr, len:size_t):syserr;
 
 // These are the same as scan/print float but they assume an 'i' afterwards.
@@ -3843,6 +3854,67 @@ private proc readBytesOrString(ch: channel, ref out_var: ?t,  len: int(64))
 
 }
 
+/*
+   Read integers or real numbers into an array.  The channel lock is held
+   while reading all of the values.  When the channel is reading text, the
+   values are parsed in bulk straight from the channel's buffer, which is
+   much faster than reading them one at a time.  Textual values must be
+   separated by whitespace and are read according to the channel's style.
+
+   :arg data: the array to read into, filled starting from its first element
+   :returns: the number of values read, which is less than ``data.size``
+             only if end of file was reached
+
+   :throws SystemError: Thrown if a value could not be read from the channel.
+ */
+proc channel.readArray(ref data: [] ?t): int throws
+    where data.rank == 1 && (isIntegralType(t) || isRealType(t)) {
+  if writing then compilerError("read on write-only channel");
+  const origLocale = this.getLocaleOfIoRequest();
+  var numRead = 0;
+
+  on this.home {
+    try this.lock(); defer { this.unlock(); }
+
+    const text = kind == iokind.dynamic &&
+                 qio_channel_binary(_channel_internal) == 0;
+
+    if text && !data.stridable && data._instance.isDefaultRectangular() &&
+       data._value.locale == here {
+      var got:ssize_t = 0;
+      var err:syserr = ENOERR;
+      if data.size > 0 {
+        const ptr = c_ptrTo(data[data.domain.low]):c_void_ptr;
+        if isIntegralType(t) then
+          err = qio_channel_scan_ints(false, _channel_internal, ptr,
+                                      numBytes(t), isIntType(t), data.size,
+                                      got);
+        else
+          err = qio_channel_scan_floats(false, _channel_internal, ptr,
+                                        numBytes(t), data.size, got);
+      }
+      numRead = got;
+      if err != ENOERR && err != EEOF then
+        try this._ch_ioerror(err, "in channel.readArray");
+    } else {
+      // binary I/O, or an array we cannot fill through a pointer
+      for x in data {
+        var gotOne = true;
+        try {
+          _readOne(kind, x, origLocale);
+        } catch err: SystemError {
+          if err.err != EEOF then throw err;
+          gotOne = false;
+        }
+        if !gotOne then break;
+        numRead += 1;
+      }
+    }
+  }
+
+  return numRead;
+}
+
 /*
    Read bits with binary I/O
 
@@ -52,6 +52,14 @@ module Map {
 
   private use IO;
 
+  /*
+    If `true`, maps store their entries in a hashtable with a power-of-two
+    size and a separate array of one-byte hash fingerprints, which lookups
+    scan 8 slots at a time. This layout is usually faster for large maps,
+    and it lets maps fill more of the table before growing.
+  */
+  config param mapUseSwissTable = false;
+
   pragma "no doc"
   inline proc checkForNonNilableClass(type t) type {
     if isNonNilableClass(t) {
@@ -71,7 +79,7 @@ module Map {
     param parSafe = false;
 
     pragma "no doc"
-    var table: chpl__hashtable(keyType, valType);
+    var table: chpl__hashtable(keyType, valType, mapUseSwissTable);
 
     pragma "no doc"
     var _lock$ = if parSafe then new _LockWrapper() else none;
@@ -587,6 +595,32 @@ module Map {
       return true;
     }
 
+    /*
+      Adds each key in `keys` to the map, mapped to the value at the same
+      position in `vals`. The map is grown once to fit all of the keys, and
+      they are then hashed and added in parallel. Keys that are already in
+      the map keep their current values. If a key appears more than once
+      in `keys`, it is added with the value from one of its positions.
+
+     :arg keys: The keys to add to the map
+     :type keys: [] keyType
+
+     :arg vals: The values that map to ``keys``, one for each key
+     :type vals: [] valType
+
+     :returns: The number of keys that were added to the map.
+     :rtype: int
+    */
+    proc addAll(keys: [?kd] keyType, vals: [?vd] valType): int
+    lifetime this < vals {
+      if keys.size != vals.size then
+        halt("map.addAll was given ", keys.size, " keys but ",
+             vals.size, " values");
+
+      _enter(); defer _leave();
+      return table.bulkAdd(keys, vals);
+    }
+
 
     /*
       Sets the value associated with a key. Method returns `false` if the key
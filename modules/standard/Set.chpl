@@ -47,6 +47,14 @@ module Set {
   private use Reflection;
   private use ChapelHashtable;
 
+  /*
+    If `true`, sets store their elements in a hashtable with a power-of-two
+    size and a separate array of one-byte hash fingerprints, which lookups
+    scan 8 slots at a time. This layout is usually faster for large sets,
+    and it lets sets fill more of the table before growing.
+  */
+  config param setUseSwissTable = false;
+
   pragma "no doc"
   private param _sanityChecks = true;
 
@@ -136,7 +144,7 @@ module Set {
     var _lock$ = if parSafe then new _LockWrapper() else none;
 
     pragma "no doc"
-    var _htb: chpl__hashtable(eltType, nothing);
+    var _htb: chpl__hashtable(eltType, nothing, setUseSwissTable);
 
     /*
       Initializes an empty set containing elements of the given type.
@@ -276,6 +284,27 @@ module Set {
       _addElem(x);
     }
 
+    /*
+      Add a copy of each element of `arr` to this set. The set is grown once
+      to fit all of the elements, and they are then hashed and added in
+      parallel. Elements that this set already contains, and repeats within
+      `arr`, are not added again.
+
+      :arg arr: The elements to add to this set.
+      :return: The number of elements added to this set.
+      :rtype: `int`
+    */
+    proc ref addAll(const ref arr: [] eltType): int lifetime this < arr {
+      var result = 0;
+
+      on this {
+        _enter(); defer _leave();
+        result = _htb.bulkAdd(arr);
+      }
+
+      return result;
+    }
+
     /*
       Returns `true` if the given element is a member of this set, and `false`
       otherwise.
@@ -21,13 +21,31 @@
 #ifndef _chpl_cache_task_decls_h_
 #define _chpl_cache_task_decls_h_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// How many concurrent strided streams does each task track?
+#define CHPL_CACHE_STREAMS_PER_TASK 4
+
+// One stream seen by the remote cache's stream detector.
+// An all-zero stream is unused.
+typedef struct {
+  uintptr_t last_raddr;   // address of the last GET in the stream
+  int32_t stride;         // bytes between GETs; 0 if not known yet
+  int32_t node;           // locale the stream reads from
+  uint16_t confidence;    // number of times the stride has repeated
+  uint16_t lru;           // for replacing the least recently used stream
+  int32_t prefetched;     // bytes past last_raddr already prefetched
+} chpl_cache_stream_t;
+
 // This is the type of the task private data used by the cache
 typedef struct {
   int64_t last_acquire; // cache acquire barrier sets this
+  uint16_t stream_clock; // advanced on each GET the detector sees
+  chpl_cache_stream_t streams[CHPL_CACHE_STREAMS_PER_TASK];
 } chpl_cache_taskPrvData_t;
 
 #ifdef __cplusplus
@@ -58,7 +58,9 @@ extern int chpl_comm_diags_print_unstable;
   MACRO(cache_get_hits) \
   MACRO(cache_get_misses) \
   MACRO(cache_put_hits) \
-  MACRO(cache_put_misses)
+  MACRO(cache_put_misses) \
+  MACRO(cache_stream_useful) \
+  MACRO(cache_stream_wasted)
 
 
 typedef struct _chpl_commDiagnostics {
@@ -527,6 +527,113 @@ void strd_common_call(void* dstaddr_arg, size_t* dststrides, int32_t srclocale,
 }
 
 
+//
+// Support for comm layers that move strided data by packing it into a
+// contiguous buffer on one side, transferring that with a single RMA,
+// and unpacking it on the other side.
+//
+
+//
+// Number of contiguous runs (of count[0] elements each) in a strided
+// region.
+//
+static inline
+size_t strd_num_runs(size_t* count, int32_t stridelevels) {
+  size_t n = 1;
+  for (int32_t i = 1; i <= stridelevels; i++) {
+    n *= count[i];
+  }
+  return n;
+}
+
+
+//
+// Decide whether a strided transfer should be packed rather than done
+// one run at a time.  Packing costs a round trip to the remote side and
+// a copy on each side, so it only pays off when there are enough runs
+// and they are short enough that the per-run overhead dominates.  The
+// caller gives the limits appropriate to its comm layer.
+//
+static inline
+chpl_bool strd_should_pack(size_t* count, int32_t stridelevels,
+                           size_t elemSize,
+                           size_t maxRunSize, size_t minRuns,
+                           size_t maxPackSize) {
+  if (stridelevels <= 0) {
+    return false;
+  }
+
+  const size_t runSize = count[0] * elemSize;
+  if (runSize == 0 || runSize > maxRunSize) {
+    return false;
+  }
+
+  const size_t numRuns = strd_num_runs(count, stridelevels);
+  return numRuns >= minRuns && numRuns <= maxPackSize / runSize;
+}
+
+
+//
+// Copy the strided region at 'addr' into the contiguous buffer 'buf'
+// (pack) or from 'buf' into the strided region (unpack).  The strides
+// are in elements, as for the strided transfer functions.
+//
+static inline
+void strd_pack_common(chpl_bool pack, void* buf,
+                      void* addr, size_t* strides,
+                      size_t* count, int32_t stridelevels, size_t elemSize) {
+  const size_t strlvls = (size_t) stridelevels;
+  const size_t runSize = count[0] * elemSize;
+  const size_t numRuns = strd_num_runs(count, stridelevels);
+  size_t str[strlvls + 1];
+  size_t idx[strlvls + 1];
+  size_t i, l;
+
+  for (l = 0; l < strlvls; l++) {
+    str[l] = strides[l] * elemSize;
+    idx[l] = 0;
+  }
+
+  int8_t* b = (int8_t*) buf;
+  int8_t* a = (int8_t*) addr;
+  size_t off = 0;
+  for (i = 0; i < numRuns; i++) {
+    if (pack) {
+      memcpy(b, a + off, runSize);
+    } else {
+      memcpy(a + off, b, runSize);
+    }
+    b += runSize;
+
+    // advance to the next run, carrying into the outer levels
+    for (l = 0; l < strlvls; l++) {
+      off += str[l];
+      if (++idx[l] < count[l + 1]) {
+        break;
+      }
+      off -= str[l] * count[l + 1];
+      idx[l] = 0;
+    }
+  }
+}
+
+
+static inline
+void strd_pack(void* buf, void* srcaddr, size_t* srcstrides,
+               size_t* count, int32_t stridelevels, size_t elemSize) {
+  strd_pack_common(true, buf, srcaddr, srcstrides,
+                   count, stridelevels, elemSize);
+}
+
+
+static inline
+void strd_unpack(void* dstaddr, size_t* dststrides, void* buf,
+                 size_t* count, int32_t stridelevels, size_t elemSize) {
+  strd_pack_common(false, buf, dstaddr, dststrides,
+                   count, stridelevels, elemSize);
+}
+
+
 #ifdef __cplusplus
 }
 #endif
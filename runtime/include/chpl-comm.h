@@ -486,6 +486,28 @@ void chpl_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
 
 void chpl_comm_getput_unordered_task_fence(void);
 
+//
+// Aggregated ops
+//
+// These are like the unordered ops, but are meant for use by libraries
+// that want to batch many small transfers from one task.  The comm layer
+// may hold them in task-private buffers and send them together.  For a
+// PUT the source data has been captured by the time the call returns,
+// so addr can be reused immediately.  But the target of a GET and the
+// remote effect of a PUT are only guaranteed to be visible after the
+// calling task has done chpl_comm_aggregated_flush() or has ended.
+//
+void chpl_comm_get_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn);
+
+void chpl_comm_put_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn);
+
+//
+// Complete all the aggregated ops done so far by the calling task.
+//
+void chpl_comm_aggregated_flush(void);
+
 //
 // Runs a function f on a remote locale, passing it
 // arg where size of arg is stored in arg_size.
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+//
+// Per-thread arenas for short-lived task allocations.
+//
+// Task pool descriptors, argument bundle copies, and other memory that
+// lives no longer than a task are allocated and freed at a high rate,
+// usually by different threads.  Going to the general allocator for
+// each of these puts the task spawn and exit paths in contention on
+// the allocator's shared arenas.  Instead, each thread keeps its own
+// size-classed free lists of such blocks.  An allocation is satisfied
+// from the calling thread's lists when possible, and a free puts the
+// block back on the lists of the thread that allocated it, so neither
+// takes any lock.  When a task ends, the thread running it hands any
+// blocks beyond its retention limit back to the memory layer in one
+// batch.
+//
+// Blocks handed out by the arena are tracked by the memory tracking
+// support under the caller's description just like any other
+// allocation, but blocks resting in the arena are not, so --memLeaks
+// and --memStats still reflect only memory that is actually in use.
+// The arena's own hit/miss and retention figures are reported with
+// --memStats.
+//
+
+#ifndef _chpl_mem_arena_H_
+#define _chpl_mem_arena_H_
+
+#ifndef LAUNCHER
+
+#include <stddef.h>
+#include <stdint.h>
+#include "chpl-mem-desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint64_t allocs;        // allocations requested of the arenas
+  uint64_t hits;          // ... satisfied from a free list
+  uint64_t frees;         // blocks returned to the arenas
+  uint64_t remoteFrees;   // ... by a thread other than the allocating one
+  uint64_t bulkReturns;   // blocks handed back to the memory layer
+  uint64_t bytesRetained; // bytes currently resting in free lists
+} chpl_mem_arena_stats_t;
+
+void chpl_mem_arena_init(void);
+
+void* chpl_mem_arena_alloc(size_t size, chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename);
+void chpl_mem_arena_free(void* p, int32_t lineno, int32_t filename);
+
+//
+// Called by the tasking layer on the thread that ran a task, once the
+// task's body has returned.
+//
+void chpl_mem_arena_task_end(void);
+
+//
+// Called by the tasking layer when a thread it created is about to
+// exit, to release that thread's arena.
+//
+void chpl_mem_arena_thread_exit(void);
+
+void chpl_mem_arena_getStats(chpl_mem_arena_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LAUNCHER
+
+#endif // _chpl_mem_arena_H_
@@ -31,6 +31,7 @@
 #include "chpl-mem-desc.h"
 #include "chpl-mem-hook.h"
 #include "chpl-topo.h"
+#include "chplsys.h"
 #include "chpltypes.h"
 #include "error.h"
 
@@ -82,6 +83,22 @@ void* chpl_mem_array_alloc(size_t nmemb, size_t eltSize,
 
   if (p == NULL) {
     p = chpl_malloc(nmemb * eltSize);
+
+    //
+    // If the array is to be spread across the sublocales, bind
+    // successive equal parts of it to successive NUMA domains.  Under
+    // the numa locale model this matches how the data-parallel
+    // iterators divide the array among the sublocales, so their chunks
+    // find their memory local.  (Memory from the comm layer is
+    // localized in its post-alloc processing instead.)
+    //
+    if (subloc == c_sublocid_all) {
+      const int numDomains = chpl_topo_getNumNumaDomains();
+      if (numDomains > 1
+          && size >= numDomains * 2 * chpl_getSysPageSize()) {
+        chpl_topo_setMemSubchunkLocality(p, size, true, NULL);
+      }
+    }
   }
 
   chpl_memhook_malloc_post(p, nmemb, eltSize, CHPL_RT_MD_ARRAY_ELEMENTS,
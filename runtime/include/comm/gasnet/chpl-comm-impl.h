@@ -33,6 +33,13 @@ extern "C" {
     chpl_comm_impl_regMemHeapInfo(start_p, size_p)
 void chpl_comm_impl_regMemHeapInfo(void** start_p, size_t* size_p);
 
+//
+// Task end hook, to complete any outstanding aggregated GETs and PUTs.
+//
+#define CHPL_COMM_IMPL_TASK_END() \
+        chpl_comm_impl_task_end()
+void chpl_comm_impl_task_end(void);
+
 #ifdef __cplusplus
 }
 #endif
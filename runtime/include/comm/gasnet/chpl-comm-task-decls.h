@@ -31,6 +31,7 @@ extern "C" {
 
 typedef struct {
     chpl_cache_taskPrvData_t cache_data;
+    void* agg_buff;             // outstanding aggregated GETs/PUTs, if any
 } chpl_comm_taskPrvData_t;
 
 //
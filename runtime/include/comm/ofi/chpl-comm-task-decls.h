@@ -45,6 +45,7 @@ typedef struct {
   void* amo_nf_buff;
   void* get_buff;
   void* put_buff;
+  void* am_buff;                // coalesced AM requests, if any
 } chpl_comm_taskPrvData_t;
 
 //
@@ -424,6 +424,10 @@ qioerr qio_channel_print_bool(const int threadsafe, qio_channel_t* restrict ch,
 qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned);
 qioerr qio_channel_scan_float(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len);
 qioerr qio_channel_scan_imag(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len);
+// Scan n numbers of byte size len into the array out, stopping at the first
+// error.  *num_read_out is set to how many were read.
+qioerr qio_channel_scan_ints(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned, ssize_t n, ssize_t* restrict num_read_out);
+qioerr qio_channel_scan_floats(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, ssize_t n, ssize_t* restrict num_read_out);
 qioerr qio_channel_print_int(const int threadsafe, qio_channel_t* restrict ch, const void* restrict ptr, size_t len, int issigned);
 qioerr qio_channel_print_float(const int threadsafe, qio_channel_t* restrict ch, const void* restrict ptr, size_t len);
 qioerr qio_channel_print_imag(const int threadsafe, qio_channel_t* restrict ch, const void* restrict ptr, size_t len);
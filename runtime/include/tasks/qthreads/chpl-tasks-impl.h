@@ -59,9 +59,16 @@ typedef unsigned int chpl_taskID_t;
 //
 // Sync variables
 //
+// The lock and the full/empty bit share one word, so uncontended
+// operations need just one atomic op to lock and one to set the new
+// state and unlock.  The FEB signal words are only touched when some
+// task actually has to wait.  The waiter counts are protected by the
+// lock.
+//
 typedef struct {
-    aligned_t lock;
-    int       is_full;
+    aligned_t state;
+    int       num_waiting_full;
+    int       num_waiting_empty;
     aligned_t signal_full;
     aligned_t signal_empty;
 } chpl_sync_aux_t;
@@ -284,10 +284,14 @@ use.
 #include "sys.h" // sys_page_size()
 #include "chpl-comm-compiler-macros.h"
 #include "chpl-comm-no-warning-macros.h" // No warnings for chpl_comm_get etc.
+#include "chpl-env.h"
+#include "error.h"
 
 
 #include <string.h> // memcpy, memset, etc.
 #include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
 
 
 #ifdef HAS_CHPL_CACHE_FNS
@@ -313,25 +317,38 @@ use.
 // Reasonable values for CACHEPAGE_BITS are between 6 and 12
 // (64 bytes and 4k bytes. CACHEPAGE_BITS should not be larger than the
 // page size) and it must currently be even.
-// Here we set it to 1k bytes (ie 2^10).
-#define CACHEPAGE_BITS 10
+// By default we set it to 1k bytes (ie 2^10). It can be changed for
+// a run with CHPL_RT_CACHE_PAGE_SIZE (see chpl_cache_init).
+//
+// Structures that have a bit per byte or per line of a page are sized
+// for CACHEPAGE_MAX_BITS so that they do not depend on the setting.
+#define CACHEPAGE_MIN_BITS 6
+#define CACHEPAGE_MAX_BITS 12
+#define CACHEPAGE_DEFAULT_BITS 10
+static int cachepage_bits = CACHEPAGE_DEFAULT_BITS;
+#define CACHEPAGE_BITS cachepage_bits
 #define CACHEPAGE_SIZE (1 << CACHEPAGE_BITS)
 #define CACHEPAGE_MASK (CACHEPAGE_SIZE-1)
+#define CACHEPAGE_MAX_SIZE (1 << CACHEPAGE_MAX_BITS)
 
 // CACHELINE_BITS
 // Controls the cache line size - that is, the minimum number of bytes
 // that are fetched for any 'get' operation.
 //
 // Reasonable values for CACHELINE_BITS are between 6 and CACHEPAGE_BITS.
-// Here we set it to 64 bytes (ie 2^6)
-#define CACHELINE_BITS 6
+// By default we set it to 64 bytes (ie 2^6). It can be changed for
+// a run with CHPL_RT_CACHE_LINE_SIZE.
+#define CACHELINE_MIN_BITS 6
+#define CACHELINE_DEFAULT_BITS 6
+static int cacheline_bits = CACHELINE_DEFAULT_BITS;
+#define CACHELINE_BITS cacheline_bits
 #define CACHELINE_SIZE (1 << CACHELINE_BITS)
 #define CACHELINE_MASK (CACHELINE_SIZE-1)
 
 // What type can store the number of cache lines in a cache page?
 typedef int8_t line_per_page_t;
-// What type for a number of lines to read ahead?
-typedef int16_t readahead_distance_t;
+// What type for a number of bytes to read ahead?
+typedef int32_t readahead_distance_t;
 
 // used to compress top_index_list / bottom_index arrays
 // the entry pointer is entry_base + idx*sizeof(entry type)
@@ -340,7 +357,18 @@ typedef int16_t entry_id_t;
 // When prefetching, what is the maximum number of pages
 // we are willing to prefetch? This is also the maximum
 // readahead window size for sequential access.
-#define MAX_PAGES_PER_PREFETCH 2
+// It can be changed for a run with CHPL_RT_CACHE_PREFETCH_PAGES.
+#define DEFAULT_PAGES_PER_PREFETCH 2
+#define MAX_PAGES_PER_PREFETCH_LIMIT 16
+static int max_pages_per_prefetch = DEFAULT_PAGES_PER_PREFETCH;
+
+// Should the readahead window of each cache be adjusted based on
+// the hits and misses it sees? Set with CHPL_RT_CACHE_ADAPTIVE.
+// When this is on, each cache starts with max_pages_per_prefetch and
+// moves its own window between 1 and MAX_PAGES_PER_PREFETCH_LIMIT.
+static int cache_adaptive = 0;
+// How many GETs make up one sample when adapting the readahead window?
+#define ADAPT_WINDOW_GETS 4096
 
 // Should we enable sequential readahead?
 // For sequential access If we're reading
@@ -349,7 +377,21 @@ typedef int16_t entry_id_t;
 
 #define ENABLE_READAHEAD_TRIGGER_SEQUENTIAL 0
 
-#define MAX_SEQUENTIAL_READAHEAD_BYTES (MAX_PAGES_PER_PREFETCH*CACHEPAGE_SIZE)
+#define MAX_SEQUENTIAL_READAHEAD_BYTES(cache) \
+  ((cache)->pages_per_prefetch*CACHEPAGE_SIZE)
+
+// Should each task's stream detector prefetch ahead of GETs that
+// walk remote memory with a constant stride (forward or backward)?
+// Set with CHPL_RT_CACHE_STREAM_PREFETCH. See cache_stream_observe.
+static int cache_stream_prefetch = 0;
+// How many times must a stride repeat before the detector prefetches?
+#define STREAM_TRAIN_COUNT 2
+// Larger strides than this (in bytes) are not treated as streams.
+#define STREAM_MAX_STRIDE (1 << 20)
+// How many elements ahead of a stream with a stride of at least a page
+// should be prefetched? (Streams with smaller strides are prefetched
+// pages_per_prefetch pages ahead.)
+#define STREAM_PREFETCH_DEPTH 8
 
 // These defines can enable different kinds of debugging output.
 
@@ -469,13 +511,16 @@ struct rdcache_s;
 // How many uint64_t words do we need to create a bitmask for CACHEPAGE_SIZE?
 // Divide # bytes in cache by 64, rounding up.
 #define CACHEPAGE_BITMASK_WORDS ((CACHEPAGE_SIZE+63)/64)
+#define CACHEPAGE_MAX_BITMASK_WORDS ((CACHEPAGE_MAX_SIZE+63)/64)
 
 // How many cache lines per cache page?
 #define CACHE_LINES_PER_PAGE (CACHEPAGE_SIZE/CACHELINE_SIZE)
 
 // How many uint64_t words do we need to create a bitmask for CACHE_LINES_PER_PAGE
 // ie, a mask recording a bit per cache line?
-#define CACHE_LINES_PER_PAGE_BITMASK_WORDS (((CACHEPAGE_SIZE/CACHELINE_SIZE)+63)/64)
+// The largest page with the smallest lines needs the most words.
+#define CACHE_LINES_PER_PAGE_BITMASK_WORDS \
+  (((CACHEPAGE_MAX_SIZE >> CACHELINE_MIN_BITS)+63)/64)
 
 // Storing a remote address (node number is separate).
 typedef uintptr_t raddr_t;
@@ -523,7 +568,7 @@ struct dirty_entry_s {
   // which cache entry are we talking about here?
   struct cache_entry_s* entry;
   // Which of the page's bytes are dirty?
-  uint64_t dirty[CACHEPAGE_BITMASK_WORDS]; // ie we need to create a put for these bytes
+  uint64_t dirty[CACHEPAGE_MAX_BITMASK_WORDS]; // ie we need to create a put for these bytes
 };
 
 #define QUEUE_FREE 0
@@ -548,6 +593,8 @@ struct cache_entry_s {
   struct cache_list_entry_s base; // contains raddr, node, next offset
   // Queue information. This entry could be in Ain, Aout, or Am queues.
   int queue;
+  // Was the page prefetched by the stream detector and not read since?
+  int8_t stream_prefetched;
 
   // Since e.g. with ugni, a comm event can cause the implementation
   // to switch tasks, only allow one task at a time to manipulate
@@ -627,6 +674,22 @@ struct rdcache_s {
   // for the number of table slots.
   int table_bits;
 
+  // The readahead window, in pages. This is max_pages_per_prefetch
+  // unless CHPL_RT_CACHE_ADAPTIVE is set, in which case
+  // cache_adapt_readahead adjusts it.
+  int pages_per_prefetch;
+  // Counts of GETs in the current sample for cache_adapt_readahead,
+  // along with the miss rate (in 1/1024ths) of the previous sample
+  // and the direction that pages_per_prefetch last moved.
+  int adapt_gets;
+  int adapt_misses;
+  int adapt_last_miss_rate;
+  int adapt_direction;
+
+  // Set while the stream detector is issuing prefetches, so that
+  // the entries they fill can be marked.
+  int stream_prefetching;
+
   // The variable names Ain Aout and Am come from the 2Q paper
 
   // Ain is a FIFO queue storing entries initially as they go into
@@ -779,7 +842,14 @@ struct rdcache_s* cache_create(void) {
 
   // This used to grow based on the number of locales, but that
   // would mean increasing memory usage per node, which isn't acceptable.
+  // With pages smaller than the default, use more of them
+  // (up to the same number of bytes) so small pages don't make
+  // the cache much smaller.
   cache_pages = 1024;
+  if( CACHEPAGE_BITS < CACHEPAGE_DEFAULT_BITS ) {
+    cache_pages <<= (CACHEPAGE_DEFAULT_BITS - CACHEPAGE_BITS);
+    if( cache_pages > 4096 ) cache_pages = 4096;
+  }
 
   ain_pages = cache_pages / 4; // 2Q: "Kin should be 25% of page slots"
                                // but here we set it smaller so that
@@ -867,6 +937,14 @@ struct rdcache_s* cache_create(void) {
   c->last_cache_miss_read_node = -1;
   c->last_cache_miss_read_addr = 0;
 
+  c->pages_per_prefetch = max_pages_per_prefetch;
+  c->adapt_gets = 0;
+  c->adapt_misses = 0;
+  c->adapt_last_miss_rate = -1;
+  c->adapt_direction = 1;
+
+  c->stream_prefetching = 0;
+
   c->max_pages = cache_pages;
   c->max_entries = n_entries;
 
@@ -2100,6 +2178,15 @@ void flush_entry(struct rdcache_s* cache,
     }
   }
 
+  // A page from the stream detector that is dropped before
+  // anything reads it was a wasted prefetch.
+  if( entry->stream_prefetched &&
+      ( (op & FLUSH_DO_EVICT) ||
+        ( (op & FLUSH_DO_INVALIDATE) && len == CACHEPAGE_SIZE ) ) ) {
+    entry->stream_prefetched = 0;
+    chpl_comm_diags_incr(cache_stream_wasted);
+  }
+
   // If invalidating, clear valid bits.
   if( op & FLUSH_DO_INVALIDATE ) {
     if( len == CACHEPAGE_SIZE ) {
@@ -2197,6 +2284,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     tree->am_current++;
 
     bottom_match->queue = QUEUE_AM;
+    bottom_match->stream_prefetched = 0;
     bottom_match->entryReservedByTask = NULL;
     bottom_match->readahead_skip = 0;
     bottom_match->readahead_len = 0;
@@ -2225,6 +2313,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     bottom_tmp->base.next = NULL;
 
     bottom_tmp->queue = QUEUE_AIN;
+    bottom_tmp->stream_prefetched = 0;
     bottom_tmp->entryReservedByTask = NULL;
     bottom_tmp->readahead_skip = 0;
     bottom_tmp->readahead_len = 0;
@@ -2627,8 +2716,8 @@ void cache_get_trigger_readahead(struct rdcache_s* cache,
   if( ENABLE_READAHEAD && skip && ! is_congested(cache) ) {
     next_ra_length = 2 * len;
 
-    if( next_ra_length > MAX_SEQUENTIAL_READAHEAD_BYTES )
-      next_ra_length = MAX_SEQUENTIAL_READAHEAD_BYTES;
+    if( next_ra_length > MAX_SEQUENTIAL_READAHEAD_BYTES(cache) )
+      next_ra_length = MAX_SEQUENTIAL_READAHEAD_BYTES(cache);
 
     if( skip < 0 )
       next_ra_length = - next_ra_length;
@@ -2911,6 +3000,11 @@ int cache_get_in_page(struct rdcache_s* cache,
       // Copy the data out.
       chpl_memcpy(addr, entry->page + (raddr-ra_page), size);
 
+      if( entry->stream_prefetched ) {
+        entry->stream_prefetched = 0;
+        chpl_comm_diags_incr(cache_stream_useful);
+      }
+
 #ifdef DUMP
       {
         // printing out gotten data for debug
@@ -3026,6 +3120,10 @@ int cache_get_in_page(struct rdcache_s* cache,
     assert(entry->base.raddr == ra_page && entry->base.node == node);
 
     entry->max_prefetch_sequence_number = seqn_max(entry->max_prefetch_sequence_number, sn);
+
+    if( cache->stream_prefetching ) {
+      entry->stream_prefetched = 1;
+    }
   }
 
   // Set the minimum sequence number
@@ -3177,8 +3275,8 @@ int cache_get(struct rdcache_s* cache,
 
   // If the request is too large to reasonably fit in the cache, limit
   // the amount of data prefetched. (or do nothing?)
-  if( isprefetch && (ra_last_page-ra_first_page)/CACHEPAGE_SIZE+1 > MAX_PAGES_PER_PREFETCH ) {
-    ra_last_page = ra_first_page + CACHEPAGE_SIZE*MAX_PAGES_PER_PREFETCH;
+  if( isprefetch && (ra_last_page-ra_first_page)/CACHEPAGE_SIZE+1 > cache->pages_per_prefetch ) {
+    ra_last_page = ra_first_page + CACHEPAGE_SIZE*cache->pages_per_prefetch;
   }
 
   // Try to find it in the cache. Go through one page at a time.
@@ -3609,6 +3707,67 @@ void chpl_cache_do_init(void)
   }
 }
 
+// Returns log2(size) if size is a power of 2 between 2^min_bits and
+// 2^max_bits (and even, if must_be_even), or dflt_bits otherwise.
+static
+int cache_size_env_to_bits(const char* ev, int dflt_bits,
+                           int min_bits, int max_bits, int must_be_even)
+{
+  int64_t size = chpl_env_rt_get_int(ev, (int64_t) 1 << dflt_bits);
+  int bits;
+
+  for( bits = min_bits; bits <= max_bits; bits++ ) {
+    if( size == ((int64_t) 1 << bits) &&
+        ( !must_be_even || (bits % 2) == 0 ) ) {
+      return bits;
+    }
+  }
+
+  if( chpl_nodeID == 0 ) {
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "CHPL_RT_%s=%" PRId64 " is not supported; using %d "
+             "(the size must be a power of %d from %d to %d)",
+             ev, size, 1 << dflt_bits, must_be_even ? 4 : 2,
+             1 << min_bits, 1 << max_bits);
+    chpl_warning(msg, 0, 0);
+  }
+  return dflt_bits;
+}
+
+// Set the cache geometry from the environment. This must be done
+// before any cache is created.
+static
+void cache_configure_from_env(void)
+{
+  int64_t pages;
+
+  cachepage_bits = cache_size_env_to_bits("CACHE_PAGE_SIZE",
+                                          CACHEPAGE_DEFAULT_BITS,
+                                          CACHEPAGE_MIN_BITS,
+                                          CACHEPAGE_MAX_BITS,
+                                          1 /* must be even */);
+
+  // lines can't be bigger than pages
+  cacheline_bits = cache_size_env_to_bits("CACHE_LINE_SIZE",
+                                          CACHELINE_DEFAULT_BITS <= cachepage_bits ?
+                                            CACHELINE_DEFAULT_BITS :
+                                            cachepage_bits,
+                                          CACHELINE_MIN_BITS,
+                                          cachepage_bits,
+                                          0);
+
+  pages = chpl_env_rt_get_int("CACHE_PREFETCH_PAGES",
+                              DEFAULT_PAGES_PER_PREFETCH);
+  if( pages < 1 ) pages = 1;
+  if( pages > MAX_PAGES_PER_PREFETCH_LIMIT ) pages = MAX_PAGES_PER_PREFETCH_LIMIT;
+  max_pages_per_prefetch = (int) pages;
+
+  cache_adaptive = chpl_env_rt_get_bool("CACHE_ADAPTIVE", false);
+
+  cache_stream_prefetch = chpl_env_rt_get_bool("CACHE_STREAM_PREFETCH", false);
+}
+
 // The implementation of functions in chpl-cache.h
 
 void chpl_cache_init(void) {
@@ -3619,6 +3778,8 @@ void chpl_cache_init(void) {
     return;
   }
 
+  cache_configure_from_env();
+
   //printf("CACHE IS ENABLED\n");
   chpl_cache_do_init();
 }
@@ -3680,6 +3841,226 @@ void chpl_cache_invalidate(c_nodeid_t node, void* raddr, size_t size,
   cache_invalidate(cache, task_local, node, (raddr_t)raddr, size);
 }
 
+// Prefetch start..end-1 for the stream detector, if it is OK to read.
+// Returns 1 if a prefetch was started.
+static
+int cache_stream_prefetch_region(struct rdcache_s* cache,
+                                 chpl_cache_taskPrvData_t* task_local,
+                                 c_nodeid_t node,
+                                 raddr_t start, raddr_t end,
+                                 int ln, int32_t fn)
+{
+  if( start >= end ) return 0;
+
+  // As with readahead, don't read past the end of registered memory
+  // (or into guard pages).
+  if( chpl_task_guardPagesInUse() ||
+      !chpl_comm_addr_gettable(node, (void*) start, end - start) ) {
+    return 0;
+  }
+
+  TRACE_READAHEAD_PRINT(("%d: task %d stream prefetch from %p to %p\n",
+                         chpl_nodeID, (int)chpl_task_getId(),
+                         (void*) start, (void*) end));
+
+  cache->stream_prefetching = 1;
+  cache_get(cache, task_local,
+            /* addr */ NULL /* means prefetch */,
+            node, start, end - start,
+            /* sequential_readahead_length */ 0,
+            CHPL_COMM_UNKNOWN_ID, ln, fn);
+  cache->stream_prefetching = 0;
+  return 1;
+}
+
+// Issue prefetches ahead of a stream that has been seen to repeat its
+// stride, unless enough of the data ahead of it is already on its way.
+// 'stream->prefetched' is the distance past last_raddr that is covered.
+static
+void cache_stream_issue(struct rdcache_s* cache,
+                        chpl_cache_taskPrvData_t* task_local,
+                        chpl_cache_stream_t* stream, size_t size,
+                        int ln, int32_t fn)
+{
+  c_nodeid_t node = stream->node;
+  raddr_t raddr = stream->last_raddr;
+  int32_t stride = stream->stride;
+  int32_t abs_stride = (stride < 0) ? -stride : stride;
+  int32_t ahead;
+  int32_t k;
+
+  if( is_congested(cache) ) return;
+
+  if( abs_stride < CACHEPAGE_SIZE ) {
+    // Nearby elements share pages, so prefetch one contiguous region.
+    ahead = MAX_SEQUENTIAL_READAHEAD_BYTES(cache);
+    // Wait until at least half of the window has been consumed
+    // so that each prefetch covers a useful amount of data.
+    if( stream->prefetched > ahead / 2 ) return;
+
+    if( stride > 0 ) {
+      raddr_t start = raddr + size;
+      if( stream->prefetched > (int32_t) size ) {
+        start = raddr + stream->prefetched;
+      }
+      if( !cache_stream_prefetch_region(cache, task_local, node,
+                                        start, raddr + ahead, ln, fn) )
+        return;
+    } else {
+      if( raddr < (raddr_t) ahead ) return;
+      if( !cache_stream_prefetch_region(cache, task_local, node,
+                                        raddr - ahead,
+                                        raddr - stream->prefetched, ln, fn) )
+        return;
+    }
+    stream->prefetched = ahead;
+  } else {
+    // Each element is on its own page, so prefetch the elements
+    // themselves, up to STREAM_PREFETCH_DEPTH of them ahead.
+    int32_t done = stream->prefetched / abs_stride;
+    if( done > STREAM_PREFETCH_DEPTH / 2 ) return;
+
+    for( k = done + 1; k <= STREAM_PREFETCH_DEPTH; k++ ) {
+      raddr_t start = raddr + (intptr_t) k * stride;
+      if( stride < 0 && raddr < (raddr_t) k * abs_stride ) break;
+      if( !cache_stream_prefetch_region(cache, task_local, node,
+                                        start, start + size, ln, fn) )
+        break;
+      stream->prefetched = k * abs_stride;
+    }
+  }
+}
+
+// The stream detector. Like a hardware stream prefetcher, each task
+// tracks a few streams of GETs. A GET that lands at the expected stride
+// from the end of a stream advances it; once a stride has repeated
+// STREAM_TRAIN_COUNT times, prefetches are issued ahead of the stream
+// in its direction. A GET near a stream that is not yet trained
+// retrains its stride, and any other GET replaces the least recently
+// used stream.
+static
+void cache_stream_observe(struct rdcache_s* cache,
+                          chpl_cache_taskPrvData_t* task_local,
+                          c_nodeid_t node, raddr_t raddr, size_t size,
+                          int ln, int32_t fn)
+{
+  chpl_cache_stream_t* streams = task_local->streams;
+  chpl_cache_stream_t* match = NULL;
+  chpl_cache_stream_t* nearest = NULL;
+  chpl_cache_stream_t* victim = &streams[0];
+  intptr_t nearest_dist = STREAM_MAX_STRIDE + 1;
+  int i;
+
+  task_local->stream_clock++;
+
+  for( i = 0; i < CHPL_CACHE_STREAMS_PER_TASK; i++ ) {
+    chpl_cache_stream_t* s = &streams[i];
+    intptr_t delta, dist;
+
+    if( s->last_raddr == 0 ) {
+      // an unused stream is the best one to replace
+      if( victim->last_raddr != 0 ) victim = s;
+      continue;
+    }
+    if( victim->last_raddr != 0 &&
+        (uint16_t) (task_local->stream_clock - s->lru) >
+        (uint16_t) (task_local->stream_clock - victim->lru) ) {
+      victim = s;
+    }
+
+    if( s->node != node ) continue;
+
+    delta = (intptr_t) (raddr - s->last_raddr);
+    if( delta == 0 ) {
+      // rereading the same element; nothing to learn
+      s->lru = task_local->stream_clock;
+      return;
+    }
+    if( s->stride != 0 && delta == s->stride ) {
+      match = s;
+      break;
+    }
+    dist = (delta < 0) ? -delta : delta;
+    if( dist < nearest_dist ) {
+      nearest_dist = dist;
+      nearest = s;
+    }
+  }
+
+  if( match ) {
+    int32_t abs_stride = (match->stride < 0) ? -match->stride : match->stride;
+    match->last_raddr = raddr;
+    match->lru = task_local->stream_clock;
+    match->prefetched -= abs_stride;
+    if( match->prefetched < 0 ) match->prefetched = 0;
+    if( match->confidence < UINT16_MAX ) match->confidence++;
+    if( match->confidence >= STREAM_TRAIN_COUNT ) {
+      cache_stream_issue(cache, task_local, match, size, ln, fn);
+    }
+    return;
+  }
+
+  if( nearest && nearest->confidence < STREAM_TRAIN_COUNT ) {
+    // learn a new stride for a stream that isn't established yet
+    nearest->stride = (int32_t) (intptr_t) (raddr - nearest->last_raddr);
+    nearest->last_raddr = raddr;
+    nearest->confidence = 1;
+    nearest->prefetched = 0;
+    nearest->lru = task_local->stream_clock;
+    return;
+  }
+
+  // start a new stream
+  victim->last_raddr = raddr;
+  victim->node = node;
+  victim->stride = 0;
+  victim->confidence = 0;
+  victim->prefetched = 0;
+  victim->lru = task_local->stream_clock;
+}
+
+// Adjust the readahead window based on the hits and misses seen by
+// this cache. Every ADAPT_WINDOW_GETS GETs, compare the miss rate to the
+// previous sample: if it got better keep moving the window the same way,
+// and if it got worse turn around. This is a simple hill climb, so it
+// settles near the best window for a phase of the program and follows
+// it when the access pattern changes.
+static inline
+void cache_adapt_readahead(struct rdcache_s* cache, int all_hits)
+{
+  int miss_rate;
+  int n;
+
+  cache->adapt_gets++;
+  if( ! all_hits ) cache->adapt_misses++;
+
+  if( cache->adapt_gets < ADAPT_WINDOW_GETS ) return;
+
+  miss_rate = (int) (((int64_t) cache->adapt_misses * 1024) /
+                     cache->adapt_gets);
+  cache->adapt_gets = 0;
+  cache->adapt_misses = 0;
+
+  if( cache->adapt_last_miss_rate >= 0 &&
+      miss_rate > cache->adapt_last_miss_rate ) {
+    cache->adapt_direction = -cache->adapt_direction;
+  }
+  cache->adapt_last_miss_rate = miss_rate;
+
+  // Grow by doubling and shrink by halving.
+  n = cache->pages_per_prefetch;
+  n = (cache->adapt_direction > 0) ? 2*n : n/2;
+  if( n < 1 ) n = 1;
+  if( n > MAX_PAGES_PER_PREFETCH_LIMIT ) n = MAX_PAGES_PER_PREFETCH_LIMIT;
+
+  TRACE_READAHEAD_PRINT(("%d: cache %p miss rate %d/1024, "
+                         "readahead window %d -> %d pages\n",
+                         chpl_nodeID, cache, miss_rate,
+                         cache->pages_per_prefetch, n));
+
+  cache->pages_per_prefetch = n;
+}
+
 // If a transfer is large enough we should directly initiate it to avoid
 // overheads of going through the cache
 //
@@ -3776,8 +4157,14 @@ void chpl_cache_comm_get(void *addr, c_nodeid_t node, void* raddr,
       chpl_comm_diags_incr(cache_get_hits);
     else
       chpl_comm_diags_incr(cache_get_misses);
+
+    if (cache_adaptive)
+      cache_adapt_readahead(cache, all_hits);
   }
 
+  if (cache_stream_prefetch && size != 0)
+    cache_stream_observe(cache, task_local, node, (raddr_t)raddr, size, ln, fn);
+
   return;
 }
 
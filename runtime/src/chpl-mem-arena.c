@@ -0,0 +1,377 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+//
+// Per-thread arenas for short-lived task allocations.  See the header
+// for the rationale.
+//
+
+#include "chplrt.h"
+
+#include "chpl-atomics.h"
+#include "chpl-env.h"
+#include "chpl-mem.h"
+#include "chpl-mem-arena.h"
+#include "chpl-thread-local-storage.h"
+#include "chpltypes.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+
+struct arena_s;
+
+//
+// Each block starts with a small header recording its size class, so
+// that a free can find the right list, and, while the block is in use,
+// the arena that handed it out, so that a free on another thread can
+// give it back.  The header is padded so the caller's part of the block
+// keeps the memory layer's alignment.
+//
+typedef union arena_block_u {
+  struct {
+    int sizeClass;
+    union {
+      struct arena_s* owner;           // while in use
+      union arena_block_u* next;       // while on a free list
+    } u;
+  } h;
+  max_align_t align;
+} arena_block_t;
+
+#define BLOCK_HDR_SIZE sizeof(arena_block_t)
+
+//
+// Size classes are powers of 2 from 64 bytes (including the header) up
+// to 2 KiB.  Task pool descriptors and argument bundles fall well inside
+// this range.  Anything larger is handed straight to the memory layer,
+// marked with the LARGE_CLASS sentinel.
+//
+#define MIN_CLASS_SHIFT 6
+#define NUM_CLASSES     6
+#define LARGE_CLASS     NUM_CLASSES
+
+static inline
+size_t class_size(int c) {
+  return ((size_t) 1) << (MIN_CLASS_SHIFT + c);
+}
+
+static inline
+int size_class(size_t size) {
+  for (int c = 0; c < NUM_CLASSES; c++) {
+    if (size <= class_size(c))
+      return c;
+  }
+  return LARGE_CLASS;
+}
+
+//
+// A thread keeps up to retainMax blocks on each list, and frees past
+// that go straight back to the memory layer.  Once a list is longer
+// than retainTarget the thread marks itself over the limit, and at the
+// end of the next task it runs it trims each list back down to
+// retainTarget in one batch.
+//
+// Blocks are often freed by a different thread than the one that
+// allocated them (in fifo tasking, the spawner allocates a task's
+// descriptor and the worker that ran it frees it).  Such a remote free
+// pushes the block onto a lock-free list in the owning arena, which the
+// owner takes over whole when its own list for that size runs dry.
+// Each remote list is also limited to retainMax blocks; past that,
+// remote frees go straight back to the memory layer.
+//
+static int retainMax = 256;
+static int retainTarget = 64;
+
+typedef struct arena_s {
+  // used only by the owning thread
+  arena_block_t* free[NUM_CLASSES];
+  int count[NUM_CLASSES];
+  chpl_bool overLimit;
+  chpl_mem_arena_stats_t stats;
+  // pushed onto by other threads, taken over by the owner
+  atomic_uintptr_t remote[NUM_CLASSES];        // (arena_block_t*)
+  atomic_int_least64_t remoteCount[NUM_CLASSES];
+  // protected by arenaList_lock
+  struct arena_s* next;
+  struct arena_s* prev;
+} arena_t;
+
+static chpl_bool arenaEnabled = false;
+
+static CHPL_TLS_DECL(arena_t*, threadArena);
+
+//
+// All arenas in use are on a list so their stats can be gathered.
+// Blocks from an arena may still be in use after its thread exits, so
+// arenas are never freed.  Instead, an exiting thread puts its arena on
+// the idle list, and the next thread that needs an arena adopts it.
+// The lock is only taken when a thread acquires or releases an arena,
+// and when stats are gathered, never on the allocation paths.
+//
+static pthread_mutex_t arenaList_lock = PTHREAD_MUTEX_INITIALIZER;
+static arena_t* arenaList = NULL;
+static arena_t* idleArenaList = NULL;
+
+
+void chpl_mem_arena_init(void) {
+  arenaEnabled = chpl_env_rt_get_bool("MEM_TASK_ARENA", true);
+
+  int max = (int) chpl_env_rt_get_int("MEM_TASK_ARENA_RETAIN", retainMax);
+  if (max >= 0) {
+    retainMax = max;
+    retainTarget = max / 4;
+  }
+
+  CHPL_TLS_INIT(threadArena);
+}
+
+
+static
+arena_t* get_arena(void) {
+  arena_t* a = (arena_t*) CHPL_TLS_GET(threadArena);
+  if (a == NULL) {
+    (void) pthread_mutex_lock(&arenaList_lock);
+    if ((a = idleArenaList) != NULL) {
+      idleArenaList = a->next;
+    } else if ((a = (arena_t*) chpl_calloc(1, sizeof(*a))) != NULL) {
+      for (int c = 0; c < NUM_CLASSES; c++) {
+        atomic_init_uintptr_t(&a->remote[c], (uintptr_t) NULL);
+        atomic_init_int_least64_t(&a->remoteCount[c], 0);
+      }
+    }
+    if (a != NULL) {
+      a->prev = NULL;
+      a->next = arenaList;
+      if (arenaList != NULL)
+        arenaList->prev = a;
+      arenaList = a;
+    }
+    (void) pthread_mutex_unlock(&arenaList_lock);
+    if (a == NULL)
+      return NULL;
+    CHPL_TLS_SET(threadArena, a);
+  }
+  return a;
+}
+
+
+//
+// Move the blocks other threads have given back to us onto our own
+// list for size class c.
+//
+static
+void take_remote_frees(arena_t* a, int c) {
+  arena_block_t* b;
+  int64_t n = 0;
+
+  b = (arena_block_t*) atomic_exchange_uintptr_t(&a->remote[c],
+                                                 (uintptr_t) NULL);
+  while (b != NULL) {
+    arena_block_t* next = b->h.u.next;
+    b->h.u.next = a->free[c];
+    a->free[c] = b;
+    n++;
+    b = next;
+  }
+  if (n > 0) {
+    (void) atomic_fetch_sub_int_least64_t(&a->remoteCount[c], n);
+    a->count[c] += n;
+    a->stats.bytesRetained += n * class_size(c);
+    if (a->count[c] > retainTarget)
+      a->overLimit = true;
+  }
+}
+
+
+void* chpl_mem_arena_alloc(size_t size, chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename) {
+  chpl_memhook_malloc_pre(1, size, description, lineno, filename);
+
+  arena_block_t* b = NULL;
+  int c = arenaEnabled ? size_class(BLOCK_HDR_SIZE + size) : LARGE_CLASS;
+  if (c == LARGE_CLASS) {
+    b = (arena_block_t*) chpl_malloc(BLOCK_HDR_SIZE + size);
+  } else {
+    arena_t* a = get_arena();
+    if (a != NULL) {
+      a->stats.allocs++;
+      if (a->free[c] == NULL &&
+          atomic_load_explicit_uintptr_t(&a->remote[c],
+                                         memory_order_relaxed) != 0)
+        take_remote_frees(a, c);
+      if ((b = a->free[c]) != NULL) {
+        a->free[c] = b->h.u.next;
+        a->count[c]--;
+        a->stats.hits++;
+        a->stats.bytesRetained -= class_size(c);
+      }
+    }
+    if (b == NULL)
+      b = (arena_block_t*) chpl_malloc(class_size(c));
+    if (b != NULL)
+      b->h.u.owner = a;
+  }
+
+  void* p = NULL;
+  if (b != NULL) {
+    b->h.sizeClass = c;
+    p = (char*) b + BLOCK_HDR_SIZE;
+  }
+
+  chpl_memhook_malloc_post(p, 1, size, description, lineno, filename);
+  return p;
+}
+
+
+void chpl_mem_arena_free(void* p, int32_t lineno, int32_t filename) {
+  chpl_memhook_free_pre(p, lineno, filename);
+
+  arena_block_t* b = (arena_block_t*) ((char*) p - BLOCK_HDR_SIZE);
+  const int c = b->h.sizeClass;
+  arena_t* o;
+  arena_t* a;
+  if (c == LARGE_CLASS || (o = b->h.u.owner) == NULL) {
+    chpl_free(b);
+    return;
+  }
+
+  a = get_arena();
+  if (a == o) {
+    a->stats.frees++;
+    if (a->count[c] >= retainMax) {
+      a->stats.bulkReturns++;
+      chpl_free(b);
+      return;
+    }
+    b->h.u.next = a->free[c];
+    a->free[c] = b;
+    a->stats.bytesRetained += class_size(c);
+    if (++a->count[c] > retainTarget)
+      a->overLimit = true;
+    return;
+  }
+
+  //
+  // Give the block back to the arena it came from, unless that arena
+  // already has plenty waiting for it.
+  //
+  if (a != NULL) {
+    a->stats.frees++;
+    a->stats.remoteFrees++;
+  }
+  if (atomic_fetch_add_int_least64_t(&o->remoteCount[c], 1) >= retainMax) {
+    (void) atomic_fetch_sub_int_least64_t(&o->remoteCount[c], 1);
+    if (a != NULL)
+      a->stats.bulkReturns++;
+    chpl_free(b);
+    return;
+  }
+  uintptr_t head = atomic_load_explicit_uintptr_t(&o->remote[c],
+                                                  memory_order_relaxed);
+  do {
+    b->h.u.next = (arena_block_t*) head;
+  } while (!atomic_compare_exchange_weak_explicit_uintptr_t(
+              &o->remote[c], &head, (uintptr_t) b,
+              memory_order_release, memory_order_relaxed));
+}
+
+
+static
+void trim_arena(arena_t* a, int target) {
+  for (int c = 0; c < NUM_CLASSES; c++) {
+    while (a->count[c] > target) {
+      arena_block_t* b = a->free[c];
+      a->free[c] = b->h.u.next;
+      a->count[c]--;
+      a->stats.bulkReturns++;
+      a->stats.bytesRetained -= class_size(c);
+      chpl_free(b);
+    }
+  }
+  a->overLimit = false;
+}
+
+
+void chpl_mem_arena_task_end(void) {
+  arena_t* a = (arena_t*) CHPL_TLS_GET(threadArena);
+  if (a != NULL && a->overLimit)
+    trim_arena(a, retainTarget);
+}
+
+
+void chpl_mem_arena_thread_exit(void) {
+  arena_t* a = (arena_t*) CHPL_TLS_GET(threadArena);
+  if (a == NULL)
+    return;
+
+  for (int c = 0; c < NUM_CLASSES; c++)
+    take_remote_frees(a, c);
+  trim_arena(a, 0);
+
+  //
+  // Other threads may still free blocks that came from this arena, so
+  // keep it (and its stats) around for the next thread that needs one.
+  //
+  (void) pthread_mutex_lock(&arenaList_lock);
+  if (a->prev != NULL)
+    a->prev->next = a->next;
+  else
+    arenaList = a->next;
+  if (a->next != NULL)
+    a->next->prev = a->prev;
+  a->prev = NULL;
+  a->next = idleArenaList;
+  idleArenaList = a;
+  (void) pthread_mutex_unlock(&arenaList_lock);
+
+  CHPL_TLS_SET(threadArena, NULL);
+}
+
+
+static
+void add_arena_stats(chpl_mem_arena_stats_t* stats, arena_t* a) {
+  stats->allocs += a->stats.allocs;
+  stats->hits += a->stats.hits;
+  stats->frees += a->stats.frees;
+  stats->remoteFrees += a->stats.remoteFrees;
+  stats->bulkReturns += a->stats.bulkReturns;
+  stats->bytesRetained += a->stats.bytesRetained;
+  for (int c = 0; c < NUM_CLASSES; c++) {
+    stats->bytesRetained +=
+      atomic_load_int_least64_t(&a->remoteCount[c]) * class_size(c);
+  }
+}
+
+
+void chpl_mem_arena_getStats(chpl_mem_arena_stats_t* stats) {
+  //
+  // Other threads' counters may be changing while we read them, so
+  // these are only a snapshot, but that is all a report needs.
+  //
+  memset(stats, 0, sizeof(*stats));
+  (void) pthread_mutex_lock(&arenaList_lock);
+  for (arena_t* a = arenaList; a != NULL; a = a->next)
+    add_arena_stats(stats, a);
+  for (arena_t* a = idleArenaList; a != NULL; a = a->next)
+    add_arena_stats(stats, a);
+  (void) pthread_mutex_unlock(&arenaList_lock);
+}
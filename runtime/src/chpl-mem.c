@@ -24,6 +24,7 @@
 #include "chplrt.h"
 
 #include "chpl-mem.h"
+#include "chpl-mem-arena.h"
 #include "chpltypes.h"
 #include "error.h"
 #include "chplsys.h"
@@ -33,6 +34,7 @@ static int heapInitialized = 0;
 
 void chpl_mem_init(void) {
   chpl_mem_layerInit();
+  chpl_mem_arena_init();
   heapInitialized = 1;
 }
 
@@ -22,12 +22,14 @@
 
 #include "chplmemtrack.h"
 #include "chpl-mem.h"
+#include "chpl-mem-arena.h"
 #include "chpl-mem-desc.h"
 #include "chpl-mem-sys.h"  // mem layer not initialized yet, need system alloc
 #include "chpl-tasks.h"
 #include "chpltypes.h"
 #include "chpl-comm.h"
 #include "chpl-comm-internal.h"
+#include "chpl-env.h"
 #include "chplcgfns.h"
 #include "chpl-linefile-support.h"
 #include "config.h"
@@ -72,6 +74,7 @@ typedef struct memTableEntry_struct { /* table entry */
   void* memAlloc;
   int32_t lineno;
   int32_t filename;
+  size_t weight;       /* number of allocations this entry stands for */
   struct memTableEntry_struct* nextInBucket;
 } memTableEntry;
 
@@ -81,10 +84,42 @@ static int hashSizes[NUM_HASH_SIZE_INDICES] = { 1543, 3079, 6151, 12289, 24593,
                                                 196613, 393241, 786433, 1572869, 3145739,
                                                 6291469, 12582917, 25165843, 50331653,
                                                 100663319, 201326611, 402653189, 805306457 };
-static int hashSizeIndex = 0;
-static int hashSize = 0;
 
-static memTableEntry** memTable = NULL;
+//
+// The table is split into shards selected by address, each with its
+// own lock and its own chained hash table that grows and shrinks
+// independently.  An allocation and its free always land in the same
+// shard no matter which threads do them, and concurrent tasks rarely
+// contend for the same shard.  The reporting functions merge the
+// shards.
+//
+#define NUM_MEM_TABLE_SHARDS 64
+
+typedef struct {
+  pthread_mutex_t lock;
+  memTableEntry** table;
+  int hashSizeIndex;
+  int hashSize;
+  size_t entries;        /* number of entries in this shard */
+  size_t unsampled;      /* entries tracked only because of their size */
+  size_t allocated;      /* total memory allocated, this shard */
+  size_t freed;          /* total memory freed, this shard */
+} memTableShard;
+
+static memTableShard memTable[NUM_MEM_TABLE_SHARDS];
+
+//
+// In sampling mode (CHPL_RT_MEMTRACK_SAMPLE=N, N > 1) only about 1 in N
+// of the allocations smaller than memSampleCutoff are tracked, chosen
+// by a hash of their address so that a free can tell whether its
+// allocation was tracked without looking.  Each of those entries
+// stands for N allocations in the totals.  Allocations at or above the
+// cutoff are always tracked, so a few large ones cannot skew the
+// estimate.  A free whose address was not sampled only has to look in
+// its shard if that shard holds any of these unsampled entries.
+//
+static uint64_t memSample = 1;
+static size_t memSampleCutoff = 0;
 
 static _Bool memStats = false;
 static _Bool memLeaksByType = false;
@@ -96,11 +131,13 @@ static c_string memLog = NULL;
 static FILE* memLogFile = NULL;
 static c_string memLeaksLog = NULL;
 
+//
+// These are updated with atomic builtins rather than under a lock, so
+// that they do not serialize the shards.  See below for why we do not
+// use the runtime atomics here.
+//
 static size_t totalMem = 0;       /* total memory currently allocated */
 static size_t maxMem = 0;         /* maximum total memory during run  */
-static size_t totalAllocated = 0; /* total memory allocated */
-static size_t totalFreed = 0;     /* total memory freed */
-static size_t totalEntries = 0;     /* number of entries in hash table */
 
 
 // We can't use a sync var for concurrency control here.  The Qthreads
@@ -110,25 +147,23 @@ static size_t totalEntries = 0;     /* number of entries in hash table */
 // the tasking layer is shut down, ends up trying to create a qthread in
 // the terminated Qthreads library.  Chaos results.  We also cannot use
 // an atomic var, because with CHPL_ATOMICS=locks those are implemented
-// by means of sync vars.  So, we use a pthread mutex.  Note that this
-// is only safe if we cannot switch tasks on a pthread while holding the
+// by means of sync vars.  So, we use pthread mutexes for the shards and
+// compiler atomic builtins for the global totals.  Note that this is
+// only safe if we cannot switch tasks on a pthread while holding a
 // mutex and then try to lock it recursively.  Currently that is the
-// case, since we do not yield while holding the mutex.
-// 
-static pthread_mutex_t memTrack_lockVar = PTHREAD_MUTEX_INITIALIZER;
-
+// case, since we do not yield while holding the mutexes.
+//
 static inline
-void memTrack_lock(void) {
-  (void) pthread_mutex_lock(&memTrack_lockVar);
+void memTable_lock(memTableShard* sh) {
+  (void) pthread_mutex_lock(&sh->lock);
 }
 
 static inline
-void memTrack_unlock(void) {
-  (void) pthread_mutex_unlock(&memTrack_lockVar);
+void memTable_unlock(memTableShard* sh) {
+  (void) pthread_mutex_unlock(&sh->lock);
 }
 
 
-
 void chpl_setMemFlags(void) {
   chpl_bool local_memTrack = false;
 
@@ -180,77 +215,141 @@ void chpl_setMemFlags(void) {
   }
 
   if (chpl_memTrack) {
-    hashSizeIndex = 0;
-    hashSize = hashSizes[hashSizeIndex];
-    memTable = sys_calloc(hashSize, sizeof(memTableEntry*));
+    int64_t sample = chpl_env_rt_get_int("MEMTRACK_SAMPLE", 1);
+    memSample = (sample > 1) ? (uint64_t) sample : 1;
+    memSampleCutoff = chpl_env_rt_get_size("MEMTRACK_SAMPLE_CUTOFF",
+                                           64 * 1024);
+
+    //
+    // The memory limit has to be checked against the real total, not
+    // an estimate, so it turns sampling off.
+    //
+    if (memSample > 1 && memMax > 0) {
+      if (chpl_nodeID == 0)
+        chpl_warning("CHPL_RT_MEMTRACK_SAMPLE is ignored with --memMax",
+                     0, 0);
+      memSample = 1;
+    }
+
+    for (int i = 0; i < NUM_MEM_TABLE_SHARDS; i++) {
+      memTableShard* sh = &memTable[i];
+      (void) pthread_mutex_init(&sh->lock, NULL);
+      sh->hashSizeIndex = 0;
+      sh->hashSize = hashSizes[sh->hashSizeIndex];
+      sh->table = sys_calloc(sh->hashSize, sizeof(memTableEntry*));
+    }
   }
 }
 
 
-static unsigned hash(void* memAlloc, int hashSize) {
-  unsigned hashValue = 0;
-  char* fakeCharPtr = (char*)&memAlloc;
-  size_t i;
-  for (i = 0; i < sizeof(void*); i++) {
-    hashValue = *fakeCharPtr + 31 * hashValue;
-    fakeCharPtr++;
-  }
-  return hashValue % hashSize;
+//
+// Mix the address bits, so that the shard, the sampling decision, and
+// the bucket can each be taken from a different part of the result.
+//
+static inline uint64_t hash(void* memAlloc) {
+  uint64_t h = (uint64_t) (uintptr_t) memAlloc;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
 }
 
+static inline memTableShard* hashShard(uint64_t h) {
+  return &memTable[h % NUM_MEM_TABLE_SHARDS];
+}
 
-static void increaseMemStat(size_t chunk, int32_t lineno, int32_t filename) {
-  totalMem += chunk;
-  totalAllocated += chunk;
-  if (memMax && (totalMem > memMax)) {
+static inline _Bool hashSampled(uint64_t h) {
+  return memSample == 1
+         || ((h / NUM_MEM_TABLE_SHARDS) & 0xffffffff) % memSample == 0;
+}
+
+static inline _Bool trackedAlloc(uint64_t h, size_t chunk) {
+  return chunk >= memSampleCutoff || hashSampled(h);
+}
+
+//
+// Does a free or realloc of an address with this hash need to look in
+// the table?  Reading the unsampled count without the lock is fine:
+// the allocation being freed happened before the free, so its entry
+// has been counted by then.
+//
+static inline _Bool mayBeTracked(memTableShard* sh, uint64_t h) {
+  return hashSampled(h)
+         || __atomic_load_n(&sh->unsampled, __ATOMIC_RELAXED) > 0;
+}
+
+static inline unsigned hashBucket(uint64_t h, int hashSize) {
+  return (h >> 32) % hashSize;
+}
+
+
+static void increaseMemStat(memTableShard* sh, size_t chunk,
+                            int32_t lineno, int32_t filename) {
+  size_t newTotal;
+  size_t oldMax;
+
+  sh->allocated += chunk;
+  newTotal = __atomic_add_fetch(&totalMem, chunk, __ATOMIC_RELAXED);
+  if (memMax && newTotal > memMax) {
     chpl_error("Exceeded memory limit", lineno, filename);
   }
-  if (totalMem > maxMem)
-    maxMem = totalMem;
+  oldMax = __atomic_load_n(&maxMem, __ATOMIC_RELAXED);
+  while (newTotal > oldMax
+         && !__atomic_compare_exchange_n(&maxMem, &oldMax, newTotal, true,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
 }
 
 
-static void decreaseMemStat(size_t chunk) {
-  totalMem -= chunk; // > totalMem ? 0 : totalMem - chunk;
-  totalFreed += chunk;
+static void decreaseMemStat(memTableShard* sh, size_t chunk) {
+  sh->freed += chunk;
+  (void) __atomic_sub_fetch(&totalMem, chunk, __ATOMIC_RELAXED);
 }
 
 
 static void
-resizeTable(int direction) {
+resizeTable(memTableShard* sh, int direction) {
   memTableEntry** newMemTable = NULL;
   int newHashSizeIndex, newHashSize, newHashValue;
   int i;
   memTableEntry* me;
   memTableEntry* next;
 
-  newHashSizeIndex = hashSizeIndex + direction;
+  newHashSizeIndex = sh->hashSizeIndex + direction;
   newHashSize = hashSizes[newHashSizeIndex];
   newMemTable = sys_calloc(newHashSize, sizeof(memTableEntry*));
+  if (!newMemTable) {
+    // Just keep using the table we have.
+    return;
+  }
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = next) {
+  for (i = 0; i < sh->hashSize; i++) {
+    for (me = sh->table[i]; me != NULL; me = next) {
       next = me->nextInBucket;
-      newHashValue = hash(me->memAlloc, newHashSize);
+      newHashValue = hashBucket(hash(me->memAlloc), newHashSize);
       me->nextInBucket = newMemTable[newHashValue];
       newMemTable[newHashValue] = me;
     }
   }
 
-  sys_free(memTable);
-  memTable = newMemTable;
-  hashSize = newHashSize;
-  hashSizeIndex = newHashSizeIndex;
+  sys_free(sh->table);
+  sh->table = newMemTable;
+  sh->hashSize = newHashSize;
+  sh->hashSizeIndex = newHashSizeIndex;
 }
 
-static void addMemTableEntry(void *memAlloc, size_t number, size_t size,
+static void addMemTableEntry(memTableShard* sh, uint64_t h,
+                             void *memAlloc, size_t number, size_t size,
                              chpl_mem_descInt_t description, int32_t lineno,
                              int32_t filename) {
   unsigned hashValue;
   memTableEntry* memEntry;
 
-  if ((totalEntries+1)*2 > hashSize && hashSizeIndex < NUM_HASH_SIZE_INDICES-1)
-    resizeTable(1);
+  if ((sh->entries+1)*2 > sh->hashSize
+      && sh->hashSizeIndex < NUM_HASH_SIZE_INDICES-1)
+    resizeTable(sh, 1);
 
   memEntry = (memTableEntry*) sys_calloc(1, sizeof(memTableEntry));
   if (!memEntry) {
@@ -258,33 +357,37 @@ static void addMemTableEntry(void *memAlloc, size_t number, size_t size,
                lineno, filename);
   }
 
-  hashValue = hash(memAlloc, hashSize);
-  memEntry->nextInBucket = memTable[hashValue];
-  memTable[hashValue] = memEntry;
+  hashValue = hashBucket(h, sh->hashSize);
+  memEntry->nextInBucket = sh->table[hashValue];
+  sh->table[hashValue] = memEntry;
   memEntry->description = description;
   memEntry->memAlloc = memAlloc;
   memEntry->lineno = lineno;
   memEntry->filename = filename;
   memEntry->number = number;
   memEntry->size = size;
-  increaseMemStat(number*size, lineno, filename);
-  totalEntries += 1;
+  memEntry->weight = hashSampled(h) ? memSample : 1;
+  increaseMemStat(sh, number*size*memEntry->weight, lineno, filename);
+  sh->entries += 1;
+  if (!hashSampled(h))
+    __atomic_add_fetch(&sh->unsampled, 1, __ATOMIC_RELAXED);
 }
 
 
-static memTableEntry* removeMemTableEntry(void* address) {
-  unsigned hashValue = hash(address, hashSize);
-  memTableEntry* thisBucketEntry = memTable[hashValue];
+static memTableEntry* removeMemTableEntry(memTableShard* sh, uint64_t h,
+                                          void* address) {
+  unsigned hashValue = hashBucket(h, sh->hashSize);
+  memTableEntry* thisBucketEntry = sh->table[hashValue];
   memTableEntry* deletedBucket = NULL;
 
   if (!thisBucketEntry)
     return NULL;
 
   if (thisBucketEntry->memAlloc == address) {
-    memTable[hashValue] = thisBucketEntry->nextInBucket;
+    sh->table[hashValue] = thisBucketEntry->nextInBucket;
     deletedBucket = thisBucketEntry;
   } else {
-    for (thisBucketEntry = memTable[hashValue];
+    for (thisBucketEntry = sh->table[hashValue];
          thisBucketEntry != NULL;
          thisBucketEntry = thisBucketEntry->nextInBucket) {
 
@@ -297,15 +400,31 @@ static memTableEntry* removeMemTableEntry(void* address) {
     }
   }
   if (deletedBucket) {
-    decreaseMemStat(deletedBucket->number * deletedBucket->size);
-    totalEntries -= 1;
-    if (totalEntries*8 < hashSize && hashSizeIndex > 0)
-      resizeTable(-1);
+    decreaseMemStat(sh, deletedBucket->number * deletedBucket->size
+                        * deletedBucket->weight);
+    sh->entries -= 1;
+    if (!hashSampled(h))
+      __atomic_sub_fetch(&sh->unsampled, 1, __ATOMIC_RELAXED);
+    if (sh->entries*8 < sh->hashSize && sh->hashSizeIndex > 0)
+      resizeTable(sh, -1);
   }
   return deletedBucket;
 }
 
 
+static inline
+void memTable_lockAll(void) {
+  for (int i = 0; i < NUM_MEM_TABLE_SHARDS; i++)
+    (void) pthread_mutex_lock(&memTable[i].lock);
+}
+
+static inline
+void memTable_unlockAll(void) {
+  for (int i = NUM_MEM_TABLE_SHARDS - 1; i >= 0; i--)
+    (void) pthread_mutex_unlock(&memTable[i].lock);
+}
+
+
 uint64_t chpl_memoryUsed(int32_t lineno, int32_t filename) {
   if (!chpl_memTrack) {
     chpl_warning("invalid call to memoryUsed(); rerun with --memTrack",
@@ -313,7 +432,7 @@ uint64_t chpl_memoryUsed(int32_t lineno, int32_t filename) {
     return 0;
   }
 
-  return (uint64_t)totalMem;
+  return (uint64_t)__atomic_load_n(&totalMem, __ATOMIC_RELAXED);
 }
 
 
@@ -344,18 +463,34 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
              nodeWidth, chpl_nodeID);
   }
 
+  //
+  // Merge the shards' figures.  When sampling, these are already
+  // weighted to estimate the real ones.
+  //
+  size_t totalAllocated = 0;
+  size_t totalFreed = 0;
+
+  memTable_lockAll();
+  for (int i = 0; i < NUM_MEM_TABLE_SHARDS; i++) {
+    totalAllocated += memTable[i].allocated;
+    totalFreed += memTable[i].freed;
+  }
+  size_t nowMem = __atomic_load_n(&totalMem, __ATOMIC_RELAXED);
+  size_t highMem = __atomic_load_n(&maxMem, __ATOMIC_RELAXED);
+  memTable_unlockAll();
+
   //
   // Take a pre-run through the descriptions and values to figure
   // out how long each line will need to be.
   //
-  static const struct {
+  const struct {
     const char* desc;
-    size_t* val;
+    size_t val;
   } descsVals[] = {
-    { "Allocated Now:", &totalMem },
-    { "Allocation High Water Mark:", &maxMem },
-    { "Sum of Allocations:", &totalAllocated },
-    { "Sum of Frees:", &totalFreed },
+    { "Allocated Now:", nowMem },
+    { "Allocation High Water Mark:", highMem },
+    { "Sum of Allocations:", totalAllocated },
+    { "Sum of Frees:", totalFreed },
   };
   const int nDescsVals = sizeof(descsVals) / sizeof(descsVals[0]);
 
@@ -367,9 +502,9 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
     if (thisDescWidth > descWidth)
       descWidth = thisDescWidth;
     const int thisMemWidth =
-                (*descsVals[i].val == 0)
+                (descsVals[i].val == 0)
                 ? 1
-                : (int) lrint(ceil(log10((double) *descsVals[i].val)));
+                : (int) lrint(ceil(log10((double) descsVals[i].val)));
     if (thisMemWidth > memWidth)
       memWidth = thisMemWidth;
   }
@@ -381,20 +516,22 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
   char buf[4 * (strlen(prefixBuf) + 1 + descWidth + 1 + memWidth + 1) + 1];
   size_t len;
 
-  memTrack_lock();
-
   len = 0;
   for (int i = 0; i < nDescsVals; i++) {
     len += snprintf(buf + len, sizeof(buf) - len,
                     "%s %-*s %*zd\n",
                     prefixBuf,
                     descWidth, descsVals[i].desc,
-                    memWidth, *descsVals[i].val);
+                    memWidth, descsVals[i].val);
   }
 
-  memTrack_unlock();
-
   fputs(buf, memLogFile);
+  if (memSample > 1) {
+    fprintf(memLogFile,
+            "%s (estimated from tracking 1 in %" PRIu64 " allocations"
+            " under %zu bytes)\n",
+            prefixBuf, memSample, memSampleCutoff);
+  }
 }
 
 
@@ -421,12 +558,16 @@ static void printMemAllocsByType(_Bool forLeaks,
 
   table = (size_t*)sys_calloc(numEntries, 3*sizeof(size_t));
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = me->nextInBucket) {
-      table[3*me->description] += me->number*me->size;
-      table[3*me->description+1] += 1;
-      table[3*me->description+2] = me->description;
+  for (int sh = 0; sh < NUM_MEM_TABLE_SHARDS; sh++) {
+    memTable_lock(&memTable[sh]);
+    for (i = 0; i < memTable[sh].hashSize; i++) {
+      for (me = memTable[sh].table[i]; me != NULL; me = me->nextInBucket) {
+        table[3*me->description] += me->number*me->size * me->weight;
+        table[3*me->description+1] += me->weight;
+        table[3*me->description+2] = me->description;
+      }
     }
+    memTable_unlock(&memTable[sh]);
   }
 
   qsort(table, numEntries, 3*sizeof(size_t), memTableEntryCmp);
@@ -537,21 +678,30 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
     return;
   }
 
+  //
+  // The entries are listed individually, so hold all the shards for
+  // the duration to keep them from being freed out from under us.
+  //
+  memTable_lockAll();
+
   n = 0;
   filenameWidth = strlen("Allocated Memory (Bytes)");
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk < threshold)
-        continue;
-      if (description != -1 && memEntry->description != description)
-        continue;
-      n += 1;
-      if (memEntry->filename) {
-        memEntryFilename = chpl_lookupFilename(memEntry->filename);
-        filenameLength = strlen(memEntryFilename);
-        if (filenameLength > filenameWidth)
-          filenameWidth = filenameLength;
+  for (int sh = 0; sh < NUM_MEM_TABLE_SHARDS; sh++) {
+    for (i = 0; i < memTable[sh].hashSize; i++) {
+      for (memEntry = memTable[sh].table[i]; memEntry != NULL;
+           memEntry = memEntry->nextInBucket) {
+        size_t chunk = memEntry->number * memEntry->size;
+        if (chunk < threshold)
+          continue;
+        if (description != -1 && memEntry->description != description)
+          continue;
+        n += 1;
+        if (memEntry->filename) {
+          memEntryFilename = chpl_lookupFilename(memEntry->filename);
+          filenameLength = strlen(memEntryFilename);
+          if (filenameLength > filenameWidth)
+            filenameWidth = filenameLength;
+        }
       }
     }
   }
@@ -580,18 +730,23 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
   fprintf(memLogFile, "\n");
 
   table = (memTableEntry**)sys_malloc(n*sizeof(memTableEntry*));
-  if (!table)
+  if (!table) {
+    memTable_unlockAll();
     chpl_error("out of memory printing memory table", lineno, filename);
+  }
 
   n = 0;
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk < threshold)
-        continue;
-      if (description != -1 && memEntry->description != description)
-        continue;
-      table[n++] = memEntry;
+  for (int sh = 0; sh < NUM_MEM_TABLE_SHARDS; sh++) {
+    for (i = 0; i < memTable[sh].hashSize; i++) {
+      for (memEntry = memTable[sh].table[i]; memEntry != NULL;
+           memEntry = memEntry->nextInBucket) {
+        size_t chunk = memEntry->number * memEntry->size;
+        if (chunk < threshold)
+          continue;
+        if (description != -1 && memEntry->description != description)
+          continue;
+        table[n++] = memEntry;
+      }
     }
   }
   qsort(table, n, sizeof(memTableEntry*), descCmp);
@@ -619,15 +774,48 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
   fprintf(memLogFile, "\n");
   putchar('\n');
 
+  memTable_unlockAll();
+
   sys_free(table);
   sys_free(loc);
 }
 
 
+//
+// Report how the per-thread task arenas did.  Blocks in use are already
+// counted in the regular stats; these describe the recycling.  Nothing
+// is printed if the arenas were never used.
+//
+static void printMemArenaStats(void) {
+  chpl_mem_arena_stats_t st;
+  chpl_mem_arena_getStats(&st);
+  if (st.allocs == 0)
+    return;
+
+  const char* prefix = (chpl_numNodes == 1) ? "memStats:" : "memStats: node";
+  const int node = (chpl_numNodes == 1) ? -1 : chpl_nodeID;
+  char nodeBuf[16] = "";
+  if (node >= 0)
+    snprintf(nodeBuf, sizeof(nodeBuf), " %d", node);
+
+  fprintf(memLogFile, "%s%s Task Arena Allocations:  %" PRIu64 "\n",
+          prefix, nodeBuf, st.allocs);
+  fprintf(memLogFile, "%s%s Task Arena Reuses:       %" PRIu64 "\n",
+          prefix, nodeBuf, st.hits);
+  fprintf(memLogFile, "%s%s Task Arena Remote Frees: %" PRIu64 "\n",
+          prefix, nodeBuf, st.remoteFrees);
+  fprintf(memLogFile, "%s%s Task Arena Bulk Frees:   %" PRIu64 "\n",
+          prefix, nodeBuf, st.bulkReturns);
+  fprintf(memLogFile, "%s%s Task Arena Retained:     %" PRIu64 "\n",
+          prefix, nodeBuf, st.bytesRetained);
+}
+
+
 void chpl_reportMemInfo() {
   if (memStats) {
     fprintf(memLogFile, "\n");
     chpl_printMemAllocStats(0, 0);
+    printMemArenaStats();
   }
   if (memLeaksByType) {
     if (totalMem) {
@@ -666,9 +854,14 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
                        int32_t lineno, int32_t filename) {
   if (number * size > memThreshold) {
     if (chpl_memTrack && chpl_mem_descTrack(description)) {
-      memTrack_lock();
-      addMemTableEntry(memAlloc, number, size, description, lineno, filename);
-      memTrack_unlock();
+      const uint64_t h = hash(memAlloc);
+      if (trackedAlloc(h, number * size)) {
+        memTableShard* sh = hashShard(h);
+        memTable_lock(sh);
+        addMemTableEntry(sh, h, memAlloc, number, size, description,
+                         lineno, filename);
+        memTable_unlock(sh);
+      }
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
@@ -684,20 +877,31 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
 void chpl_track_free(void* memAlloc, int32_t lineno, int32_t filename) {
   memTableEntry* memEntry = NULL;
   if (chpl_memTrack) {
-    memTrack_lock();
-    memEntry = removeMemTableEntry(memAlloc);
-    if (memEntry) {
-      if (chpl_verbose_mem) {
-        fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
-                            ": free %zuB of %s at %p\n",
-                chpl_nodeID, (filename ? chpl_lookupFilename(filename) : "--"),
-                lineno, memEntry->number * memEntry->size,
-                chpl_mem_descString(memEntry->description), memAlloc);
+    const uint64_t h = hash(memAlloc);
+    memTableShard* sh = hashShard(h);
+    if (mayBeTracked(sh, h)) {
+      memTable_lock(sh);
+      memEntry = removeMemTableEntry(sh, h, memAlloc);
+      if (memEntry) {
+        if (chpl_verbose_mem) {
+          fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
+                              ": free %zuB of %s at %p\n",
+                  chpl_nodeID,
+                  (filename ? chpl_lookupFilename(filename) : "--"),
+                  lineno, memEntry->number * memEntry->size,
+                  chpl_mem_descString(memEntry->description), memAlloc);
+        }
+        sys_free(memEntry);
       }
-      sys_free(memEntry);
+      memTable_unlock(sh);
     }
-    memTrack_unlock();
-  } else if (chpl_verbose_mem && !memEntry) {
+  }
+
+  //
+  // Without tracking, or when sampling left this allocation out of the
+  // table, all we know is the address.
+  //
+  if (chpl_verbose_mem && !memEntry && (!chpl_memTrack || memSample > 1)) {
     fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32 ": free at %p\n",
             chpl_nodeID, (filename ? chpl_lookupFilename(filename) : "--"),
             lineno, memAlloc);
@@ -710,14 +914,16 @@ void chpl_track_realloc_pre(void* memAlloc, size_t size,
                          int32_t lineno, int32_t filename) {
   memTableEntry* memEntry = NULL;
 
-  if (chpl_memTrack && size > memThreshold) {
-    memTrack_lock();
-    if (memAlloc) {
-      memEntry = removeMemTableEntry(memAlloc);
+  if (chpl_memTrack && size > memThreshold && memAlloc) {
+    const uint64_t h = hash(memAlloc);
+    memTableShard* sh = hashShard(h);
+    if (mayBeTracked(sh, h)) {
+      memTable_lock(sh);
+      memEntry = removeMemTableEntry(sh, h, memAlloc);
       if (memEntry)
         sys_free(memEntry);
+      memTable_unlock(sh);
     }
-    memTrack_unlock();
   }
 }
 
@@ -728,9 +934,14 @@ void chpl_track_realloc_post(void* moreMemAlloc,
                          int32_t lineno, int32_t filename) {
   if (size > memThreshold) {
     if (chpl_memTrack && chpl_mem_descTrack(description)) {
-      memTrack_lock();
-      addMemTableEntry(moreMemAlloc, 1, size, description, lineno, filename);
-      memTrack_unlock();
+      const uint64_t h = hash(moreMemAlloc);
+      if (trackedAlloc(h, size)) {
+        memTableShard* sh = hashShard(h);
+        memTable_lock(sh);
+        addMemTableEntry(sh, h, moreMemAlloc, 1, size, description,
+                         lineno, filename);
+        memTable_unlock(sh);
+      }
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
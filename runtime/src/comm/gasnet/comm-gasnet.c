@@ -1423,6 +1423,151 @@ void chpl_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
 
 void chpl_comm_getput_unordered_task_fence(void) { }
 
+//
+// Aggregated GETs and PUTs are started as nonblocking transfers, and
+// their handles are kept in a task-private array until the task
+// flushes or ends, or the array fills up.  PUTs use the non-bulk form
+// so that the source buffer can be reused as soon as the call returns.
+// Transfers whose remote address is not in the remote segment are done
+// as regular blocking GETs and PUTs.
+//
+#define MAX_AGG_HANDLES 64
+
+typedef struct {
+  int n;
+  gasnet_handle_t h[MAX_AGG_HANDLES];
+} agg_buff_t;
+
+static inline
+agg_buff_t* agg_buff_acquire(void) {
+  chpl_task_infoRuntime_t* infoRuntime = chpl_task_getInfoRuntime();
+  if (infoRuntime == NULL)
+    return NULL;
+
+  agg_buff_t* ab = (agg_buff_t*) infoRuntime->comm_data.agg_buff;
+  if (ab == NULL) {
+    ab = (agg_buff_t*) chpl_mem_allocManyZero(1, sizeof(*ab),
+                                              CHPL_RT_MD_COMM_PER_LOC_INFO,
+                                              0, 0);
+    infoRuntime->comm_data.agg_buff = ab;
+  }
+  return ab;
+}
+
+static inline
+void agg_buff_flush(agg_buff_t* ab) {
+  if (ab->n > 0) {
+    gasnet_wait_syncnb_all(ab->h, ab->n);
+    ab->n = 0;
+  }
+}
+
+static inline
+void agg_buff_add(agg_buff_t* ab, gasnet_handle_t h) {
+  if (h == GASNET_INVALID_HANDLE)
+    return;
+  ab->h[ab->n++] = h;
+  if (ab->n == MAX_AGG_HANDLES)
+    agg_buff_flush(ab);
+}
+
+void chpl_comm_get_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn) {
+  agg_buff_t* ab;
+  int remote_in_segment;
+
+  assert(addr != NULL);
+  assert(raddr != NULL);
+
+  if (size == 0)
+    return;
+
+  if (node == chpl_nodeID) {
+    memmove(addr, raddr, size);
+    return;
+  }
+
+#ifdef GASNET_SEGMENT_EVERYTHING
+  remote_in_segment = 1;
+#else
+  remote_in_segment = chpl_comm_addr_gettable(node, raddr, size);
+#endif
+
+  if (!remote_in_segment || (ab = agg_buff_acquire()) == NULL) {
+    chpl_comm_get(addr, node, raddr, size, commID, ln, fn);
+    return;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get)) {
+    chpl_comm_cb_info_t cb_data =
+      {chpl_comm_cb_event_kind_get, chpl_nodeID, node,
+       .iu.comm={addr, raddr, size, commID, ln, fn}};
+    chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("aggregated get", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(get);
+
+  agg_buff_add(ab, gasnet_get_nb_bulk(addr, node, raddr, size));
+}
+
+void chpl_comm_put_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn) {
+  agg_buff_t* ab;
+  int remote_in_segment;
+
+  assert(addr != NULL);
+  assert(raddr != NULL);
+
+  if (size == 0)
+    return;
+
+  if (node == chpl_nodeID) {
+    memmove(raddr, addr, size);
+    return;
+  }
+
+#ifdef GASNET_SEGMENT_EVERYTHING
+  remote_in_segment = 1;
+#else
+  remote_in_segment = chpl_comm_addr_gettable(node, raddr, size);
+#endif
+
+  if (!remote_in_segment || (ab = agg_buff_acquire()) == NULL) {
+    chpl_comm_put(addr, node, raddr, size, commID, ln, fn);
+    return;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put)) {
+    chpl_comm_cb_info_t cb_data =
+      {chpl_comm_cb_event_kind_put, chpl_nodeID, node,
+       .iu.comm={addr, raddr, size, commID, ln, fn}};
+    chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("aggregated put", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(put);
+
+  agg_buff_add(ab, gasnet_put_nb(node, raddr, addr, size));
+}
+
+void chpl_comm_aggregated_flush(void) {
+  chpl_task_infoRuntime_t* infoRuntime = chpl_task_getInfoRuntime();
+  if (infoRuntime != NULL && infoRuntime->comm_data.agg_buff != NULL)
+    agg_buff_flush((agg_buff_t*) infoRuntime->comm_data.agg_buff);
+}
+
+void chpl_comm_impl_task_end(void) {
+  chpl_task_infoRuntime_t* infoRuntime = chpl_task_getInfoRuntime();
+  if (infoRuntime != NULL && infoRuntime->comm_data.agg_buff != NULL) {
+    agg_buff_flush((agg_buff_t*) infoRuntime->comm_data.agg_buff);
+    chpl_mem_free(infoRuntime->comm_data.agg_buff, 0, 0);
+    infoRuntime->comm_data.agg_buff = NULL;
+  }
+}
+
 static inline
 void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
                         chpl_fn_int_t fid,
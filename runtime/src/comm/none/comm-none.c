@@ -224,6 +224,22 @@ void chpl_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
 
 void chpl_comm_getput_unordered_task_fence(void) { }
 
+void chpl_comm_get_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn)
+{
+  assert(node == 0);
+  memmove(addr, raddr, size);
+}
+
+void chpl_comm_put_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn)
+{
+  assert(node == 0);
+  memmove(raddr, addr, size);
+}
+
+void chpl_comm_aggregated_flush(void) { }
+
 typedef struct {
   chpl_fn_int_t fid;
   size_t        arg_size;
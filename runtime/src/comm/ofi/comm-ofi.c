@@ -111,22 +111,38 @@ static struct fi_info* ofi_info;        // fabric interface info
 static struct fid_fabric* ofi_fabric;   // fabric domain
 static struct fid_domain* ofi_domain;   // fabric access domain
 static struct fid_ep* ofi_txEpScal;     // scalable transmit endpoint
-static struct fid_poll* ofi_amhPollSet; // poll set for AM handler
-static int pollSetSize = 0;             // number of fids in the poll set
-static struct fid_wait* ofi_amhWaitSet; // wait set for AM handler
+static int pollSetSize = 0;             // number of fids in a poll set
 
 //
 // We direct RMA traffic and AM traffic to different endpoints so we can
 // spread the progress load across all the threads when we're doing
-// manual progress.
-//
-static struct fid_ep* ofi_rxEp;         // receive endpoint
-static struct fid_cq* ofi_rxCQ;         // receive endpoint CQ
+// manual progress.  Each AM handler has its own receive endpoint, so
+// that the handlers can service requests independently.  The first AM
+// handler's endpoint is also the target of all inbound RMA.
+//
+struct amHandlerInfo_t {
+  int id;                       // index in amhTab[]
+  struct fid_ep* rxEp;          // receive endpoint
+  struct fid_cq* rxCQ;          // receive endpoint CQ
+  struct fid_poll* pollSet;     // poll set, or NULL if not using one
+  struct fid_wait* waitSet;     // wait set, or NULL if not using one
+  void* amLZs[2];               // AM request landing zones
+  struct iovec iov_reqs[2];
+  struct fi_msg msg_reqs[2];
+  int msg_i;                    // which landing zone is posted
+};
+
+static int numAmHandlers = 1;
+static struct amHandlerInfo_t* amhTab;
 
 static struct fid_av* ofi_av;           // address vector
 static fi_addr_t* ofi_rxAddrs;          // table of remote endpoint addresses
 
-#define rxAddr(n) (ofi_rxAddrs[n])
+//
+// Each node's AM handler endpoint addresses are adjacent in the table.
+// RMA goes to the first one.
+//
+#define rxAddr(n) (ofi_rxAddrs[(n) * numAmHandlers])
 
 //
 // Transmit support.
@@ -161,6 +177,21 @@ static int tciTabLen;
 static struct perTxCtxInfo_t* tciTab;
 static chpl_bool tciTabBindTxCtxs;
 
+//
+// AM requests are spread across the target node's AM handlers by tx
+// context, offset by our node ID so that lightly loaded senders don't
+// all pick the same handler.  All the requests sent through a given tx
+// context to a given node go to the same handler there.
+//
+static inline
+int amRxIdx(struct perTxCtxInfo_t* tcip) {
+  return (numAmHandlers == 1)
+         ? 0
+         : (int) (((tcip - tciTab) + chpl_nodeID) % numAmHandlers);
+}
+
+#define amRxAddr(n, tcip) (ofi_rxAddrs[(n) * numAmHandlers + amRxIdx(tcip)])
+
 static size_t txCQLen;
 
 //
@@ -203,15 +234,14 @@ struct amRequest_execOnLrg_t {
   void* pPayload;                 // addr of arg payload on initiator node
 };
 
-static int numAmHandlers = 1;
-
 //
-// AM request landing zones.
+// AM request coalescing.  Non-blocking AM requests from a task can be
+// packed into per-destination batches, which are sent when they fill
+// up, when the task fences or ends, or when they time out.
 //
-static void* amLZs[2];
-static struct iovec ofi_iov_reqs[2];
-static struct fi_msg ofi_msg_reqs[2];
-static int ofi_msg_i;
+static chpl_bool envAmCoalesce;         // coalesce AM requests?
+static size_t envAmCoalesceSize;        // max bytes in a batch
+static double envAmCoalesceTimeout;     // max secs a request waits to go
 
 //
 // These are the major modes in which we can operate in order to
@@ -377,6 +407,11 @@ static void ofiErrReport(const char*, int, const char*);
 //
 static __thread chpl_bool isAmHandler = false;
 
+//
+// If so, this is its info.
+//
+static __thread struct amHandlerInfo_t* amhInfo;
+
 
 //
 // Flag used to tell AM handler(s) to exit.
@@ -956,6 +991,40 @@ void chpl_comm_init(int *argc_p, char ***argv_p) {
 
   envOversubscribed = chpl_env_rt_get_bool("OVERSUBSCRIBED", false);
 
+  {
+    int64_t n = chpl_env_rt_get_int("COMM_OFI_NUM_AM_HANDLERS", 1);
+    if (n < 1 || n > 64) {
+      chpl_warning("CHPL_RT_COMM_OFI_NUM_AM_HANDLERS must be in [1, 64], "
+                   "using 1", 0, 0);
+      n = 1;
+    }
+    numAmHandlers = (int) n;
+  }
+
+  envAmCoalesce = chpl_env_rt_get_bool("COMM_OFI_AM_COALESCE", false);
+  {
+    const int64_t minSize = 2 * sizeof(struct amRequest_execOn_t);
+    int64_t sz = chpl_env_rt_get_int("COMM_OFI_AM_COALESCE_SIZE", 8192);
+    if (sz < minSize || sz > ((int64_t) 1 << 20)) {
+      char msg[200];
+      (void) snprintf(msg, sizeof(msg),
+                      "CHPL_RT_COMM_OFI_AM_COALESCE_SIZE must be in "
+                      "[%" PRId64 ", %d], using 8192",
+                      minSize, 1 << 20);
+      chpl_warning(msg, 0, 0);
+      sz = 8192;
+    }
+    envAmCoalesceSize = ALIGN_UP((size_t) sz, sizeof(uint64_t));
+
+    int64_t us = chpl_env_rt_get_int("COMM_OFI_AM_COALESCE_TIMEOUT", 1000);
+    if (us <= 0) {
+      chpl_warning("CHPL_RT_COMM_OFI_AM_COALESCE_TIMEOUT <= 0, using 1000",
+                   0, 0);
+      us = 1000;
+    }
+    envAmCoalesceTimeout = (double) us * 1.0e-6;
+  }
+
   //
   // The user can specify the provider by setting either the Chapel
   // CHPL_RT_COMM_OFI_PROVIDER environment variable or the libfabric
@@ -1027,9 +1096,11 @@ void init_ofi(void) {
   init_ofiConnections();
 
   DBG_PRINTF(DBG_CFG,
-             "AM config: recv buf size %zd MiB, %s, responses use %s",
-             ofi_iov_reqs[ofi_msg_i].iov_len / (1L << 20),
-             (ofi_amhPollSet == NULL) ? "explicit polling" : "poll+wait sets",
+             "AM config: %d handler%s, recv buf size %zd MiB, %s, "
+             "responses use %s",
+             numAmHandlers, (numAmHandlers == 1) ? "" : "s",
+             amhTab[0].iov_reqs[0].iov_len / (1L << 20),
+             (amhTab[0].pollSet == NULL) ? "explicit polling" : "poll+wait sets",
              (tciTab[tciTabLen - 1].txCQ != NULL) ? "CQ" : "counter");
   if (ofi_txEpScal != NULL) {
     DBG_PRINTF(DBG_CFG,
@@ -1941,11 +2012,18 @@ void init_ofiDoProviderChecks(void) {
 
 static
 void init_ofiEp(void) {
+  CHPL_CALLOC(amhTab, numAmHandlers);
+  for (int i = 0; i < numAmHandlers; i++) {
+    amhTab[i].id = i;
+  }
+
   //
-  // The AM handler is responsible not only for AM handling and progress
-  // on any RMA it initiates but also progress on inbound RMA, if that
-  // is needed.  It uses poll and wait sets to manage this, if it can.
-  // Note: we'll either have both a poll and a wait set, or neither.
+  // The AM handlers are responsible not only for AM handling and
+  // progress on any RMA they initiate but also progress on inbound RMA,
+  // if that is needed.  They use poll and wait sets to manage this, if
+  // they can.  Each handler has its own, so that it only wakes up for
+  // its own events.  Note: we'll either have both a poll and a wait set
+  // for every handler, or neither.
   //
   // We don't use poll and wait sets with the efa provider because that
   // doesn't support wait objects.  I tried just setting the cq_attr
@@ -1972,19 +2050,28 @@ void init_ofiEp(void) {
     int ret;
     struct fi_poll_attr pollSetAttr = (struct fi_poll_attr)
                                       { .flags = 0, };
-    OFI_CHK_2(fi_poll_open(ofi_domain, &pollSetAttr, &ofi_amhPollSet),
+    struct fi_wait_attr waitSetAttr = (struct fi_wait_attr)
+                                      { .wait_obj = FI_WAIT_UNSPEC, };
+    struct amHandlerInfo_t* amh = &amhTab[0];
+    OFI_CHK_2(fi_poll_open(ofi_domain, &pollSetAttr, &amh->pollSet),
               ret, -FI_ENOSYS);
     if (ret == FI_SUCCESS) {
-      struct fi_wait_attr waitSetAttr = (struct fi_wait_attr)
-                                        { .wait_obj = FI_WAIT_UNSPEC, };
-      OFI_CHK_2(fi_wait_open(ofi_fabric, &waitSetAttr, &ofi_amhWaitSet),
+      OFI_CHK_2(fi_wait_open(ofi_fabric, &waitSetAttr, &amh->waitSet),
                 ret, -FI_ENOSYS);
       if (ret != FI_SUCCESS) {
-        ofi_amhPollSet = NULL;
-        ofi_amhWaitSet = NULL;
+        OFI_CHK(fi_close(&amh->pollSet->fid));
+        amh->pollSet = NULL;
+        amh->waitSet = NULL;
       }
     } else {
-      ofi_amhPollSet = NULL;
+      amh->pollSet = NULL;
+    }
+
+    if (amh->pollSet != NULL) {
+      for (int i = 1; i < numAmHandlers; i++) {
+        OFI_CHK(fi_poll_open(ofi_domain, &pollSetAttr, &amhTab[i].pollSet));
+        OFI_CHK(fi_wait_open(ofi_fabric, &waitSetAttr, &amhTab[i].waitSet));
+      }
     }
   }
 
@@ -2004,7 +2091,6 @@ void init_ofiEp(void) {
     ofi_info->ep_attr->tx_ctx_cnt = numTxCtxs;
   }
 
-  CHK_TRUE(ofi_info->domain_attr->max_ep_rx_ctx >= numAmHandlers);
   numRxCtxs = numAmHandlers;
 
   tciTabLen = numTxCtxs;
@@ -2023,7 +2109,9 @@ void init_ofiEp(void) {
   //
   struct fi_av_attr avAttr = (struct fi_av_attr)
                              { .type = FI_AV_TABLE,
-                               .count = chpl_numNodes * 2 /* AM, RMA+AMO */,
+                               .count = chpl_numNodes
+                                        * (numAmHandlers /* AM, RMA+AMO */
+                                           + 1 /* tx */),
                                .name = NULL,
                                .rx_ctx_bits = 0, };
   if (provCtl_sizeAvsByNumEps) {
@@ -2070,7 +2158,9 @@ void init_ofiEp(void) {
   // TX contexts for the AM handler(s) can just use counters, if the
   // provider supports them.  Otherwise, they have to use CQs also.
   //
-  const enum fi_wait_obj waitObj = (ofi_amhWaitSet == NULL)
+  // Each AM handler's tx context is tciTab[numWorkerTxCtxs + its id].
+  //
+  const enum fi_wait_obj waitObj = (amhTab[0].waitSet == NULL)
                                    ? FI_WAIT_NONE
                                    : FI_WAIT_SET;
   if (true /*ofi_info->domain_attr->cntr_cnt == 0*/) { // disable tx counters
@@ -2078,23 +2168,23 @@ void init_ofiEp(void) {
              { .format = FI_CQ_FORMAT_MSG,
                .size = 100,
                .wait_obj = waitObj,
-               .wait_cond = FI_CQ_COND_NONE,
-               .wait_set = ofi_amhWaitSet, };
+               .wait_cond = FI_CQ_COND_NONE, };
     for (int i = numWorkerTxCtxs; i < tciTabLen; i++) {
+      cqAttr.wait_set = amhTab[i - numWorkerTxCtxs].waitSet;
       init_ofiEpTxCtx(i, true /*isAMHandler*/, &cqAttr, NULL);
     }
   } else {
     cntrAttr = (struct fi_cntr_attr)
                { .events = FI_CNTR_EVENTS_COMP,
-                 .wait_obj = waitObj,
-                 .wait_set = ofi_amhWaitSet, };
+                 .wait_obj = waitObj, };
     for (int i = numWorkerTxCtxs; i < tciTabLen; i++) {
+      cntrAttr.wait_set = amhTab[i - numWorkerTxCtxs].waitSet;
       init_ofiEpTxCtx(i, true /*isAMHandler*/, NULL, &cntrAttr);
     }
   }
 
   //
-  // Create receive contexts.
+  // Create receive contexts, one per AM handler.
   //
   // For the CQ length, allow for an appreciable proportion of the job
   // to send requests to us at once.
@@ -2103,27 +2193,27 @@ void init_ofiEp(void) {
            { .size = chpl_numNodes * numWorkerTxCtxs,
              .format = FI_CQ_FORMAT_DATA,
              .wait_obj = waitObj,
-             .wait_cond = FI_CQ_COND_NONE,
-             .wait_set = ofi_amhWaitSet, };
-  cntrAttr = (struct fi_cntr_attr)
-             { .events = FI_CNTR_EVENTS_COMP,
-               .wait_obj = waitObj,
-               .wait_set = ofi_amhWaitSet, };
+             .wait_cond = FI_CQ_COND_NONE, };
 
-  OFI_CHK(fi_endpoint(ofi_domain, ofi_info, &ofi_rxEp, NULL));
-  OFI_CHK(fi_ep_bind(ofi_rxEp, &ofi_av->fid, 0));
-  OFI_CHK(fi_cq_open(ofi_domain, &cqAttr, &ofi_rxCQ, &ofi_rxCQ));
-  OFI_CHK(fi_ep_bind(ofi_rxEp, &ofi_rxCQ->fid, FI_TRANSMIT | FI_RECV));
-  OFI_CHK(fi_enable(ofi_rxEp));
+  for (int i = 0; i < numAmHandlers; i++) {
+    struct amHandlerInfo_t* amh = &amhTab[i];
+    cqAttr.wait_set = amh->waitSet;
+    OFI_CHK(fi_endpoint(ofi_domain, ofi_info, &amh->rxEp, NULL));
+    OFI_CHK(fi_ep_bind(amh->rxEp, &ofi_av->fid, 0));
+    OFI_CHK(fi_cq_open(ofi_domain, &cqAttr, &amh->rxCQ, &amh->rxCQ));
+    OFI_CHK(fi_ep_bind(amh->rxEp, &amh->rxCQ->fid, FI_TRANSMIT | FI_RECV));
+    OFI_CHK(fi_enable(amh->rxEp));
 
-  //
-  // If we're using poll and wait sets, put all the progress-related
-  // CQs and/or counters in the poll set.
-  //
-  if (ofi_amhPollSet != NULL) {
-    OFI_CHK(fi_poll_add(ofi_amhPollSet, &ofi_rxCQ->fid, 0));
-    OFI_CHK(fi_poll_add(ofi_amhPollSet, tciTab[tciTabLen - 1].txCmplFid, 0));
-    pollSetSize = 3;
+    //
+    // If we're using poll and wait sets, put all the progress-related
+    // CQs and/or counters in the poll set.
+    //
+    if (amh->pollSet != NULL) {
+      OFI_CHK(fi_poll_add(amh->pollSet, &amh->rxCQ->fid, 0));
+      OFI_CHK(fi_poll_add(amh->pollSet,
+                          tciTab[numWorkerTxCtxs + i].txCmplFid, 0));
+      pollSetSize = 3;
+    }
   }
 }
 
@@ -2182,7 +2272,7 @@ void init_ofiExchangeAvInfo(void) {
     // Sanity-check our same-address-length assumption.
     //
     size_t len = 0;
-    OFI_CHK_1(fi_getname(&ofi_rxEp->fid, NULL, &len), -FI_ETOOSMALL);
+    OFI_CHK_1(fi_getname(&amhTab[0].rxEp->fid, NULL, &len), -FI_ETOOSMALL);
 
     size_t* lens;
     CHPL_CALLOC(lens, chpl_numNodes);
@@ -2194,24 +2284,34 @@ void init_ofiExchangeAvInfo(void) {
     }
   }
 
-  char* my_addr;
+  //
+  // Each node contributes the addresses of all its AM handler receive
+  // endpoints, in order.
+  //
+  char* my_addrs;
   char* addrs;
   size_t my_addr_len = 0;
 
-  OFI_CHK_1(fi_getname(&ofi_rxEp->fid, NULL, &my_addr_len), -FI_ETOOSMALL);
-  CHPL_CALLOC_SZ(my_addr, my_addr_len, 1);
-  OFI_CHK(fi_getname(&ofi_rxEp->fid, my_addr, &my_addr_len));
-  CHPL_CALLOC_SZ(addrs, chpl_numNodes, my_addr_len);
-  if (DBG_TEST_MASK(DBG_CFG_AV)) {
-    char nameBuf[128];
-    size_t nameLen;
-    nameLen = sizeof(nameBuf);
-    (void) fi_av_straddr(ofi_av, my_addr, nameBuf, &nameLen);
-    DBG_PRINTF(DBG_CFG_AV, "my_addrs: %.*s%s",
-               (int) nameLen, nameBuf,
-               (nameLen <= sizeof(nameBuf)) ? "" : "[...]");
+  OFI_CHK_1(fi_getname(&amhTab[0].rxEp->fid, NULL, &my_addr_len),
+            -FI_ETOOSMALL);
+  CHPL_CALLOC_SZ(my_addrs, numAmHandlers, my_addr_len);
+  for (int i = 0; i < numAmHandlers; i++) {
+    char* my_addr = my_addrs + i * my_addr_len;
+    size_t len = my_addr_len;
+    OFI_CHK(fi_getname(&amhTab[i].rxEp->fid, my_addr, &len));
+    CHK_TRUE(len == my_addr_len);
+    if (DBG_TEST_MASK(DBG_CFG_AV)) {
+      char nameBuf[128];
+      size_t nameLen;
+      nameLen = sizeof(nameBuf);
+      (void) fi_av_straddr(ofi_av, my_addr, nameBuf, &nameLen);
+      DBG_PRINTF(DBG_CFG_AV, "my_addrs[%d]: %.*s%s",
+                 i, (int) nameLen, nameBuf,
+                 (nameLen <= sizeof(nameBuf)) ? "" : "[...]");
+    }
   }
-  chpl_comm_ofi_oob_allgather(my_addr, addrs, my_addr_len);
+  CHPL_CALLOC_SZ(addrs, chpl_numNodes * numAmHandlers, my_addr_len);
+  chpl_comm_ofi_oob_allgather(my_addrs, addrs, numAmHandlers * my_addr_len);
 
   //
   // Insert the addresses into the address vector and build up a vector
@@ -2223,12 +2323,12 @@ void init_ofiExchangeAvInfo(void) {
   // Only when the provider cannot support scalable EPs and we have
   // multiple actual endpoints are the AVs individualized to those.
   //
-  size_t numAddrs = chpl_numNodes;
+  size_t numAddrs = chpl_numNodes * numAmHandlers;
   CHPL_CALLOC(ofi_rxAddrs, numAddrs);
   CHK_TRUE(fi_av_insert(ofi_av, addrs, numAddrs, ofi_rxAddrs, 0, NULL)
            == numAddrs);
 
-  CHPL_FREE(my_addr);
+  CHPL_FREE(my_addrs);
   CHPL_FREE(addrs);
 }
 
@@ -2309,7 +2409,7 @@ void init_ofiForMem(void) {
     CHK_TRUE(prov_key || memTab[i].key == i);
     DBG_PRINTF(DBG_MR, "[%d]     key %#" PRIx64, i, memTab[i].key);
     if ((ofi_info->domain_attr->mr_mode & FI_MR_ENDPOINT) != 0) {
-      OFI_CHK(fi_mr_bind(ofiMrTab[i], &ofi_rxEp->fid, 0));
+      OFI_CHK(fi_mr_bind(ofiMrTab[i], &amhTab[0].rxEp->fid, 0));
       OFI_CHK(fi_mr_enable(ofiMrTab[i]));
     }
   }
@@ -2479,54 +2579,58 @@ void init_ofiForAms(void) {
 
   //
   // Set the minimum multi-receive buffer space.  Make it big enough to
-  // hold a max-sized request from every potential sender, but no more
-  // than 10% of the buffer size.  Some providers don't have fi_setopt()
-  // for some ep types, so allow this to fail in that case.  But note
-  // that if it does fail and we get overruns we'll die or, worse yet,
-  // silently compute wrong results.
+  // hold a max-sized request (or batch, if we're coalescing) from every
+  // potential sender, but no more than 10% of the buffer size.  Some
+  // providers don't have fi_setopt() for some ep types, so allow this
+  // to fail in that case.  But note that if it does fail and we get
+  // overruns we'll die or, worse yet, silently compute wrong results.
   //
   {
-    size_t sz = chpl_numNodes * tciTabLen * sizeof(struct amRequest_execOn_t);
+    size_t maxReqSize = sizeof(struct amRequest_execOn_t);
+    if (envAmCoalesce && envAmCoalesceSize > maxReqSize) {
+      maxReqSize = envAmCoalesceSize;
+    }
+    size_t sz = chpl_numNodes * tciTabLen * maxReqSize;
     if (sz > amLZSize / 10) {
         sz = amLZSize / 10;
     }
-    int ret;
-    OFI_CHK_2(fi_setopt(&ofi_rxEp->fid, FI_OPT_ENDPOINT,
-                        FI_OPT_MIN_MULTI_RECV, &sz, sizeof(sz)),
-              ret, -FI_ENOSYS);
+    for (int i = 0; i < numAmHandlers; i++) {
+      int ret;
+      OFI_CHK_2(fi_setopt(&amhTab[i].rxEp->fid, FI_OPT_ENDPOINT,
+                          FI_OPT_MIN_MULTI_RECV, &sz, sizeof(sz)),
+                ret, -FI_ENOSYS);
+    }
   }
 
   //
-  // Pre-post multi-receive buffer for inbound AM requests.  In reality
-  // set up two of these and swap back and forth between them, to hedge
-  // against receiving "buffer filled and released" events out of order
-  // with respect to the messages stored within them.
-  //
-  CHPL_CALLOC_SZ(amLZs[0], 1, amLZSize);
-  CHPL_CALLOC_SZ(amLZs[1], 1, amLZSize);
-
-  ofi_iov_reqs[0] = (struct iovec) { .iov_base = amLZs[0],
-                                     .iov_len = amLZSize, };
-  ofi_iov_reqs[1] = (struct iovec) { .iov_base = amLZs[1],
-                                     .iov_len = amLZSize, };
-  ofi_msg_reqs[0] = (struct fi_msg) { .msg_iov = &ofi_iov_reqs[0],
-                                      .desc = NULL,
-                                      .iov_count = 1,
-                                      .addr = FI_ADDR_UNSPEC,
-                                      .context = txnTrkEncodeId(__LINE__),
-                                      .data = 0x0, };
-  ofi_msg_reqs[1] = (struct fi_msg) { .msg_iov = &ofi_iov_reqs[1],
-                                      .desc = NULL,
-                                      .iov_count = 1,
-                                      .addr = FI_ADDR_UNSPEC,
-                                      .context = txnTrkEncodeId(__LINE__),
-                                      .data = 0x0, };
-  ofi_msg_i = 0;
-  OFI_CHK(fi_recvmsg(ofi_rxEp, &ofi_msg_reqs[ofi_msg_i], FI_MULTI_RECV));
-  DBG_PRINTF(DBG_AM_BUF,
-             "pre-post fi_recvmsg(AMLZs %p, len %#zx)",
-             ofi_msg_reqs[ofi_msg_i].msg_iov->iov_base,
-             ofi_msg_reqs[ofi_msg_i].msg_iov->iov_len);
+  // Pre-post multi-receive buffers for inbound AM requests, for each
+  // AM handler.  In reality set up two of these per handler and swap
+  // back and forth between them, to hedge against receiving "buffer
+  // filled and released" events out of order with respect to the
+  // messages stored within them.
+  //
+  for (int i = 0; i < numAmHandlers; i++) {
+    struct amHandlerInfo_t* amh = &amhTab[i];
+    for (int j = 0; j < 2; j++) {
+      CHPL_CALLOC_SZ(amh->amLZs[j], 1, amLZSize);
+      amh->iov_reqs[j] = (struct iovec) { .iov_base = amh->amLZs[j],
+                                          .iov_len = amLZSize, };
+      amh->msg_reqs[j] = (struct fi_msg) { .msg_iov = &amh->iov_reqs[j],
+                                           .desc = NULL,
+                                           .iov_count = 1,
+                                           .addr = FI_ADDR_UNSPEC,
+                                           .context = txnTrkEncodeId(__LINE__),
+                                           .data = 0x0, };
+    }
+    amh->msg_i = 0;
+    OFI_CHK(fi_recvmsg(amh->rxEp, &amh->msg_reqs[amh->msg_i],
+                       FI_MULTI_RECV));
+    DBG_PRINTF(DBG_AM_BUF,
+               "pre-post fi_recvmsg(AMLZs[%d] %p, len %#zx)",
+               i,
+               amh->msg_reqs[amh->msg_i].msg_iov->iov_base,
+               amh->msg_reqs[amh->msg_i].msg_iov->iov_len);
+  }
 
   init_amHandling();
 }
@@ -2737,18 +2841,23 @@ void fini_ofi(void) {
     CHPL_FREE(memTabMap);
   }
 
-  CHPL_FREE(amLZs[1]);
-  CHPL_FREE(amLZs[0]);
-
   CHPL_FREE(ofi_rxAddrs);
 
-  if (ofi_amhPollSet != NULL) {
-    OFI_CHK(fi_poll_del(ofi_amhPollSet, tciTab[tciTabLen - 1].txCmplFid, 0));
-    OFI_CHK(fi_poll_del(ofi_amhPollSet, &ofi_rxCQ->fid, 0));
-  }
+  const int numWorkerTxCtxs = tciTabLen - numAmHandlers;
+  for (int i = 0; i < numAmHandlers; i++) {
+    struct amHandlerInfo_t* amh = &amhTab[i];
+    CHPL_FREE(amh->amLZs[1]);
+    CHPL_FREE(amh->amLZs[0]);
+
+    if (amh->pollSet != NULL) {
+      OFI_CHK(fi_poll_del(amh->pollSet,
+                          tciTab[numWorkerTxCtxs + i].txCmplFid, 0));
+      OFI_CHK(fi_poll_del(amh->pollSet, &amh->rxCQ->fid, 0));
+    }
 
-  OFI_CHK(fi_close(&ofi_rxEp->fid));
-  OFI_CHK(fi_close(&ofi_rxCQ->fid));
+    OFI_CHK(fi_close(&amh->rxEp->fid));
+    OFI_CHK(fi_close(&amh->rxCQ->fid));
+  }
 
   for (int i = 0; i < tciTabLen; i++) {
     OFI_CHK(fi_close(&tciTab[i].txCtx->fid));
@@ -2761,11 +2870,15 @@ void fini_ofi(void) {
 
   OFI_CHK(fi_close(&ofi_av->fid));
 
-  if (ofi_amhPollSet != NULL) {
-    OFI_CHK(fi_close(&ofi_amhWaitSet->fid));
-    OFI_CHK(fi_close(&ofi_amhPollSet->fid));
+  for (int i = 0; i < numAmHandlers; i++) {
+    if (amhTab[i].pollSet != NULL) {
+      OFI_CHK(fi_close(&amhTab[i].waitSet->fid));
+      OFI_CHK(fi_close(&amhTab[i].pollSet->fid));
+    }
   }
 
+  CHPL_FREE(amhTab);
+
   OFI_CHK(fi_close(&ofi_domain->fid));
   OFI_CHK(fi_close(&ofi_fabric->fid));
 
@@ -3168,6 +3281,8 @@ void* mrLocalizeTargetRemote(const void* addr, size_t size,
 //
 
 static void retireDelayedAmDone(chpl_bool);
+static void am_buff_flush(chpl_comm_taskPrvData_t*, chpl_bool);
+static void am_buff_task_end(chpl_comm_taskPrvData_t*);
 
 
 static inline
@@ -3248,6 +3363,7 @@ void chpl_comm_impl_unordered_task_fence(void) {
   DBG_PRINTF(DBG_IFACE_MCM, "%s()", __func__);
 
   task_local_buff_end(get_buff | put_buff | amo_nf_buff);
+  am_buff_flush(get_comm_taskPrvdata(), false /*wait*/);
 }
 
 
@@ -3264,6 +3380,7 @@ void chpl_comm_impl_task_end(void) {
   DBG_PRINTF(DBG_IFACE_MCM, "%s()", __func__);
 
   task_local_buff_end(get_buff | put_buff | amo_nf_buff);
+  am_buff_task_end(get_comm_taskPrvdata());
   retireDelayedAmDone(true /*taskIsEnding*/);
   forceMemFxVisAllNodes_noTcip(true /*checkPuts*/, true /*checkAmos*/);
 }
@@ -3279,10 +3396,13 @@ typedef enum {
   am_opExecOnLrg,                          // on-stmt, large arg
   am_opGet,                                // do an RMA GET
   am_opPut,                                // do an RMA PUT
+  am_opGetStrd,                            // do an RMA GET, then unpack
+  am_opPutStrd,                            // pack, then do an RMA PUT
   am_opAMO,                                // do an AMO
   am_opFree,                               // free some memory
   am_opNop,                                // do nothing; for MCM & liveness
   am_opShutdown,                           // signal main process for shutdown
+  am_opBatch,                              // a batch of coalesced requests
 } amOp_t;
 
 #ifdef CHPL_COMM_DEBUG
@@ -3317,6 +3437,22 @@ struct amRequest_RMA_t {
   size_t size;                  // number of bytes
 };
 
+//
+// Strided transfers with more levels than this don't use packing.
+//
+#define AM_STRD_MAX_LEVELS 8
+
+struct amRequest_strd_t {
+  struct amRequest_base_t b;
+  void* addr;                   // strided address on AM target node
+  void* raddr;                  // packed buffer on AM initiator's node
+  size_t size;                  // number of bytes packed
+  size_t elemSize;              // element size (bytes)
+  int32_t stridelevels;         // number of stride levels
+  size_t strides[AM_STRD_MAX_LEVELS];     // strides on AM target node
+  size_t count[AM_STRD_MAX_LEVELS + 1];   // counts
+};
+
 typedef union {
   int32_t i32;
   uint32_t u32;
@@ -3343,13 +3479,32 @@ struct amRequest_free_t {
   void* p;                      // address to free, on AM target node
 };
 
+//
+// A batch header is followed by 'numReqs' requests, each preceded by
+// its size as a uint64_t and padded to a multiple of 8 bytes.  If the
+// batch has a 'done' indicator it is set after all the requests have
+// been handled.
+//
+struct amRequest_batch_t {
+  struct amRequest_base_t b;
+  uint32_t numReqs;             // number of requests in the batch
+  uint32_t size;                // total bytes, including this header
+};
+
+#define AM_BATCH_HDR_SIZE \
+        ALIGN_UP(sizeof(struct amRequest_batch_t), sizeof(uint64_t))
+#define AM_BATCH_ENTRY_SIZE(reqSize) \
+        (sizeof(uint64_t) + ALIGN_UP((reqSize), sizeof(uint64_t)))
+
 typedef union {
   struct amRequest_base_t b;
   struct amRequest_execOn_t xo;      // present only to set the max req size
   struct amRequest_execOnLrg_t xol;
   struct amRequest_RMA_t rma;
+  struct amRequest_strd_t strd;
   struct amRequest_AMO_t amo;
   struct amRequest_free_t free;
+  struct amRequest_batch_t batch;
 } amRequest_t;
 
 struct taskArg_RMA_t {
@@ -3357,6 +3512,11 @@ struct taskArg_RMA_t {
   struct amRequest_RMA_t rma;
 };
 
+struct taskArg_strd_t {
+  chpl_task_bundle_t hdr;
+  struct amRequest_strd_t strd;
+};
+
 
 #ifdef CHPL_COMM_DEBUG
 static const char* am_opName(amOp_t);
@@ -3374,6 +3534,10 @@ static void amRequestExecOn(c_nodeid_t, c_sublocid_t, chpl_fn_int_t,
                             chpl_bool, chpl_bool);
 static void amRequestRmaPut(c_nodeid_t, void*, void*, size_t);
 static void amRequestRmaGet(c_nodeid_t, void*, void*, size_t);
+static void amRequestStrdPut(c_nodeid_t, void*, size_t*, void*, size_t*,
+                             size_t*, int32_t, size_t);
+static void amRequestStrdGet(c_nodeid_t, void*, size_t*, void*, size_t*,
+                             size_t*, int32_t, size_t);
 static void amRequestAMO(c_nodeid_t, void*, const void*, const void*, void*,
                          int, enum fi_datatype, size_t);
 static void amRequestFree(c_nodeid_t, void*);
@@ -3382,6 +3546,8 @@ static void amRequestCommon(c_nodeid_t, amRequest_t*, size_t,
                             amDone_t**, chpl_bool, struct perTxCtxInfo_t*);
 static void amWaitForDone(amDone_t*);
 static chpl_bool setUpDelayedAmDone(chpl_comm_taskPrvData_t**, void**);
+static chpl_bool am_buff_add(c_nodeid_t, amRequest_t*, size_t, chpl_bool);
+static void am_buff_retire(chpl_comm_taskPrvData_t*);
 
 
 void chpl_comm_execute_on(c_nodeid_t node, c_sublocid_t subloc,
@@ -3464,14 +3630,24 @@ void amRequestExecOn(c_nodeid_t node, c_sublocid_t subloc,
   assert(!isAmHandler);
   CHK_TRUE(!(fast && !blocking)); // handler doesn't expect fast nonblocking
 
-  retireDelayedAmDone(false /*taskIsEnding*/);
-
   arg->comm = (chpl_comm_bundleData_t) { .fast = fast,
                                          .fid = fid,
                                          .node = chpl_nodeID,
                                          .subloc = subloc,
                                          .argSize = argSize, };
 
+  //
+  // A small nonblocking executeOn can go in a batch with others.
+  //
+  if (!blocking && argSize <= sizeof(amRequest_t)) {
+    arg->kind = am_opExecOn;
+    if (am_buff_add(node, (amRequest_t*) arg, argSize, false /*isAmo*/)) {
+      return;
+    }
+  }
+
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
   if (argSize <= sizeof(amRequest_t)) {
     //
     // The arg bundle will fit in max-sized AM request; just send it.
@@ -3572,6 +3748,82 @@ void amRequestRmaGet(c_nodeid_t node, void* addr, void* raddr, size_t size) {
 }
 
 
+static inline
+void amRequestStrdPut(c_nodeid_t node, void* raddr, size_t* rstrides,
+                      void* addr, size_t* strides,
+                      size_t* count, int32_t stridelevels, size_t elemSize) {
+  assert(!isAmHandler);
+  assert(stridelevels > 0 && stridelevels <= AM_STRD_MAX_LEVELS);
+
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
+  //
+  // Pack the source into a remotely accessible buffer.  The target
+  // will GET that and unpack it into its strided destination.
+  //
+  size_t size = strd_num_runs(count, stridelevels) * count[0] * elemSize;
+  void* buf = allocBounceBuf(size);
+  strd_pack(buf, addr, strides, count, stridelevels, elemSize);
+  void* myBuf = mrLocalizeSourceRemote(buf, size, "strided RMA via AM");
+
+  DBG_PRINTF(DBG_RMA | DBG_RMA_WRITE,
+             "PUT strided %d:%p <= %p, size %zd, via AM GET",
+             (int) node, raddr, addr, size);
+  amRequest_t req = { .strd = { .b = { .op = am_opGetStrd, // remote GETs
+                                       .node = chpl_nodeID, },
+                                .addr = raddr,
+                                .raddr = myBuf,
+                                .size = size,
+                                .elemSize = elemSize,
+                                .stridelevels = stridelevels, }, };
+  memcpy(req.strd.strides, rstrides, stridelevels * sizeof(rstrides[0]));
+  memcpy(req.strd.count, count, (stridelevels + 1) * sizeof(count[0]));
+  amRequestCommon(node, &req, sizeof(req.strd),
+                  &req.b.pAmDone, true /*yieldDuringTxnWait*/, NULL);
+
+  mrUnLocalizeSource(myBuf, buf);
+  freeBounceBuf(buf);
+}
+
+
+static inline
+void amRequestStrdGet(c_nodeid_t node, void* raddr, size_t* rstrides,
+                      void* addr, size_t* strides,
+                      size_t* count, int32_t stridelevels, size_t elemSize) {
+  assert(!isAmHandler);
+  assert(stridelevels > 0 && stridelevels <= AM_STRD_MAX_LEVELS);
+
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
+  //
+  // The target will pack its strided source and PUT that into our
+  // buffer, which we then unpack into the strided destination.
+  //
+  size_t size = strd_num_runs(count, stridelevels) * count[0] * elemSize;
+  void* buf = allocBounceBuf(size);
+  void* myBuf = mrLocalizeTargetRemote(buf, size, "strided RMA via AM");
+
+  DBG_PRINTF(DBG_RMA | DBG_RMA_READ,
+             "GET strided %p <= %d:%p, size %zd, via AM PUT",
+             addr, (int) node, raddr, size);
+  amRequest_t req = { .strd = { .b = { .op = am_opPutStrd, // remote PUTs
+                                       .node = chpl_nodeID, },
+                                .addr = raddr,
+                                .raddr = myBuf,
+                                .size = size,
+                                .elemSize = elemSize,
+                                .stridelevels = stridelevels, }, };
+  memcpy(req.strd.strides, rstrides, stridelevels * sizeof(rstrides[0]));
+  memcpy(req.strd.count, count, (stridelevels + 1) * sizeof(count[0]));
+  amRequestCommon(node, &req, sizeof(req.strd),
+                  &req.b.pAmDone, true /*yieldDuringTxnWait*/, NULL);
+
+  mrUnLocalizeTarget(myBuf, buf, size);
+  strd_unpack(addr, strides, buf, count, stridelevels, elemSize);
+  freeBounceBuf(buf);
+}
+
+
 static inline
 void amRequestAMO(c_nodeid_t node, void* object,
                   const void* opnd, const void* cmpr, void* result,
@@ -3661,6 +3913,337 @@ void amRequestShutdown(c_nodeid_t node) {
                   NULL, true /*yieldDuringTxnWait*/, NULL);
 }
 
+//
+// AM request coalescing.
+//
+// Each task that coalesces has a small direct-mapped set of batch
+// buffers, one per destination node currently in use.  Non-blocking
+// executeOns and non-fetching AMOs that have to be done via AM go into
+// the buffer for their target node instead of being sent right away.
+// A buffer is sent when it fills or when a request for another node
+// maps to it, when the task fences or ends, when the task does some
+// other operation with MCM implications (see retireDelayedAmDone()),
+// and when it has held requests for more than the timeout.  The AM
+// handler takes care of the timeouts, since the owning task may be
+// blocked waiting for the effects of the very requests it buffered.
+//
+// MCM: the memory effects of the task's prior PUTs and AMOs are made
+// visible when a request is added rather than when the batch is sent.
+// The requests in a batch are handled in order, so non-fetching AMOs
+// to the same node can share a single 'done' indicator for the whole
+// batch.  Only one batch with AMOs can be open at a time; before
+// adding a request for some other node we send that batch and wait
+// for it to be done, just as we would for a single delayed-blocking
+// AMO.
+//
+
+#define AM_BUFF_NUM_SLOTS 4
+
+typedef struct {
+  c_nodeid_t node;              // target node of buffered requests
+  uint32_t numReqs;             // number of buffered requests
+  size_t used;                  // bytes used, including batch header
+  double firstTime;             // when the first request was added
+  char* buf;                    // envAmCoalesceSize bytes
+} am_buff_slot_t;
+
+typedef struct am_buff_task_info_s {
+  pthread_mutex_t lock;         // owning task vs. AM handler timeouts
+  struct am_buff_task_info_s* next;
+  struct am_buff_task_info_s* prev;
+  int amoSlot;                  // slot with AMOs needing 'done', or -1
+  chpl_bool amDonePending;      // sent AMO batch not known done yet?
+  amDone_t amDone;              // 'done' indicator for AMO batches
+  am_buff_slot_t slots[AM_BUFF_NUM_SLOTS];
+} am_buff_task_info_t;
+
+//
+// All the tasks' buffers, so the AM handler can find the ones that
+// have timed out.
+//
+static am_buff_task_info_t* amBuffList;
+static pthread_mutex_t amBuffListLock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int_least32_t amBuffNumPending;  // # non-empty slots
+
+
+static
+am_buff_task_info_t* am_buff_acquire(chpl_comm_taskPrvData_t* prvData) {
+  am_buff_task_info_t* info = prvData->am_buff;
+  if (info != NULL) {
+    return info;
+  }
+
+  CHPL_CALLOC_SZ(info, 1,
+                 sizeof(*info) + AM_BUFF_NUM_SLOTS * envAmCoalesceSize);
+  PTHREAD_CHK(pthread_mutex_init(&info->lock, NULL));
+  info->amoSlot = -1;
+  char* bufs = (char*) info + ALIGN_UP(sizeof(*info), sizeof(uint64_t));
+  for (int i = 0; i < AM_BUFF_NUM_SLOTS; i++) {
+    info->slots[i].node = -1;
+    info->slots[i].used = AM_BATCH_HDR_SIZE;
+    info->slots[i].buf = bufs + i * envAmCoalesceSize;
+  }
+
+  PTHREAD_CHK(pthread_mutex_lock(&amBuffListLock));
+  info->prev = NULL;
+  info->next = amBuffList;
+  if (amBuffList != NULL) {
+    amBuffList->prev = info;
+  }
+  amBuffList = info;
+  PTHREAD_CHK(pthread_mutex_unlock(&amBuffListLock));
+
+  prvData->am_buff = info;
+  return info;
+}
+
+
+//
+// Send one slot's batch.  The caller holds the info lock.
+//
+static
+void am_buff_flush_slot(am_buff_task_info_t* info, int si,
+                        struct perTxCtxInfo_t* tcip) {
+  am_buff_slot_t* slot = &info->slots[si];
+  if (slot->numReqs == 0) {
+    return;
+  }
+
+  struct amRequest_batch_t* batch = (struct amRequest_batch_t*) slot->buf;
+  *batch = (struct amRequest_batch_t) { .b = { .op = am_opBatch,
+                                               .node = chpl_nodeID,
+                                               .pAmDone = NULL, },
+                                        .numReqs = slot->numReqs,
+                                        .size = slot->used, };
+  if (si == info->amoSlot) {
+    info->amDone = 0;
+    chpl_atomic_thread_fence(memory_order_release);
+    batch->b.pAmDone = &info->amDone;
+    info->amDonePending = true;
+    info->amoSlot = -1;
+  }
+
+  DBG_PRINTF(DBG_AM | DBG_AM_SEND,
+             "flush AM batch to %d: %" PRIu32 " reqs, %zd bytes",
+             (int) slot->node, slot->numReqs, slot->used);
+  amRequestCommon(slot->node, (amRequest_t*) batch, slot->used,
+                  NULL, false /*yieldDuringTxnWait*/, tcip);
+
+  slot->node = -1;
+  slot->numReqs = 0;
+  slot->used = AM_BATCH_HDR_SIZE;
+  (void) atomic_fetch_sub_int_least32_t(&amBuffNumPending, 1);
+}
+
+
+//
+// Wait until the last AMO batch we sent is done.  The caller holds the
+// info lock.  We don't hold it while we yield, so the AM handler can
+// still time out our other slots meanwhile.
+//
+static
+void am_buff_wait_done(am_buff_task_info_t* info) {
+  while (info->amDonePending) {
+    if (*(volatile amDone_t*) &info->amDone) {
+      info->amDonePending = false;
+    } else {
+      PTHREAD_CHK(pthread_mutex_unlock(&info->lock));
+      local_yield();
+      PTHREAD_CHK(pthread_mutex_lock(&info->lock));
+    }
+  }
+}
+
+
+//
+// Add a request to the calling task's batch for the given node.  This
+// returns false, having done nothing, if the request can't be
+// coalesced and should be sent in the ordinary way.
+//
+static
+chpl_bool am_buff_add(c_nodeid_t node, amRequest_t* req, size_t reqSize,
+                      chpl_bool isAmo) {
+  chpl_comm_taskPrvData_t* prvData;
+  if (!envAmCoalesce
+      || isAmHandler
+      || (prvData = get_comm_taskPrvdata()) == NULL
+      || prvData->taskIsEnding) {
+    return false;
+  }
+
+  const size_t entrySize = AM_BATCH_ENTRY_SIZE(reqSize);
+  if (AM_BATCH_HDR_SIZE + entrySize > envAmCoalesceSize) {
+    return false;
+  }
+
+  am_buff_task_info_t* info = am_buff_acquire(prvData);
+
+  //
+  // Retire any delayed-blocking AM done outside of coalescing, and make
+  // the effects of our prior PUTs and AMOs visible.  Both executeOns
+  // and non-fetching AMOs require that.
+  //
+  if (prvData->amDonePending) {
+    amWaitForDone((amDone_t*) &prvData->amDone);
+    prvData->amDonePending = false;
+  }
+  forceMemFxVisAllNodes_noTcip(true /*checkPuts*/, true /*checkAmos*/);
+
+#ifdef CHPL_COMM_DEBUG
+  am_debugPrep(req);
+#endif
+
+  const int si = node % AM_BUFF_NUM_SLOTS;
+  am_buff_slot_t* slot = &info->slots[si];
+
+  PTHREAD_CHK(pthread_mutex_lock(&info->lock));
+
+  while (true) {
+    if (info->amoSlot >= 0 && info->slots[info->amoSlot].node != node) {
+      // AMOs for some other node must be done before this request
+      am_buff_flush_slot(info, info->amoSlot, NULL);
+    } else if (info->amDonePending) {
+      am_buff_wait_done(info);
+    } else if (slot->numReqs > 0
+               && (slot->node != node
+                   || slot->used + entrySize > envAmCoalesceSize)) {
+      am_buff_flush_slot(info, si, NULL);
+    } else {
+      break;
+    }
+  }
+
+  if (slot->numReqs == 0) {
+    slot->node = node;
+    slot->firstTime = chpl_comm_ofi_time_get();
+    (void) atomic_fetch_add_int_least32_t(&amBuffNumPending, 1);
+  }
+  *(uint64_t*) (slot->buf + slot->used) = reqSize;
+  memcpy(slot->buf + slot->used + sizeof(uint64_t), req, reqSize);
+  slot->used += entrySize;
+  slot->numReqs++;
+  if (isAmo) {
+    info->amoSlot = si;
+  }
+
+  DBG_PRINTF(DBG_AM | DBG_AM_SEND,
+             "coalesce AM to %d (%" PRIu32 " in batch): %s",
+             (int) node, slot->numReqs, am_reqStr(node, req, reqSize));
+
+  PTHREAD_CHK(pthread_mutex_unlock(&info->lock));
+  return true;
+}
+
+
+//
+// Send all of the calling task's batches.  If 'wait' is true, also
+// wait for any AMOs in them to be done.
+//
+static
+void am_buff_flush(chpl_comm_taskPrvData_t* prvData, chpl_bool wait) {
+  am_buff_task_info_t* info;
+  if (prvData == NULL || (info = prvData->am_buff) == NULL) {
+    return;
+  }
+
+  PTHREAD_CHK(pthread_mutex_lock(&info->lock));
+  for (int i = 0; i < AM_BUFF_NUM_SLOTS; i++) {
+    am_buff_flush_slot(info, i, NULL);
+  }
+  if (wait) {
+    am_buff_wait_done(info);
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&info->lock));
+}
+
+
+//
+// Before an operation with MCM implications, send the batch holding
+// AMOs, if any, and wait for it to be done.  Batches holding only
+// executeOns don't need to go yet.
+//
+static
+void am_buff_retire(chpl_comm_taskPrvData_t* prvData) {
+  am_buff_task_info_t* info = prvData->am_buff;
+  if (info == NULL) {
+    return;
+  }
+
+  PTHREAD_CHK(pthread_mutex_lock(&info->lock));
+  if (info->amoSlot >= 0) {
+    am_buff_flush_slot(info, info->amoSlot, NULL);
+  }
+  am_buff_wait_done(info);
+  PTHREAD_CHK(pthread_mutex_unlock(&info->lock));
+}
+
+
+//
+// The task is ending.  Send everything, then tear down its buffers.
+//
+static
+void am_buff_task_end(chpl_comm_taskPrvData_t* prvData) {
+  am_buff_task_info_t* info;
+  if (prvData == NULL || (info = prvData->am_buff) == NULL) {
+    return;
+  }
+
+  am_buff_flush(prvData, true /*wait*/);
+
+  PTHREAD_CHK(pthread_mutex_lock(&amBuffListLock));
+  if (info->prev == NULL) {
+    amBuffList = info->next;
+  } else {
+    info->prev->next = info->next;
+  }
+  if (info->next != NULL) {
+    info->next->prev = info->prev;
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&amBuffListLock));
+
+  PTHREAD_CHK(pthread_mutex_destroy(&info->lock));
+  CHPL_FREE(info);
+  prvData->am_buff = NULL;
+}
+
+
+//
+// The AM handler calls this to send batches that have waited too long.
+// It skips tasks that are busy with their buffers right now; it will
+// get them next time.
+//
+static
+void am_buff_flush_timed_out(struct perTxCtxInfo_t* tcip) {
+  static __thread double lastCheck = 0.0;
+
+  if (atomic_load_int_least32_t(&amBuffNumPending) == 0) {
+    return;
+  }
+
+  double now = chpl_comm_ofi_time_get();
+  if (now - lastCheck < envAmCoalesceTimeout / 2) {
+    return;
+  }
+  lastCheck = now;
+
+  PTHREAD_CHK(pthread_mutex_lock(&amBuffListLock));
+  for (am_buff_task_info_t* info = amBuffList;
+       info != NULL;
+       info = info->next) {
+    if (pthread_mutex_trylock(&info->lock) != 0) {
+      continue;
+    }
+    for (int i = 0; i < AM_BUFF_NUM_SLOTS; i++) {
+      if (info->slots[i].numReqs > 0
+          && now - info->slots[i].firstTime >= envAmCoalesceTimeout) {
+        am_buff_flush_slot(info, i, tcip);
+      }
+    }
+    PTHREAD_CHK(pthread_mutex_unlock(&info->lock));
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&amBuffListLock));
+}
+
 
 typedef void (amReqFn_t)(c_nodeid_t node,
                          amRequest_t* req, size_t reqSize, void* mrDesc,
@@ -3795,17 +4378,31 @@ void amReqFn_msgOrdFence(c_nodeid_t node,
     }
     break;
   case am_opGet:
+  case am_opGetStrd:
     havePutsOut = (tcip->putVisBitmap != NULL
                    && bitmapTest(tcip->putVisBitmap, node));
     haveAmosOut = (tcip->amoVisBitmap != NULL
                    && bitmapTest(tcip->amoVisBitmap, node));
     break;
   case am_opPut:
+  case am_opPutStrd:
     haveAmosOut = (tcip->amoVisBitmap != NULL
                    && bitmapTest(tcip->amoVisBitmap, node));
     break;
   }
 
+  if ((havePutsOut || haveAmosOut) && amRxIdx(tcip) != 0) {
+    //
+    // A fence only orders this send after prior operations that went
+    // to the same endpoint.  Our PUTs and AMOs went to the target's
+    // RMA endpoint but this request is going to one of its other AM
+    // handlers, so force their visibility explicitly instead.
+    //
+    forceMemFxVisOneNode(node, havePutsOut, haveAmosOut, tcip);
+    havePutsOut = false;
+    haveAmosOut = false;
+  }
+
   if (havePutsOut || haveAmosOut) {
     //
     // Special case: Do a fenced send if we need it for ordering with
@@ -3875,9 +4472,11 @@ void amReqFn_msgOrd(c_nodeid_t node,
     }
     break;
   case am_opGet:
+  case am_opGetStrd:
     forceMemFxVisOneNode(node, true /*checkPuts*/, true /*checkAmos*/, tcip);
     break;
   case am_opPut:
+  case am_opPutStrd:
     forceMemFxVisOneNode(node, false /*checkPuts*/, true /*checkAmos*/, tcip);
     break;
   }
@@ -3934,7 +4533,7 @@ ssize_t wrap_fi_send(c_nodeid_t node,
   }
   OFI_RIDE_OUT_EAGAIN(tcip,
                       fi_send(tcip->txCtx, req, reqSize, mrDesc,
-                              rxAddr(node), ctx));
+                              amRxAddr(node, tcip), ctx));
   tcip->numTxnsOut++;
   tcip->numTxnsSent++;
   return FI_SUCCESS;
@@ -3953,7 +4552,7 @@ ssize_t wrap_fi_inject(c_nodeid_t node,
   // TODO: How quickly/often does local resource throttling happen?
   OFI_RIDE_OUT_EAGAIN(tcip,
                       fi_inject(tcip->txCtx, req, reqSize,
-                                rxAddr(node)));
+                                amRxAddr(node, tcip)));
   tcip->numTxnsSent++;
   return FI_SUCCESS;
 }
@@ -3969,7 +4568,7 @@ ssize_t wrap_fi_sendmsg(c_nodeid_t node,
   const struct fi_msg msg = { .msg_iov = &msg_iov,
                               .desc = mrDesc,
                               .iov_count = 1,
-                              .addr = rxAddr(node),
+                              .addr = amRxAddr(node, tcip),
                               .context = ctx };
   if (DBG_TEST_MASK(DBG_AM | DBG_AM_SEND)
       || (req->b.op == am_opAMO && DBG_TEST_MASK(DBG_AMO))) {
@@ -4039,6 +4638,7 @@ void retireDelayedAmDone(chpl_bool taskIsEnding) {
   //
   chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
   if (prvData != NULL) {
+    am_buff_retire(prvData);
     if (prvData->amDonePending) {
       amWaitForDone((amDone_t*) &prvData->amDone);
       prvData->amDonePending = false;
@@ -4060,13 +4660,17 @@ static pthread_cond_t amStartStopCond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t amStartStopMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static void amHandler(void*);
-static void processRxAmReq(struct perTxCtxInfo_t*);
+static void processRxAmReq(struct amHandlerInfo_t*);
+static void amHandleReq(amRequest_t*);
+static void amHandleBatch(struct amRequest_batch_t*);
 static void amHandleExecOn(chpl_comm_on_bundle_t*);
 static void amWrapExecOnBody(void*);
 static void amHandleExecOnLrg(chpl_comm_on_bundle_t*);
 static void amWrapExecOnLrgBody(struct amRequest_execOnLrg_t*);
 static void amWrapGet(struct taskArg_RMA_t*);
 static void amWrapPut(struct taskArg_RMA_t*);
+static void amWrapGetStrd(struct taskArg_strd_t*);
+static void amWrapPutStrd(struct taskArg_strd_t*);
 static void amHandleAMO(struct amRequest_AMO_t*);
 static void amPutDone(c_nodeid_t, amDone_t*);
 static void amCheckLiveness(void);
@@ -4090,10 +4694,11 @@ void init_amHandling(void) {
   // least one is running.
   //
   atomic_init_bool(&amHandlersExit, false);
+  atomic_init_int_least32_t(&amBuffNumPending, 0);
 
   PTHREAD_CHK(pthread_mutex_lock(&amStartStopMutex));
   for (int i = 0; i < numAmHandlers; i++) {
-    CHK_TRUE(chpl_task_createCommTask(amHandler, NULL) == 0);
+    CHK_TRUE(chpl_task_createCommTask(amHandler, &amhTab[i]) == 0);
   }
   PTHREAD_CHK(pthread_cond_wait(&amStartStopCond, &amStartStopMutex));
   PTHREAD_CHK(pthread_mutex_unlock(&amStartStopMutex));
@@ -4119,19 +4724,21 @@ void fini_amHandling(void) {
 
 
 //
-// The AM handler runs this.
+// The AM handlers run this.  The argument is the handler's info.
 //
 static __thread struct perTxCtxInfo_t* amTcip;
 
 static
-void amHandler(void* argNil) {
+void amHandler(void* arg) {
+  struct amHandlerInfo_t* amh = (struct amHandlerInfo_t*) arg;
+  amhInfo = amh;
+  isAmHandler = true;
+
   struct perTxCtxInfo_t* tcip;
   CHK_TRUE((tcip = tciAllocForAmHandler()) != NULL);
   amTcip = tcip;
 
-  isAmHandler = true;
-
-  DBG_PRINTF(DBG_AM, "AM handler running");
+  DBG_PRINTF(DBG_AM, "AM handler %d running", amh->id);
 
   //
   // Count this AM handler thread as running.  The creator thread
@@ -4150,17 +4757,25 @@ void amHandler(void* argNil) {
     chpl_bool hadRxEvent, hadTxEvent;
     amCheckRxTxCmpls(&hadRxEvent, &hadTxEvent, tcip);
     if (hadRxEvent) {
-      processRxAmReq(tcip);
+      processRxAmReq(amh);
     } else if (!hadTxEvent) {
       //
-      // No activity; avoid CPU monopolization.
+      // No activity; avoid CPU monopolization.  Don't wait long if
+      // some task has coalesced AM requests that may time out.
       //
       int ret;
-      OFI_CHK_3(fi_wait(ofi_amhWaitSet, 100 /*ms*/), ret,
+      int ms = (envAmCoalesce
+                && atomic_load_int_least32_t(&amBuffNumPending) > 0)
+               ? 1 : 100;
+      OFI_CHK_3(fi_wait(amh->waitSet, ms), ret,
                 -FI_EINTR, -FI_ETIMEDOUT);
     }
 
-    if (amDoLivenessChecks) {
+    if (envAmCoalesce) {
+      am_buff_flush_timed_out(tcip);
+    }
+
+    if (amDoLivenessChecks && amh->id == 0) {
       amCheckLiveness();
     }
   }
@@ -4175,23 +4790,23 @@ void amHandler(void* argNil) {
     PTHREAD_CHK(pthread_cond_signal(&amStartStopCond));
   PTHREAD_CHK(pthread_mutex_unlock(&amStartStopMutex));
 
-  DBG_PRINTF(DBG_AM, "AM handler done");
+  DBG_PRINTF(DBG_AM, "AM handler %d done", amh->id);
 }
 
 
 static
-void processRxAmReq(struct perTxCtxInfo_t* tcip) {
+void processRxAmReq(struct amHandlerInfo_t* amh) {
   //
-  // Process requests received on the AM request endpoint.
+  // Process requests received on this AM handler's request endpoint.
   //
   struct fi_cq_data_entry cqes[5];
   const size_t maxEvents = sizeof(cqes) / sizeof(cqes[0]);
   ssize_t ret;
-  CHK_TRUE((ret = fi_cq_read(ofi_rxCQ, cqes, maxEvents)) > 0
+  CHK_TRUE((ret = fi_cq_read(amh->rxCQ, cqes, maxEvents)) > 0
            || ret == -FI_EAGAIN
            || ret == -FI_EAVAIL);
   if (ret == -FI_EAVAIL) {
-    reportCQError(ofi_rxCQ);
+    reportCQError(amh->rxCQ);
   }
 
   const size_t numEvents = (ret == -FI_EAGAIN) ? 0 : ret;
@@ -4204,82 +4819,136 @@ void processRxAmReq(struct perTxCtxInfo_t* tcip) {
       amRequest_t* req = (amRequest_t*) cqes[i].buf;
       DBG_PRINTF(DBG_AM_BUF,
                  "CQ rx AM req @ buffer offset %zd, sz %zd, seqId %s",
-                 (char*) req - (char*) ofi_iov_reqs[ofi_msg_i].iov_base,
+                 (char*) req - (char*) amh->iov_reqs[amh->msg_i].iov_base,
                  cqes[i].len, am_seqIdStr(req));
       DBG_PRINTF(DBG_AM | DBG_AM_RECV,
                  "rx AM req: %s",
                  am_reqStr(chpl_nodeID, req, cqes[i].len));
-      switch (req->b.op) {
-      case am_opExecOn:
-        if (req->xo.hdr.comm.fast) {
-          amWrapExecOnBody(&req->xo.hdr);
-        } else {
-          amHandleExecOn(&req->xo.hdr);
-        }
-        break;
+      amHandleReq(req);
+    }
 
-      case am_opExecOnLrg:
-        amHandleExecOnLrg(&req->xol.hdr);
-        break;
+    if ((cqes[i].flags & FI_MULTI_RECV) != 0) {
+      //
+      // Multi-receive buffer filled; post the other one.
+      //
+      amh->msg_i = 1 - amh->msg_i;
+      OFI_CHK(fi_recvmsg(amh->rxEp, &amh->msg_reqs[amh->msg_i],
+                         FI_MULTI_RECV));
+      DBG_PRINTF(DBG_AM_BUF,
+                 "re-post fi_recvmsg(AMLZs[%d] %p, len %#zx)",
+                 amh->id,
+                 amh->msg_reqs[amh->msg_i].msg_iov->iov_base,
+                 amh->msg_reqs[amh->msg_i].msg_iov->iov_len);
+    }
 
-      case am_opGet:
-        {
-          struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
-                                       .rma = req->rma, };
-          chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapGet,
-                                   &arg, sizeof(arg), c_sublocid_any,
-                                   chpl_nullTaskID);
-        }
-        break;
+    CHK_TRUE((cqes[i].flags & ~(FI_MSG | FI_RECV | FI_MULTI_RECV)) == 0);
+  }
+}
 
-      case am_opPut:
-        {
-          struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
-                                       .rma = req->rma, };
-          chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapPut,
-                                   &arg, sizeof(arg), c_sublocid_any,
-                                   chpl_nullTaskID);
-        }
-        break;
 
-      case am_opAMO:
-        amHandleAMO(&req->amo);
-        break;
+static
+void amHandleReq(amRequest_t* req) {
+  switch (req->b.op) {
+  case am_opExecOn:
+    if (req->xo.hdr.comm.fast) {
+      amWrapExecOnBody(&req->xo.hdr);
+    } else {
+      amHandleExecOn(&req->xo.hdr);
+    }
+    break;
 
-      case am_opFree:
-        CHPL_FREE(req->free.p);
-        break;
+  case am_opExecOnLrg:
+    amHandleExecOnLrg(&req->xol.hdr);
+    break;
 
-      case am_opNop:
-        DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr(req));
-        if (req->b.pAmDone != NULL) {
-          amPutDone(req->b.node, req->b.pAmDone);
-        }
-        break;
+  case am_opGet:
+    {
+      struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                   .rma = req->rma, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapGet,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
+    }
+    break;
 
-      case am_opShutdown:
-        chpl_signal_shutdown();
-        break;
+  case am_opPut:
+    {
+      struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                   .rma = req->rma, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapPut,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
+    }
+    break;
 
-      default:
-        INTERNAL_ERROR_V("unexpected AM op %d", (int) req->b.op);
-        break;
-      }
+  case am_opGetStrd:
+    {
+      struct taskArg_strd_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                    .strd = req->strd, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapGetStrd,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
     }
+    break;
 
-    if ((cqes[i].flags & FI_MULTI_RECV) != 0) {
-      //
-      // Multi-receive buffer filled; post the other one.
-      //
-      ofi_msg_i = 1 - ofi_msg_i;
-      OFI_CHK(fi_recvmsg(ofi_rxEp, &ofi_msg_reqs[ofi_msg_i], FI_MULTI_RECV));
-      DBG_PRINTF(DBG_AM_BUF,
-                 "re-post fi_recvmsg(AMLZs %p, len %#zx)",
-                 ofi_msg_reqs[ofi_msg_i].msg_iov->iov_base,
-                 ofi_msg_reqs[ofi_msg_i].msg_iov->iov_len);
+  case am_opPutStrd:
+    {
+      struct taskArg_strd_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                    .strd = req->strd, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapPutStrd,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
     }
+    break;
 
-    CHK_TRUE((cqes[i].flags & ~(FI_MSG | FI_RECV | FI_MULTI_RECV)) == 0);
+  case am_opAMO:
+    amHandleAMO(&req->amo);
+    break;
+
+  case am_opFree:
+    CHPL_FREE(req->free.p);
+    break;
+
+  case am_opNop:
+    DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr(req));
+    if (req->b.pAmDone != NULL) {
+      amPutDone(req->b.node, req->b.pAmDone);
+    }
+    break;
+
+  case am_opShutdown:
+    chpl_signal_shutdown();
+    break;
+
+  case am_opBatch:
+    amHandleBatch(&req->batch);
+    break;
+
+  default:
+    INTERNAL_ERROR_V("unexpected AM op %d", (int) req->b.op);
+    break;
+  }
+}
+
+
+static
+void amHandleBatch(struct amRequest_batch_t* batch) {
+  char* p = (char*) batch + AM_BATCH_HDR_SIZE;
+  for (uint32_t i = 0; i < batch->numReqs; i++) {
+    size_t reqSize = *(uint64_t*) p;
+    amRequest_t* req = (amRequest_t*) (p + sizeof(uint64_t));
+    DBG_PRINTF(DBG_AM | DBG_AM_RECV,
+               "rx AM req %" PRIu32 " of %" PRIu32 " in batch: %s",
+               i + 1, batch->numReqs,
+               am_reqStr(chpl_nodeID, req, reqSize));
+    CHK_TRUE(req->b.op != am_opBatch);
+    amHandleReq(req);
+    p += AM_BATCH_ENTRY_SIZE(reqSize);
+  }
+  CHK_TRUE(p - (char*) batch == batch->size);
+
+  if (batch->b.pAmDone != NULL) {
+    amPutDone(batch->b.node, batch->b.pAmDone);
   }
 }
 
@@ -4402,6 +5071,45 @@ void amWrapPut(struct taskArg_RMA_t* tsk_rma) {
 }
 
 
+static
+void amWrapGetStrd(struct taskArg_strd_t* tsk_strd) {
+  struct amRequest_strd_t* strd = &tsk_strd->strd;
+  DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqStartStr((amRequest_t*) strd));
+
+  CHK_TRUE(mrGetKey(NULL, NULL, strd->b.node, strd->raddr, strd->size));
+  void* buf = allocBounceBuf(strd->size);
+  (void) ofi_get(buf, strd->b.node, strd->raddr, strd->size);
+  strd_unpack(strd->addr, strd->strides, buf,
+              strd->count, strd->stridelevels, strd->elemSize);
+  freeBounceBuf(buf);
+
+  DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr((amRequest_t*) strd));
+  amPutDone(strd->b.node, strd->b.pAmDone);
+}
+
+
+static
+void amWrapPutStrd(struct taskArg_strd_t* tsk_strd) {
+  struct amRequest_strd_t* strd = &tsk_strd->strd;
+  DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqStartStr((amRequest_t*) strd));
+
+  CHK_TRUE(mrGetKey(NULL, NULL, strd->b.node, strd->raddr, strd->size));
+  void* buf = allocBounceBuf(strd->size);
+  strd_pack(buf, strd->addr, strd->strides,
+            strd->count, strd->stridelevels, strd->elemSize);
+  (void) ofi_put(buf, strd->b.node, strd->raddr, strd->size);
+  freeBounceBuf(buf);
+
+  //
+  // Note: the RMA bytes must be visible in target memory before the
+  // 'done' indicator is.
+  //
+
+  DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr((amRequest_t*) strd));
+  amPutDone(strd->b.node, strd->b.pAmDone);
+}
+
+
 static
 void amHandleAMO(struct amRequest_AMO_t* amo) {
   DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqStartStr((amRequest_t*) amo));
@@ -4655,6 +5363,29 @@ void chpl_comm_get(void* addr, int32_t node, void* raddr,
 }
 
 
+//
+// Without packing, each contiguous run of a strided transfer is done
+// as a separate blocking GET or PUT.  Packing instead costs an AM round
+// trip, a task on the target, a single RMA, and a copy on each side.
+// That is cheaper once there are a few runs, as long as they are small
+// enough that the copies don't dominate.  Very large transfers aren't
+// packed, to limit the size of the buffers.
+//
+#define STRD_PACK_MAX_RUN_SIZE ((size_t) 8 << 10)
+#define STRD_PACK_MIN_RUNS     4
+#define STRD_PACK_MAX_SIZE     ((size_t) 16 << 20)
+
+static inline
+chpl_bool strdUsePacking(c_nodeid_t node, size_t* count,
+                         int32_t stridelevels, size_t elemSize) {
+  return (node != chpl_nodeID
+          && stridelevels <= AM_STRD_MAX_LEVELS
+          && strd_should_pack(count, stridelevels, elemSize,
+                              STRD_PACK_MAX_RUN_SIZE, STRD_PACK_MIN_RUNS,
+                              STRD_PACK_MAX_SIZE));
+}
+
+
 void chpl_comm_put_strd(void* dstaddr_arg, size_t* dststrides,
                         c_nodeid_t dstnode,
                         void* srcaddr_arg, size_t* srcstrides,
@@ -4665,6 +5396,26 @@ void chpl_comm_put_strd(void* dstaddr_arg, size_t* dststrides,
              dstaddr_arg, dststrides, (int) dstnode, srcaddr_arg, srcstrides,
              count, (int) stridelevels, elemSize, (int) commID);
 
+  if (strdUsePacking(dstnode, count, stridelevels, elemSize)) {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put_strd)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_put_strd, chpl_nodeID, dstnode,
+         .iu.comm_strd={srcaddr_arg, srcstrides, dstaddr_arg, dststrides,
+                        count, stridelevels, elemSize, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    size_t size = strd_num_runs(count, stridelevels) * count[0] * elemSize;
+    chpl_comm_diags_verbose_rdma("put", dstnode, size, ln, fn, commID);
+    chpl_comm_diags_incr(put);
+
+    amRequestStrdPut(dstnode, dstaddr_arg, dststrides,
+                     srcaddr_arg, srcstrides,
+                     count, stridelevels, elemSize);
+    return;
+  }
+
   put_strd_common(dstaddr_arg, dststrides,
                   dstnode,
                   srcaddr_arg, srcstrides,
@@ -4684,6 +5435,26 @@ void chpl_comm_get_strd(void* dstaddr_arg, size_t* dststrides,
              dstaddr_arg, dststrides, (int) srcnode, srcaddr_arg, srcstrides,
              count, (int) stridelevels, elemSize, (int) commID);
 
+  if (strdUsePacking(srcnode, count, stridelevels, elemSize)) {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get_strd)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_get_strd, chpl_nodeID, srcnode,
+         .iu.comm_strd={srcaddr_arg, srcstrides, dstaddr_arg, dststrides,
+                        count, stridelevels, elemSize, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    size_t size = strd_num_runs(count, stridelevels) * count[0] * elemSize;
+    chpl_comm_diags_verbose_rdma("get", srcnode, size, ln, fn, commID);
+    chpl_comm_diags_incr(get);
+
+    amRequestStrdGet(srcnode, srcaddr_arg, srcstrides,
+                     dstaddr_arg, dststrides,
+                     count, stridelevels, elemSize);
+    return;
+  }
+
   get_strd_common(dstaddr_arg, dststrides,
                   srcnode,
                   srcaddr_arg, srcstrides,
@@ -4818,6 +5589,94 @@ void chpl_comm_getput_unordered_task_fence(void) {
 }
 
 
+//
+// The aggregated ops share the task-local GET and PUT buffers with the
+// unordered ops.  Those are already flushed at task end, so all we need
+// in addition is the explicit flush.
+//
+void chpl_comm_get_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn) {
+  DBG_PRINTF(DBG_IFACE,
+             "%s(%p, %d, %p, %zd, %d)", __func__,
+             addr, (int) node, raddr, size, (int) commID);
+
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
+  //
+  // Sanity checks, self-communication.
+  //
+  CHK_TRUE(addr != NULL);
+  CHK_TRUE(raddr != NULL);
+
+  if (size == 0) {
+    return;
+  }
+
+  if (node == chpl_nodeID) {
+    memmove(addr, raddr, size);
+    return;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_get, chpl_nodeID, node,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("aggregated get", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(get);
+
+  do_remote_get_buff(addr, node, raddr, size);
+}
+
+
+void chpl_comm_put_aggregated(void* addr, c_nodeid_t node, void* raddr,
+                              size_t size, int32_t commID, int ln, int32_t fn) {
+  DBG_PRINTF(DBG_IFACE,
+             "%s(%p, %d, %p, %zd, %d)", __func__,
+             addr, (int) node, raddr, size, (int) commID);
+
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
+  //
+  // Sanity checks, self-communication.
+  //
+  CHK_TRUE(addr != NULL);
+  CHK_TRUE(raddr != NULL);
+
+  if (size == 0) {
+    return;
+  }
+
+  if (node == chpl_nodeID) {
+    memmove(raddr, addr, size);
+    return;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_put, chpl_nodeID, node,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("aggregated put", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(put);
+
+  do_remote_put_buff(addr, node, raddr, size);
+}
+
+
+void chpl_comm_aggregated_flush(void) {
+  DBG_PRINTF(DBG_IFACE_MCM, "%s()", __func__);
+
+  task_local_buff_flush(get_buff | put_buff);
+}
+
+
 ////////////////////////////////////////
 //
 // Internal communication support
@@ -4891,11 +5750,11 @@ struct perTxCtxInfo_t* findFreeTciTabEntry(chpl_bool bindToAmHandler) {
 
   if (bindToAmHandler) {
     //
-    // AM handlers use tciTab[numWorkerTxCtxs .. tciTabLen - 1].  For
-    // now we only support a single AM handler, so this is simple.  If
-    // we ever have more, the CHK_FALSE will force us to revisit this.
+    // AM handlers use tciTab[numWorkerTxCtxs .. tciTabLen - 1], in
+    // order, because each of those tx contexts' completions go to the
+    // corresponding handler's wait set.
     //
-    tcip = &tciTab[numWorkerTxCtxs];
+    tcip = &tciTab[numWorkerTxCtxs + amhInfo->id];
     CHK_TRUE(tciAllocTabEntry(tcip));
     return tcip;
   }
@@ -6236,10 +7095,11 @@ void amEnsureProgress(struct perTxCtxInfo_t* tcip) {
 static
 void amCheckRxTxCmpls(chpl_bool* pHadRxEvent, chpl_bool* pHadTxEvent,
                       struct perTxCtxInfo_t* tcip) {
-  if (ofi_amhPollSet != NULL) {
+  struct amHandlerInfo_t* amh = amhInfo;
+  if (amh->pollSet != NULL) {
     void* contexts[pollSetSize];
     int ret;
-    OFI_CHK_COUNT(fi_poll(ofi_amhPollSet, contexts, pollSetSize), ret);
+    OFI_CHK_COUNT(fi_poll(amh->pollSet, contexts, pollSetSize), ret);
 
     //
     // Process the CQs/counters that had events.  We really only have
@@ -6250,7 +7110,7 @@ void amCheckRxTxCmpls(chpl_bool* pHadRxEvent, chpl_bool* pHadTxEvent,
     // have done that.
     //
     for (int i = 0; i < ret; i++) {
-      if (contexts[i] == &ofi_rxCQ) {
+      if (contexts[i] == &amh->rxCQ) {
         if (pHadRxEvent != NULL) {
           *pHadRxEvent = true;
         }
@@ -6815,12 +7675,36 @@ void doAMO(c_nodeid_t node, void* object,
     return;
   }
 
-  retireDelayedAmDone(false /*taskIsEnding*/);
-
   uint64_t mrKey;
   uint64_t mrRaddr;
-  if (!isAtomicValid(ofiType)
-      || !mrGetKey(&mrKey, &mrRaddr, node, object, size)) {
+  chpl_bool amoViaAm = (!isAtomicValid(ofiType)
+                        || !mrGetKey(&mrKey, &mrRaddr, node, object, size));
+
+  //
+  // A non-fetching AMO that has to be done via AM can go in a batch
+  // with others.
+  //
+  if (amoViaAm && node != chpl_nodeID && result == NULL && cmpr == NULL
+      && envAmCoalesce) {
+    amRequest_t req = { .amo = { .b = { .op = am_opAMO,
+                                        .node = chpl_nodeID,
+                                        .pAmDone = NULL, },
+                                 .ofiOp = ofiOp,
+                                 .ofiType = ofiType,
+                                 .size = size,
+                                 .obj = object,
+                                 .result = NULL, }, };
+    if (opnd != NULL) {
+      memcpy(&req.amo.opnd, opnd, size);
+    }
+    if (am_buff_add(node, &req, sizeof(req.amo), true /*isAmo*/)) {
+      return;
+    }
+  }
+
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
+  if (amoViaAm) {
     //
     // We can't do the AMO on the network, so do it on the CPU.  If the
     // object is on this node do it directly; otherwise, use an AM.
@@ -7534,10 +8418,13 @@ const char* am_opName(amOp_t op) {
   case am_opExecOnLrg: return "opExecOnLrg";
   case am_opGet: return "opGet";
   case am_opPut: return "opPut";
+  case am_opGetStrd: return "opGetStrd";
+  case am_opPutStrd: return "opPutStrd";
   case am_opAMO: return "opAMO";
   case am_opFree: return "opFree";
   case am_opNop: return "opNop";
   case am_opShutdown: return "opShutdown";
+  case am_opBatch: return "opBatch";
   default: return "op???";
   }
 }
@@ -7620,6 +8507,21 @@ const char* am_reqStr(c_nodeid_t tgtNode, amRequest_t* req, size_t reqSize) {
                     req->rma.b.node, req->rma.raddr, req->rma.size);
     break;
 
+  case am_opGetStrd:
+    len += snprintf(buf + len, sizeof(buf) - len,
+                    ", %d:%p <- %d:%p, sz %zd, lvls %d",
+                    (int) tgtNode, req->strd.addr,
+                    req->strd.b.node, req->strd.raddr,
+                    req->strd.size, (int) req->strd.stridelevels);
+    break;
+  case am_opPutStrd:
+    len += snprintf(buf + len, sizeof(buf) - len,
+                    ", %d:%p -> %d:%p, sz %zd, lvls %d",
+                    (int) tgtNode, req->strd.addr,
+                    req->strd.b.node, req->strd.raddr,
+                    req->strd.size, (int) req->strd.stridelevels);
+    break;
+
   case am_opAMO:
     if (req->amo.ofiOp == FI_CSWAP) {
       len += snprintf(buf + len, sizeof(buf) - len,
@@ -7663,6 +8565,11 @@ const char* am_reqStr(c_nodeid_t tgtNode, amRequest_t* req, size_t reqSize) {
                     req->free.p);
     break;
 
+  case am_opBatch:
+    len += snprintf(buf + len, sizeof(buf) - len, ", %" PRIu32 " reqs",
+                    req->batch.numReqs);
+    break;
+
   default:
     break;
   }
@@ -2659,12 +2659,73 @@ error:
 }
 
 
+// Store a scanned integer of byte size len into out, returning ERANGE
+// if it does not fit.
+static
+qioerr _store_scanned_int(void* restrict out, size_t len, int issigned, int sign, unsigned long long int num)
+{
+  long long int signed_num;
+  ssize_t signed_len;
+  qioerr err = 0;
+
+  signed_len = len;
+  if( issigned ) signed_len = - signed_len;
+
+  signed_num = num;
+  if( sign < 0 ) signed_num = - num;
+
+  switch( signed_len ) {
+    case -1:
+      *(int8_t*) out = signed_num;
+      if( signed_num > INT8_MAX || signed_num < INT8_MIN )
+        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case 1:
+      *(uint8_t*) out = num;
+      if( num > UINT8_MAX )
+        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case -2:
+      *(int16_t*) out = signed_num;
+      if( signed_num > INT16_MAX || signed_num < INT16_MIN )
+        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case 2:
+      *(uint16_t*) out = num;
+      if( num > UINT16_MAX )
+        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case -4:
+      *(int32_t*) out = signed_num;
+      if( signed_num > INT32_MAX || signed_num < INT32_MIN )
+        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case 4:
+      *(uint32_t*) out = num;
+      if( num > UINT32_MAX )
+        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case -8:
+      *(int64_t*) out = signed_num;
+      //if( signed_num > INT64_MAX || signed_num < INT64_MIN )
+      //  QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    case 8:
+      *(uint64_t*) out = num;
+      //if( num > UINT64_MAX )
+      //  QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
+      break;
+    default:
+      QIO_GET_CONSTANT_ERROR(err, EINVAL, "bad integer type");
+  }
+
+  return err;
+}
+
 qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned)
 {
   unsigned long long int num = 0;
-  long long int signed_num;
   int sign = 1;
-  ssize_t signed_len;
   number_reading_state_t st;
   int64_t amount;
   int64_t start;
@@ -2753,55 +2814,9 @@ error:
   if( err != 0 ) num = 0;
 
   // now return the number.
-  signed_len = len;
-  if( issigned ) signed_len = - signed_len;
-
-  signed_num = num;
-  if( sign < 0 ) signed_num = - num;
-
-  switch( signed_len ) {
-    case -1:
-      *(int8_t*) out = signed_num;
-      if( signed_num > INT8_MAX || signed_num < INT8_MIN )
-        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case 1:
-      *(uint8_t*) out = num;
-      if( num > UINT8_MAX )
-        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case -2:
-      *(int16_t*) out = signed_num;
-      if( signed_num > INT16_MAX || signed_num < INT16_MIN )
-        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case 2:
-      *(uint16_t*) out = num;
-      if( num > UINT16_MAX )
-        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case -4:
-      *(int32_t*) out = signed_num;
-      if( signed_num > INT32_MAX || signed_num < INT32_MIN )
-        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case 4:
-      *(uint32_t*) out = num;
-      if( num > UINT32_MAX )
-        QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case -8:
-      *(int64_t*) out = signed_num;
-      //if( signed_num > INT64_MAX || signed_num < INT64_MIN )
-      //  QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    case 8:
-      *(uint64_t*) out = num;
-      //if( num > UINT64_MAX )
-      //  QIO_GET_CONSTANT_ERROR(err, ERANGE, "read out of bounds integer");
-      break;
-    default:
-      QIO_GET_CONSTANT_ERROR(err, EINVAL, "bad integer type");
+  {
+    qioerr store_err = _store_scanned_int(out, len, issigned, sign, num);
+    if( store_err ) err = store_err;
   }
 
   MAYBE_STACK_FREE(buf, buf_onstack);
@@ -2999,6 +3014,348 @@ qioerr qio_channel_scan_imag(const int threadsafe, qio_channel_t* restrict ch, v
   return qio_channel_scan_float_or_imag(false, ch, out, len, true);
 }
 
+// Bulk scanning of numbers.
+//
+// qio_channel_scan_ints and qio_channel_scan_floats read n numbers while
+// holding the channel lock once.  Plain decimal numbers that lie entirely
+// within the channel's cached buffer are parsed directly from it.
+// Anything else -- other bases, inf and nan, non-ASCII input, a number
+// running into the end of the cached buffer, or any error -- is handed
+// to qio_channel_scan_int/qio_channel_scan_float, so the results are the
+// same as calling those n times.
+
+static inline
+int _is_ascii_space(uint8_t c)
+{
+  return c == ' ' || ('\t' <= c && c <= '\r');
+}
+
+static inline
+int _is_ascii_digit(uint8_t c)
+{
+  return (unsigned) (c - '0') < 10;
+}
+
+// Check 8 bytes at once for all being ASCII digits.
+static inline
+int _are_eight_digits(const uint8_t* p)
+{
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+// Convert 8 ASCII digits at once.
+static inline
+uint32_t _parse_eight_digits(const uint8_t* p)
+{
+  uint64_t v;
+  memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  v -= 0x3030303030303030ULL;
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+       (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+  return (uint32_t) v;
+}
+
+// Accumulate the digits starting at p into *m_inout and count them in
+// *ndigits_inout.  *m_inout is only meaningful while the count is at
+// most 19, which always fits in 64 bits.  Returns the first non-digit.
+static inline
+const uint8_t* _scan_digits(const uint8_t* p, const uint8_t* end,
+                            uint64_t* m_inout, int* ndigits_inout)
+{
+  uint64_t m = *m_inout;
+  int n = *ndigits_inout;
+
+  while( end - p >= 8 && _are_eight_digits(p) ) {
+    if( n + 8 <= 19 ) m = m * 100000000 + _parse_eight_digits(p);
+    n += 8;
+    p += 8;
+  }
+  while( p < end && _is_ascii_digit(*p) ) {
+    if( n < 19 ) m = m * 10 + (*p - '0');
+    n++;
+    p++;
+  }
+
+  *m_inout = m;
+  *ndigits_inout = n;
+  return p;
+}
+
+// Is there a byte at p, and does it end a number without possibly
+// being part of it?
+static inline
+int _number_ends_at(const uint8_t* p, const uint8_t* end, int point_char)
+{
+  return p < end && *p < 0x80 && ! isalnum(*p) &&
+         *p != '.' && *p != point_char;
+}
+
+typedef struct bulk_scan_chars_s {
+  int positive_char;
+  int negative_char;
+  int point_char;
+} bulk_scan_chars_t;
+
+static
+void _bulk_scan_chars(const qio_style_t* style, bulk_scan_chars_t* c)
+{
+  c->positive_char = tolower(style->positive_char);
+  c->negative_char = tolower(style->negative_char);
+  c->point_char = tolower(style->point_char);
+}
+
+// Skip whitespace and read an optional sign, returning NULL if
+// the slow path is needed.
+static inline
+const uint8_t* _scan_space_sign(const uint8_t* p, const uint8_t* end,
+                                const bulk_scan_chars_t* c,
+                                int allow_neg, int* sign_out)
+{
+  while( p < end && _is_ascii_space(*p) ) p++;
+  if( p == end ) return NULL;
+
+  *sign_out = 0;
+  if( *p == c->positive_char ) {
+    *sign_out = 1;
+    p++;
+  } else if( *p == c->negative_char ) {
+    if( ! allow_neg ) return NULL;
+    *sign_out = -1;
+    p++;
+  }
+
+  if( p == end || ! _is_ascii_digit(*p) ) return NULL;
+  return p;
+}
+
+// Returns the end of the number, or NULL if the slow path is needed.
+static
+const uint8_t* _scan_int_fast(const uint8_t* p, const uint8_t* end,
+                              const bulk_scan_chars_t* c, int issigned,
+                              int* sign_out, unsigned long long int* num_out)
+{
+  uint64_t m = 0;
+  int ndigits = 0;
+
+  p = _scan_space_sign(p, end, c, issigned, sign_out);
+  if( ! p ) return NULL;
+
+  p = _scan_digits(p, end, &m, &ndigits);
+  if( ndigits > 19 ) return NULL; // might not fit; let strtoull decide
+  if( ! _number_ends_at(p, end, c->point_char) ) return NULL;
+
+  *num_out = m;
+  return p;
+}
+
+// Powers of ten that are exactly representable as a double.
+static const double _exact_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Returns the end of the number, or NULL if the slow path is needed.
+static
+const uint8_t* _scan_float_fast(const uint8_t* p, const uint8_t* end,
+                                const bulk_scan_chars_t* c,
+                                double* num_out)
+{
+  const uint8_t* num_start;
+  uint64_t m = 0;
+  int ndigits = 0;
+  int nint;
+  int64_t exp10 = 0;
+  int sign;
+  double num;
+
+  num_start = _scan_space_sign(p, end, c, 1, &sign);
+  if( ! num_start ) {
+    // a number starting with the point, as in .5, is fine too
+    while( p < end && _is_ascii_space(*p) ) p++;
+    if( p + 1 >= end || *p != '.' || ! _is_ascii_digit(p[1]) ) return NULL;
+    num_start = p;
+    sign = 0;
+  }
+  p = num_start;
+
+  p = _scan_digits(p, end, &m, &ndigits);
+  nint = ndigits;
+  if( p < end && *p == '.' ) {
+    p++;
+    p = _scan_digits(p, end, &m, &ndigits);
+    exp10 = - (int64_t) (ndigits - nint);
+  }
+  if( p < end && (*p == 'e' || *p == 'E') ) {
+    int esign = 1;
+    int64_t e = 0;
+    p++;
+    if( p < end && (*p == '+' || *p == '-') ) {
+      if( *p == '-' ) esign = -1;
+      p++;
+    }
+    if( p == end || ! _is_ascii_digit(*p) ) return NULL;
+    while( p < end && _is_ascii_digit(*p) ) {
+      if( e < 100000 ) e = e * 10 + (*p - '0');
+      p++;
+    }
+    exp10 += esign * e;
+  }
+  if( ! _number_ends_at(p, end, c->point_char) ) return NULL;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  if( ndigits <= 19 && m <= (1ULL << DBL_MANT_DIG) &&
+      -22 <= exp10 && exp10 <= 22 ) {
+    // Both m and the power of ten are exact, so one correctly
+    // rounded operation gives the correctly rounded result.
+    num = (double) m;
+    if( exp10 < 0 ) num /= _exact_pow10[-exp10];
+    else num *= _exact_pow10[exp10];
+  } else
+#endif
+  {
+    char tmp[128];
+    char* end_conv;
+    size_t len = p - num_start;
+
+    if( len >= sizeof(tmp) ) return NULL;
+    memcpy(tmp, num_start, len);
+    tmp[len] = '\0';
+
+    errno = 0;
+    num = strtod(tmp, &end_conv);
+    if( end_conv != tmp + len ) return NULL;
+    if( (num == HUGE_VAL || num == -HUGE_VAL || num == 0.0) &&
+        errno == ERANGE ) {
+      return NULL; // report the error from the slow path
+    }
+  }
+
+  *num_out = (sign < 0) ? -num : num;
+  return p;
+}
+
+qioerr qio_channel_scan_ints(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned, ssize_t n, ssize_t* restrict num_read_out)
+{
+  bulk_scan_chars_t chars;
+  int fast;
+  ssize_t i;
+  qioerr err = 0;
+
+  *num_read_out = 0;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  _bulk_scan_chars(&ch->style, &chars);
+  fast = (ch->style.base == 0 || ch->style.base == 10) &&
+         (len == 1 || len == 2 || len == 4 || len == 8);
+
+  for( i = 0; i < n; i++ ) {
+    void* dst = qio_ptr_add(out, i * len);
+
+    if( fast ) {
+      const uint8_t* next;
+      unsigned long long int num;
+      int sign;
+
+      if( ! ch->cached_end ) _qio_buffered_setup_cached(ch);
+
+      if( ch->cached_cur ) {
+        next = _scan_int_fast((const uint8_t*) ch->cached_cur,
+                              (const uint8_t*) ch->cached_end,
+                              &chars, issigned, &sign, &num);
+        if( next && ! _store_scanned_int(dst, len, issigned, sign, num) ) {
+          ch->cached_cur = (void*) next;
+          continue;
+        }
+      }
+    }
+
+    err = qio_channel_scan_int(false, ch, dst, len, issigned);
+    if( err ) break;
+  }
+
+  *num_read_out = i;
+
+  _qio_channel_set_error_unlocked(ch, err);
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+qioerr qio_channel_scan_floats(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, ssize_t n, ssize_t* restrict num_read_out)
+{
+  bulk_scan_chars_t chars;
+  int fast;
+  ssize_t i;
+  qioerr err = 0;
+
+  *num_read_out = 0;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  // the fast path hands numbers to strtod as they are written
+  _bulk_scan_chars(&ch->style, &chars);
+  fast = (ch->style.base == 0 || ch->style.base == 10) &&
+         (len == 4 || len == 8) &&
+         chars.positive_char == '+' && chars.negative_char == '-' &&
+         chars.point_char == '.' && tolower(ch->style.exponent_char) == 'e';
+
+  for( i = 0; i < n; i++ ) {
+    void* dst = qio_ptr_add(out, i * len);
+
+    if( fast ) {
+      const uint8_t* next;
+      double num;
+
+      if( ! ch->cached_end ) _qio_buffered_setup_cached(ch);
+
+      if( ch->cached_cur ) {
+        next = _scan_float_fast((const uint8_t*) ch->cached_cur,
+                                (const uint8_t*) ch->cached_end,
+                                &chars, &num);
+        if( next ) {
+          if( len == 8 ) *(double*) dst = num;
+          else *(float*) dst = num;
+          ch->cached_cur = (void*) next;
+          continue;
+        }
+      }
+    }
+
+    err = qio_channel_scan_float(false, ch, dst, len);
+    if( err ) break;
+  }
+
+  *num_read_out = i;
+
+  _qio_channel_set_error_unlocked(ch, err);
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
 // core of ltoa for arbitrary base.
 // Fills in tmp from right to left
 // Returns the number of positions in tmp to skip to get to number.
@@ -0,0 +1,441 @@
+/*
+ * Copyright 2021 Hewlett Packard Enterprise Development LP
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// QIO_METHOD_URING: buffered file I/O through Linux io_uring.
+//
+// qio_preadv and qio_pwritev do one blocking system call per call, which
+// moves the parts of the buffer one after the other and blocks the
+// thread underneath the Chapel task while it does so.  Here instead each
+// part of the buffer (usually one iobuf) becomes its own asynchronous
+// request, as many as the ring has room for are submitted with a single
+// system call, and the task yields until they have all completed.  Other
+// tasks, including other channels on the same file, can submit and reap
+// through the same ring in the meantime, so a few threads can keep many
+// requests in flight.
+//
+// Each file has its own ring, created the first time it is used.  Its
+// lock is held only to submit requests and reap completions, never
+// across a yield.  Whichever task reaps a completion records its result
+// in the request, which lives on its submitter's stack until the
+// submitter has seen it complete.
+//
+// We use the io_uring system calls directly rather than liburing, to
+// avoid a new third-party dependency.  If they are not available, or the
+// kernel refuses to set up a ring, we fall back to pread/pwrite.
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "sys_basic.h"
+
+#ifndef CHPL_RT_UNIT_TEST
+#include "chplrt.h"
+#include "chpl-tasks.h"
+#endif
+
+#include "qio.h"
+#include "qbuffer.h"
+#include "sys.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define QIO_HAVE_URING 1
+#endif
+#endif
+
+// How many requests a file's ring can hold.
+ssize_t qio_uring_queue_depth = 64;
+
+#ifdef QIO_HAVE_URING
+
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+typedef struct qio_uring_s {
+  qio_lock_t lock;
+  int fd;
+
+  unsigned sq_entries;
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  struct io_uring_sqe* sqes;
+
+  unsigned cq_entries;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+
+  // Requests submitted but not yet reaped.  Kept no greater than the
+  // completion queue size, so the completion queue cannot overflow.
+  unsigned inflight;
+
+  void* sq_ring;
+  size_t sq_ring_size;
+  void* cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+} qio_uring_t;
+
+// One per part of the buffer.
+typedef struct {
+  int res;
+  int done;
+} uring_req_t;
+
+// Set once we know the kernel will not give us rings.
+static int uring_unavailable = 0;
+
+static
+void uring_yield(void)
+{
+#ifdef CHPL_RT_UNIT_TEST
+  sched_yield();
+#else
+  chpl_task_yield();
+#endif
+}
+
+static
+void uring_unmap(qio_uring_t* r)
+{
+  if( r->sqes ) munmap(r->sqes, r->sqes_size);
+  if( r->cq_ring ) munmap(r->cq_ring, r->cq_ring_size);
+  if( r->sq_ring ) munmap(r->sq_ring, r->sq_ring_size);
+  if( r->fd >= 0 ) close(r->fd);
+}
+
+static
+qio_uring_t* uring_create(void)
+{
+  struct io_uring_params p;
+  qio_uring_t* r;
+  unsigned depth;
+
+  r = (qio_uring_t*) qio_calloc(1, sizeof(qio_uring_t));
+  if( ! r ) return NULL;
+
+  depth = (qio_uring_queue_depth > 0) ? qio_uring_queue_depth : 1;
+
+  memset(&p, 0, sizeof(p));
+  r->fd = (int) syscall(__NR_io_uring_setup, depth, &p);
+  if( r->fd < 0 ) goto error;
+
+  r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  r->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+  if( r->sq_ring == MAP_FAILED ) { r->sq_ring = NULL; goto error; }
+  r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+  if( r->cq_ring == MAP_FAILED ) { r->cq_ring = NULL; goto error; }
+  r->sqes = (struct io_uring_sqe*)
+            mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+  if( r->sqes == MAP_FAILED ) { r->sqes = NULL; goto error; }
+
+  r->sq_entries = p.sq_entries;
+  r->sq_head = (unsigned*) qio_ptr_add(r->sq_ring, p.sq_off.head);
+  r->sq_tail = (unsigned*) qio_ptr_add(r->sq_ring, p.sq_off.tail);
+  r->sq_mask = (unsigned*) qio_ptr_add(r->sq_ring, p.sq_off.ring_mask);
+  r->sq_array = (unsigned*) qio_ptr_add(r->sq_ring, p.sq_off.array);
+
+  r->cq_entries = p.cq_entries;
+  r->cq_head = (unsigned*) qio_ptr_add(r->cq_ring, p.cq_off.head);
+  r->cq_tail = (unsigned*) qio_ptr_add(r->cq_ring, p.cq_off.tail);
+  r->cq_mask = (unsigned*) qio_ptr_add(r->cq_ring, p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe*) qio_ptr_add(r->cq_ring, p.cq_off.cqes);
+
+  if( qio_lock_init(&r->lock) ) goto error;
+
+  return r;
+
+error:
+  uring_unmap(r);
+  qio_free(r);
+  return NULL;
+}
+
+// Returns the file's ring, creating it if need be, or NULL if we
+// should fall back to pread/pwrite.
+static
+qio_uring_t* uring_for_file(qio_file_t* file)
+{
+  qio_uring_t* r;
+
+  if( uring_unavailable || file->fd < 0 ) return NULL;
+
+  // channel locks are always taken before file locks, so this is safe
+  if( qio_lock(&file->lock) ) return NULL;
+  if( ! file->uring ) {
+    file->uring = uring_create();
+    if( ! file->uring ) uring_unavailable = 1;
+  }
+  r = file->uring;
+  qio_unlock(&file->lock);
+
+  return r;
+}
+
+void qio_uring_release(qio_file_t* file)
+{
+  qio_uring_t* r = file->uring;
+
+  if( ! r ) return;
+
+  // Nothing can be in flight; channels hold a reference to the file.
+  qio_lock_destroy(&r->lock);
+  uring_unmap(r);
+  qio_free(r);
+  file->uring = NULL;
+}
+
+// Record the results of any completed requests.  Lock must be held.
+static
+void uring_reap_locked(qio_uring_t* r)
+{
+  unsigned head = *r->cq_head;
+  unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+
+  while( head != tail ) {
+    struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+    uring_req_t* req = (uring_req_t*) (uintptr_t) cqe->user_data;
+    req->res = cqe->res;
+    req->done = 1;
+    head++;
+    r->inflight--;
+  }
+
+  __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Queue and submit up to n requests, one per iovec, and return how many
+// were submitted.  Lock must be held.  Because the lock is held until
+// the kernel has taken them all, no other task's entries can be behind
+// ours in the submission queue, so on a hard error we can simply take
+// back the ones the kernel has not consumed.
+static
+int uring_submit_locked(qio_uring_t* r, int opcode, int fd,
+                        struct iovec* iov, uring_req_t* reqs, int n,
+                        int64_t offset, qioerr* err_out)
+{
+  unsigned tail = *r->sq_tail;
+  unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+  unsigned room = r->sq_entries - (tail - head);
+  int i;
+  int tries = 0;
+  int submitted = 0;
+
+  *err_out = 0;
+
+  if( room > r->cq_entries - r->inflight ) room = r->cq_entries - r->inflight;
+  if( (unsigned) n > room ) n = room;
+  if( n == 0 ) return 0;
+
+  for( i = 0; i < n; i++ ) {
+    unsigned idx = tail & *r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) &iov[i];
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = (uint64_t) (uintptr_t) &reqs[i];
+    r->sq_array[idx] = idx;
+
+    reqs[i].done = 0;
+    offset += iov[i].iov_len;
+    tail++;
+  }
+
+  __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+
+  while( submitted < n ) {
+    int rc = (int) syscall(__NR_io_uring_enter, r->fd, n - submitted, 0, 0,
+                           NULL, 0);
+    if( rc >= 0 ) {
+      submitted += rc;
+      r->inflight += rc;
+      continue;
+    }
+
+    if( (errno == EINTR || errno == EAGAIN || errno == EBUSY) &&
+        ++tries < 1000 ) {
+      // transient; make room in the completion queue and retry
+      uring_reap_locked(r);
+      continue;
+    }
+
+    *err_out = qio_int_to_err(errno);
+    __atomic_store_n(r->sq_tail, tail - (n - submitted), __ATOMIC_RELEASE);
+    break;
+  }
+
+  return submitted;
+}
+
+static
+qioerr uring_rw(qio_file_t* file, qio_uring_t* r, int opcode,
+                qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end,
+                int64_t seek_to_offset, ssize_t* num_out)
+{
+  int64_t num_bytes = qbuffer_iter_num_bytes(start, end);
+  ssize_t num_parts = qbuffer_iter_num_parts(start, end);
+  struct iovec* iov = NULL;
+  uring_req_t* reqs = NULL;
+  size_t iovcnt;
+  MAYBE_STACK_SPACE(struct iovec, iov_onstack);
+  MAYBE_STACK_SPACE(uring_req_t, reqs_onstack);
+  int64_t offset = seek_to_offset;
+  int next = 0;     // first part not yet submitted
+  int waiting = 0;  // first part not known to be done
+  ssize_t total = 0;
+  qioerr err = 0;
+  qioerr submit_err = 0;
+  int i;
+
+  if( num_bytes < 0 || num_parts < 0 || num_parts > INT_MAX ) {
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "range outside of buffer");
+  }
+
+  MAYBE_STACK_ALLOC(struct iovec, num_parts, iov, iov_onstack);
+  MAYBE_STACK_ALLOC(uring_req_t, num_parts, reqs, reqs_onstack);
+  if( ! iov || ! reqs ) {
+    err = QIO_ENOMEM;
+    goto error;
+  }
+
+  err = qbuffer_to_iov(buf, start, end, num_parts, iov, NULL, &iovcnt);
+  if( err ) goto error;
+
+  err = qio_lock(&r->lock);
+  if( err ) goto error;
+
+  while( waiting < (int) iovcnt ) {
+    if( next < (int) iovcnt && ! submit_err ) {
+      int n = uring_submit_locked(r, opcode, file->fd, &iov[next],
+                                  &reqs[next], iovcnt - next, offset,
+                                  &submit_err);
+      for( i = next; i < next + n; i++ ) offset += iov[i].iov_len;
+      next += n;
+    }
+
+    uring_reap_locked(r);
+
+    while( waiting < next && reqs[waiting].done ) waiting++;
+
+    // Stop once everything submitted is done if we cannot submit more.
+    if( waiting == next && (submit_err || next == (int) iovcnt) ) break;
+
+    if( waiting < (int) iovcnt ) {
+      qio_unlock(&r->lock);
+      uring_yield();
+      err = qio_lock(&r->lock);
+      if( err ) {
+        // We cannot leave while requests referring to our stack are in
+        // flight, so there is no good way to recover from this.
+        assert( ! err );
+        abort();
+      }
+    }
+  }
+
+  qio_unlock(&r->lock);
+
+  // The parts are contiguous in the file, so the result is what the
+  // leading run of complete parts moved, as with a single preadv/pwritev.
+  for( i = 0; i < next; i++ ) {
+    if( reqs[i].res < 0 ) {
+      err = qio_int_to_err(-reqs[i].res);
+      break;
+    }
+    total += reqs[i].res;
+    if( (size_t) reqs[i].res < iov[i].iov_len ) break;
+  }
+  if( ! err && i == next && next < (int) iovcnt ) err = submit_err;
+  // and, as with sys_preadv, reading nothing at all means end of file
+  if( ! err && opcode == IORING_OP_READV && total == 0 && num_bytes != 0 ) {
+    err = qio_int_to_err(EEOF);
+  }
+
+error:
+  MAYBE_STACK_FREE(reqs, reqs_onstack);
+  MAYBE_STACK_FREE(iov, iov_onstack);
+
+  *num_out = total;
+  return err;
+}
+
+qioerr qio_uring_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+{
+  qio_uring_t* r = uring_for_file(file);
+
+  if( ! r ) {
+    return qio_preadv(file, buf, start, end, seek_to_offset, num_read);
+  }
+
+  return uring_rw(file, r, IORING_OP_READV, buf, start, end,
+                  seek_to_offset, num_read);
+}
+
+qioerr qio_uring_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+{
+  qio_uring_t* r = uring_for_file(file);
+
+  if( ! r ) {
+    return qio_pwritev(file, buf, start, end, seek_to_offset, num_written);
+  }
+
+  return uring_rw(file, r, IORING_OP_WRITEV, buf, start, end,
+                  seek_to_offset, num_written);
+}
+
+#else // ! QIO_HAVE_URING
+
+qioerr qio_uring_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+{
+  return qio_preadv(file, buf, start, end, seek_to_offset, num_read);
+}
+
+qioerr qio_uring_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+{
+  return qio_pwritev(file, buf, start, end, seek_to_offset, num_written);
+}
+
+void qio_uring_release(qio_file_t* file)
+{
+}
+
+#endif // QIO_HAVE_URING
@@ -26,10 +26,12 @@
 #include "chpl_rt_utils_static.h"
 #include "chplcgfns.h"
 #include "chpl-arg-bundle.h"
+#include "chpl-atomics.h"
 #include "chpl-comm.h"
 #include "chplexit.h"
 #include "chpl-locale-model.h"
 #include "chpl-mem.h"
+#include "chpl-mem-arena.h"
 #include "chpl-tasks.h"
 #include "chpl-tasks-callbacks-internal.h"
 #include "chpl-topo.h"
@@ -49,7 +51,14 @@
 
 
 //
-// task pool: linked list of tasks
+// task pool: each worker thread has a work-stealing deque of tasks, and
+// tasks created by other threads go on a shared injection queue.
+//
+// A task created by a cobegin or coforall is also on its parent's task
+// list, so it may be started either by a thread that finds it in the
+// pool or by the parent in chpl_task_executeTasksInList().  Whoever
+// starts it first claims it, and the descriptor is freed once both the
+// pool and the list are done with it.
 //
 typedef struct task_pool_struct* task_pool_p;
 
@@ -58,11 +67,10 @@ typedef struct {
 } chpl_task_prvDataImpl_t;
 
 typedef struct task_pool_struct {
-  task_pool_p*     p_list_head;  // task list we're on, if any
-  task_pool_p      list_next;    // double-link pointers for list
-  task_pool_p      list_prev;
-  task_pool_p      next;         // double-link pointers for pool
-  task_pool_p      prev;
+  task_pool_p      list_next;    // next task on our task list, if any
+  task_pool_p      next;         // next task in the injection queue
+  atomic_bool      claimed;      // has someone started this task?
+  atomic_int_least32_t refs;     // pool and task list references
 
   chpl_task_prvDataImpl_t chpl_data;
 
@@ -80,10 +88,39 @@ typedef struct lockReport {
 } lockReport_t;
 
 
+//
+// Work-stealing deque (Chase and Lev, "Dynamic Circular Work-Stealing
+// Deque", SPAA 2005, using the memory orderings from Le et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP
+// 2013).  The owning thread pushes and takes tasks at the bottom, and
+// other threads steal them from the top.  When the array fills up it
+// is replaced by one twice the size.  A thief may still be reading the
+// old one, so it is kept on a list until the owner sees that no thief
+// is in the middle of a steal, and then freed.
+//
+typedef struct task_deque_array_s {
+  int64_t                    size;     // a power of 2
+  struct task_deque_array_s* prev;     // retired smaller array
+  atomic_uintptr_t           buf[];
+} task_deque_array_t;
+
+typedef struct {
+  atomic_int_least64_t top;
+  atomic_int_least32_t thieves;        // number of steals in progress
+  char                 pad[64];        // keep thieves off owner's line
+  atomic_int_least64_t bottom;
+  atomic_uintptr_t     array;          // (task_deque_array_t*)
+} task_deque_t;
+
+#define TASK_DEQUE_INITIAL_SIZE 256
+
+
 // This is the data that is private to each thread.
 typedef struct {
   task_pool_p   ptask;
   lockReport_t* lockRprt;
+  task_deque_t* deque;                 // NULL if this thread has none
+  uint64_t      steal_rand;            // state for choosing victims
 } thread_private_data_t;
 
 
@@ -91,19 +128,27 @@ static chpl_bool        initialized = false;
 
 static chpl_thread_mutex_t threading_lock;     // critical section lock
 static chpl_thread_mutex_t extra_task_lock;    // critical section lock
-static chpl_thread_mutex_t task_id_lock;       // critical section lock
 static chpl_thread_mutex_t task_list_lock;     // critical section lock
+static chpl_thread_mutex_t inject_lock;        // critical section lock
 static volatile task_pool_p
-                           task_pool_head;     // head of task pool
-static volatile task_pool_p
-                           task_pool_tail;     // tail of task pool
-
-static int                 queued_task_cnt;    // number of tasks in task pool
+                           inject_head;        // head of injection queue
+static task_pool_p         inject_tail;        // tail of injection queue
+
+static atomic_uintptr_t*   task_deques;        // registered deques
+static int32_t             max_task_deques;    // size of task_deques[]
+static atomic_int_least32_t
+                           num_task_deques;    // number registered
+
+static atomic_uint_least64_t
+                           next_task_id;       // next task ID to hand out
+static atomic_int_least32_t
+                           queued_task_cnt;    // number of unclaimed tasks
 static int64_t             extra_task_cnt;     // number of tasks being run by
                                                //   threads occupied already
 static int                 blocked_thread_cnt; // number of threads that
                                                //   cannot make progress
-static int                 idle_thread_cnt;    // number of threads looking
+static atomic_int_least32_t
+                           idle_thread_cnt;    // number of threads looking
                                                //   for work
 static uint64_t            progress_cnt;       // number of unblock operations,
                                                //   as a proxy for progress
@@ -121,7 +166,12 @@ static chpl_fn_p comm_task_fn;
 // Internal functions.
 //
 static void                    enqueue_task(task_pool_p, task_pool_p*);
-static void                    dequeue_task(task_pool_p);
+static task_pool_p             find_task(thread_private_data_t*);
+static chpl_bool               claim_task(task_pool_p);
+static void                    release_task(task_pool_p);
+static void                    register_task_deque(thread_private_data_t*);
+static void                    task_deque_free_retired(task_deque_t*,
+                                                       task_deque_array_t*);
 static void                    comm_task_wrapper(void*);
 static void                    taskCallBody(chpl_fn_int_t, chpl_fn_p,
                                             void*, size_t,
@@ -341,16 +391,37 @@ static void setup_main_thread_private_data(void)
 void chpl_task_init(void) {
   chpl_thread_mutexInit(&threading_lock);
   chpl_thread_mutexInit(&extra_task_lock);
-  chpl_thread_mutexInit(&task_id_lock);
   chpl_thread_mutexInit(&task_list_lock);
-  queued_task_cnt = 0;
+  chpl_thread_mutexInit(&inject_lock);
+  atomic_init_uint_least64_t(&next_task_id, chpl_nullTaskID + 1);
+  atomic_init_int_least32_t(&queued_task_cnt, 0);
   blocked_thread_cnt = 0;
-  idle_thread_cnt = 0;
+  atomic_init_int_least32_t(&idle_thread_cnt, 0);
   extra_task_cnt = 0;
-  task_pool_head = task_pool_tail = NULL;
+  inject_head = inject_tail = NULL;
 
   chpl_thread_init(thread_begin, thread_end);
 
+  //
+  // Every worker thread gets a deque, as does the thread that runs
+  // main.  If the number of threads is unbounded we still need a
+  // limit; threads beyond it just use the injection queue.
+  //
+  {
+    int32_t i;
+
+    max_task_deques = (int32_t) chpl_thread_getMaxThreads();
+    if (max_task_deques <= 0)
+      max_task_deques = 1024;
+    max_task_deques++;
+    task_deques = (atomic_uintptr_t*)
+                  chpl_mem_allocMany(max_task_deques, sizeof(task_deques[0]),
+                                     CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+    for (i = 0; i < max_task_deques; i++)
+      atomic_init_uintptr_t(&task_deques[i], (uintptr_t) NULL);
+    atomic_init_int_least32_t(&num_task_deques, 0);
+  }
+
   //
   // Set main thread private data, so that things that require access
   // to it, like chpl_task_getID() and chpl_task_setSerial(), can be
@@ -377,10 +448,34 @@ void chpl_task_init(void) {
 
 
 void chpl_task_exit(void) {
+  thread_private_data_t* tp;
+  int32_t i;
+
   if (!initialized)
     return;
 
   chpl_thread_exit();
+
+  tp = (thread_private_data_t*) chpl_thread_getPrivateData();
+  if (tp != NULL)
+    tp->deque = NULL;
+
+  // The other threads are gone, so nobody can be stealing any more.
+  for (i = 0; i < max_task_deques; i++) {
+    task_deque_t* d;
+    task_deque_array_t* a;
+
+    d = (task_deque_t*) atomic_load_uintptr_t(&task_deques[i]);
+    if (d == NULL)
+      continue;
+    a = (task_deque_array_t*) atomic_load_uintptr_t(&d->array);
+    task_deque_free_retired(d, a);
+    chpl_mem_free(a, 0, 0);
+    chpl_mem_free(d, 0, 0);
+    atomic_store_uintptr_t(&task_deques[i], (uintptr_t) NULL);
+  }
+  chpl_mem_free(task_deques, 0, 0);
+  task_deques = NULL;
 }
 
 
@@ -391,6 +486,9 @@ static void* do_callMain(void* arg) {
   // make sure this thread has thread-private data.
   setup_main_thread_private_data();
 
+  // main creates tasks like any other, so give it a deque
+  register_task_deque(get_thread_private_data());
+
   // make sure that the lock report is set up.
   if (blockreport)
     initializeLockReportForThread();
@@ -534,70 +632,364 @@ static void comm_task_wrapper(void* arg) {
 
 
 //
-// Enqueue and dequeue tasks from the pool.
+// Work-stealing deque operations.
 //
+static task_deque_array_t* task_deque_array_alloc(int64_t size,
+                                                  task_deque_array_t* prev) {
+  task_deque_array_t* a;
+  int64_t i;
+
+  a = (task_deque_array_t*)
+      chpl_mem_alloc(offsetof(task_deque_array_t, buf)
+                     + size * sizeof(a->buf[0]),
+                     CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+  a->size = size;
+  a->prev = prev;
+  for (i = 0; i < size; i++)
+    atomic_init_uintptr_t(&a->buf[i], (uintptr_t) NULL);
+  return a;
+}
+
+
 static inline
-void enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
-  queued_task_cnt++;
+task_pool_p task_deque_array_get(task_deque_array_t* a, int64_t i) {
+  return (task_pool_p)
+         atomic_load_explicit_uintptr_t(&a->buf[i & (a->size - 1)],
+                                        memory_order_relaxed);
+}
 
-  //
-  // Add to pool.
-  //
-  if (task_pool_tail)
-    task_pool_tail->next = ptask;
+
+static inline
+void task_deque_array_put(task_deque_array_t* a, int64_t i, task_pool_p t) {
+  atomic_store_explicit_uintptr_t(&a->buf[i & (a->size - 1)],
+                                  (uintptr_t) t, memory_order_relaxed);
+}
+
+
+//
+// Give the calling thread its own deque and make it visible to thieves.
+//
+static void register_task_deque(thread_private_data_t* tp) {
+  task_deque_t* d;
+  int32_t idx;
+
+  d = (task_deque_t*) chpl_mem_alloc(sizeof(*d),
+                                     CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+  atomic_init_int_least64_t(&d->top, 0);
+  atomic_init_int_least32_t(&d->thieves, 0);
+  atomic_init_int_least64_t(&d->bottom, 0);
+  atomic_init_uintptr_t(&d->array,
+                        (uintptr_t) task_deque_array_alloc(
+                                      TASK_DEQUE_INITIAL_SIZE, NULL));
+
+  idx = atomic_fetch_add_int_least32_t(&num_task_deques, 1);
+  if (idx >= max_task_deques) {
+    // Too many threads; this one will put its tasks in the injection
+    // queue instead.
+    (void) atomic_fetch_sub_int_least32_t(&num_task_deques, 1);
+    chpl_mem_free((void*) atomic_load_uintptr_t(&d->array), 0, 0);
+    chpl_mem_free(d, 0, 0);
+    return;
+  }
+
+  atomic_store_uintptr_t(&task_deques[idx], (uintptr_t) d);
+  tp->deque = d;
+  tp->steal_rand = (uint64_t) idx * 0x9e3779b97f4a7c15ULL + 1;
+}
+
+
+//
+// Free the arrays that our deque has outgrown, if no thief can still be
+// reading them.  Thieves count themselves in d->thieves before they load
+// d->array, and the owner stored the current array before it looks at
+// the count; both are seq_cst.  So if the count is zero, any thief that
+// has not counted itself yet will see the current array.
+//
+static void task_deque_free_retired(task_deque_t* d, task_deque_array_t* a) {
+  task_deque_array_t* old;
+
+  if (atomic_load_int_least32_t(&d->thieves) != 0)
+    return;
+
+  old = a->prev;
+  a->prev = NULL;
+  while (old != NULL) {
+    task_deque_array_t* prev = old->prev;
+    chpl_mem_free(old, 0, 0);
+    old = prev;
+  }
+}
+
+
+//
+// Push a task onto the bottom of our own deque.
+//
+static void task_deque_push(task_deque_t* d, task_pool_p ptask) {
+  int64_t b = atomic_load_explicit_int_least64_t(&d->bottom,
+                                                 memory_order_relaxed);
+  int64_t t = atomic_load_explicit_int_least64_t(&d->top,
+                                                 memory_order_acquire);
+  task_deque_array_t* a;
+
+  a = (task_deque_array_t*)
+      atomic_load_explicit_uintptr_t(&d->array, memory_order_relaxed);
+  if (b - t > a->size - 1) {
+    task_deque_array_t* na;
+    int64_t i;
+
+    na = task_deque_array_alloc(2 * a->size, a);
+    for (i = t; i < b; i++)
+      task_deque_array_put(na, i, task_deque_array_get(a, i));
+    // seq_cst, so that task_deque_free_retired() can tell when thieves
+    // may still be using the old array (see there)
+    atomic_store_uintptr_t(&d->array, (uintptr_t) na);
+    a = na;
+  }
+  if (a->prev != NULL)
+    task_deque_free_retired(d, a);
+  task_deque_array_put(a, b, ptask);
+  chpl_atomic_thread_fence(memory_order_release);
+  atomic_store_explicit_int_least64_t(&d->bottom, b + 1,
+                                      memory_order_relaxed);
+}
+
+
+//
+// Take the most recently pushed task from the bottom of our own deque.
+//
+static task_pool_p task_deque_take(task_deque_t* d) {
+  int64_t b = atomic_load_explicit_int_least64_t(&d->bottom,
+                                                 memory_order_relaxed) - 1;
+  task_deque_array_t* a;
+  task_pool_p ptask;
+  int64_t t;
+
+  a = (task_deque_array_t*)
+      atomic_load_explicit_uintptr_t(&d->array, memory_order_relaxed);
+  atomic_store_explicit_int_least64_t(&d->bottom, b, memory_order_relaxed);
+  chpl_atomic_thread_fence(memory_order_seq_cst);
+  t = atomic_load_explicit_int_least64_t(&d->top, memory_order_relaxed);
+
+  if (t > b) {
+    // empty
+    atomic_store_explicit_int_least64_t(&d->bottom, b + 1,
+                                        memory_order_relaxed);
+    return NULL;
+  }
+
+  ptask = task_deque_array_get(a, b);
+  if (t == b) {
+    // last one; race any thieves for it
+    if (!atomic_compare_exchange_strong_explicit_int_least64_t(
+           &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+      ptask = NULL;
+    atomic_store_explicit_int_least64_t(&d->bottom, b + 1,
+                                        memory_order_relaxed);
+  }
+  return ptask;
+}
+
+
+//
+// Steal the oldest task from the top of another thread's deque.  This
+// returns NULL if the deque is empty or if we lose a race for the task.
+//
+static task_pool_p task_deque_steal(task_deque_t* d) {
+  int64_t t = atomic_load_explicit_int_least64_t(&d->top,
+                                                 memory_order_acquire);
+  int64_t b;
+  task_deque_array_t* a;
+  task_pool_p ptask;
+
+  chpl_atomic_thread_fence(memory_order_seq_cst);
+  b = atomic_load_explicit_int_least64_t(&d->bottom, memory_order_acquire);
+  if (t >= b)
+    return NULL;
+
+  // Announce the steal before looking at the array, so that the owner
+  // does not free an array we are reading (see task_deque_free_retired).
+  (void) atomic_fetch_add_int_least32_t(&d->thieves, 1);
+  a = (task_deque_array_t*) atomic_load_uintptr_t(&d->array);
+  ptask = task_deque_array_get(a, t);
+  (void) atomic_fetch_sub_int_least32_t(&d->thieves, 1);
+  if (!atomic_compare_exchange_strong_explicit_int_least64_t(
+         &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    return NULL;
+  return ptask;
+}
+
+
+static inline
+chpl_bool task_deque_maybe_empty(task_deque_t* d) {
+  return (atomic_load_explicit_int_least64_t(&d->top, memory_order_relaxed)
+          >= atomic_load_explicit_int_least64_t(&d->bottom,
+                                                memory_order_relaxed));
+}
+
+
+//
+// Drop tasks that have already been claimed from the bottom of our own
+// deque, stopping at the first one that hasn't.
+//
+static void prune_task_deque(task_deque_t* d) {
+  task_pool_p ptask;
+
+  while ((ptask = task_deque_take(d)) != NULL) {
+    if (!atomic_load_bool(&ptask->claimed)) {
+      task_deque_push(d, ptask);
+      break;
+    }
+    release_task(ptask);
+  }
+}
+
+
+//
+// Injection queue, for tasks created by threads that have no deque:
+// the comm thread (for moved tasks), the original thread, and any
+// threads past the deque limit.
+//
+static void inject_task(task_pool_p ptask) {
+  ptask->next = NULL;
+
+  // begin critical section
+  chpl_thread_mutexLock(&inject_lock);
+
+  if (inject_tail)
+    inject_tail->next = ptask;
   else
-    task_pool_head = ptask;
-  ptask->prev = task_pool_tail;
-  task_pool_tail = ptask;
+    inject_head = ptask;
+  inject_tail = ptask;
 
-  //
-  // Add to list, if any.
-  //
-  if (p_task_list_head == NULL) {
-    ptask->p_list_head = NULL;
+  // end critical section
+  chpl_thread_mutexUnlock(&inject_lock);
+}
+
+
+static task_pool_p take_injected_task(void) {
+  task_pool_p ptask;
+
+  if (inject_head == NULL)
+    return NULL;
+
+  // begin critical section
+  chpl_thread_mutexLock(&inject_lock);
+
+  if ((ptask = inject_head) != NULL) {
+    if ((inject_head = ptask->next) == NULL)
+      inject_tail = NULL;
   }
-  else {
-    ptask->p_list_head = p_task_list_head;
-    ptask->list_next = *p_task_list_head;
-    if (*p_task_list_head != NULL)
-      (*p_task_list_head)->list_prev = ptask;
-    ptask->list_prev = NULL;
-    *p_task_list_head = ptask;
+
+  // end critical section
+  chpl_thread_mutexUnlock(&inject_lock);
+
+  return ptask;
+}
+
+
+//
+// Try to steal a task from some other thread's deque, starting with a
+// randomly chosen victim so that thieves spread out.
+//
+static task_pool_p steal_task(thread_private_data_t* tp) {
+  int32_t n = atomic_load_int_least32_t(&num_task_deques);
+  int32_t start;
+  int32_t i;
+
+  if (n > max_task_deques)
+    n = max_task_deques;
+  if (n <= 0)
+    return NULL;
+
+  // xorshift64
+  tp->steal_rand ^= tp->steal_rand << 13;
+  tp->steal_rand ^= tp->steal_rand >> 7;
+  tp->steal_rand ^= tp->steal_rand << 17;
+  start = (int32_t) (tp->steal_rand % (uint64_t) n);
+
+  for (i = 0; i < n; i++) {
+    task_deque_t* d;
+    task_pool_p ptask;
+
+    d = (task_deque_t*) atomic_load_uintptr_t(&task_deques[(start + i) % n]);
+    if (d == NULL || d == tp->deque || task_deque_maybe_empty(d))
+      continue;
+    if ((ptask = task_deque_steal(d)) != NULL)
+      return ptask;
   }
+
+  return NULL;
+}
+
+
+//
+// Find a task for a worker thread to run: the newest one on its own
+// deque, else the oldest injected one, else one stolen from another
+// thread.  The task may already have been claimed by its parent.
+//
+static task_pool_p find_task(thread_private_data_t* tp) {
+  task_pool_p ptask;
+
+  if (tp->deque != NULL && (ptask = task_deque_take(tp->deque)) != NULL)
+    return ptask;
+  if ((ptask = take_injected_task()) != NULL)
+    return ptask;
+  return steal_task(tp);
 }
 
 
+//
+// Add a task to the pool, and to a task list if there is one.
+//
 static inline
-void dequeue_task(task_pool_p ptask) {
-  assert(queued_task_cnt > 0);
-  queued_task_cnt--;
+void enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
+  thread_private_data_t* tp = chpl_thread_getPrivateData();
+
+  (void) atomic_fetch_add_int_least32_t(&queued_task_cnt, 1);
 
   //
-  // Remove from pool.
+  // Add to list, if any.  Only the parent task uses its task list, so
+  // this needs no synchronization.
   //
-  if (ptask == task_pool_head) {
-    if ((task_pool_head = task_pool_head->next) == NULL)
-      task_pool_tail = NULL;
-    else
-      task_pool_head->prev = NULL;
-  }
-  else {
-    if ((ptask->prev->next = ptask->next) == NULL)
-      task_pool_tail = ptask->prev;
-    else
-      ptask->next->prev = ptask->prev;
+  if (p_task_list_head != NULL) {
+    ptask->list_next = *p_task_list_head;
+    *p_task_list_head = ptask;
   }
 
   //
-  // Remove from list, if on one.
+  // Add to pool.
   //
-  if (ptask->p_list_head != NULL) {
-    if (ptask == *(ptask->p_list_head))
-      *(ptask->p_list_head) = ptask->list_next;
-    else
-      ptask->list_prev->list_next = ptask->list_next;
-    if (ptask->list_next != NULL)
-      ptask->list_next->list_prev = ptask->list_prev;
+  if (tp != NULL && tp->deque != NULL)
+    task_deque_push(tp->deque, ptask);
+  else
+    inject_task(ptask);
+}
+
+
+//
+// Claim a task so that we can run it.  This fails if someone else
+// already did.
+//
+static inline
+chpl_bool claim_task(task_pool_p ptask) {
+  if (atomic_load_explicit_bool(&ptask->claimed, memory_order_relaxed)
+      || atomic_exchange_bool(&ptask->claimed, true))
+    return false;
+
+  (void) atomic_fetch_sub_int_least32_t(&queued_task_cnt, 1);
+  return true;
+}
+
+
+//
+// Drop a reference to a task descriptor, freeing it if it was the last.
+//
+static inline
+void release_task(task_pool_p ptask) {
+  if (atomic_fetch_sub_int_least32_t(&ptask->refs, 1) == 1) {
+    atomic_destroy_bool(&ptask->claimed);
+    atomic_destroy_int_least32_t(&ptask->refs);
+    chpl_mem_arena_free(ptask, 0, 0);
   }
 }
 
@@ -614,9 +1006,6 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid,
 
   arg->kind = CHPL_ARG_BUNDLE_KIND_TASK;
 
-  // begin critical section
-  chpl_thread_mutexLock(&threading_lock);
-
   if (task_list_locale == chpl_nodeID) {
     (void) add_to_task_pool(fid, chpl_ftable[fid], arg, arg_size,
                             false, (task_pool_p*) p_task_list_void,
@@ -633,9 +1022,6 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid,
     (void) add_to_task_pool(fid, chpl_ftable[fid], arg, arg_size,
                             false, NULL, true, 0, CHPL_FILE_IDX_UNKNOWN);
   }
-
-  // end critical section
-  chpl_thread_mutexUnlock(&threading_lock);
 }
 
 
@@ -650,21 +1036,21 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
   curr_ptask = get_current_ptask(true /*must_be_task*/);
 
   while (*p_task_list_head != NULL) {
-    chpl_fn_p task_to_run_fun = NULL;
+    chpl_fn_p task_to_run_fun;
 
-    // begin critical section
-    chpl_thread_mutexLock(&threading_lock);
+    child_ptask = *p_task_list_head;
+    *p_task_list_head = child_ptask->list_next;
 
-    if ((child_ptask = *p_task_list_head) != NULL) {
-      task_to_run_fun = child_ptask->taskBundle->requested_fn;
-      dequeue_task(child_ptask);
+    //
+    // If some thread took this task out of the pool and started it,
+    // we're done with it.
+    //
+    if (!claim_task(child_ptask)) {
+      release_task(child_ptask);
+      continue;
     }
 
-    // end critical section
-    chpl_thread_mutexUnlock(&threading_lock);
-
-    if (task_to_run_fun == NULL)
-      continue;
+    task_to_run_fun = child_ptask->taskBundle->requested_fn;
 
     set_current_ptask(child_ptask);
 
@@ -718,9 +1104,19 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
     chpl_thread_mutexUnlock(&extra_task_lock);
 
     set_current_ptask(curr_ptask);
-    chpl_mem_free(child_ptask, 0, 0);
+    release_task(child_ptask);
 
   }
+
+  //
+  // The tasks we just ran are probably still on our deque.  Drop them
+  // now rather than leaving them for some thief to find.
+  //
+  {
+    thread_private_data_t* tp = get_thread_private_data();
+    if (tp->deque != NULL)
+      prune_task_deque(tp->deque);
+  }
 }
 
 
@@ -737,14 +1133,8 @@ void taskCallBody(chpl_fn_int_t fid, chpl_fn_p fp,
                   void* arg, size_t arg_size,
                   c_sublocid_t subloc,
                   int lineno, int32_t filename) {
-  // begin critical section
-  chpl_thread_mutexLock(&threading_lock);
-
   (void) add_to_task_pool(fid, fp, arg, arg_size, true,
                           NULL, false, lineno, filename);
-
-  // end critical section
-  chpl_thread_mutexUnlock(&threading_lock);
 }
 
 
@@ -864,7 +1254,7 @@ chpl_bool chpl_task_guardPagesInUse(void) {
 }
 
 uint32_t chpl_task_getNumQueuedTasks(void) {
-  return queued_task_cnt;
+  return (uint32_t) atomic_load_int_least32_t(&queued_task_cnt);
 }
 
 int32_t chpl_task_getNumBlockedTasks(void) {
@@ -875,7 +1265,8 @@ int32_t chpl_task_getNumBlockedTasks(void) {
     chpl_thread_mutexLock(&threading_lock);
     chpl_thread_mutexLock(&block_report_lock);
 
-    numBlockedTasks = blocked_thread_cnt - idle_thread_cnt;
+    numBlockedTasks = blocked_thread_cnt
+                      - atomic_load_int_least32_t(&idle_thread_cnt);
 
     // end critical section
     chpl_thread_mutexUnlock(&block_report_lock);
@@ -895,15 +1286,9 @@ int32_t chpl_task_getNumBlockedTasks(void) {
 // Get a new task ID.
 //
 static chpl_taskID_t get_next_task_id(void) {
-  static chpl_taskID_t       id = chpl_nullTaskID + 1;
-
-  chpl_taskID_t              next_id;
-
-  chpl_thread_mutexLock(&task_id_lock);
-  next_id = id++;
-  chpl_thread_mutexUnlock(&task_id_lock);
-
-  return next_id;
+  return (chpl_taskID_t)
+         atomic_fetch_add_explicit_uint_least64_t(&next_task_id, 1,
+                                                  memory_order_relaxed);
 }
 
 
@@ -977,8 +1362,21 @@ static void report_locked_threads(void) {
 // This signal handler prints an overall task report, containing
 // pending tasks and those that are running.
 //
+static void report_pending_task(task_pool_p ptask) {
+  if (ptask != NULL
+      && !atomic_load_explicit_bool(&ptask->claimed, memory_order_relaxed))
+    printf("- %s:%d\n", chpl_lookupFilename(ptask->taskBundle->filename),
+           ptask->taskBundle->lineno);
+}
+
+//
+// The other threads keep running while we do this, so the list of
+// pending tasks is only a best-effort snapshot.
+//
 static void report_all_tasks(void) {
-  task_pool_p pendingTask = task_pool_head;
+  task_pool_p pendingTask = inject_head;
+  int32_t n = atomic_load_int_least32_t(&num_task_deques);
+  int32_t i;
 
   printf("Task report\n");
   printf("--------------------------------\n");
@@ -986,10 +1384,24 @@ static void report_all_tasks(void) {
   // print out pending tasks
   printf("Pending tasks:\n");
   while (pendingTask != NULL) {
-    printf("- %s:%d\n", chpl_lookupFilename(pendingTask->taskBundle->filename),
-           pendingTask->taskBundle->lineno);
+    report_pending_task(pendingTask);
     pendingTask = pendingTask->next;
   }
+  if (n > max_task_deques)
+    n = max_task_deques;
+  for (i = 0; i < n; i++) {
+    task_deque_t* d = (task_deque_t*) atomic_load_uintptr_t(&task_deques[i]);
+    task_deque_array_t* a;
+    int64_t t, b;
+
+    if (d == NULL)
+      continue;
+    t = atomic_load_int_least64_t(&d->top);
+    b = atomic_load_int_least64_t(&d->bottom);
+    a = (task_deque_array_t*) atomic_load_uintptr_t(&d->array);
+    for ( ; t < b; t++)
+      report_pending_task(task_deque_array_get(a, t));
+  }
   printf("\n");
 
   // print out running tasks
@@ -1151,6 +1563,9 @@ thread_begin(void* ptask_void) {
 
   tp->ptask = NULL;
   tp->lockRprt = NULL;
+  tp->deque = NULL;
+  tp->steal_rand = 0;
+  register_task_deque(tp);
   if (blockreport)
     initializeLockReportForThread();
 
@@ -1169,7 +1584,7 @@ thread_begin(void* ptask_void) {
     // that were waiting on the signal, but since there was a performance
     // impact from keeping it as a hybrid as opposed to merely yielding,
     // it was decided that we would return to the simple yield case.
-    while (!task_pool_head) {
+    while (atomic_load_int_least32_t(&queued_task_cnt) == 0) {
       if (set_block_loc(0, CHPL_FILE_IDX_IDLE_TASK)) {
         // all other tasks appear to be blocked
         struct timeval deadline, now;
@@ -1177,32 +1592,36 @@ thread_begin(void* ptask_void) {
         deadline.tv_sec += 1;
         do {
           chpl_thread_yield();
-          if (!task_pool_head)
+          if (atomic_load_int_least32_t(&queued_task_cnt) == 0)
             gettimeofday(&now, NULL);
-        } while (!task_pool_head
+        } while (atomic_load_int_least32_t(&queued_task_cnt) == 0
                  && (now.tv_sec < deadline.tv_sec
                      || (now.tv_sec == deadline.tv_sec
                          && now.tv_usec < deadline.tv_usec)));
-        if (!task_pool_head) {
+        if (atomic_load_int_least32_t(&queued_task_cnt) == 0) {
           check_for_deadlock();
         }
       }
       else {
         do {
           chpl_thread_yield();
-        } while (!task_pool_head);
+        } while (atomic_load_int_least32_t(&queued_task_cnt) == 0);
       }
 
       unset_block_loc();
     }
 
     //
-    // Just now the pool had at least one task in it.  Lock and see if
-    // there's something still there.
+    // Just now there was at least one unclaimed task.  See if we can
+    // find it, or some other one.  A task we find may already have
+    // been started by its parent, in which case we just drop it.
     //
-    chpl_thread_mutexLock(&threading_lock);
-    if (!task_pool_head) {
-      chpl_thread_mutexUnlock(&threading_lock);
+    if ((ptask = find_task(tp)) == NULL) {
+      chpl_thread_yield();
+      continue;
+    }
+    if (!claim_task(ptask)) {
+      release_task(ptask);
       continue;
     }
 
@@ -1214,17 +1633,11 @@ thread_begin(void* ptask_void) {
       progress_cnt++;
 
     //
-    // start new task; remove task from pool also add to task to task-table
-    // (structure in ChapelRuntime that keeps track of currently running tasks
-    // for task-reports on deadlock or Ctrl+C).
+    // start new task; also add to task to task-table (structure in
+    // ChapelRuntime that keeps track of currently running tasks for
+    // task-reports on deadlock or Ctrl+C).
     //
-    ptask = task_pool_head;
-    idle_thread_cnt--;
-
-    dequeue_task(ptask);
-
-    // end critical section
-    chpl_thread_mutexUnlock(&threading_lock);
+    (void) atomic_fetch_sub_int_least32_t(&idle_thread_cnt, 1);
 
     tp->ptask = ptask;
 
@@ -1257,18 +1670,13 @@ thread_begin(void* ptask_void) {
     }
 
     tp->ptask = NULL;
-    chpl_mem_free(ptask, 0, 0);
-
-    // begin critical section
-    chpl_thread_mutexLock(&threading_lock);
+    release_task(ptask);
+    chpl_mem_arena_task_end();
 
     //
     // finished task; increment idle count
     //
-    idle_thread_cnt++;
-
-    // end critical section
-    chpl_thread_mutexUnlock(&threading_lock);
+    (void) atomic_fetch_add_int_least32_t(&idle_thread_cnt, 1);
   }
 }
 
@@ -1289,6 +1697,7 @@ static void thread_end(void)
     chpl_mem_free(tp, 0, 0);
     chpl_thread_setPrivateData(NULL);
   }
+  chpl_mem_arena_thread_exit();
 }
 
 
@@ -1300,7 +1709,7 @@ static void maybe_add_thread(void) {
 
   if (!warning_issued && chpl_thread_canCreate()) {
     if (chpl_thread_create(NULL) == 0) {
-      idle_thread_cnt++;
+      (void) atomic_fetch_add_int_least32_t(&idle_thread_cnt, 1);
     }
     else {
       int32_t max_threads = chpl_thread_getMaxThreads();
@@ -1324,8 +1733,7 @@ static void maybe_add_thread(void) {
 
 
 // create a task from the given function pointer and arguments
-// and append it to the end of the task pool
-// assumes threading_lock has already been acquired!
+// and add it to the task pool
 static inline
 task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
                              void* a, size_t a_size,
@@ -1345,19 +1753,19 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
   // could be either a comm or a task one.
   //
   assert(a_size >= chpl_argBundleSizeofHdr(a));
-  ptask = (task_pool_p) chpl_mem_alloc(offsetof(task_pool_t, bundle) + a_size,
-                                       CHPL_RT_MD_TASK_ARG_AND_POOL_DESC,
-                                       lineno, filename);
+  ptask = (task_pool_p)
+          chpl_mem_arena_alloc(offsetof(task_pool_t, bundle) + a_size,
+                               CHPL_RT_MD_TASK_ARG_AND_POOL_DESC,
+                               lineno, filename);
 
   memcpy(&ptask->bundle, a, a_size);
   ptask->taskBundle = chpl_argBundleTaskArgBundle(&ptask->bundle);
 
-  ptask->p_list_head            = NULL;
   ptask->list_next              = NULL;
-  ptask->list_prev              = NULL;
   ptask->next                   = NULL;
-  ptask->prev                   = NULL;
   ptask->chpl_data              = pv;
+  atomic_init_bool(&ptask->claimed, false);
+  atomic_init_int_least32_t(&ptask->refs, (p_task_list_head == NULL) ? 1 : 2);
 
   *ptask->taskBundle =
     (chpl_task_bundle_t)
@@ -1371,8 +1779,10 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
       .infoChapel      = ptask->taskBundle->infoChapel,// retain; set by caller
     };
 
-  enqueue_task(ptask, p_task_list_head);
-
+  //
+  // Once the task is in the pool another thread may run it and free it
+  // at any time, so do everything that refers to it first.
+  //
   chpl_task_do_callbacks(chpl_task_cb_event_kind_create,
                          ptask->taskBundle->requested_fid,
                          ptask->taskBundle->filename,
@@ -1389,10 +1799,19 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
     chpl_thread_mutexUnlock(&taskTable_lock);
   }
 
+  enqueue_task(ptask, p_task_list_head);
+
   // If we now have more tasks than threads to run them on, try to start
   // another thread
-  if (queued_task_cnt > idle_thread_cnt) {
+  if (atomic_load_int_least32_t(&queued_task_cnt)
+      > atomic_load_int_least32_t(&idle_thread_cnt)) {
+    // begin critical section
+    chpl_thread_mutexLock(&threading_lock);
+
     maybe_add_thread();
+
+    // end critical section
+    chpl_thread_mutexUnlock(&threading_lock);
   }
 
   return ptask;
@@ -1406,5 +1825,5 @@ uint32_t chpl_task_getNumThreads(void) {
 }
 
 uint32_t chpl_task_getNumIdleThreads(void) {
-  return idle_thread_cnt;
+  return (uint32_t) atomic_load_int_least32_t(&idle_thread_cnt);
 }
@@ -42,6 +42,7 @@
 #include "chplexit.h"
 #include "chpl-locale-model.h"
 #include "chpl-mem.h"
+#include "chpl-mem-arena.h"
 #include "chplsys.h"
 #include "chpl-linefile-support.h"
 #include "chpl-tasks.h"
@@ -194,18 +195,64 @@ void chpl_task_yield(void)
 }
 
 // Sync variables
+//
+// See chpl-tasks-impl.h for the representation.  A task that finds the
+// variable in the wrong state registers itself as a waiter while holding
+// the lock, then unlocks and blocks on the FEB signal word.  A task that
+// changes the state fills the signal word only if there are waiters, and
+// does so before it unlocks, so a wakeup cannot be lost.  A fill with no
+// matching wait just costs the next waiter one extra trip around its loop.
+//
+#define SYNC_LOCKED ((aligned_t) 0x1)
+#define SYNC_FULL   ((aligned_t) 0x2)
+
+// how many times to spin on a held lock before yielding
+#define SYNC_SPINS_BEFORE_YIELD 64
+
+static inline
+aligned_t sync_state(chpl_sync_aux_t *s)
+{
+    return *(volatile aligned_t *) &s->state;
+}
+
+static inline
+chpl_bool sync_try_lock_in_state(chpl_sync_aux_t *s, aligned_t st)
+{
+    return qthread_cas(&s->state, st, st | SYNC_LOCKED) == st;
+}
+
+// Only the lock holder changes the state, so we know what it is and can
+// unlock with an atomic add instead of a CAS that might have to retry.
+static inline
+void sync_set_state_and_unlock(chpl_sync_aux_t *s, aligned_t st)
+{
+    (void) qthread_incr(&s->state, st - sync_state(s));
+}
+
 void chpl_sync_lock(chpl_sync_aux_t *s)
 {
+    aligned_t st;
+    int spins = 0;
+
     PROFILE_INCR(profile_sync_lock, 1);
 
-    qthread_lock(&s->lock);
+    while (true) {
+        st = sync_state(s);
+        if ((st & SYNC_LOCKED) == 0 && sync_try_lock_in_state(s, st)) {
+            return;
+        }
+        if (++spins == SYNC_SPINS_BEFORE_YIELD) {
+            chpl_task_yield();
+            spins = 0;
+        }
+    }
 }
 
 void chpl_sync_unlock(chpl_sync_aux_t *s)
 {
     PROFILE_INCR(profile_sync_unlock, 1);
 
-    qthread_unlock(&s->lock);
+    sync_set_state_and_unlock(s, sync_state(s) & ~SYNC_LOCKED);
 }
 
 void chpl_sync_waitFullAndLock(chpl_sync_aux_t *s,
@@ -214,11 +261,18 @@ void chpl_sync_waitFullAndLock(chpl_sync_aux_t *s,
 {
     PROFILE_INCR(profile_sync_waitFullAndLock, 1);
 
+    // fast path: full and unlocked
+    if (sync_try_lock_in_state(s, SYNC_FULL)) {
+        return;
+    }
+
     chpl_sync_lock(s);
-    while (s->is_full == 0) {
+    while ((sync_state(s) & SYNC_FULL) == 0) {
+        s->num_waiting_full++;
         chpl_sync_unlock(s);
         qthread_readFE(NULL, &(s->signal_full));
         chpl_sync_lock(s);
+        s->num_waiting_full--;
     }
 }
 
@@ -228,11 +282,18 @@ void chpl_sync_waitEmptyAndLock(chpl_sync_aux_t *s,
 {
     PROFILE_INCR(profile_sync_waitEmptyAndLock, 1);
 
+    // fast path: empty and unlocked
+    if (sync_try_lock_in_state(s, 0)) {
+        return;
+    }
+
     chpl_sync_lock(s);
-    while (s->is_full != 0) {
+    while ((sync_state(s) & SYNC_FULL) != 0) {
+        s->num_waiting_empty++;
         chpl_sync_unlock(s);
         qthread_readFE(NULL, &(s->signal_empty));
         chpl_sync_lock(s);
+        s->num_waiting_empty--;
     }
 }
 
@@ -240,18 +301,20 @@ void chpl_sync_markAndSignalFull(chpl_sync_aux_t *s)         // and unlock
 {
     PROFILE_INCR(profile_sync_markAndSignalFull, 1);
 
-    qthread_fill(&(s->signal_full));
-    s->is_full = 1;
-    chpl_sync_unlock(s);
+    if (s->num_waiting_full > 0) {
+        qthread_fill(&(s->signal_full));
+    }
+    sync_set_state_and_unlock(s, SYNC_FULL);
 }
 
 void chpl_sync_markAndSignalEmpty(chpl_sync_aux_t *s)         // and unlock
 {
     PROFILE_INCR(profile_sync_markAndSignalEmpty, 1);
 
-    qthread_fill(&(s->signal_empty));
-    s->is_full = 0;
-    chpl_sync_unlock(s);
+    if (s->num_waiting_empty > 0) {
+        qthread_fill(&(s->signal_empty));
+    }
+    sync_set_state_and_unlock(s, 0);
 }
 
 chpl_bool chpl_sync_isFull(void            *val_ptr,
@@ -259,17 +322,18 @@ chpl_bool chpl_sync_isFull(void            *val_ptr,
 {
     PROFILE_INCR(profile_sync_isFull, 1);
 
-    return s->is_full;
+    return (sync_state(s) & SYNC_FULL) != 0;
 }
 
 void chpl_sync_initAux(chpl_sync_aux_t *s)
 {
     PROFILE_INCR(profile_sync_initAux, 1);
 
-    s->lock         = 0;
-    s->is_full      = 0;
-    s->signal_empty = 0;
-    s->signal_full  = 0;
+    s->state             = 0;
+    s->num_waiting_full  = 0;
+    s->num_waiting_empty = 0;
+    s->signal_empty      = 0;
+    s->signal_full       = 0;
 }
 
 void chpl_sync_destroyAux(chpl_sync_aux_t *s)
@@ -775,6 +839,8 @@ static aligned_t chapel_wrapper(void *arg)
 
     wrap_callbacks(chpl_task_cb_event_kind_end, bundle);
 
+    chpl_mem_arena_task_end();
+
     return 0;
 }
 
@@ -0,0 +1,63 @@
+// Parallel inserts into a single parSafe associative domain,
+// for several task counts.
+config const timing = true;
+config const perf = false;
+config const correctness = false;
+
+config const numKeys = 10**8;
+config const taskCounts = "1,8,64";
+
+use Time;
+
+// spread consecutive i over the table; this is a bijection on int
+inline proc key(i: int) {
+  return (i:uint * 0x9E3779B97F4A7C15):int;
+}
+
+for (tasksStr, idx) in zip(taskCounts.split(","), 1..) {
+  const numTasks = tasksStr:int;
+
+  var D: domain(int, parSafe=true);
+
+  var t1 = new Timer();
+  t1.start();
+
+  coforall tid in 0..#numTasks with (ref D) {
+    const lo = numKeys * tid / numTasks;
+    const hi = numKeys * (tid + 1) / numTasks - 1;
+    for i in lo..hi {
+      // add every key twice so that half the adds find it present
+      D += key(i);
+      D += key(i);
+    }
+  }
+
+  t1.stop();
+
+  if correctness {
+    if D.size != numKeys then
+      writeln("error: ", numTasks, " tasks built a domain of size ", D.size,
+              ", expected ", numKeys);
+    const allFound = && reduce [i in 0..#numKeys] D.contains(key(i));
+    if !allFound then
+      writeln("error: ", numTasks, " tasks lost keys");
+  }
+
+  if timing {
+    if perf {
+      writef("%i: % 6.3r\n", idx, t1.elapsed());
+    } else {
+      if idx != 1 then write("\t");
+      writef("%i tasks: % 6.3r Minserts/s", numTasks,
+             2 * numKeys / t1.elapsed() / 1e6);
+    }
+  }
+}
+
+if timing && !perf {
+  writeln();
+}
+
+if perf || correctness {
+  writeln("SUCCESS");
+}
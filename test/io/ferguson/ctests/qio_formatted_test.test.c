@@ -1091,6 +1091,89 @@ void test_readwritestring()
         string_escape_tests();
 }
 
+// Check that the bulk number scans read the same values, and stop at
+// the same errors, as scanning one number at a time.  If errexpect is
+// 0, ask for exactly nexpect numbers.
+void check_scan_bulk(const char* text, int isfloat, int nexpect, int errexpect)
+{
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  int64_t got_ints[32];
+  int64_t one_int;
+  double got_floats[32];
+  double one_float;
+  ssize_t num_read;
+  ssize_t n = errexpect ? 32 : nexpect;
+  int i;
+
+  err = qio_file_open_tmp(&f, 0, NULL);
+  assert(!err);
+
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  err = qio_channel_write_amt(true, writing, text, strlen(text));
+  assert(!err);
+  qio_channel_release(writing);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+  if( isfloat ) {
+    err = qio_channel_scan_floats(true, reading, got_floats, 8, n, &num_read);
+  } else {
+    err = qio_channel_scan_ints(true, reading, got_ints, 8, 1, n, &num_read);
+  }
+  assert(qio_err_to_int(err) == errexpect);
+  assert(num_read == nexpect);
+  qio_channel_release(reading);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+  for( i = 0; i < nexpect; i++ ) {
+    if( isfloat ) {
+      err = qio_channel_scan_float(true, reading, &one_float, 8);
+      assert(!err);
+      assert(one_float == got_floats[i] ||
+             (isnan(one_float) && isnan(got_floats[i])));
+      assert(signbit(one_float) == signbit(got_floats[i]));
+    } else {
+      err = qio_channel_scan_int(true, reading, &one_int, 8, 1);
+      assert(!err);
+      assert(one_int == got_ints[i]);
+    }
+  }
+  if( errexpect ) {
+    if( isfloat ) {
+      err = qio_channel_scan_float(true, reading, &one_float, 8);
+    } else {
+      err = qio_channel_scan_int(true, reading, &one_int, 8, 1);
+    }
+    assert(qio_err_to_int(err) == errexpect);
+  }
+  qio_channel_release(reading);
+
+  qio_file_release(f);
+}
+
+void test_scan_bulk(void)
+{
+  if( verbose ) printf("Testing bulk number scanning\n");
+
+  check_scan_bulk(" 1 -2 +3\n4567890123\t-9223372036854775807 "
+                  "12345678901234567890 0x1f 007"
+                  " 00000000000000000000000042 5\n", 0, 10, 0);
+  check_scan_bulk("1 2,3", 0, 2, EFORMAT);
+
+  check_scan_bulk("1.5 -2.25e3 .5 5. -0 0.1 1e-300 2.2250738585072011e-308"
+                  " 3.141592653589793238462643 9007199254740993"
+                  " 123456789012345678901234567890e-10 1E22 1e23"
+                  " nan -inf 0x1p4 1.7976931348623157e308\n", 1, 17, 0);
+  check_scan_bulk("1.5 2.5,x", 1, 2, EFORMAT);
+
+  if( verbose ) printf("PASS: bulk number scanning\n");
+}
+
 void test_scanmatch()
 {
   qioerr err;
@@ -1532,6 +1615,7 @@ int main(int argc, char** argv)
     test_endian();
     test_printscan_int();
     test_printscan_float();
+    test_scan_bulk();
 
     test_readwritestring();
 
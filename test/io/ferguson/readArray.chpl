@@ -0,0 +1,50 @@
+use IO;
+
+var f = openmem();
+
+{
+  var w = f.writer();
+  w.writeln("1 -2 +3 4567890123");
+  w.writeln("5\t6");
+  w.writeln("1.5 -2.25e3 .5 1e-300 nan");
+  w.writeln("7 8 9");
+  w.close();
+}
+
+{
+  var r = f.reader();
+
+  var ints: [1..6] int;
+  writeln(r.readArray(ints));
+  writeln(ints);
+
+  var reals: [0..4] real;
+  writeln(r.readArray(reals));
+  writeln(reals);
+
+  // reading past the end gives a short count
+  var small: [0..4] uint(8);
+  writeln(r.readArray(small));
+  writeln(small);
+  writeln(r.readArray(small));
+
+  r.close();
+}
+
+{
+  // a non-numeric value is an error
+  var w = f.writer();
+  w.writeln("1 2 x");
+  w.close();
+
+  var r = f.reader();
+  var ints: [0..2] int(32);
+  try {
+    r.readArray(ints);
+  } catch e: SystemError {
+    writeln("error: ", e.err == EFORMAT);
+  }
+  r.close();
+}
+
+f.close();
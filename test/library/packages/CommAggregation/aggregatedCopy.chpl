@@ -0,0 +1,28 @@
+use BlockDist, CommAggregation;
+
+config const size = 10000;
+const space = {0..size};
+const D = space dmapped Block(space);
+var A, reversedA, gathered: [D] int = D;
+
+forall i in D with (var agg = new DstAggregator(int)) do
+  agg.copy(reversedA[size-i], A[i]);
+
+forall (rA, i) in zip(reversedA, D) do
+  assert(rA == size-i);
+
+forall i in D with (var agg = new SrcAggregator(int)) do
+  agg.copy(gathered[i], reversedA[size-i]);
+
+forall (g, i) in zip(gathered, D) do
+  assert(g == i);
+
+// explicit flush before reading the destination in the same task
+on Locales[numLocales-1] {
+  var agg = new DstAggregator(int);
+  agg.copy(A[0], 42);
+  agg.flush();
+  assert(A[0] == 42);
+}
+
+writeln("OK");
@@ -0,0 +1,70 @@
+use BlockDist, DistributedMap;
+
+config const n = 10000;
+
+var m = new DistributedMap(int, int);
+
+// single-key operations
+assert(m.add(1, 10));
+assert(!m.add(1, 11));
+assert(m.contains(1));
+assert(m.getValue(1) == 10);
+assert(m.set(1, 12));
+assert(!m.set(2, 20));
+m.addOrSet(2, 20);
+assert(m.getValue(2) == 20);
+assert(m.remove(2));
+assert(!m.remove(2));
+assert(m.size == 1);
+m.clear();
+assert(m.isEmpty());
+
+// batched operations over a distributed key array
+const D = {0..#n} dmapped Block({0..#n});
+var keys: [D] int = [i in D] i * 3;
+var vals: [D] int = [i in D] i;
+
+writeln(m.addAll(keys, vals));
+writeln(m.addAll(keys, vals));
+writeln(m.size);
+
+// each key went to the locale that owns it, and only there
+var expected: [LocaleSpace] int;
+for k in keys do
+  expected[m._owner(k).id] += 1;
+coforall loc in Locales do on loc {
+  const inst = m._value;
+  var count = 0;
+  for slot in inst.table.allSlots() {
+    if inst.table.isSlotFull(slot) {
+      assert(inst._owner(inst.table.table[slot].key) == here);
+      count += 1;
+    }
+  }
+  assert(count == expected[here.id]);
+  assert(count > 0);
+}
+
+var newVals: [D] int = [i in D] -i;
+writeln(m.setAll(keys, newVals));
+
+var probe: [D] int = [i in D] i;
+var got: [D] int;
+var found: [D] bool;
+writeln(m.lookupAll(probe, got, found));
+forall i in D {
+  assert(found[i] == (i % 3 == 0));
+  if found[i] then assert(got[i] == -(i / 3));
+}
+
+// every locale holds part of the map
+coforall loc in Locales do on loc {
+  assert(m.getValue(3) == -1);
+}
+
+// iteration
+writeln(+ reduce [k in m] k);
+var total = 0;
+for k in m do total += k;
+writeln(total);
+writeln(+ reduce [(k, v) in m.items()] k + v);
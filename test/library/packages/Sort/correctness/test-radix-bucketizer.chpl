@@ -1,5 +1,6 @@
 use Sort;
 use RadixSortHelp;
+use MSBRadixSort;
 use Random;
 
 config const debug = false;
@@ -227,6 +228,55 @@ proc testBucketizerRandomized(nelts:int, seed:int) {
     assert(total == nelts);
   }
 
+  // Check in-place parallel partitioning, with small blocks so that full
+  // blocks get permuted, and with skewed data so that some buckets have
+  // many blocks.
+  for skewed in (false, true) {
+    for blockSize in (1, 2, 3, 8) {
+      var dst = A;
+      if skewed then
+        dst &= 0x03ffffffffffffff;
+      var src = dst;
+      var counts = InPlacePartitioning.bucketize(A.domain.low, A.domain.high,
+                                                 dst,
+                                                 b, criterion, 0,
+                                                 blockSize=blockSize);
+      if debug {
+        writef("A = %xt\n", src);
+        writef("InPlaceBucketized(%i) = %xt\n", blockSize, dst);
+      }
+
+      // Check that top byte is in order.
+      for i in A.domain {
+        if i != A.domain.low {
+          var topPrev = dst[i-1] >> 56;
+          var topHere = dst[i] >> 56;
+          assert(topPrev <= topHere);
+          assert(counts[(1+topHere):int] > 0);
+        }
+      }
+
+      // Check that all of the elements are represented
+      var srcSorted = src;
+      sort(srcSorted, criterion);
+      var dstSorted = dst;
+      sort(dstSorted, criterion);
+      assert(srcSorted.equals(dstSorted));
+
+      var total = + reduce counts;
+      assert(total == nelts);
+    }
+  }
+
+  // Check radix sorting that shuffles with all tasks
+  var ParSorted = A;
+  MSBRadixSort.msbRadixSort(ParSorted, A.domain.low, A.domain.high,
+                            criterion, 0, max(int),
+                            new MSBRadixSortSettings(sortSwitch=1,
+                                                     parallelShuffleRatio=0,
+                                                     CHECK_SORTS=true));
+  assert(ASorted.equals(ParSorted));
+
 
   // Check two-array sorting
   var TwoSorted = A;
@@ -0,0 +1,71 @@
+/*
+    Compares the radix sorts on 2**M bytes of random data:
+
+      p: msbRadixSort, shuffling large inputs with all tasks (what sort() uses)
+      m: msbRadixSort, shuffling serially at each level
+      t: twoArrayRadixSort
+
+    Each sort is timed and its throughput reported. For memory use, run one
+    sort at a time with --memStats and compare the allocation high water
+    marks; the in-place sorts only add small per-task buffers to the input,
+    while twoArrayRadixSort also allocates a scratch copy of it.
+
+    Note: The correctness test for this is simply checking that it compiles and
+          runs without errors
+ */
+
+use Sort;
+use Random;
+use Time;
+use MSBRadixSort;
+use TwoArrayRadixSort;
+
+config const M: int = 6,                    // 2**M bytes
+             correctness: bool = true,      // Disables output
+             sorts: string = 'pmt';         // Sorts to use (first letter)
+
+config type T = int;
+
+// Number of elements
+const N: int = (2**M / numBytes(T)): int;
+
+proc main() {
+  print('Sorting ', 2**M, ' bytes (', N, ' ', T:string, 's)');
+  if sorts.find('p') != -1 then
+    timeSort('msbRadixSort parallel shuffle',
+             new MSBRadixSortSettings());
+  if sorts.find('m') != -1 then
+    timeSort('msbRadixSort serial shuffle',
+             new MSBRadixSortSettings(minForParallelShuffle=max(int)));
+  if sorts.find('t') != -1 then
+    timeSort('twoArrayRadixSort', none);
+}
+
+proc timeSort(name: string, settings) {
+  var A: [1..N] T;
+  fillRandom(A, seed=42);
+
+  var t = new Timer();
+  t.start();
+  if settings.type == nothing {
+    twoArrayRadixSort(A);
+  } else {
+    msbRadixSort(A, A.domain.low, A.domain.high, defaultComparator,
+                 0, numBits(T) - 8, settings);
+  }
+  t.stop();
+
+  if !isSorted(A) then
+    writeln(name, ' failed to sort data');
+  else {
+    print(name + ' (seconds): ', t.elapsed());
+    print(name + ' (MiB/s): ', (2**M) / t.elapsed() / 2**20);
+  }
+}
+
+proc print(args...) {
+  if correctness && args.size == 2 then
+    writeln(args(0), "x.xxx");
+  else
+    writeln((...args));
+}
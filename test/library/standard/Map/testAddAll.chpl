@@ -0,0 +1,31 @@
+use Map;
+
+config const n = 100000;
+
+var m = new map(int, int);
+m.add(-1, 1);
+m.add(5, 50);
+
+var keys = [i in 0..#n] i;
+var vals = [i in 0..#n] -i;
+
+// 5 is already present and keeps its value
+var added = m.addAll(keys, vals);
+writeln(added);
+writeln(m.size);
+writeln(m[5]);
+assert(&& reduce [i in 1..#n-1] (i == 5 || m[i] == -i));
+
+// adding the same keys again adds nothing
+writeln(m.addAll(keys, vals));
+
+// repeated keys within one call are added once
+var repKeys = [i in 0..#n] n + i % 10;
+var repVals = [i in 0..#n] i % 10;
+writeln(m.addAll(repKeys, repVals));
+assert(&& reduce [i in 0..#10] m[n+i] == i);
+writeln(m.size);
+
+var strMap = new map(string, real, parSafe=true);
+writeln(strMap.addAll(["a", "b", "c"], [1.0, 2.0, 3.0]));
+writeln(strMap.contains("b"), " ", strMap.contains("d"));
@@ -0,0 +1,22 @@
+use Set;
+
+config const n = 100000;
+
+proc doTest(type eltType) {
+  var s: set(eltType);
+  s.add(0:eltType);
+
+  var arr = [i in 0..#n] (i % (n/2)):eltType;
+
+  // every element appears twice, and 0 is already in the set
+  writeln(s.addAll(arr));
+  writeln(s.size);
+  assert(&& reduce [i in 0..#n/2] s.contains(i:eltType));
+  assert(!s.contains((n/2):eltType));
+
+  writeln(s.addAll(arr));
+  writeln(s.size);
+}
+
+doTest(int);
+doTest(string);
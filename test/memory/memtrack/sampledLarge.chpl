@@ -0,0 +1,29 @@
+//
+// With sampling on, allocations at or above the cutoff are still
+// tracked exactly, so they show up in the total at their real size.
+//
+use CPtr, Memory.Diagnostics;
+
+config const nAllocs = 10;
+config const allocSize = 1024 * 1024;
+
+var ptrs: [1..nAllocs] c_ptr(uint(8));
+
+const before = memoryUsed();
+
+for p in ptrs do
+  p = c_malloc(uint(8), allocSize);
+
+const held = (memoryUsed() - before): int;
+if held != nAllocs * allocSize then
+  writeln("after allocating: expected ", nAllocs * allocSize,
+          " bytes, got ", held);
+
+for p in ptrs do
+  c_free(p);
+
+const left = (memoryUsed() - before): int;
+if left != 0 then
+  writeln("after freeing: expected 0 bytes, got ", left);
+
+writeln("OK");
@@ -0,0 +1,12 @@
+//
+// --memMax is enforced on the exact total even if sampling is asked
+// for: a large allocation under the limit must not halt, and one over
+// it must.
+//
+config const n = 1024 * 1024;
+
+var A: [1..n] uint(8);
+writeln("allocated ", n, " bytes under the limit");
+
+var B: [1..4*n] uint(8);
+writeln("Shouldn't get here: over the limit");
@@ -0,0 +1,37 @@
+//
+// Allocate and free from many tasks at once, and check that the
+// tracked total, which is kept across the table's shards, comes out
+// exact at each step.
+//
+use CPtr, Memory.Diagnostics;
+
+config const nTasks = 16;
+config const nAllocs = 1000;
+
+proc sizeOf(t: int, i: int) return 1 + (t * nAllocs + i) % 97;
+
+var ptrs: [0..#nTasks, 0..#nAllocs] c_ptr(uint(8));
+var expected = 0;
+for t in 0..#nTasks do
+  for i in 0..#nAllocs do
+    expected += sizeOf(t, i);
+
+const before = memoryUsed();
+
+coforall t in 0..#nTasks do
+  for i in 0..#nAllocs do
+    ptrs[t, i] = c_malloc(uint(8), sizeOf(t, i));
+
+const held = (memoryUsed() - before): int;
+if held != expected then
+  writeln("after allocating: expected ", expected, " bytes, got ", held);
+
+coforall t in 0..#nTasks do
+  for i in 0..#nAllocs by -1 do
+    c_free(ptrs[(t + 1) % nTasks, i]);
+
+const left = (memoryUsed() - before): int;
+if left != 0 then
+  writeln("after freeing: expected 0 bytes, got ", left);
+
+writeln("OK");
@@ -0,0 +1,96 @@
+//
+// Microbenchmarks for sync and single variable handoffs:
+//
+//   uncontended: one task alternately fills and empties a sync var, so
+//                no operation ever has to wait
+//   ping-pong:   two tasks bounce a value back and forth through a pair
+//                of sync vars, so every handoff wakes a waiting task
+//                (this measures handoff latency)
+//   pipeline:    a producer and a consumer stream values through one
+//                sync var (this measures handoff throughput)
+//   single:      one task fills and reads an array of single vars
+//
+use Time;
+
+config const n = 1000000;
+config const printTiming = false;
+
+proc uncontended() {
+  var s: sync int;
+  var sum = 0;
+  var t: Timer;
+  t.start();
+  for i in 1..n {
+    s.writeEF(i);
+    sum += s.readFE();
+  }
+  t.stop();
+  return (t.elapsed(), sum);
+}
+
+proc pingPong() {
+  var ping, pong: sync int;
+  var sum = 0;
+  var t: Timer;
+  t.start();
+  cobegin with (ref sum) {
+    for i in 1..n {
+      ping.writeEF(i);
+      sum += pong.readFE();
+    }
+    for i in 1..n {
+      pong.writeEF(ping.readFE());
+    }
+  }
+  t.stop();
+  return (t.elapsed(), sum);
+}
+
+proc pipeline() {
+  var s: sync int;
+  var sum = 0;
+  var t: Timer;
+  t.start();
+  cobegin with (ref sum) {
+    for i in 1..n do
+      s.writeEF(i);
+    for i in 1..n do
+      sum += s.readFE();
+  }
+  t.stop();
+  return (t.elapsed(), sum);
+}
+
+proc singles() {
+  const m = min(n, 100000);
+  var S: [1..m] single int;
+  var sum = 0;
+  var t: Timer;
+  t.start();
+  for i in 1..m do
+    S[i].writeEF(i);
+  for i in 1..m do
+    sum += S[i].readFF();
+  t.stop();
+  return (t.elapsed(), sum, m);
+}
+
+const expected = n * (n + 1) / 2;
+
+const (uTime, uSum) = uncontended();
+const (ppTime, ppSum) = pingPong();
+const (plTime, plSum) = pipeline();
+const (sTime, sSum, m) = singles();
+
+if printTiming {
+  writeln("uncontended handoff (ns): ", uTime / n * 1e9);
+  writeln("ping-pong handoff (ns): ", ppTime / (2 * n) * 1e9);
+  writeln("pipeline throughput (M handoffs/s): ", n / plTime / 1e6);
+  writeln("single fill+read (ns): ", sTime / m * 1e9);
+}
+
+if uSum == expected && ppSum == expected && plSum == expected &&
+   sSum == m * (m + 1) / 2 then
+  writeln("SUCCESS");
+else
+  writeln("FAILURE");
@@ -0,0 +1,61 @@
+//
+// Task spawn scaling:
+//
+//   begin:    1, 2, 4, ... spawner tasks each create their share of n
+//             'begin' tasks inside one sync block, so the spawners and
+//             the workers running the new tasks contend on the task pool
+//   coforall: the same number of tasks created by repeated coforalls of
+//             the given width, so spawning and joining alternate
+//
+// The rates are in millions of tasks per second.
+//
+use Time;
+
+config const n = 1000000;
+config const maxSpawners = 8;
+config const printTiming = false;
+
+proc spawnBegins(spawners: int) {
+  var count: atomic int;
+  const perSpawner = n / spawners;
+  var t: Timer;
+  t.start();
+  sync {
+    coforall 1..spawners {
+      for 1..perSpawner do
+        begin count.add(1);
+    }
+  }
+  t.stop();
+  return (spawners * perSpawner / t.elapsed() / 1e6,
+          count.read() == spawners * perSpawner);
+}
+
+proc spawnCoforalls(width: int) {
+  var count: atomic int;
+  const rounds = n / width;
+  var t: Timer;
+  t.start();
+  for 1..rounds {
+    coforall 1..width do
+      count.add(1);
+  }
+  t.stop();
+  return (rounds * width / t.elapsed() / 1e6,
+          count.read() == rounds * width);
+}
+
+var ok = true;
+var spawners = 1;
+while spawners <= maxSpawners {
+  const (beginRate, beginOk) = spawnBegins(spawners);
+  const (coforallRate, coforallOk) = spawnCoforalls(spawners);
+  ok &&= beginOk && coforallOk;
+  if printTiming {
+    writeln("begin ", spawners, " spawners (M tasks/s): ", beginRate);
+    writeln("coforall width ", spawners, " (M tasks/s): ", coforallRate);
+  }
+  spawners *= 2;
+}
+
+writeln(if ok then "SUCCESS" else "FAILURE");
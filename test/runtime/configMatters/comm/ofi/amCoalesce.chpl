@@ -0,0 +1,70 @@
+// Check that with CHPL_RT_COMM_OFI_AM_COALESCE the ofi comm layer still
+// does non-blocking executeOns and non-fetching AMOs correctly when it
+// packs them into batches, and that a task sees the effects of its own
+// coalesced operations when the memory consistency model says it must.
+use BlockDist;
+
+config const numOps = 10000;
+
+const D = LocaleSpace dmapped Block(LocaleSpace);
+
+//
+// Non-fetching AMOs from every locale to every locale.  Each task must
+// see its own adds as soon as it reads the counter back.
+//
+{
+  var counters: [D] atomic int;
+  coforall loc in Locales do on loc {
+    for i in 1..numOps do
+      counters[(here.id + i) % numLocales].add(1);
+    for l in LocaleSpace do
+      assert(counters[l].read() >= numOps / numLocales);
+  }
+  writeln(+ reduce [c in counters] c.read());
+}
+
+//
+// Many small non-blocking executeOns from one task.  A PUT done before
+// one of them must be visible to it.
+//
+{
+  const E = {1..numOps} dmapped Block({1..numOps});
+  var data: [E] int;
+  var count: atomic int;
+  sync {
+    for i in E {
+      data[i] = i;
+      begin on data[i] {
+        assert(data[i] == i);
+        count.add(1);
+      }
+    }
+  }
+  writeln(count.read());
+}
+
+//
+// The same without the PUTs, spreading the tasks over the locales in
+// turn.
+//
+{
+  var count: atomic int;
+  sync {
+    for i in 1..numOps do
+      begin on Locales[i % numLocales] do count.add(1);
+  }
+  writeln(count.read());
+}
+
+//
+// A task that blocks right after starting a remote task it waits for
+// must not hold that task back in its batch forever.
+//
+{
+  for l in LocaleSpace {
+    var done$: sync bool;
+    begin on Locales[l] do done$.writeEF(true);
+    done$.readFE();
+  }
+  writeln("done");
+}
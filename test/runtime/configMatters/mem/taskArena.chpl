@@ -0,0 +1,121 @@
+// Check that the per-thread task arenas recycle blocks, that a block
+// freed by a different thread than the one that allocated it goes back
+// to the allocating thread's arena, and that the arenas do not hold on
+// to more memory than their retention limits.
+use CPtr, SysCTypes;
+
+require "chpl-mem-arena.h";
+
+config const numTasks = 100000;
+config const batchSize = 100;
+config const numBlocks = 100;
+config const printStats = false;
+
+extern "chpl_mem_arena_stats_t" record arenaStats {
+  var allocs, hits, frees, remoteFrees, bulkReturns, bytesRetained: uint(64);
+}
+extern proc chpl_mem_arena_getStats(ref stats: arenaStats);
+extern proc chpl_mem_arena_alloc(size: size_t, description: int(16),
+                                 lineno: int(32), filename: int(32)): c_void_ptr;
+extern proc chpl_mem_arena_free(p: c_void_ptr, lineno: int(32),
+                                filename: int(32));
+extern proc chpl_task_getNumThreads(): uint(32);
+extern proc chpl_thread_getId(): int(64);
+
+proc getStats() {
+  var st: arenaStats;
+  chpl_mem_arena_getStats(st);
+  return st;
+}
+
+proc printDelta(what: string, before: arenaStats, after: arenaStats) {
+  if printStats {
+    writeln(what);
+    writeln("  allocs: ", after.allocs - before.allocs);
+    writeln("  hits: ", after.hits - before.hits);
+    writeln("  remote frees: ", after.remoteFrees - before.remoteFrees);
+    writeln("  bulk returns: ", after.bulkReturns - before.bulkReturns);
+    writeln("  bytes retained: ", after.bytesRetained);
+  }
+}
+
+//
+// Spawn tasks in batches, so that the descriptors of one batch are free
+// again by the time the next one is spawned.
+//
+{
+  const before = getStats();
+
+  var count: atomic int;
+  for 1..numTasks / batchSize {
+    sync {
+      for 1..batchSize do
+        begin count.add(1);
+    }
+  }
+  assert(count.read() == numTasks / batchSize * batchSize);
+
+  const after = getStats();
+  printDelta("spawning", before, after);
+
+  // all the tasks were spawned by this one, so nearly all of their
+  // descriptors should have been reused
+  const allocs = after.allocs - before.allocs;
+  assert(allocs >= numTasks / batchSize * batchSize);
+  assert(after.hits - before.hits >= allocs * 9 / 10);
+}
+
+//
+// Allocate blocks in one task, free them in another, and allocate
+// again in the first.  The second round of allocations should be
+// satisfied from the blocks given back.
+//
+{
+  var blocks: [1..numBlocks] c_void_ptr;
+  var allocThread: int;
+  var allocated, freed: sync bool;
+  var before, mid, after: arenaStats;
+
+  cobegin with (ref blocks, ref allocThread, ref before, ref mid, ref after) {
+    {
+      allocThread = chpl_thread_getId();
+      before = getStats();
+      for b in blocks do
+        b = chpl_mem_arena_alloc(100, 0, 0, 0);
+      allocated.writeEF(true);
+      freed.readFE();
+      mid = getStats();
+      for b in blocks do
+        b = chpl_mem_arena_alloc(100, 0, 0, 0);
+      after = getStats();
+      assert(chpl_thread_getId() == allocThread);
+    }
+    {
+      // the tasks wait for each other, so they can't share a thread
+      allocated.readFE();
+      assert(chpl_thread_getId() != allocThread);
+      for b in blocks do
+        chpl_mem_arena_free(b, 0, 0);
+      freed.writeEF(true);
+    }
+  }
+  printDelta("remote frees", before, after);
+
+  assert(mid.remoteFrees - before.remoteFrees >= numBlocks);
+  assert(after.hits - mid.hits >= numBlocks);
+
+  for b in blocks do
+    chpl_mem_arena_free(b, 0, 0);
+}
+
+//
+// Each thread's arena keeps at most 256 blocks per list, and per remote
+// list, in 6 size classes of at most 2 KiB.
+//
+{
+  const maxRetainedPerArena = 2 * 256 * 6 * 2048;
+  const numArenas = chpl_task_getNumThreads() + 1;
+  assert(getStats().bytesRetained <= numArenas * maxRetainedPerArena);
+}
+
+writeln("OK");
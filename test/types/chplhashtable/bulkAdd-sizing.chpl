@@ -0,0 +1,38 @@
+use ChapelHashtable;
+
+config const n = 10000;
+
+// bulkAdd sizes the table for every key it is given, but when most of
+// them are repeats or already present, the table should end up sized
+// for the keys it actually holds.
+proc test(param swiss: bool) {
+  var h = new chpl__hashtable(int, nothing, swiss);
+
+  // n keys, each repeated 64 times
+  var keys: [0..#64*n] int;
+  forall (k, i) in zip(keys, keys.domain) do
+    k = i % n;
+
+  writeln(h.bulkAdd(keys) == n);
+  writeln(h.tableNumFullSlots == n);
+  writeln(h.tableSizeNum == h._findSizeNum(n));
+
+  for i in 0..#n do
+    assert(h.findFullSlot(i)(0));
+  assert(!h.findFullSlot(n)(0));
+
+  // adding them all again adds nothing and leaves the size alone
+  const sizeNum = h.tableSizeNum;
+  writeln(h.bulkAdd(keys) == 0);
+  writeln(h.tableSizeNum == sizeNum);
+
+  // a table that was already big enough is not shrunk
+  var big = new chpl__hashtable(int, nothing, swiss);
+  big.requestCapacity(64*n);
+  const bigSizeNum = big.tableSizeNum;
+  writeln(big.bulkAdd(keys) == n);
+  writeln(big.tableSizeNum == bigSizeNum);
+}
+
+test(swiss=false);
+test(swiss=true);
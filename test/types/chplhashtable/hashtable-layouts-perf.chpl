@@ -0,0 +1,72 @@
+//
+// Compares the two chpl__hashtable layouts on n int keys:
+//
+//   add:    adding every key to an empty table, growing as it goes
+//   hit:    looking up every key
+//   miss:   looking up n keys that are not in the table
+//   remove: removing every other key, then adding them back
+//
+// The rates are in millions of operations per second.
+//
+use ChapelHashtable, Time;
+
+config const n = 100000;
+config const printTiming = false;
+
+proc time(layout: string, op: string, nOps: int, ref t: Timer) {
+  t.stop();
+  if printTiming then
+    writeln(layout, " ", op, " (M ops/s): ", nOps / t.elapsed() / 1e6);
+  t.clear();
+  t.start();
+}
+
+proc run(param swiss: bool) {
+  const layout = if swiss then "swiss" else "prime";
+  var h = new chpl__hashtable(int, int, swiss=swiss);
+  // spread the keys out so that they do not hash to consecutive slots
+  proc key(i: int) return i * 0x9E3779B1;
+
+  var ok = true;
+  var t: Timer;
+  t.start();
+
+  for i in 0..#n {
+    const (found, slot) = h.findAvailableSlot(key(i));
+    h.fillSlot(slot, key(i), i);
+  }
+  time(layout, "add", n, t);
+
+  var sum = 0;
+  for i in 0..#n {
+    const (found, slot) = h.findFullSlot(key(i));
+    if found then sum += h.table[slot].val;
+  }
+  ok &&= sum == n*(n-1)/2;
+  time(layout, "hit", n, t);
+
+  var misses = 0;
+  for i in n..#n {
+    const (found, _) = h.findFullSlot(key(i));
+    if !found then misses += 1;
+  }
+  ok &&= misses == n;
+  time(layout, "miss", n, t);
+
+  for i in 0..#n by 2 {
+    const (found, slot) = h.findFullSlot(key(i));
+    var k, v: int;
+    h.clearSlot(slot, k, v);
+  }
+  for i in 0..#n by 2 {
+    const (found, slot) = h.findAvailableSlot(key(i));
+    h.fillSlot(slot, key(i), i);
+  }
+  ok &&= h.tableNumFullSlots == n;
+  time(layout, "remove", n, t);
+
+  return ok;
+}
+
+const ok = run(swiss=false) && run(swiss=true);
+writeln(if ok then "SUCCESS" else "FAILURE");
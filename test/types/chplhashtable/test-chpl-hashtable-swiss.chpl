@@ -0,0 +1,65 @@
+use ChapelHashtable;
+
+config const n = 10000;
+
+// Exercises the swiss layout through growth, removal, slot reuse,
+// requestCapacity and shrinking, comparing against what was added.
+proc checkContents(const ref h: chpl__hashtable, keys) {
+  var count = 0;
+  for slot in h.allSlots() {
+    if h.isSlotFull(slot) {
+      const ref entry = h.table[slot];
+      assert(entry.val == 10*entry.key);
+      count += 1;
+    }
+  }
+  assert(count == h.tableNumFullSlots);
+
+  for i in keys.low-10..keys.high+10 {
+    const (found, slot) = h.findFullSlot(i);
+    assert(found == keys.contains(i));
+    if found then assert(h.table[slot].key == i);
+  }
+  return count;
+}
+
+proc add(ref h: chpl__hashtable, i: int) {
+  const (found, slot) = h.findAvailableSlot(i);
+  assert(!found);
+  h.fillSlot(slot, i, 10*i);
+}
+
+proc remove(ref h: chpl__hashtable, i: int) {
+  const (found, slot) = h.findFullSlot(i);
+  assert(found);
+  var key, val: int;
+  h.clearSlot(slot, key, val);
+  assert(key == i && val == 10*i);
+}
+
+var h = new chpl__hashtable(int, int, swiss=true);
+
+writeln("adding");
+for i in 0..#n do add(h, i);
+writeln(checkContents(h, 0..#n) == n);
+assert((h.tableSize & (h.tableSize - 1)) == 0);
+
+writeln("removing odd keys");
+for i in 1..#n by 2 do remove(h, i);
+writeln(checkContents(h, 0..#n by 2) == n/2);
+
+writeln("adding them back");
+for i in 1..#n by 2 do add(h, i);
+writeln(checkContents(h, 0..#n) == n);
+
+writeln("requestCapacity");
+h.requestCapacity(4*n);
+writeln(checkContents(h, 0..#n) == n);
+
+writeln("removing all but the first key");
+for i in 1..n-1 {
+  remove(h, i);
+  h.maybeShrinkAfterRemove();
+}
+writeln(checkContents(h, 0..0) == 1);
+writeln(h.tableSize < n);